@@ -296,22 +296,7 @@ int epicsStdCall ca_create_channel (
         return caStatus;
     }
 
-    {
-        CAFDHANDLER * pFunc = 0;
-        void * pArg = 0;
-        {
-            epicsGuard < epicsMutex >
-                guard ( pcac->mutex );
-            if ( pcac->fdRegFuncNeedsToBeCalled ) {
-                pFunc = pcac->fdRegFunc;
-                pArg = pcac->fdRegArg;
-                pcac->fdRegFuncNeedsToBeCalled = false;
-            }
-        }
-        if ( pFunc ) {
-            ( *pFunc ) ( pArg, pcac->sock, true );
-        }
-    }
+    pcac->fdRegNotify ();
 
     try {
         epicsGuard < epicsMutex > guard ( pcac->mutex );
@@ -353,6 +338,71 @@ int epicsStdCall ca_create_channel (
     return ECA_NORMAL;
 }
 
+/*
+ *  ca_create_channels ()
+ *
+ *  creates all of the channels with one acquisition of the
+ *  lock so that their search requests go out together
+ */
+// extern "C"
+int epicsStdCall ca_create_channels (
+     unsigned nChannels, const char * const * pChanNames,
+     caCh * conn_func, void * const * pUserPrivates,
+     capri priority, chid * pChanIDs )
+{
+    ca_client_context * pcac;
+    int caStatus = fetchClientContext ( & pcac );
+    if ( caStatus != ECA_NORMAL ) {
+        return caStatus;
+    }
+
+    pcac->fdRegNotify ();
+
+    unsigned i = 0u;
+    try {
+        epicsGuard < epicsMutex > guard ( pcac->mutex );
+        pcac->reserveChannels ( guard, nChannels );
+        for ( ; i < nChannels; i++ ) {
+            oldChannelNotify * pChanNotify =
+                new ( pcac->oldChannelNotifyFreeList )
+                    oldChannelNotify ( guard, *pcac, pChanNames[i],
+                        conn_func, pUserPrivates ? pUserPrivates[i] : 0,
+                        priority );
+            pChanIDs[i] = pChanNotify;
+            pChanNotify->initiateConnect ( guard );
+        }
+    }
+    catch ( cacChannel::badString & ) {
+        caStatus = ECA_BADSTR;
+    }
+    catch ( std::bad_alloc & ) {
+        caStatus = ECA_ALLOCMEM;
+    }
+    catch ( cacChannel::badPriority & ) {
+        caStatus = ECA_BADPRIORITY;
+    }
+    catch ( cacChannel::unsupportedByService & ) {
+        caStatus = ECA_UNAVAILINSERV;
+    }
+    catch ( std :: exception & except ) {
+        pcac->printFormated (
+            "ca_create_channels: "
+            "unexpected exception was \"%s\"",
+            except.what () );
+        caStatus = ECA_INTERNAL;
+    }
+    catch ( ... ) {
+        caStatus = ECA_INTERNAL;
+    }
+
+    // the channels created before a failure remain valid
+    for ( ; i < nChannels; i++ ) {
+        pChanIDs[i] = 0;
+    }
+
+    return caStatus;
+}
+
 /*
  *  ca_clear_channel ()
  *
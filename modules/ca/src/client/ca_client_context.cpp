@@ -672,6 +672,30 @@ cacChannel & ca_client_context::createChannel (
         guard, pChannelName, chan, pri );
 }
 
+void ca_client_context::fdRegNotify ()
+{
+    CAFDHANDLER * pFunc = 0;
+    void * pArg = 0;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        if ( this->fdRegFuncNeedsToBeCalled ) {
+            pFunc = this->fdRegFunc;
+            pArg = this->fdRegArg;
+            this->fdRegFuncNeedsToBeCalled = false;
+        }
+    }
+    if ( pFunc ) {
+        ( *pFunc ) ( pArg, this->sock, true );
+    }
+}
+
+void ca_client_context::reserveChannels (
+    epicsGuard < epicsMutex > & guard, unsigned nChannels )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    this->pServiceContext->reserveChannels ( guard, nChannels );
+}
+
 void ca_client_context::flush ( epicsGuard < epicsMutex > & guard )
 {
     this->pServiceContext->flush ( guard );
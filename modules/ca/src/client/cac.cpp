@@ -141,7 +141,6 @@ cac::cac (
     pUserName ( 0 ),
     pudpiiu ( 0 ),
     tcpSmallRecvBufFreeList ( 0 ),
-    tcpLargeRecvBufFreeList ( 0 ),
     notify ( notifyIn ),
     initializingThreadsId ( epicsThreadGetIdSelf() ),
     initializingThreadsPriority ( epicsThreadGetPrioritySelf() ),
@@ -225,10 +224,7 @@ cac::cac (
             autoMaxBytes = 1;
 
         if(!autoMaxBytes) {
-            freeListInitPvt ( &this->tcpLargeRecvBufFreeList, this->maxRecvBytesTCP, 1 );
-            if ( ! this->tcpLargeRecvBufFreeList ) {
-                throw std::bad_alloc ();
-            }
+            this->tcpLargeRecvBufs.setMaxBytes ( this->maxRecvBytesTCP );
         }
         unsigned bufsPerArray = this->maxRecvBytesTCP / comBuf::capacityBytes ();
         if ( bufsPerArray > 1u ) {
@@ -240,9 +236,6 @@ cac::cac (
         osiSockRelease ();
         delete [] this->pUserName;
         freeListCleanup ( this->tcpSmallRecvBufFreeList );
-        if ( this->tcpLargeRecvBufFreeList ) {
-            freeListCleanup ( this->tcpLargeRecvBufFreeList );
-        }
         this->timerQueue.release ();
         throw;
     }
@@ -329,9 +322,6 @@ cac::~cac ()
     }
 
     freeListCleanup ( this->tcpSmallRecvBufFreeList );
-    if ( this->tcpLargeRecvBufFreeList ) {
-        freeListCleanup ( this->tcpLargeRecvBufFreeList );
-    }
 
     delete [] this->pUserName;
 
@@ -415,6 +405,10 @@ void cac::show (
     // this also suppresses the "defined, but not used"
     // warning message
     ::printf ( "\trevision \"%s\"\n", pVersionCAC );
+    this->tcpLargeRecvBufs.show ( level );
+    if ( this->pudpiiu ) {
+        this->pudpiiu->showSearch ( level );
+    }
 
     if ( level > 0u ) {
         this->serverTable.show ( level - 1u );
@@ -521,17 +515,39 @@ cacChannel & cac::createChannel (
         throw cacChannel::badString ();
     }
 
+    this->createDatagramIIU ( guard );
+
+    nciu * pNetChan = new ( this->channelFreeList )
+            nciu ( *this, noopIIU, chan, pName, pri );
+    this->chanTable.idAssignAdd ( *pNetChan );
+    return *pNetChan;
+}
+
+//
+// Make room in the channel table for all of them at once and have
+// the first search timer send the requests for them as soon as the
+// guard is released, in as few full datagrams as possible.
+//
+void cac::reserveChannels (
+    epicsGuard < epicsMutex > & guard, unsigned nChannels )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    this->createDatagramIIU ( guard );
+    this->chanTable.setTableSize (
+        this->chanTable.numEntriesInstalled () + nChannels );
+    this->pudpiiu->searchNow ( guard );
+}
+
+void cac::createDatagramIIU (
+    epicsGuard < epicsMutex > & guard )
+{
     if ( ! this->pudpiiu ) {
         this->pudpiiu = new udpiiu (
             guard, this->timerQueue, this->cbMutex,
             this->mutex, this->notify, *this, this->_serverPort,
             this->searchDestList );
     }
-
-    nciu * pNetChan = new ( this->channelFreeList )
-            nciu ( *this, noopIIU, chan, pName, pri );
-    this->chanTable.idAssignAdd ( *pNetChan );
-    return *pNetChan;
 }
 
 bool cac::findOrCreateVirtCircuit (
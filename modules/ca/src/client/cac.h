@@ -39,6 +39,7 @@
 #include "netIO.h"
 #include "localHostName.h"
 #include "virtualCircuit.h"
+#include "recvBufPool.h"
 
 class netWriteNotifyIO;
 class netReadNotifyIO;
@@ -127,6 +128,8 @@ public:
     cacChannel & createChannel (
         epicsGuard < epicsMutex > & guard, const char * pChannelName,
         cacChannelNotify &, cacChannel::priLev );
+    void reserveChannels (
+        epicsGuard < epicsMutex > &, unsigned nChannels );
     void destroyChannel (
         epicsGuard < epicsMutex > &, nciu & );
     void initiateConnect (
@@ -258,7 +261,7 @@ private:
     char * pUserName;
     class udpiiu * pudpiiu;
     void * tcpSmallRecvBufFreeList;
-    void * tcpLargeRecvBufFreeList;
+    recvBufPool tcpLargeRecvBufs;
     cacContextNotify & notify;
     epicsThreadId initializingThreadsId;
     unsigned initializingThreadsPriority;
@@ -280,6 +283,9 @@ private:
         epicsGuard < epicsMutex > & cbGuard,
         epicsGuard < epicsMutex > & guard, nciu & chan );
 
+    void createDatagramIIU (
+        epicsGuard < epicsMutex > & );
+
     void ioExceptionNotify ( unsigned id, int status,
         const char * pContext, unsigned type, arrayElementCount count );
     void ioExceptionNotifyAndUninstall ( unsigned id, int status,
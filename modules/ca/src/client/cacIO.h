@@ -286,6 +286,10 @@ public:
         epicsGuard < epicsMutex > & ) const = 0;
     virtual void show (
         epicsGuard < epicsMutex > &, unsigned level ) const = 0;
+    // the caller is about to create nChannels channels while
+    // holding the guard, last so the earlier vtable slots don't move
+    virtual void reserveChannels (
+        epicsGuard < epicsMutex > &, unsigned nChannels );
 };
 
 class LIBCA_API cacContextNotify {
@@ -217,6 +217,33 @@ LIBCA_API int epicsStdCall ca_create_channel
      chid           *pChanID
 );
 
+/*
+ * ca_create_channels ()
+ *
+ * Creates many channels at once, which is faster than calling
+ * ca_create_channel() for each of them.  Should creating one of the
+ * channels fail, the error is returned, the channels created so far
+ * remain valid and their successors in pChanIDs are set to NULL.
+ *
+ * nChannels            R   number of channels
+ * pChanNames           R   array of nChannels channel name strings
+ * pConnStateCallback   R   address of connection state change
+ *                          callback function for all of the channels
+ * pUserPrivates        R   array of nChannels user private pointers,
+ *                          or NULL to leave them all NULL
+ * priority             R   priority level in the server 0 - 100
+ * pChanIDs             RW  array of nChannels channel ids written here
+ */
+LIBCA_API int epicsStdCall ca_create_channels
+(
+     unsigned           nChannels,
+     const char * const *pChanNames,
+     caCh               *pConnStateCallback,
+     void * const       *pUserPrivates,
+     capri              priority,
+     chid               *pChanIDs
+);
+
 /*
  * ca_change_connection_event()
  *
@@ -97,6 +97,70 @@ inline epicsUInt32 dbr_htonl ( const epicsUInt32 & host )
     return tmp;
 }
 
+#if EPICS_BYTE_ORDER == EPICS_ENDIAN_LITTLE && \
+        EPICS_FLOAT_WORD_ORDER == EPICS_ENDIAN_LITTLE
+/*
+ * The integers and floats of a little endian host are the exact byte
+ * reverse of the net format, so arrays are converted in either direction
+ * by reversing the bytes of each element.  Unlike the loops calling
+ * dbr_ntohX() for each element these vectorize, and the wider elements
+ * are handled as 16 bit words because compilers turn a whole word swap
+ * into a bswap instruction which then doesn't.  They also work in place.
+ */
+#define CVRT_SWAP_BLOCK
+
+static void swapBlock16 ( const void *s, void *d, arrayElementCount num )
+{
+    const epicsUInt8    *pSrc = (const epicsUInt8 *) s;
+    epicsUInt8          *pDest = (epicsUInt8 *) d;
+
+    for ( arrayElementCount i = 0; i < num; i++ ) {
+        epicsUInt16 w;
+        memcpy ( &w, pSrc + 2 * i, 2 );
+        w = byteSwap ( w );
+        memcpy ( pDest + 2 * i, &w, 2 );
+    }
+}
+
+static void swapBlock32 ( const void *s, void *d, arrayElementCount num )
+{
+    const epicsUInt8    *pSrc = (const epicsUInt8 *) s;
+    epicsUInt8          *pDest = (epicsUInt8 *) d;
+
+    for ( arrayElementCount i = 0; i < num; i++ ) {
+        epicsUInt16 w0, w1;
+        memcpy ( &w0, pSrc + 4 * i, 2 );
+        memcpy ( &w1, pSrc + 4 * i + 2, 2 );
+        w0 = byteSwap ( w0 );
+        w1 = byteSwap ( w1 );
+        memcpy ( pDest + 4 * i, &w1, 2 );
+        memcpy ( pDest + 4 * i + 2, &w0, 2 );
+    }
+}
+
+static void swapBlock64 ( const void *s, void *d, arrayElementCount num )
+{
+    const epicsUInt8    *pSrc = (const epicsUInt8 *) s;
+    epicsUInt8          *pDest = (epicsUInt8 *) d;
+
+    for ( arrayElementCount i = 0; i < num; i++ ) {
+        epicsUInt16 w0, w1, w2, w3;
+        memcpy ( &w0, pSrc + 8 * i, 2 );
+        memcpy ( &w1, pSrc + 8 * i + 2, 2 );
+        memcpy ( &w2, pSrc + 8 * i + 4, 2 );
+        memcpy ( &w3, pSrc + 8 * i + 6, 2 );
+        w0 = byteSwap ( w0 );
+        w1 = byteSwap ( w1 );
+        w2 = byteSwap ( w2 );
+        w3 = byteSwap ( w3 );
+        memcpy ( pDest + 8 * i, &w3, 2 );
+        memcpy ( pDest + 8 * i + 2, &w2, 2 );
+        memcpy ( pDest + 8 * i + 4, &w1, 2 );
+        memcpy ( pDest + 8 * i + 6, &w0, 2 );
+    }
+}
+#endif
+
 /*
  * if hton is true then it is a host to network conversion
  * otherwise vise-versa
@@ -134,6 +198,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef CVRT_SWAP_BLOCK
+    swapBlock16 ( s, d, num );
+#else
     dbr_short_t         *pSrc = (dbr_short_t *) s;
     dbr_short_t         *pDest = (dbr_short_t *) d;
 
@@ -147,6 +214,7 @@ arrayElementCount   num         /* number of values     */
             pDest[i] = dbr_ntohs( pSrc[i] );
         }
     }
+#endif
 }
 
 /*
@@ -184,6 +252,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef CVRT_SWAP_BLOCK
+    swapBlock32 ( s, d, num );
+#else
     dbr_long_t          *pSrc = (dbr_long_t *) s;
     dbr_long_t          *pDest = (dbr_long_t *) d;
 
@@ -197,6 +268,7 @@ arrayElementCount   num         /* number of values     */
             pDest[i] = dbr_ntohl( pSrc[i] );
         }
     }
+#endif
 }
 
 /*
@@ -213,6 +285,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef CVRT_SWAP_BLOCK
+    swapBlock16 ( s, d, num );
+#else
     dbr_enum_t          *pSrc = (dbr_enum_t *) s;
     dbr_enum_t          *pDest = (dbr_enum_t *) d;
 
@@ -226,6 +301,7 @@ arrayElementCount   num         /* number of values     */
             pDest[i] = dbr_ntohs ( pSrc[i] );
         }
     }
+#endif
 }
 
 /*
@@ -244,6 +320,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef CVRT_SWAP_BLOCK
+    swapBlock32 ( s, d, num );
+#else
     const dbr_float_t   *pSrc = (const dbr_float_t *) s;
     dbr_float_t         *pDest = (dbr_float_t *) d;
 
@@ -257,6 +336,7 @@ arrayElementCount   num         /* number of values     */
             dbr_ntohf ( &pSrc[i], &pDest[i] );
         }
     }
+#endif
 }
 
 /*
@@ -269,6 +349,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef CVRT_SWAP_BLOCK
+    swapBlock64 ( s, d, num );
+#else
     dbr_double_t        *pSrc = (dbr_double_t *) s;
     dbr_double_t        *pDest = (dbr_double_t *) d;
 
@@ -282,6 +365,7 @@ arrayElementCount   num         /* number of values     */
             dbr_ntohd( &pSrc[i], &pDest[i] );
         }
     }
+#endif
 }
 
 /****************************************************************************
@@ -835,10 +919,14 @@ arrayElementCount   num         /* number of values     */
     if ( s == d )
         return;
 
+    memcpy(pDest->units,pSrc->units,sizeof(pSrc->units));
+
     pDest->upper_disp_limit     = pSrc->upper_disp_limit;
     pDest->lower_disp_limit     = pSrc->lower_disp_limit;
     pDest->upper_alarm_limit    = pSrc->upper_alarm_limit;
     pDest->upper_warning_limit  = pSrc->upper_warning_limit;
+    pDest->lower_alarm_limit    = pSrc->lower_alarm_limit;
+    pDest->lower_warning_limit  = pSrc->lower_warning_limit;
     pDest->lower_ctrl_limit     = pSrc->lower_ctrl_limit;
     pDest->upper_ctrl_limit     = pSrc->upper_ctrl_limit;
 
@@ -1080,7 +1168,7 @@ arrayElementCount   num         /* number of values     */
         pDest->value = dbr_ntohl(pSrc->value);
     else        /* array chan-- multiple pts */
     {
-        cvrt_long(&pDest->value, &pSrc->value, encode, num);
+        cvrt_long(&pSrc->value, &pDest->value, encode, num);
     }
 }
 
@@ -1300,7 +1388,7 @@ arrayElementCount   num         /* number of values     */
         pDest->value = dbr_ntohl(pSrc->value);
     else        /* array chan-- multiple pts */
     {
-        cvrt_long(&pDest->value, &pSrc->value, encode, num);
+        cvrt_long(&pSrc->value, &pDest->value, encode, num);
     }
 }
 
@@ -305,6 +305,8 @@ public:
     cacChannel & createChannel (
         epicsGuard < epicsMutex > &, const char * pChannelName,
         cacChannelNotify &, cacChannel::priLev pri );
+    void reserveChannels (
+        epicsGuard < epicsMutex > &, unsigned nChannels );
     void flush ( epicsGuard < epicsMutex > & );
     void eliminateExcessiveSendBacklog (
         epicsGuard < epicsMutex > &, cacChannel & );
@@ -355,6 +357,10 @@ public:
     friend int epicsStdCall ca_create_channel (
         const char * name_str, caCh * conn_func, void * puser,
         capri priority, chid * chanptr );
+    friend int epicsStdCall ca_create_channels (
+        unsigned nChannels, const char * const * pChanNames,
+        caCh * conn_func, void * const * pUserPrivates,
+        capri priority, chid * pChanIDs );
     friend int epicsStdCall ca_clear_channel ( chid pChan );
     friend int epicsStdCall ca_array_get ( chtype type,
         arrayElementCount count, chid pChan, void * pValue );
@@ -425,6 +431,7 @@ private:
     cacContext & createNetworkContext (
         epicsMutex & mutualExclusion, epicsMutex & callbackControl );
     void _sendWakeupMsg ();
+    void fdRegNotify ();
 
     ca_client_context ( const ca_client_context & );
     ca_client_context & operator = ( const ca_client_context & );
@@ -0,0 +1,159 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "caProto.h"
+#include "recvBufPool.h"
+
+recvBufPool::recvBufPool () :
+    nClasses ( 0u ), nInUseBytes ( 0u ), maxInUseBytes ( 0u )
+{
+    this->setMaxBytes ( 0u );
+}
+
+recvBufPool::~recvBufPool ()
+{
+    for ( unsigned i = 0u; i < this->nClasses; i++ ) {
+        while ( char * pBuf = this->classes[i].pIdle ) {
+            this->classes[i].pIdle = * reinterpret_cast < char ** > ( pBuf );
+            free ( pBuf );
+        }
+    }
+}
+
+// only called before the first buffer is allocated
+void recvBufPool::setMaxBytes ( unsigned maxBytes )
+{
+    const unsigned limit = maxBytes ? maxBytes : 0xffffffff;
+    unsigned bytes = MAX_TCP;
+
+    this->nClasses = 0u;
+    while ( bytes < limit && this->nClasses < maxClasses ) {
+        sizeClass & cls = this->classes[this->nClasses++];
+        bytes = bytes <= limit / 2u ? bytes * 2u : limit;
+        cls.pIdle = 0;
+        cls.bytes = bytes;
+        cls.nIdle = 0u;
+        cls.nInUse = 0u;
+        cls.maxInUse = 0u;
+        cls.nRequests = 0u;
+        cls.nHeap = 0u;
+    }
+}
+
+recvBufPool::sizeClass * recvBufPool::findClass ( unsigned nBytes )
+{
+    for ( unsigned i = 0u; i < this->nClasses; i++ ) {
+        if ( nBytes <= this->classes[i].bytes ) {
+            return & this->classes[i];
+        }
+    }
+    return 0;
+}
+
+char * recvBufPool::allocate ( unsigned nBytes, unsigned & capacity )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+
+    sizeClass * pClass = this->findClass ( nBytes );
+    if ( ! pClass ) {
+        return 0;
+    }
+
+    char * pBuf = pClass->pIdle;
+    if ( pBuf ) {
+        pClass->pIdle = * reinterpret_cast < char ** > ( pBuf );
+        pClass->nIdle--;
+    }
+    else {
+        {
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            pBuf = static_cast < char * > ( malloc ( pClass->bytes ) );
+        }
+        if ( ! pBuf ) {
+            return 0;
+        }
+        pClass->nHeap++;
+    }
+
+    pClass->nRequests++;
+    pClass->nInUse++;
+    if ( pClass->nInUse > pClass->maxInUse ) {
+        pClass->maxInUse = pClass->nInUse;
+    }
+    this->nInUseBytes += pClass->bytes;
+    if ( this->nInUseBytes > this->maxInUseBytes ) {
+        this->maxInUseBytes = this->nInUseBytes;
+    }
+    capacity = pClass->bytes;
+    return pBuf;
+}
+
+void recvBufPool::release ( char * pBuf, unsigned capacity )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+
+    sizeClass * pClass = this->findClass ( capacity );
+    pClass->nInUse--;
+    this->nInUseBytes -= pClass->bytes;
+    if ( pClass->nIdle < maxIdlePerClass ) {
+        * reinterpret_cast < char ** > ( pBuf ) = pClass->pIdle;
+        pClass->pIdle = pBuf;
+        pClass->nIdle++;
+    }
+    else {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        free ( pBuf );
+    }
+}
+
+size_t recvBufPool::inUseBytes () const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    return this->nInUseBytes;
+}
+
+size_t recvBufPool::idleBytes () const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    return this->idleBytes ( guard );
+}
+
+size_t recvBufPool::idleBytes ( epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    size_t bytes = 0u;
+    for ( unsigned i = 0u; i < this->nClasses; i++ ) {
+        bytes += static_cast < size_t > ( this->classes[i].nIdle ) *
+            this->classes[i].bytes;
+    }
+    return bytes;
+}
+
+void recvBufPool::show ( unsigned level ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+
+    ::printf ( "Large receive buffers: %lu bytes in use (max %lu), %lu bytes idle\n",
+        static_cast < unsigned long > ( this->nInUseBytes ),
+        static_cast < unsigned long > ( this->maxInUseBytes ),
+        static_cast < unsigned long > ( this->idleBytes ( guard ) ) );
+    if ( level > 0u ) {
+        for ( unsigned i = 0u; i < this->nClasses; i++ ) {
+            const sizeClass & cls = this->classes[i];
+            if ( cls.nRequests == 0u ) {
+                continue;
+            }
+            ::printf ( "\t%10u byte buffers: %u in use (max %u), %u idle, "
+                "%lu requests, %lu from the heap\n",
+                cls.bytes, cls.nInUse, cls.maxInUse, cls.nIdle,
+                cls.nRequests, cls.nHeap );
+        }
+    }
+}
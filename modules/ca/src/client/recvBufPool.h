@@ -0,0 +1,58 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Message body buffers for responses larger than MAX_TCP, shared by all
+ * of the circuits of a client context.  Buffers come in power of two
+ * size classes starting at twice MAX_TCP, the largest class being
+ * limited to EPICS_CA_MAX_ARRAY_BYTES unless EPICS_CA_AUTO_ARRAY_BYTES
+ * is set.  A circuit returns its buffer once it hasn't received a large
+ * message for a few seconds, and each class keeps only a few idle
+ * buffers for reuse.
+ */
+
+#ifndef INC_recvBufPool_H
+#define INC_recvBufPool_H
+
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+
+class recvBufPool {
+public:
+    recvBufPool ();
+    ~recvBufPool ();
+    // zero for no limit
+    void setMaxBytes ( unsigned maxBytes );
+    // nil if nBytes exceeds the limit or the heap is exhausted
+    char * allocate ( unsigned nBytes, unsigned & capacity );
+    void release ( char * pBuf, unsigned capacity );
+    size_t inUseBytes () const;
+    size_t idleBytes () const;
+    void show ( unsigned level ) const;
+private:
+    struct sizeClass {
+        char * pIdle; // idle buffers, linked through their first bytes
+        unsigned bytes;
+        unsigned nIdle;
+        unsigned nInUse;
+        unsigned maxInUse;
+        unsigned long nRequests;
+        unsigned long nHeap; // of the requests, those that called malloc
+    };
+    enum { maxClasses = 18 };
+    enum { maxIdlePerClass = 2 };
+    sizeClass classes[maxClasses];
+    unsigned nClasses;
+    size_t nInUseBytes;
+    size_t maxInUseBytes;
+    mutable epicsMutex mutex;
+    sizeClass * findClass ( unsigned nBytes );
+    size_t idleBytes ( epicsGuard < epicsMutex > & ) const;
+    recvBufPool ( const recvBufPool & );
+    recvBufPool & operator = ( const recvBufPool & );
+};
+
+#endif // ifndef INC_recvBufPool_H
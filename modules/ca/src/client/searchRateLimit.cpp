@@ -0,0 +1,45 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "searchRateLimit.h"
+
+searchRateLimit::searchRateLimit (
+        double maxRate, const epicsTime & currentTime ) :
+    rate ( maxRate > 0.0 ? maxRate : 0.0 ), budget ( rate ),
+    budgetTime ( currentTime )
+{
+}
+
+double searchRateLimit::delay ( const epicsTime & currentTime )
+{
+    if ( this->rate <= 0.0 ) {
+        return 0.0;
+    }
+    double elapsed = currentTime - this->budgetTime;
+    if ( elapsed > 0.0 ) {
+        this->budget += elapsed * this->rate;
+        if ( this->budget > this->rate ) {
+            this->budget = this->rate;
+        }
+        this->budgetTime = currentTime;
+    }
+    if ( this->budget > 0.0 ) {
+        return 0.0;
+    }
+    return - this->budget / this->rate;
+}
+
+void searchRateLimit::spend ( double nBytes )
+{
+    if ( this->rate > 0.0 ) {
+        this->budget -= nBytes;
+    }
+}
+
+double searchRateLimit::maxRate () const
+{
+    return this->rate;
+}
@@ -0,0 +1,34 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Token bucket limiting the search requests sent to all destinations
+ * to EPICS_CA_MAX_SEARCH_RATE bytes per second, with at most one
+ * second's worth saved up.  A datagram may overdraw the budget, the
+ * next one then waits until it has been paid off.  The caller provides
+ * the locking.
+ */
+
+#ifndef INC_searchRateLimit_H
+#define INC_searchRateLimit_H
+
+#include "epicsTime.h"
+
+class searchRateLimit {
+public:
+    // zero for no limit
+    searchRateLimit ( double maxRate, const epicsTime & currentTime );
+    // seconds until another datagram may be sent, zero if it may now
+    double delay ( const epicsTime & currentTime );
+    void spend ( double nBytes );
+    double maxRate () const;
+private:
+    const double rate; // bytes per second
+    double budget; // bytes, negative when overdrawn
+    epicsTime budgetTime;
+};
+
+#endif // ifndef INC_searchRateLimit_H
@@ -40,8 +40,7 @@ searchTimer::searchTimer (
         searchTimerNotify & iiuIn,
         epicsTimerQueue & queueIn,
         const unsigned indexIn,
-        epicsMutex & mutexIn,
-        bool boostPossibleIn ) :
+        epicsMutex & mutexIn ) :
     timeAtLastSend ( epicsTime::getCurrent () ),
     timer ( queueIn.createTimer () ),
     iiu ( iiuIn ),
@@ -51,10 +50,11 @@ searchTimer::searchTimer (
     retry ( 0 ),
     searchAttempts ( 0u ),
     searchResponses ( 0u ),
+    searchesSent ( 0u ),
     index ( indexIn ),
     dgSeqNoAtTimerExpireBegin ( 0u ),
     dgSeqNoAtTimerExpireEnd ( 0u ),
-    boostPossible ( boostPossibleIn ),
+    passIncomplete ( false ),
     stopped ( false )
 {
 }
@@ -104,6 +104,19 @@ void searchTimer::installChannel (
     chan.channelNode::setReqPendingState ( guard, this->index );
 }
 
+//
+// expire as soon as the guard is released, sending requests for all
+// of the channels installed in the meantime
+//
+void searchTimer::searchNow (
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    if ( ! this->stopped ) {
+        this->timer.start ( *this, 0.0 );
+    }
+}
+
 void searchTimer::moveChannels (
     epicsGuard < epicsMutex > & guard, searchTimer & dest )
 {
@@ -126,6 +139,18 @@ epicsTimerNotify::expireStatus searchTimer::expire (
 {
     epicsGuard < epicsMutex > guard ( this->mutex );
 
+    // come back when the search rate budget allows sending
+    double budgetDelay = this->iiu.searchBudgetDelay ( guard, currentTime );
+    if ( budgetDelay > 0.0 ) {
+        return expireStatus ( restart, budgetDelay );
+    }
+
+    if ( this->passIncomplete ) {
+        // the rest of a pass cut short by the search rate budget, the
+        // channels searched so far have yet to wait a full period
+        return this->sendRequests ( guard, currentTime );
+    }
+
     while ( nciu * pChan = this->chanListRespPending.get () ) {
         pChan->channelNode::listMember =
             channelNode::cs_none;
@@ -135,16 +160,6 @@ epicsTimerNotify::expireStatus searchTimer::expire (
 
     this->timeAtLastSend = currentTime;
 
-    // boost search period for channels not recently
-    // searched for if there was some success
-    if ( this->searchResponses && this->boostPossible ) {
-        while ( nciu * pChan = this->chanListReqPending.get () ) {
-            pChan->channelNode::listMember =
-                channelNode::cs_none;
-            this->iiu.boostChannel ( guard, *pChan );
-        }
-    }
-
     if ( this->searchAttempts ) {
 #if 0
         //
@@ -232,6 +247,18 @@ epicsTimerNotify::expireStatus searchTimer::expire (
     this->searchAttempts = 0;
     this->searchResponses = 0;
 
+    return this->sendRequests ( guard, currentTime );
+}
+
+//
+// searchTimer::sendRequests ()
+//
+epicsTimerNotify::expireStatus searchTimer::sendRequests (
+    epicsGuard < epicsMutex > & guard, const epicsTime & currentTime )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    double budgetDelay = 0.0;
     unsigned nFrameSent = 0u;
     while ( true ) {
         nciu * pChan = this->chanListReqPending.get ();
@@ -247,7 +274,11 @@ epicsTimerNotify::expireStatus searchTimer::expire (
             if ( this->iiu.datagramFlush ( guard, currentTime ) ) {
                 nFrameSent++;
                 if ( nFrameSent < this->framesPerTry ) {
-                    success = pChan->searchMsg ( guard );
+                    budgetDelay = this->iiu.searchBudgetDelay (
+                        guard, currentTime );
+                    if ( budgetDelay <= 0.0 ) {
+                        success = pChan->searchMsg ( guard );
+                    }
                 }
             }
             if ( ! success ) {
@@ -265,6 +296,7 @@ epicsTimerNotify::expireStatus searchTimer::expire (
         if ( this->searchAttempts < UINT_MAX ) {
             this->searchAttempts++;
         }
+        this->searchesSent++;
     }
 
     // flush out the search request buffer
@@ -284,7 +316,15 @@ epicsTimerNotify::expireStatus searchTimer::expire (
         }
 #   endif
 
-    return expireStatus ( restart, this->period ( guard ) );
+    // finish the pass as soon as the budget allows, rather than leaving
+    // the remaining channels for the next period
+    double delay = this->period ( guard );
+    this->passIncomplete = budgetDelay > 0.0 && budgetDelay < delay &&
+        this->chanListReqPending.count () > 0u;
+    if ( this->passIncomplete ) {
+        delay = budgetDelay;
+    }
+    return expireStatus ( restart, delay );
 }
 
 void searchTimer :: show ( unsigned level ) const
@@ -315,6 +355,17 @@ void searchTimer :: show ( unsigned level ) const
     }
 }
 
+void searchTimer :: showStatistics (
+    epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    ::printf ( "\t%2u %10.3f %8u %8u %12lu\n",
+        this->index, this->period ( guard ),
+        this->chanListReqPending.count (),
+        this->chanListRespPending.count (),
+        this->searchesSent );
+}
+
 //
 // Reset the delay to the next search request if we get
 // at least one response. However, don't reset this delay if we
@@ -37,8 +37,6 @@
 class searchTimerNotify {
 public:
     virtual ~searchTimerNotify () = 0;
-    virtual void boostChannel (
-        epicsGuard < epicsMutex > &, nciu & ) = 0;
     virtual void noSearchRespNotify (
         epicsGuard < epicsMutex > &, nciu &, unsigned ) = 0;
     virtual double getRTTE ( epicsGuard < epicsMutex > & ) const = 0;
@@ -46,16 +44,30 @@ public:
     virtual bool datagramFlush (
         epicsGuard < epicsMutex > &,
         const epicsTime & currentTime ) = 0;
+    // delay until the search rate budget allows another datagram
+    virtual double searchBudgetDelay (
+        epicsGuard < epicsMutex > &,
+        const epicsTime & currentTime ) = 0;
     virtual ca_uint32_t datagramSeqNumber (
         epicsGuard < epicsMutex > & ) const = 0;
 };
 
+// The timer a channel goes to when its search went unanswered: the
+// next slower one up to the beacon anomaly period, then the slowest.
+inline unsigned searchTimerNextIndex ( unsigned index,
+    unsigned beaconAnomalyIndex, unsigned nTimers )
+{
+    if ( index < beaconAnomalyIndex ) {
+        return index + 1u;
+    }
+    return nTimers - 1u;
+}
+
 class searchTimer : private epicsTimerNotify {
 public:
     searchTimer (
         class searchTimerNotify &, epicsTimerQueue &,
-        const unsigned index, epicsMutex &,
-        bool boostPossible );
+        const unsigned index, epicsMutex & );
     virtual ~searchTimer ();
     void start ( epicsGuard < epicsMutex > & );
     void shutdown (
@@ -65,6 +77,8 @@ public:
         epicsGuard < epicsMutex > &, searchTimer & dest );
     void installChannel (
         epicsGuard < epicsMutex > &, nciu & );
+    void searchNow (
+        epicsGuard < epicsMutex > & );
     void uninstallChan (
         epicsGuard < epicsMutex > &, nciu & );
     void uninstallChanDueToSuccessfulSearchResponse (
@@ -72,6 +86,7 @@ public:
         ca_uint32_t respDatagramSeqNo, bool seqNumberIsValid,
         const epicsTime & currentTime );
     void show ( unsigned level ) const;
+    void showStatistics ( epicsGuard < epicsMutex > & ) const;
 private:
     tsDLList < nciu > chanListReqPending;
     tsDLList < nciu > chanListRespPending;
@@ -84,13 +99,16 @@ private:
     unsigned retry;
     unsigned searchAttempts; /* num search tries after last timer expiration */
     unsigned searchResponses; /* num search resp after last timer expiration */
+    unsigned long searchesSent; /* total num search requests sent */
     const unsigned index;
     ca_uint32_t dgSeqNoAtTimerExpireBegin;
     ca_uint32_t dgSeqNoAtTimerExpireEnd;
-    const bool boostPossible;
+    bool passIncomplete; /* requests left unsent by the search rate budget */
     bool stopped;
 
     expireStatus expire ( const epicsTime & currentTime );
+    expireStatus sendRequests (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime );
     double period ( epicsGuard < epicsMutex > & ) const;
     searchTimer ( const searchTimer & ); // not implemented
     searchTimer & operator = ( const searchTimer & ); // not implemented
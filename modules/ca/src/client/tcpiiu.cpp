@@ -469,12 +469,20 @@ void tcpRecvThread::run ()
             // file manager call backs works correctly. This does not
             // appear to impact performance.
             //
-            if ( ! pComBuf ) {
-                pComBuf = new ( this->iiu.comBufMemMgr ) comBuf;
-            }
+            // the remainder of a large message body is received
+            // directly into the message body cache
+            bool direct = this->iiu.msgBodyRecvDirect ();
 
             statusWireIO stat;
-            pComBuf->fillFromWire ( this->iiu, stat );
+            if ( direct ) {
+                this->iiu.recvMsgBodyFromWire ( stat );
+            }
+            else {
+                if ( ! pComBuf ) {
+                    pComBuf = new ( this->iiu.comBufMemMgr ) comBuf;
+                }
+                pComBuf->fillFromWire ( this->iiu, stat );
+            }
 
             epicsTime currentTime = epicsTime::getCurrent ();
 
@@ -488,8 +496,10 @@ void tcpRecvThread::run ()
                     continue;
                 }
 
-                this->iiu.recvQue.pushLastComBufReceived ( *pComBuf );
-                pComBuf = 0;
+                if ( ! direct ) {
+                    this->iiu.recvQue.pushLastComBufReceived ( *pComBuf );
+                    pComBuf = 0;
+                }
 
                 this->iiu._receiveThreadIsBusy = true;
             }
@@ -702,6 +712,7 @@ tcpiiu::tcpiiu (
     socketLibrarySendBufferSize ( 0x1000 ),
     unacknowledgedSendBytes ( 0u ),
     channelCountTot ( 0u ),
+    directRecvBytes ( 0u ),
     _receiveThreadIsBusy ( false ),
     busyStateDetected ( false ),
     flowControlActive ( false ),
@@ -1029,15 +1040,7 @@ tcpiiu :: ~tcpiiu ()
 
     // free message body cache
     if ( this->pCurData ) {
-        if ( this->curDataMax <= MAX_TCP ) {
-            freeListFree(this->cacRef.tcpSmallRecvBufFreeList, this->pCurData);
-        }
-        else if ( this->cacRef.tcpLargeRecvBufFreeList ) {
-            freeListFree(this->cacRef.tcpLargeRecvBufFreeList, this->pCurData);
-        }
-        else {
-            free ( this->pCurData );
-        }
+        this->releaseMsgBodyCache ();
     }
 }
 
@@ -1056,6 +1059,8 @@ void tcpiiu::show ( unsigned level ) const
             this->contigRecvMsgCount, this->busyStateDetected, this->flowControlActive );
         ::printf ( "\receive thread is busy=%u\n",
             this->_receiveThreadIsBusy );
+        ::printf ( "\tmessage body bytes received directly=%lu\n",
+            static_cast < unsigned long > ( this->directRecvBytes ) );
     }
     if ( level > 2u ) {
         ::printf ( "\tvirtual circuit socket identifier %d\n", (int)this->sock );
@@ -1144,6 +1149,76 @@ void tcpiiu::flushIfRecvProcessRequested (
     }
 }
 
+//
+// True when only the body of a large message remains to be received,
+// and nothing of it is already queued.  Reading it straight into the
+// message body cache avoids staging it in comBufs and then copying it
+// out again.  Shorter remainders take the comBuf path so that several
+// small messages are still fetched with one recv call.
+//
+// only called by the recv thread
+//
+bool tcpiiu::msgBodyRecvDirect () const
+{
+    return this->msgHeaderAvailable &&
+        this->curMsg.m_postsize <= this->curDataMax &&
+        this->curMsg.m_postsize - this->curDataBytes >=
+            comBuf::capacityBytes () &&
+        this->recvQue.occupiedBytes () == 0u;
+}
+
+void tcpiiu::recvMsgBodyFromWire ( statusWireIO & stat )
+{
+    arrayElementCount remaining =
+        this->curMsg.m_postsize - this->curDataBytes;
+    if ( remaining > INT_MAX ) {
+        remaining = INT_MAX;
+    }
+    this->recvBytes ( &this->pCurData[this->curDataBytes],
+        static_cast < unsigned > ( remaining ), stat );
+    if ( stat.circuitState == swioConnected ) {
+        this->curDataBytes += stat.bytesCopied;
+        this->directRecvBytes += stat.bytesCopied;
+    }
+}
+
+void tcpiiu::releaseMsgBodyCache ()
+{
+    if ( this->curDataMax <= MAX_TCP ) {
+        freeListFree ( this->cacRef.tcpSmallRecvBufFreeList, this->pCurData );
+    }
+    else {
+        this->cacRef.tcpLargeRecvBufs.release ( this->pCurData,
+            static_cast < unsigned > ( this->curDataMax ) );
+    }
+    this->pCurData = 0;
+}
+
+//
+// Give a large message body cache back to the context's pool when the
+// receive queue runs empty and no large message has arrived for a while,
+// so that idle circuits do not keep one each while circuits receiving
+// arrays regularly keep theirs.  A circuit without any traffic still
+// gets here when the reply to its echo request arrives.
+//
+// only called by the recv thread
+//
+static const double msgBodyCacheIdleDelay = 5.0; // sec
+
+void tcpiiu::shrinkMsgBodyCache ( const epicsTime & currentTime )
+{
+    if ( this->curDataMax > MAX_TCP &&
+            currentTime - this->largeMsgBodyTime >= msgBodyCacheIdleDelay ) {
+        char * pSmall = static_cast < char * > (
+            freeListMalloc ( this->cacRef.tcpSmallRecvBufFreeList ) );
+        if ( pSmall ) {
+            this->releaseMsgBodyCache ();
+            this->pCurData = pSmall;
+            this->curDataMax = MAX_TCP;
+        }
+    }
+}
+
 bool tcpiiu::processIncoming (
     const epicsTime & currentTime,
     callbackManager & mgr )
@@ -1160,6 +1235,7 @@ bool tcpiiu::processIncoming (
                 this->oldMsgHeaderAvailable =
                     this->recvQue.popOldMsgHeader ( this->curMsg );
                 if ( ! this->oldMsgHeaderAvailable ) {
+                    this->shrinkMsgBodyCache ( currentTime );
                     epicsGuard < epicsMutex > guard ( this->mutex );
                     this->flushIfRecvProcessRequested ( guard );
                     return true;
@@ -1205,41 +1281,18 @@ bool tcpiiu::processIncoming (
         //
         // make sure we have a large enough message body cache
         //
+        if ( this->curMsg.m_postsize > MAX_TCP ) {
+            this->largeMsgBodyTime = currentTime;
+        }
         if ( this->curMsg.m_postsize > this->curDataMax ) {
             assert (this->curMsg.m_postsize > MAX_TCP);
 
-            char * newbuf = NULL;
-            arrayElementCount newsize;
-
-            if ( !this->cacRef.tcpLargeRecvBufFreeList ) {
-                // round size up to multiple of 4K
-                newsize = ((this->curMsg.m_postsize-1)|0xfff)+1;
-
-                if ( this->curDataMax <= MAX_TCP ) {
-                    // small -> large
-                    newbuf = (char*)malloc(newsize);
-
-                } else {
-                    // expand large to larger
-                    newbuf = (char*)realloc(this->pCurData, newsize);
-                }
-
-            } else if ( this->curMsg.m_postsize <= this->cacRef.maxRecvBytesTCP ) {
-                newbuf = (char*) freeListMalloc(this->cacRef.tcpLargeRecvBufFreeList);
-                newsize = this->cacRef.maxRecvBytesTCP;
-
-            }
+            unsigned newsize;
+            char * newbuf = this->cacRef.tcpLargeRecvBufs.allocate (
+                this->curMsg.m_postsize, newsize );
 
             if ( newbuf) {
-                if (this->curDataMax <= MAX_TCP) {
-                    freeListFree(this->cacRef.tcpSmallRecvBufFreeList, this->pCurData );
-
-                } else if (this->cacRef.tcpLargeRecvBufFreeList) {
-                    freeListFree(this->cacRef.tcpLargeRecvBufFreeList, this->pCurData );
-
-                } else {
-                    // called realloc()
-                }
+                this->releaseMsgBodyCache ();
                 this->pCurData = newbuf;
                 this->curDataMax = newsize;
 
@@ -0,0 +1,93 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Channel creation and connection benchmark.
+ *
+ * Creates count channels to a PV, usually served by a local IOC, once
+ * with a ca_create_channel() call for each and once with a single
+ * ca_create_channels() call, and reports how long the creation took
+ * and how long until all of the channels were connected.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epicsTime.h"
+#include "cadef.h"
+
+static unsigned connCount;
+
+extern "C" void connHandler ( struct connection_handler_args args )
+{
+    if ( args.op == CA_OP_CONN_UP ) {
+        connCount++;
+    }
+}
+
+static void runConnect ( const char * pName, unsigned count, bool bulk )
+{
+    chid * pChans = new chid [count];
+    const char ** pNames = new const char * [count];
+    unsigned i;
+
+    for ( i = 0u; i < count; i++ ) {
+        pNames[i] = pName;
+    }
+
+    SEVCHK ( ca_context_create ( ca_disable_preemptive_callback ),
+        "ca_context_create" );
+    connCount = 0u;
+
+    epicsUInt64 start = epicsMonotonicGet ();
+    if ( bulk ) {
+        SEVCHK ( ca_create_channels ( count, pNames, connHandler, 0,
+            CA_PRIORITY_DEFAULT, pChans ), "ca_create_channels" );
+    }
+    else {
+        for ( i = 0u; i < count; i++ ) {
+            SEVCHK ( ca_create_channel ( pNames[i], connHandler, 0,
+                CA_PRIORITY_DEFAULT, &pChans[i] ), "ca_create_channel" );
+        }
+    }
+    double created = ( epicsMonotonicGet () - start ) * 1e-9;
+
+    double connected;
+    do {
+        ca_pend_event ( 0.001 );
+        connected = ( epicsMonotonicGet () - start ) * 1e-9;
+    } while ( connCount < count && connected < 60.0 );
+
+    printf ( "%-20s %u channels created in %.3f sec, "
+        "%u connected after %.3f sec\n",
+        bulk ? "ca_create_channels" : "ca_create_channel",
+        count, created, connCount, connected );
+
+    for ( i = 0u; i < count; i++ ) {
+        ca_clear_channel ( pChans[i] );
+    }
+    ca_context_destroy ();
+
+    delete [] pNames;
+    delete [] pChans;
+}
+
+int main ( int argc, char ** argv )
+{
+    unsigned count = 10000u;
+
+    if ( argc < 2 || argc > 3 ) {
+        printf ( "usage: %s < channel name > [ < count > ]\n", argv[0] );
+        return -1;
+    }
+    if ( argc == 3 && sscanf ( argv[2], "%u", &count ) != 1 ) {
+        printf ( "bad channel count \"%s\"\n", argv[2] );
+        return -1;
+    }
+
+    runConnect ( argv[1], count, false );
+    runConnect ( argv[1], count, true );
+
+    return 0;
+}
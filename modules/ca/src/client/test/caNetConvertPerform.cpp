@@ -0,0 +1,130 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* caNetConvert() throughput benchmark.
+ *
+ * Converts arrays of each plain and DBR_TIME_xxx type to the network
+ * byte order and back, as rsrv and the client library do for every
+ * array update, and reports GB/s for each direction.  Also checks that
+ * the round trip leaves the values unchanged.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "db_access.h"
+#include "net_convert.h"
+#include "caerr.h"
+
+#define NELEMENTS_BENCH 100000
+#define MIN_SECONDS 0.2
+
+static const struct {
+    unsigned type;
+    const char *name;
+} types[] = {
+    {DBR_SHORT, "DBR_SHORT"},
+    {DBR_FLOAT, "DBR_FLOAT"},
+    {DBR_ENUM, "DBR_ENUM"},
+    {DBR_CHAR, "DBR_CHAR"},
+    {DBR_LONG, "DBR_LONG"},
+    {DBR_DOUBLE, "DBR_DOUBLE"},
+    {DBR_TIME_SHORT, "DBR_TIME_SHORT"},
+    {DBR_TIME_FLOAT, "DBR_TIME_FLOAT"},
+    {DBR_TIME_LONG, "DBR_TIME_LONG"},
+    {DBR_TIME_DOUBLE, "DBR_TIME_DOUBLE"},
+};
+
+template < class T >
+static void fill ( void * pValue, unsigned long count )
+{
+    T * p = static_cast < T * > ( pValue );
+    for ( unsigned long i = 0; i < count; i++ ) {
+        p[i] = static_cast < T > ( ( i * 2654435761u ) % 32749u ) / 2;
+    }
+}
+
+static void fillValues ( unsigned type, void * pDbr, unsigned long count )
+{
+    void * pValue = dbr_value_ptr ( pDbr, type );
+
+    /* DBR_TIME_xxx = DBR_xxx + 14 */
+    switch ( type % ( LAST_TYPE + 1 ) ) {
+    case DBF_SHORT: fill < dbr_short_t > ( pValue, count ); break;
+    case DBF_FLOAT: fill < dbr_float_t > ( pValue, count ); break;
+    case DBF_ENUM: fill < dbr_enum_t > ( pValue, count ); break;
+    case DBF_CHAR: fill < dbr_char_t > ( pValue, count ); break;
+    case DBF_LONG: fill < dbr_long_t > ( pValue, count ); break;
+    case DBF_DOUBLE: fill < dbr_double_t > ( pValue, count ); break;
+    }
+}
+
+/* Returns GB/s */
+static double measure ( unsigned type, const void * pSrc, void * pDest,
+    int hton, unsigned long count )
+{
+    size_t size = dbr_size_n ( type, count );
+    unsigned long reps = 0;
+    epicsUInt64 start = epicsMonotonicGet ();
+    double elapsed;
+
+    do {
+        for ( int i = 0; i < 10; i++ )
+            caNetConvert ( type, pSrc, pDest, hton, count );
+        reps += 10;
+        elapsed = ( epicsMonotonicGet () - start ) * 1e-9;
+    } while ( elapsed < MIN_SECONDS );
+    return size * reps / elapsed * 1e-9;
+}
+
+static void runType ( unsigned type, const char * name, unsigned long count )
+{
+    size_t size = dbr_size_n ( type, count );
+    void * pHost = calloc ( 1, size );
+    void * pNet = calloc ( 1, size );
+    void * pBack = calloc ( 1, size );
+
+    if ( ! pHost || ! pNet || ! pBack ) {
+        testAbort ( "caNetConvertPerform: out of memory" );
+    }
+    fillValues ( type, pHost, count );
+
+    int status = caNetConvert ( type, pHost, pNet, 1, count );
+    if ( status == ECA_NORMAL )
+        status = caNetConvert ( type, pNet, pBack, 0, count );
+    testOk ( status == ECA_NORMAL && memcmp ( pHost, pBack, size ) == 0,
+        "%s[%lu] round trip", name, count );
+
+    double toNet = measure ( type, pHost, pNet, 1, count );
+    double toHost = measure ( type, pNet, pBack, 0, count );
+    double inPlace = measure ( type, pBack, pBack, 0, count );
+    testDiag ( "%-16s to net %6.2f GB/s, to host %6.2f GB/s, "
+        "in place %6.2f GB/s", name, toNet, toHost, inPlace );
+
+    free ( pHost );
+    free ( pNet );
+    free ( pBack );
+}
+
+MAIN(caNetConvertPerform)
+{
+    const unsigned ntypes = sizeof ( types ) / sizeof ( types[0] );
+
+    testPlan ( 2 * ntypes );
+
+    for ( unsigned i = 0; i < ntypes; i++ ) {
+        runType ( types[i].type, types[i].name, NELEMENTS_BENCH );
+    }
+    /* odd length, exercising the ends of the block loops */
+    for ( unsigned i = 0; i < ntypes; i++ ) {
+        runType ( types[i].type, types[i].name, 1001 );
+    }
+
+    return testDone ();
+}
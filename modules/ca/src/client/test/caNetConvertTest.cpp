@@ -0,0 +1,220 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* caNetConvert() against a reference conversion, for every DBR type.
+ *
+ * The reference builds the network form of a buffer field by field from
+ * a description of each DBR structure: integers and IEEE floats big
+ * endian, strings and padding as they are.  Each type is converted to
+ * the network byte order and back, out of place and in place, with odd
+ * element counts so the ends of the block swap loops are exercised too.
+ * Padding bytes aren't compared.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsEndian.h"
+#include "epicsTypes.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "db_access.h"
+#include "net_convert.h"
+#include "caerr.h"
+
+/*
+ * Fields of the part of a DBR structure before the value:
+ *  2, 4    integer of that many bytes
+ *  f, d    dbr_float_t, dbr_double_t
+ *  c       dbr_char_t
+ *  u       units string
+ *  e       enum state strings
+ *  x       a padding byte
+ */
+static const char * const headers[LAST_BUFFER_TYPE + 1] = {
+    "", "", "", "", "", "", "",                 /* plain */
+    "22", "22", "22", "22", "22x", "22", "22xxxx",  /* sts */
+    "2244", "2244xx", "2244", "2244xx",         /* time */
+    "2244xxx", "2244", "2244xxxx",
+    "22", "22u222222", "222xxuffffff", "222e",  /* gr */
+    "22uccccccx", "22u444444", "222xxudddddd",
+    "22", "22u22222222", "222xxuffffffff", "222e",  /* ctrl */
+    "22uccccccccx", "22u44444444", "222xxudddddddd",
+    "", "", "2222", ""                          /* acks, class name */
+};
+
+/* Field letter of the value of a type */
+static char valueField ( unsigned type )
+{
+    static const char plain[] = "s2f2c4d";
+
+    if ( type <= DBR_CTRL_DOUBLE ) {
+        return plain[type % ( LAST_TYPE + 1 )];
+    }
+    if ( type == DBR_PUT_ACKT || type == DBR_PUT_ACKS ) {
+        return '2';
+    }
+    return 's';
+}
+
+static size_t fieldSize ( char field )
+{
+    switch ( field ) {
+    case 'x':
+    case 'c': return 1;
+    case '2': return 2;
+    case '4':
+    case 'f': return 4;
+    case 'd': return 8;
+    case 'u': return MAX_UNITS_SIZE;
+    case 'e': return MAX_ENUM_STATES * MAX_ENUM_STRING_SIZE;
+    case 's': return MAX_STRING_SIZE;
+    }
+    testAbort ( "caNetConvertTest: no field '%c'", field );
+    return 0;
+}
+
+/* Integer or IEEE float in host format to big endian */
+static void refField ( char field, const epicsUInt8 * pHost,
+    epicsUInt8 * pNet )
+{
+    epicsUInt64 bits;
+    size_t size = fieldSize ( field );
+
+    switch ( field ) {
+    case '2': {
+        epicsUInt16 v;
+        memcpy ( &v, pHost, 2 );
+        bits = v;
+        break;
+    }
+    case '4':
+    case 'f': {
+        epicsUInt32 v;
+        memcpy ( &v, pHost, 4 );
+        bits = v;
+        break;
+    }
+    case 'd':
+        memcpy ( &bits, pHost, 8 );
+#if EPICS_FLOAT_WORD_ORDER != EPICS_BYTE_ORDER
+        bits = ( bits << 32 ) | ( bits >> 32 );
+#endif
+        break;
+    default:
+        memcpy ( pNet, pHost, size );
+        return;
+    }
+    for ( size_t i = 0; i < size; i++ ) {
+        pNet[i] = static_cast < epicsUInt8 > (
+            bits >> ( 8 * ( size - 1 - i ) ) );
+    }
+}
+
+/* The network form of a buffer, and a mask of the bytes to compare */
+static void refConvert ( unsigned type, const epicsUInt8 * pHost,
+    epicsUInt8 * pNet, epicsUInt8 * pMask, unsigned long count )
+{
+    const char * pField = headers[type];
+    size_t offset = 0;
+
+    for ( ; *pField; pField++ ) {
+        size_t size = fieldSize ( *pField );
+        if ( *pField != 'x' ) {
+            refField ( *pField, pHost + offset, pNet + offset );
+            memset ( pMask + offset, 1, size );
+        }
+        offset += size;
+    }
+    if ( offset != dbr_value_offset[type] ||
+            fieldSize ( valueField ( type ) ) != dbr_value_size[type] ) {
+        testAbort ( "caNetConvertTest: wrong layout of %s",
+            dbr_text[type] );
+    }
+    for ( unsigned long i = 0; i < count; i++ ) {
+        refField ( valueField ( type ), pHost + offset, pNet + offset );
+        memset ( pMask + offset, 1, dbr_value_size[type] );
+        offset += dbr_value_size[type];
+    }
+}
+
+static bool sameUnmasked ( const epicsUInt8 * pA, const epicsUInt8 * pB,
+    const epicsUInt8 * pMask, size_t size )
+{
+    for ( size_t i = 0; i < size; i++ ) {
+        if ( pMask[i] && pA[i] != pB[i] ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testType ( unsigned type, unsigned long count )
+{
+    size_t size = dbr_size_n ( type, count );
+    epicsUInt8 * pHost = static_cast < epicsUInt8 * > ( calloc ( 1, size ) );
+    epicsUInt8 * pNet = static_cast < epicsUInt8 * > ( calloc ( 1, size ) );
+    epicsUInt8 * pMask = static_cast < epicsUInt8 * > ( calloc ( 1, size ) );
+    epicsUInt8 * pDest = static_cast < epicsUInt8 * > ( calloc ( 1, size ) );
+    epicsUInt32 seed = type * 1000u + count;
+
+    if ( ! pHost || ! pNet || ! pMask || ! pDest ) {
+        testAbort ( "caNetConvertTest: out of memory" );
+    }
+    for ( size_t i = 0; i < size; i++ ) {
+        seed = seed * 1664525u + 1013904223u;
+        pHost[i] = static_cast < epicsUInt8 > ( seed >> 24 );
+    }
+    refConvert ( type, pHost, pNet, pMask, count );
+
+    int status = caNetConvert ( type, pHost, pDest, 1, count );
+    bool toNet = status == ECA_NORMAL &&
+        sameUnmasked ( pDest, pNet, pMask, size );
+
+    status = caNetConvert ( type, pNet, pDest, 0, count );
+    bool toHost = status == ECA_NORMAL &&
+        sameUnmasked ( pDest, pHost, pMask, size );
+
+    memcpy ( pDest, pHost, size );
+    status = caNetConvert ( type, pDest, pDest, 1, count );
+    bool toNetInPlace = status == ECA_NORMAL &&
+        sameUnmasked ( pDest, pNet, pMask, size );
+
+    memcpy ( pDest, pNet, size );
+    status = caNetConvert ( type, pDest, pDest, 0, count );
+    bool toHostInPlace = status == ECA_NORMAL &&
+        sameUnmasked ( pDest, pHost, pMask, size );
+
+    testOk ( toNet && toHost && toNetInPlace && toHostInPlace,
+        "%s[%lu] to net %s, to host %s, in place %s, %s", dbr_text[type],
+        count, toNet ? "ok" : "FAILS", toHost ? "ok" : "FAILS",
+        toNetInPlace ? "ok" : "FAILS", toHostInPlace ? "ok" : "FAILS" );
+
+    free ( pHost );
+    free ( pNet );
+    free ( pMask );
+    free ( pDest );
+}
+
+MAIN(caNetConvertTest)
+{
+    static const unsigned long counts[] = { 1, 3, 1001 };
+    const unsigned ncounts = sizeof ( counts ) / sizeof ( counts[0] );
+
+    testPlan ( ( LAST_BUFFER_TYPE + 1 ) * ncounts + 1 );
+
+    for ( unsigned i = 0; i < ncounts; i++ ) {
+        for ( unsigned type = 0; type <= LAST_BUFFER_TYPE; type++ ) {
+            testType ( type, counts[i] );
+        }
+    }
+
+    epicsUInt8 buf[8];
+    testOk ( caNetConvert ( LAST_BUFFER_TYPE + 1, buf, buf, 1, 1 ) ==
+        ECA_BADTYPE, "invalid type rejected" );
+
+    return testDone ();
+}
@@ -0,0 +1,106 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* The search request rate limit (EPICS_CA_MAX_SEARCH_RATE) and the
+ * search timer an unanswered channel moves on to.
+ */
+
+#include <math.h>
+
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "searchRateLimit.h"
+#include "searchTimer.h"
+
+static bool near ( double a, double b )
+{
+    return fabs ( a - b ) < 1e-6;
+}
+
+static void testNoLimit ()
+{
+    epicsTime t0 = epicsTime::getCurrent ();
+    searchRateLimit limit ( 0.0, t0 );
+
+    testDiag ( "no search rate limit" );
+
+    limit.spend ( 1e9 );
+    testOk ( limit.delay ( t0 ) == 0.0, "no delay after 1e9 bytes" );
+    testOk ( limit.maxRate () == 0.0, "rate 0" );
+
+    searchRateLimit negative ( -1.0, t0 );
+    negative.spend ( 1e9 );
+    testOk ( negative.delay ( t0 ) == 0.0 && negative.maxRate () == 0.0,
+        "negative rate is no limit" );
+}
+
+static void testBucket ()
+{
+    const double rate = 10000.0;
+    epicsTime t0 = epicsTime::getCurrent ();
+    searchRateLimit limit ( rate, t0 );
+    double delay;
+
+    testDiag ( "%.0f bytes/sec", rate );
+
+    testOk ( limit.maxRate () == rate, "rate %.0f", limit.maxRate () );
+    testOk ( limit.delay ( t0 ) == 0.0, "starts with a full budget" );
+
+    limit.spend ( rate );
+    testOk ( limit.delay ( t0 ) == 0.0, "budget used up, no overdraw" );
+
+    limit.spend ( rate / 2.0 );
+    delay = limit.delay ( t0 );
+    testOk ( near ( delay, 0.5 ), "overdrawn by half a second, delay %g",
+        delay );
+
+    delay = limit.delay ( t0 + 0.25 );
+    testOk ( near ( delay, 0.25 ), "a quarter second later, delay %g",
+        delay );
+
+    delay = limit.delay ( t0 + 0.1 );
+    testOk ( near ( delay, 0.25 ), "no refill going back in time, delay %g",
+        delay );
+
+    delay = limit.delay ( t0 + 0.5 );
+    testOk ( delay == 0.0, "paid off after the delay" );
+
+    // ten seconds idle save up no more than one second's worth
+    limit.delay ( t0 + 10.5 );
+    limit.spend ( rate + rate / 10.0 );
+    delay = limit.delay ( t0 + 10.5 );
+    testOk ( near ( delay, 0.1 ), "refill capped at one second, delay %g",
+        delay );
+}
+
+static void testTiers ()
+{
+    const unsigned nTimers = 8u;
+
+    testDiag ( "unanswered searches, %u timers", nTimers );
+
+    testOk1 ( searchTimerNextIndex ( 0u, 3u, nTimers ) == 1u );
+    testOk1 ( searchTimerNextIndex ( 2u, 3u, nTimers ) == 3u );
+    testOk ( searchTimerNextIndex ( 3u, 3u, nTimers ) == nTimers - 1u,
+        "from the beacon anomaly timer to the slowest" );
+    testOk1 ( searchTimerNextIndex ( 5u, 3u, nTimers ) == nTimers - 1u );
+    testOk ( searchTimerNextIndex ( nTimers - 1u, 3u, nTimers ) ==
+        nTimers - 1u, "stays in the slowest" );
+    testOk ( searchTimerNextIndex ( nTimers - 2u, nTimers - 1u, nTimers ) ==
+        nTimers - 1u && searchTimerNextIndex ( nTimers - 1u, nTimers - 1u,
+        nTimers ) == nTimers - 1u,
+        "beacon anomaly timer the slowest" );
+}
+
+MAIN(caSearchPolicyTest)
+{
+    testPlan ( 17 );
+    testNoLimit ();
+    testBucket ();
+    testTiers ();
+    return testDone ();
+}
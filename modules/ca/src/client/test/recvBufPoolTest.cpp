@@ -0,0 +1,106 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* recvBufPool size classes, reuse of idle buffers and the size limit.
+ */
+
+#include <string.h>
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "caProto.h"
+#include "recvBufPool.h"
+
+static void testClasses ()
+{
+    recvBufPool pool;
+    unsigned capacity = 0u;
+
+    testDiag ( "size classes" );
+
+    char * pBuf = pool.allocate ( MAX_TCP + 8u, capacity );
+    testOk ( pBuf && capacity == 2u * MAX_TCP,
+        "%u bytes from the smallest class of %u", MAX_TCP + 8u, capacity );
+    memset ( pBuf, 0xa5, capacity );
+    pool.release ( pBuf, capacity );
+
+    pBuf = pool.allocate ( 2u * MAX_TCP + 8u, capacity );
+    testOk ( pBuf && capacity == 4u * MAX_TCP,
+        "%u bytes from the class of %u", 2u * MAX_TCP + 8u, capacity );
+    testOk ( pool.inUseBytes () == capacity, "%lu bytes in use",
+        static_cast < unsigned long > ( pool.inUseBytes () ) );
+    pool.release ( pBuf, capacity );
+    testOk ( pool.inUseBytes () == 0u, "none in use after the release" );
+
+    pBuf = pool.allocate ( 0x1000000u, capacity );
+    testOk ( pBuf && capacity == 0x1000000u,
+        "16 MiB without a limit, class of %u", capacity );
+    pool.release ( pBuf, capacity );
+    pool.show ( 1u );
+}
+
+static void testIdle ()
+{
+    recvBufPool pool;
+    char * pBufs[4];
+    unsigned capacity;
+
+    testDiag ( "idle buffers" );
+
+    pBufs[0] = pool.allocate ( 3u * MAX_TCP, capacity );
+    pool.release ( pBufs[0], capacity );
+    testOk ( pool.idleBytes () == capacity, "released buffer kept idle" );
+    pBufs[1] = pool.allocate ( 3u * MAX_TCP, capacity );
+    testOk ( pBufs[1] == pBufs[0] && pool.idleBytes () == 0u,
+        "idle buffer reused" );
+    pool.release ( pBufs[1], capacity );
+
+    for ( unsigned i = 0u; i < 4u; i++ ) {
+        pBufs[i] = pool.allocate ( 3u * MAX_TCP, capacity );
+    }
+    for ( unsigned i = 0u; i < 4u; i++ ) {
+        pool.release ( pBufs[i], capacity );
+    }
+    testOk ( pool.idleBytes () == 2u * capacity,
+        "%lu idle bytes, two buffers of %u kept of four",
+        static_cast < unsigned long > ( pool.idleBytes () ), capacity );
+    pool.show ( 1u );
+}
+
+static void testLimit ()
+{
+    const unsigned maxBytes = 100000u;
+    recvBufPool pool;
+    unsigned capacity = 0u;
+
+    testDiag ( "EPICS_CA_MAX_ARRAY_BYTES %u", maxBytes );
+    pool.setMaxBytes ( maxBytes );
+
+    char * pBuf = pool.allocate ( 4u * MAX_TCP + 8u, capacity );
+    testOk ( pBuf && capacity == maxBytes,
+        "the largest class is the limit, %u", capacity );
+    pool.release ( pBuf, capacity );
+
+    pBuf = pool.allocate ( maxBytes, capacity );
+    testOk ( pBuf && capacity == maxBytes, "%u bytes from the largest class",
+        maxBytes );
+    pool.release ( pBuf, capacity );
+
+    pBuf = pool.allocate ( maxBytes + 8u, capacity );
+    testOk ( ! pBuf, "%u bytes refused", maxBytes + 8u );
+    if ( pBuf ) {
+        pool.release ( pBuf, capacity );
+    }
+}
+
+MAIN(recvBufPoolTest)
+{
+    testPlan ( 11 );
+    testClasses ();
+    testIdle ();
+    testLimit ();
+    return testDone ();
+}
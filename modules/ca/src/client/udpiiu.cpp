@@ -93,6 +93,34 @@ double getMaxPeriod()
     return maxPeriod;
 }
 
+// search request bytes per second, zero for no limit
+static
+double getMaxSearchRate()
+{
+    double maxRate = 0.0;
+
+    const char * pVal = envGetConfigParamPtr ( & EPICS_CA_MAX_SEARCH_RATE );
+    if ( pVal && pVal[0] ) {
+        long longStatus = envGetDoubleConfigParam (
+            & EPICS_CA_MAX_SEARCH_RATE, & maxRate );
+        if ( longStatus || maxRate < 0.0 ) {
+            epicsPrintf ( "EPICS \"%s\" wasnt a positive real number\n",
+                            EPICS_CA_MAX_SEARCH_RATE.name );
+            epicsPrintf ( "Not limiting the search rate\n" );
+            maxRate = 0.0;
+        }
+        else if ( maxRate > 0.0 && maxRate < MAX_UDP_SEND ) {
+            epicsPrintf ( "\"%s\" out of range (low)\n",
+                            EPICS_CA_MAX_SEARCH_RATE.name );
+            maxRate = MAX_UDP_SEND;
+            epicsPrintf ( "Setting \"%s\" = %f bytes/sec\n",
+                EPICS_CA_MAX_SEARCH_RATE.name, maxRate );
+        }
+    }
+
+    return maxRate;
+}
+
 static
 unsigned getNTimers(double maxPeriod)
 {
@@ -132,6 +160,12 @@ udpiiu::udpiiu (
         m_repeaterTimerNotify, timerQueue, cbMutexIn, ctxNotifyIn ),
     govTmr ( *this, timerQueue, cacMutexIn ),
     maxPeriod ( getMaxPeriod() ),
+    searchLimit ( getMaxSearchRate(), epicsTime::getCurrent () ),
+    searchRateTime ( epicsTime::getCurrent () ),
+    searchRateBytes ( 0.0 ),
+    searchRate ( 0.0 ),
+    searchBytes ( 0.0 ),
+    searchDatagrams ( 0u ),
     rtteMean ( minRoundTripEstimate ),
     rtteMeanDev ( 0 ),
     cacRef ( cac ),
@@ -160,8 +194,7 @@ udpiiu::udpiiu (
 
     for ( unsigned i = 0; i < this->nTimers; i++ ) {
         this->ppSearchTmr[i].reset (
-            new searchTimer ( *this, timerQueue, i, cacMutexIn,
-                i > this->beaconAnomalyTimerIndex ) );
+            new searchTimer ( *this, timerQueue, i, cacMutexIn ) );
     }
 
     this->repeaterPort =
@@ -1131,6 +1164,19 @@ bool udpiiu :: datagramFlush (
         iter++;
     }
 
+    double nBytes = static_cast < double > ( this->nBytesInXmitBuf ) *
+        _searchDestList.count ();
+    this->searchLimit.spend ( nBytes );
+    this->searchBytes += nBytes;
+    this->searchDatagrams++;
+    this->searchRateBytes += nBytes;
+    double elapsed = currentTime - this->searchRateTime;
+    if ( elapsed >= searchRateWindow ) {
+        this->searchRate = this->searchRateBytes / elapsed;
+        this->searchRateBytes = 0.0;
+        this->searchRateTime = currentTime;
+    }
+
     this->nBytesInXmitBuf = 0u;
 
     this->pushVersionMsg ();
@@ -1138,6 +1184,49 @@ bool udpiiu :: datagramFlush (
     return true;
 }
 
+//
+// Search requests are limited to EPICS_CA_MAX_SEARCH_RATE bytes per
+// second by a token bucket, see searchRateLimit.h.
+//
+double udpiiu :: searchBudgetDelay (
+    epicsGuard < epicsMutex > & guard, const epicsTime & currentTime )
+{
+    guard.assertIdenticalMutex ( cacMutex );
+
+    double delay = this->searchLimit.delay ( currentTime );
+    if ( delay <= 0.0 ) {
+        return 0.0;
+    }
+    // not shorter than the timer queue can tell apart
+    return epicsMax ( delay, minRoundTripEstimate );
+}
+
+void udpiiu :: showSearch ( unsigned level ) const
+{
+    epicsGuard < epicsMutex > guard ( this->cacMutex );
+
+    double elapsed = epicsTime::getCurrent () - this->searchRateTime;
+    double rate = this->searchRate;
+    if ( elapsed >= searchRateWindow ) {
+        rate = this->searchRateBytes / elapsed;
+    }
+    ::printf ( "Search requests: %lu datagrams, %.0f bytes sent, "
+        "%.0f bytes/sec recently",
+        this->searchDatagrams, this->searchBytes, rate );
+    if ( this->searchLimit.maxRate () > 0.0 ) {
+        ::printf ( ", limit %.0f bytes/sec\n", this->searchLimit.maxRate () );
+    }
+    else {
+        ::printf ( ", no limit\n" );
+    }
+    if ( level > 0u ) {
+        ::printf ( "\ttier period/s  req pend resp pend     searches\n" );
+        for ( unsigned i = 0; i < this->nTimers; i++ ) {
+            this->ppSearchTmr[i]->showStatistics ( guard );
+        }
+    }
+}
+
 void udpiiu :: show ( unsigned level ) const
 {
     epicsGuard < epicsMutex > guard ( this->cacMutex );
@@ -1257,6 +1346,13 @@ void udpiiu::installNewChannel (
     this->ppSearchTmr[0]->installChannel ( guard, chan );
 }
 
+// new channels are installed in the first timer
+void udpiiu::searchNow (
+    epicsGuard < epicsMutex > & guard )
+{
+    this->ppSearchTmr[0]->searchNow ( guard );
+}
+
 void udpiiu::installDisconnectedChannel (
     epicsGuard < epicsMutex > & guard, nciu & chan )
 {
@@ -1264,26 +1360,21 @@ void udpiiu::installDisconnectedChannel (
     this->govTmr.installChan ( guard, chan );
 }
 
+//
+// A channel moves to the next slower timer after each unanswered
+// search, until it has gone unanswered with the period used after
+// a beacon anomaly.  Such a name is unlikely to be resolved before
+// a server starts or restarts, so it then waits in the slowest timer
+// until a beacon anomaly moves it back.
+//
 void udpiiu::noSearchRespNotify (
     epicsGuard < epicsMutex > & guard, nciu & chan, unsigned index )
 {
-    const unsigned nTimersMinusOne = this->nTimers - 1;
-    if ( index < nTimersMinusOne ) {
-        index++;
-    }
-    else {
-        index = nTimersMinusOne;
-    }
+    index = searchTimerNextIndex ( index,
+        this->beaconAnomalyTimerIndex, this->nTimers );
     this->ppSearchTmr[index]->installChannel ( guard, chan );
 }
 
-void udpiiu::boostChannel (
-    epicsGuard < epicsMutex > & guard, nciu & chan )
-{
-    this->ppSearchTmr[this->beaconAnomalyTimerIndex]->
-            installChannel ( guard, chan );
-}
-
 void udpiiu::govExpireNotify (
     epicsGuard < epicsMutex > & guard, nciu & chan )
 {
@@ -36,6 +36,7 @@
 #include "libCaAPI.h"
 #include "netiiu.h"
 #include "searchTimer.h"
+#include "searchRateLimit.h"
 #include "disconnectGovernorTimer.h"
 #include "repeaterSubscribeTimer.h"
 #include "SearchDest.h"
@@ -87,6 +88,7 @@ static const double maxRoundTripEstimate = 30; // seconds
 static const double maxSearchPeriodDefault = 5.0 * 60.0; // seconds
 static const double maxSearchPeriodLowerLimit = 60.0; // seconds
 static const double beaconAnomalySearchPeriod = 5.0; // seconds
+static const double searchRateWindow = 10.0; // seconds
 
 class udpiiu :
     private netiiu,
@@ -107,11 +109,14 @@ public:
         epicsGuard < epicsMutex > &, nciu &, netiiu * & );
     void installDisconnectedChannel (
         epicsGuard < epicsMutex > &, nciu & );
+    void searchNow (
+        epicsGuard < epicsMutex > & );
     void beaconAnomalyNotify (
         epicsGuard < epicsMutex > & guard );
     void shutdown ( epicsGuard < epicsMutex > & cbGuard,
         epicsGuard < epicsMutex > & guard );
     void show ( unsigned level ) const;
+    void showSearch ( unsigned level ) const;
 
     // exceptions
     class noSocket {};
@@ -165,6 +170,12 @@ private:
     disconnectGovernorTimer govTmr;
     tsDLList < SearchDest > _searchDestList;
     const double maxPeriod;
+    searchRateLimit searchLimit;
+    epicsTime searchRateTime; // begin of the current rate window
+    double searchRateBytes; // sent in the current rate window
+    double searchRate; // bytes per second in the previous rate window
+    double searchBytes;
+    unsigned long searchDatagrams;
     double rtteMean;
     double rtteMeanDev;
     cac & cacRef;
@@ -293,12 +304,12 @@ private:
     double getRTTE ( epicsGuard < epicsMutex > & ) const;
     void updateRTTE ( epicsGuard < epicsMutex > &, double rtte );
     bool pushVersionMsg ();
-    void boostChannel (
-        epicsGuard < epicsMutex > & guard, nciu & chan );
     void noSearchRespNotify (
         epicsGuard < epicsMutex > &, nciu & chan, unsigned index );
     bool datagramFlush (
         epicsGuard < epicsMutex > &, const epicsTime & currentTime );
+    double searchBudgetDelay (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime );
     ca_uint32_t datagramSeqNumber (
         epicsGuard < epicsMutex > & ) const;
 
@@ -224,6 +224,7 @@ private:
     caHdrLargeArray curMsg;
     arrayElementCount curDataMax;
     arrayElementCount curDataBytes;
+    epicsTime largeMsgBodyTime; // of the last message larger than MAX_TCP
     comBufMemoryManager & comBufMemMgr;
     cac & cacRef;
     char * pCurData;
@@ -246,6 +247,7 @@ private:
     unsigned socketLibrarySendBufferSize;
     unsigned unacknowledgedSendBytes;
     unsigned channelCountTot;
+    size_t directRecvBytes; // only modified by the recv thread
     bool _receiveThreadIsBusy;
     bool busyStateDetected; // only modified by the recv thread
     bool flowControlActive; // only modified by the send process thread
@@ -264,6 +266,10 @@ private:
         unsigned nBytesInBuf, const epicsTime & currentTime );
     void recvBytes (
         void * pBuf, unsigned nBytesInBuf, statusWireIO & );
+    bool msgBodyRecvDirect () const;
+    void releaseMsgBodyCache ();
+    void shrinkMsgBodyCache ( const epicsTime & currentTime );
+    void recvMsgBodyFromWire ( statusWireIO & );
     const char * pHostName (
         epicsGuard < epicsMutex > & ) const throw ();
     double receiveWatchdogDelay (
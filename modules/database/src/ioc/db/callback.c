@@ -20,15 +20,18 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include "cantProceed.h"
 #include "dbDefs.h"
 #include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsInterrupt.h"
-#include "epicsRingPointer.h"
+#include "epicsMutex.h"
+#include "epicsRingBytes.h"
 #include "epicsString.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
 #include "epicsTimer.h"
 #include "errlog.h"
 #include "errMdef.h"
@@ -49,12 +52,158 @@
 
 
 static int callbackQueueSize = 2000;
+static int callbackQueueGrowth = 0;     /* KiB per priority */
+
+/* A queued request, with its time of queueing for latency statistics */
+typedef struct cbEntry {
+    epicsCallback *pcallback;
+    epicsUInt64 queued;
+} cbEntry;
+
+/* Lock-free multi-producer multi-consumer ring (after D. Vyukov).  Each
+ * slot carries a sequence number telling producers and consumers whose
+ * turn it is, so neither side needs a lock and the ring index they race
+ * for is the only shared write.
+ */
+typedef struct cbSlot {
+    size_t seq;
+    cbEntry entry;
+} cbSlot;
+
+#define CB_CACHE_LINE 64
+
+typedef struct cbRing {
+    size_t head;            /* next to pop */
+    char pad1[CB_CACHE_LINE - sizeof(size_t)];
+    size_t tail;            /* next to push */
+    char pad2[CB_CACHE_LINE - sizeof(size_t)];
+    size_t mask;
+    size_t highWater;
+    cbSlot *slots;
+} cbRing;
+
+static cbRing *cbRingCreate(int size)
+{
+    cbRing *ring = callocMustSucceed(1, sizeof(cbRing), "cbRingCreate");
+    size_t n = 2, i;
+
+    while (n < (size_t) size)
+        n <<= 1;
+    ring->mask = n - 1;
+    ring->slots = callocMustSucceed(n, sizeof(cbSlot), "cbRingCreate");
+    for (i = 0; i < n; i++)
+        ring->slots[i].seq = i;
+    return ring;
+}
+
+static void cbRingDelete(cbRing *ring)
+{
+    free(ring->slots);
+    free(ring);
+}
+
+static int cbRingPush(cbRing *ring, const cbEntry *pentry)
+{
+    size_t pos = epicsAtomicGetSizeT(&ring->tail);
+    size_t used;
+    cbSlot *slot;
+
+    for (;;) {
+        size_t seq;
+
+        slot = &ring->slots[pos & ring->mask];
+        seq = epicsAtomicGetSizeT(&slot->seq);
+        if (seq == pos) {
+            size_t prev = epicsAtomicCmpAndSwapSizeT(&ring->tail, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        } else if ((ptrdiff_t) (seq - pos) < 0) {
+            return 0;   /* full */
+        } else {
+            pos = epicsAtomicGetSizeT(&ring->tail);
+        }
+    }
+    slot->entry = *pentry;
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetSizeT(&slot->seq, pos + 1);
+
+    /* racy, but only statistics */
+    used = pos + 1 - epicsAtomicGetSizeT(&ring->head);
+    if (used > ring->highWater && used <= ring->mask + 1)
+        ring->highWater = used;
+    return 1;
+}
+
+static int cbRingPop(cbRing *ring, cbEntry *pentry)
+{
+    size_t pos = epicsAtomicGetSizeT(&ring->head);
+    cbSlot *slot;
+
+    for (;;) {
+        size_t seq;
+
+        slot = &ring->slots[pos & ring->mask];
+        seq = epicsAtomicGetSizeT(&slot->seq);
+        if (seq == pos + 1) {
+            size_t prev = epicsAtomicCmpAndSwapSizeT(&ring->head, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        } else if ((ptrdiff_t) (seq - (pos + 1)) < 0) {
+            return 0;   /* empty */
+        } else {
+            pos = epicsAtomicGetSizeT(&ring->head);
+        }
+    }
+    *pentry = slot->entry;
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetSizeT(&slot->seq, pos + ring->mask + 1);
+    return 1;
+}
+
+static int cbRingUsed(cbRing *ring)
+{
+    size_t head = epicsAtomicGetSizeT(&ring->head);
+    size_t tail = epicsAtomicGetSizeT(&ring->tail);
+
+    return tail > head ? (int) (tail - head) : 0;
+}
+
+/* Requests which find a full queue go to a list of overflow blocks, if
+ * callbackSetQueueGrowth() allowed any.  While it holds requests all new
+ * ones are appended there too, which keeps them in order.
+ */
+#define CB_BLOCK_ENTRIES 256
+
+typedef struct cbBlock {
+    struct cbBlock *next;
+    int first;                  /* next to pop */
+    int last;                   /* next to push */
+    cbEntry entries[CB_BLOCK_ENTRIES];
+} cbBlock;
+
+/* Time in queue histogram, bin n counts latencies of 2^n..2^(n+1)-1 ns */
+#define CB_LATENCY_BINS 40
 
 typedef struct cbQueueSet {
     epicsEventId semWakeUp;
-    epicsRingPointerId queue;
+    epicsRingBytesId queue;     /* of cbEntry, unless lock-free */
+    cbRing *ring;               /* if lock-free */
+    int threadsIdle;            /* waiting for semWakeUp, use atomic */
     int queueOverflow;
     int queueOverflows;
+    epicsMutexId overflowLock;  /* if growth allowed */
+    cbBlock *overflowHead;
+    cbBlock *overflowTail;
+    cbBlock *overflowSpare;     /* kept when drained */
+    int overflowUsed;           /* entries in blocks, use atomic */
+    int overflowHighWater;
+    int blocks;                 /* allocated, including the spare */
+    int blocksMax;
+    int growths;                /* blocks allocated since callbackInit() */
+    size_t latency[CB_LATENCY_BINS]; /* use atomic */
+    epicsUInt64 latencyMax;
     int shutdown; // use atomic
     int threadsConfigured;
     int threadsRunning;
@@ -69,6 +218,12 @@ int callbackThreadsDefault = 1;
 int callbackParallelThreadsDefault = 2;
 epicsExportAddress(int,callbackParallelThreadsDefault);
 
+int callbackLockFree = 0;
+epicsExportAddress(int,callbackLockFree);
+
+int callbackQueueTiming = 0;
+epicsExportAddress(int,callbackQueueTiming);
+
 /* Timer for Delayed Requests */
 static epicsTimerQueueId timerQueue;
 
@@ -108,18 +263,40 @@ int callbackSetQueueSize(int size)
     return 0;
 }
 
+int callbackSetQueueGrowth(int kbytes)
+{
+    if (epicsAtomicGetIntT(&cbState)!=cbInit) {
+        fprintf(stderr, "Callback system already initialized\n");
+        return -1;
+    }
+    callbackQueueGrowth = kbytes;
+    return 0;
+}
+
 int callbackQueueStatus(const int reset, callbackQueueStats *result)
 {
     int ret;
     if (epicsAtomicGetIntT(&cbState)==cbInit) return -1;
     if (result) {
         int prio;
-        result->size = callbackQueueSize;
+        result->size = callbackQueue[0].ring ?
+            (int) callbackQueue[0].ring->mask + 1 : callbackQueueSize;
         for(prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsRingPointerId qId = callbackQueue[prio].queue;
-            result->numUsed[prio] = epicsRingPointerGetUsed(qId);
-            result->maxUsed[prio] = epicsRingPointerGetHighWaterMark(qId);
-            result->numOverflow[prio] = epicsAtomicGetIntT(&callbackQueue[prio].queueOverflows);
+            cbQueueSet *mySet = &callbackQueue[prio];
+            if (mySet->ring) {
+                result->numUsed[prio] = cbRingUsed(mySet->ring);
+                result->maxUsed[prio] = (int) mySet->ring->highWater;
+            } else {
+                result->numUsed[prio] = epicsRingBytesUsedBytes(mySet->queue)
+                    / (int) sizeof(cbEntry);
+                result->maxUsed[prio] = epicsRingBytesHighWaterMark(mySet->queue)
+                    / (int) sizeof(cbEntry);
+            }
+            /* the overflow blocks only fill up behind a full queue */
+            result->numUsed[prio] += epicsAtomicGetIntT(&mySet->overflowUsed);
+            if (mySet->overflowHighWater)
+                result->maxUsed[prio] = result->size + mySet->overflowHighWater;
+            result->numOverflow[prio] = epicsAtomicGetIntT(&mySet->queueOverflows);
         }
         ret = 0;
     } else {
@@ -128,20 +305,71 @@ int callbackQueueStatus(const int reset, callbackQueueStats *result)
     if (reset) {
         int prio;
         for(prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsRingPointerResetHighWaterMark(callbackQueue[prio].queue);
+            cbQueueSet *mySet = &callbackQueue[prio];
+            int bin;
+            if (mySet->ring)
+                mySet->ring->highWater = 0;
+            else
+                epicsRingBytesResetHighWaterMark(mySet->queue);
+            mySet->overflowHighWater = 0;
+            for (bin = 0; bin < CB_LATENCY_BINS; bin++)
+                epicsAtomicSetSizeT(&mySet->latency[bin], 0);
+            mySet->latencyMax = 0;
         }
     }
     return ret;
 }
 
+/* Time in queue in microseconds not exceeded by the fraction frac of
+ * the requests counted in hist, interpolated within the bin it falls in
+ * but not beyond the longest time seen.
+ */
+static double latencyPercentile(const size_t *hist, size_t count,
+    double frac, double max)
+{
+    double target = frac * count;
+    double sum = 0.0;
+    int bin;
+
+    for (bin = 0; bin < CB_LATENCY_BINS; bin++) {
+        if (hist[bin] && sum + hist[bin] >= target) {
+            double lo = bin ? ldexp(1.0, bin) : 0.0;
+            double hi = ldexp(1.0, bin + 1);
+            double val = (lo + (hi - lo) * (target - sum) / hist[bin]) * 1e-3;
+            return val < max ? val : max;
+        }
+        sum += hist[bin];
+    }
+    return 0.0;
+}
+
 void callbackQueueShow(const int reset)
 {
     callbackQueueStats stats;
+    size_t hist[NUM_CALLBACK_PRIORITIES][CB_LATENCY_BINS];
+    size_t count[NUM_CALLBACK_PRIORITIES];
+    double latencyMax[NUM_CALLBACK_PRIORITIES];
+    int growths[NUM_CALLBACK_PRIORITIES];
+    int grownMax[NUM_CALLBACK_PRIORITIES];
+    int prio, bin;
+
+    /* before a reset by callbackQueueStatus() */
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        cbQueueSet *mySet = &callbackQueue[prio];
+        count[prio] = 0;
+        for (bin = 0; bin < CB_LATENCY_BINS; bin++) {
+            hist[prio][bin] = epicsAtomicGetSizeT(&mySet->latency[bin]);
+            count[prio] += hist[prio][bin];
+        }
+        latencyMax[prio] = mySet->latencyMax * 1e-3;
+        growths[prio] = mySet->growths;
+        grownMax[prio] = mySet->overflowHighWater;
+    }
+
     if (callbackQueueStatus(reset, &stats) == -1) {
         fprintf(stderr, "Callback system not initialized, yet. Please run "
             "iocInit before using this command.\n");
     } else {
-        int prio;
         printf("PRIORITY  HIGH-WATER MARK  ITEMS IN Q  Q SIZE  %% USED  Q OVERFLOWS\n");
         for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
             double qusage = 100.0 * stats.numUsed[prio] / stats.size;
@@ -150,6 +378,20 @@ void callbackQueueShow(const int reset)
                    stats.numUsed[prio], stats.size, qusage,
                    stats.numOverflow[prio]);
         }
+        printf("\nPRIORITY  Q GROWTHS  GROWN HIGH-WATER  REQUESTS RUN"
+               "  P50 us  P90 us  P99 us  MAX us\n");
+        for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+            printf("%8s  %9d  %16d  %12lu  %6.1f  %6.1f  %6.1f  %6.1f\n",
+                   threadNamePrefix[prio], growths[prio], grownMax[prio],
+                   (unsigned long) count[prio],
+                   latencyPercentile(hist[prio], count[prio], 0.5,
+                       latencyMax[prio]),
+                   latencyPercentile(hist[prio], count[prio], 0.9,
+                       latencyMax[prio]),
+                   latencyPercentile(hist[prio], count[prio], 0.99,
+                       latencyMax[prio]),
+                   latencyMax[prio]);
+        }
     }
 }
 
@@ -203,6 +445,112 @@ found:
     return 0;
 }
 
+static int overflowPush(cbQueueSet *mySet, const cbEntry *pentry)
+{
+    cbBlock *block;
+    int used;
+
+    epicsMutexMustLock(mySet->overflowLock);
+    block = mySet->overflowTail;
+    if (!block || block->last == CB_BLOCK_ENTRIES) {
+        if (mySet->overflowSpare) {
+            block = mySet->overflowSpare;
+            mySet->overflowSpare = NULL;
+        } else if (mySet->blocks < mySet->blocksMax &&
+                   (block = malloc(sizeof(cbBlock)))) {
+            mySet->blocks++;
+            mySet->growths++;
+        } else {
+            epicsMutexUnlock(mySet->overflowLock);
+            return 0;
+        }
+        block->next = NULL;
+        block->first = block->last = 0;
+        if (mySet->overflowTail)
+            mySet->overflowTail->next = block;
+        else
+            mySet->overflowHead = block;
+        mySet->overflowTail = block;
+    }
+    block->entries[block->last++] = *pentry;
+    used = mySet->overflowUsed + 1;
+    epicsAtomicSetIntT(&mySet->overflowUsed, used);
+    if (used > mySet->overflowHighWater)
+        mySet->overflowHighWater = used;
+    epicsMutexUnlock(mySet->overflowLock);
+    return 1;
+}
+
+static int overflowPop(cbQueueSet *mySet, cbEntry *pentry)
+{
+    cbBlock *block;
+    int popOK = 0;
+
+    epicsMutexMustLock(mySet->overflowLock);
+    block = mySet->overflowHead;
+    if (block) {
+        *pentry = block->entries[block->first++];
+        epicsAtomicSetIntT(&mySet->overflowUsed, mySet->overflowUsed - 1);
+        popOK = 1;
+        if (block->first == block->last) {
+            mySet->overflowHead = block->next;
+            if (!block->next)
+                mySet->overflowTail = NULL;
+            if (!mySet->overflowSpare) {
+                mySet->overflowSpare = block;
+            } else {
+                free(block);
+                mySet->blocks--;
+            }
+        }
+    }
+    epicsMutexUnlock(mySet->overflowLock);
+    return popOK;
+}
+
+static int queuePush(cbQueueSet *mySet, const cbEntry *pentry)
+{
+    if (mySet->ring)
+        return cbRingPush(mySet->ring, pentry);
+    return epicsRingBytesPut(mySet->queue, (char *) pentry,
+        sizeof(cbEntry)) == sizeof(cbEntry);
+}
+
+static int queueIsEmpty(cbQueueSet *mySet)
+{
+    if (epicsAtomicGetIntT(&mySet->overflowUsed))
+        return 0;
+    if (mySet->ring)
+        return cbRingUsed(mySet->ring) == 0;
+    return epicsRingBytesIsEmpty(mySet->queue);
+}
+
+/* Requests in the queue are older than those in the overflow blocks */
+static int queuePop(cbQueueSet *mySet, cbEntry *pentry)
+{
+    if (mySet->ring) {
+        if (cbRingPop(mySet->ring, pentry))
+            return 1;
+    } else if (epicsRingBytesGet(mySet->queue, (char *) pentry,
+                   sizeof(cbEntry)) == sizeof(cbEntry)) {
+        return 1;
+    }
+    return epicsAtomicGetIntT(&mySet->overflowUsed) &&
+        overflowPop(mySet, pentry);
+}
+
+static void latencyAdd(cbQueueSet *mySet, epicsUInt64 ns)
+{
+    int bin = 0;
+
+    while (bin < CB_LATENCY_BINS - 1 && (ns >> (bin + 1)))
+        bin++;
+    epicsAtomicIncrSizeT(&mySet->latency[bin]);
+    /* racy, but only statistics */
+    if (ns > mySet->latencyMax)
+        mySet->latencyMax = ns;
+}
+
 static void callbackTask(void *arg)
 {
     int prio = *(int*)arg;
@@ -212,14 +560,26 @@ static void callbackTask(void *arg)
     epicsEventSignal(startStopEvent);
 
     while(!epicsAtomicGetIntT(&mySet->shutdown)) {
-        void *ptr;
-        if (epicsRingPointerIsEmpty(mySet->queue))
+        cbEntry entry;
+
+        /* Requests only signal semWakeUp while a thread is idle.  The
+         * atomic increment orders it before the check of the queue, as
+         * callbackRequest() orders its push before the check of idle.
+         */
+        epicsAtomicIncrIntT(&mySet->threadsIdle);
+        if (queueIsEmpty(mySet))
             epicsEventMustWait(mySet->semWakeUp);
+        epicsAtomicDecrIntT(&mySet->threadsIdle);
 
-        while ((ptr = epicsRingPointerPop(mySet->queue))) {
-            epicsCallback *pcallback = (epicsCallback *)ptr;
-            if(!epicsRingPointerIsEmpty(mySet->queue))
+        while (queuePop(mySet, &entry)) {
+            epicsCallback *pcallback = entry.pcallback;
+
+            /* pass the wakeup on to another idle thread */
+            if (!queueIsEmpty(mySet) &&
+                epicsAtomicGetIntT(&mySet->threadsIdle))
                 epicsEventMustTrigger(mySet->semWakeUp);
+            if (entry.queued)
+                latencyAdd(mySet, epicsMonotonicGet() - entry.queued);
             mySet->queueOverflow = FALSE;
             (*pcallback->callback)(pcallback);
         }
@@ -269,8 +629,20 @@ void callbackCleanup(void)
         assert(epicsAtomicGetIntT(&mySet->threadsRunning)==0);
         epicsEventDestroy(mySet->semWakeUp);
         mySet->semWakeUp = NULL;
-        epicsRingPointerDelete(mySet->queue);
+        if (mySet->ring)
+            cbRingDelete(mySet->ring);
+        else
+            epicsRingBytesDelete(mySet->queue);
         mySet->queue = NULL;
+        mySet->ring = NULL;
+        while (mySet->overflowHead) {
+            cbBlock *block = mySet->overflowHead;
+            mySet->overflowHead = block->next;
+            free(block);
+        }
+        free(mySet->overflowSpare);
+        if (mySet->overflowLock)
+            epicsMutexDestroy(mySet->overflowLock);
         free(mySet->threads);
         mySet->threads = NULL;
     }
@@ -299,11 +671,21 @@ void callbackInit(void)
         epicsThreadId tid;
 
         callbackQueue[i].semWakeUp = epicsEventMustCreate(epicsEventEmpty);
-        callbackQueue[i].queue = epicsRingPointerLockedCreate(callbackQueueSize);
-        if (callbackQueue[i].queue == 0)
-            cantProceed("epicsRingPointerLockedCreate failed for %s\n",
-                threadNamePrefix[i]);
+        if (callbackLockFree) {
+            callbackQueue[i].ring = cbRingCreate(callbackQueueSize);
+        } else {
+            callbackQueue[i].queue = epicsRingBytesLockedCreate(
+                callbackQueueSize * sizeof(cbEntry));
+            if (callbackQueue[i].queue == 0)
+                cantProceed("epicsRingBytesLockedCreate failed for %s\n",
+                    threadNamePrefix[i]);
+        }
         callbackQueue[i].queueOverflow = FALSE;
+        /* whole blocks only, less than one allows no growth */
+        callbackQueue[i].blocksMax = callbackQueueGrowth > 0 ?
+            (int) (callbackQueueGrowth * 1024.0 / sizeof(cbBlock)) : 0;
+        if (callbackQueue[i].blocksMax)
+            callbackQueue[i].overflowLock = epicsMutexMustCreate();
 
         if (callbackQueue[i].threadsConfigured == 0)
             callbackQueue[i].threadsConfigured = callbackThreadsDefault;
@@ -339,6 +721,7 @@ int callbackRequest(epicsCallback *pcallback)
     int priority;
     int pushOK;
     cbQueueSet *mySet;
+    cbEntry entry;
 
     if (!pcallback) {
         epicsInterruptContextMessage("callbackRequest: " ERL_ERROR " pcallback was NULL\n");
@@ -354,13 +737,27 @@ int callbackRequest(epicsCallback *pcallback)
         return S_db_badChoice;
     }
     mySet = &callbackQueue[priority];
-    if (!mySet->queue) {
+    if (!mySet->queue && !mySet->ring) {
         epicsInterruptContextMessage("callbackRequest: " ERL_ERROR " Callbacks not initialized\n");
         return S_db_notInit;
     }
     if (mySet->queueOverflow) return S_db_bufFull;
 
-    pushOK = epicsRingPointerPush(mySet->queue, pcallback);
+    entry.pcallback = pcallback;
+    entry.queued = callbackQueueTiming ? epicsMonotonicGet() : 0;
+
+    /* The overflow blocks can't be used from interrupt context, requests
+     * from there may overtake those queued in them.
+     */
+    if (epicsAtomicGetIntT(&mySet->overflowUsed) &&
+        !epicsInterruptIsInterruptContext()) {
+        pushOK = overflowPush(mySet, &entry);
+    } else {
+        pushOK = queuePush(mySet, &entry);
+        if (!pushOK && mySet->blocksMax &&
+            !epicsInterruptIsInterruptContext())
+            pushOK = overflowPush(mySet, &entry);
+    }
 
     if (!pushOK) {
         epicsInterruptContextMessage(fullMessage[priority]);
@@ -368,7 +765,9 @@ int callbackRequest(epicsCallback *pcallback)
         epicsAtomicIncrIntT(&mySet->queueOverflows);
         return S_db_bufFull;
     }
-    epicsEventSignal(mySet->semWakeUp);
+    /* busy threads will find the request without a wakeup */
+    if (epicsAtomicGetIntT(&mySet->threadsIdle))
+        epicsEventSignal(mySet->semWakeUp);
     return 0;
 }
 
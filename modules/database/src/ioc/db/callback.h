@@ -69,6 +69,11 @@ typedef struct callbackQueueStats {
 #define callbackGetUser(USER, PCALLBACK) \
     ( (USER) = (PCALLBACK)->user )
 
+/* Non-zero before callbackInit() for lock-free callback queues */
+DBCORE_API extern int callbackLockFree;
+/* Non-zero to time requests in the queue, see callbackQueueShow() */
+DBCORE_API extern int callbackQueueTiming;
+
 DBCORE_API void callbackInit(void);
 DBCORE_API void callbackStop(void);
 DBCORE_API void callbackCleanup(void);
@@ -83,6 +88,7 @@ DBCORE_API void callbackCancelDelayed(epicsCallback *pcallback);
 DBCORE_API void callbackRequestProcessCallbackDelayed(
     epicsCallback *pCallback, int Priority, void *pRec, double seconds);
 DBCORE_API int callbackSetQueueSize(int size);
+DBCORE_API int callbackSetQueueGrowth(int kbytes);
 DBCORE_API int callbackQueueStatus(const int reset, callbackQueueStats *result);
 DBCORE_API void callbackQueueShow(const int reset);
 DBCORE_API int callbackParallelThreads(int count, const char *prio);
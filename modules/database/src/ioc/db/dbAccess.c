@@ -69,6 +69,9 @@ volatile int interruptAccept=FALSE;
 int dbAccessDebugPUTF = 0;
 epicsExportAddress(int, dbAccessDebugPUTF);
 
+int dbProcessProfile = 0;
+epicsExportAddress(int, dbProcessProfile);
+
 /* Hook Routines */
 
 DB_LOAD_RECORDS_HOOK_ROUTINE dbLoadRecordsHook = NULL;
@@ -472,6 +475,74 @@ int dbGetFieldIndex(const struct dbAddr *paddr)
     return paddr->pfldDes->indRecordType;
 }
 
+long dbProfileEnable(int on)
+{
+    DBENTRY dbentry;
+    long status;
+
+    if (on && pdbbase) {
+        dbInitEntry(pdbbase, &dbentry);
+        status = dbFirstRecordType(&dbentry);
+        while (!status) {
+            status = dbFirstRecord(&dbentry);
+            while (!status) {
+                dbCommon *precord = dbentry.precnode->precord;
+                lockRecord *plr = precord->lset;
+
+                /* no lockRecord before iocInit() */
+                if (!dbIsAlias(&dbentry) && plr && !plr->prof) {
+                    dbProfile *prof = calloc(1, sizeof(dbProfile));
+
+                    if (!prof) {
+                        dbFinishEntry(&dbentry);
+                        errlogPrintf("dbProfileEnable: Out of memory\n");
+                        return S_db_noMemory;
+                    }
+                    dbScanLock(precord);
+                    if (!plr->prof) {
+                        plr->prof = prof;
+                        prof = NULL;
+                    }
+                    dbScanUnlock(precord);
+                    free(prof);
+                }
+                status = dbNextRecord(&dbentry);
+            }
+            status = dbNextRecordType(&dbentry);
+        }
+        dbFinishEntry(&dbentry);
+    }
+    dbProcessProfile = on;
+    return 0;
+}
+
+int dbProfileGet(dbCommon *precord, dbProfile *pprof, int reset)
+{
+    lockRecord *plr = precord->lset;
+    int found = 0;
+
+    if (!plr)
+        return 0;
+    dbScanLock(precord);
+    if (plr->prof) {
+        *pprof = *plr->prof;
+        if (reset)
+            memset(plr->prof, 0, sizeof(dbProfile));
+        found = 1;
+    }
+    dbScanUnlock(precord);
+    return found;
+}
+
+/* Called with the record locked */
+static void profileAdd(dbProfile *prof, epicsUInt64 ns)
+{
+    prof->count++;
+    prof->total += ns;
+    if (ns > prof->max)
+        prof->max = ns;
+}
+
 /*
  *   Process the record.
  *     1.  Check for breakpoints.
@@ -608,7 +679,14 @@ long dbProcess(dbCommon *precord)
         printf("%s: dbProcess of '%s'\n", context, precord->name);
 
     /* process record */
-    status = prset->process(precord);
+    if (dbProcessProfile && precord->lset->prof) {
+        epicsUInt64 start = epicsMonotonicGet();
+
+        status = prset->process(precord);
+        profileAdd(precord->lset->prof, epicsMonotonicGet() - start);
+    }
+    else
+        status = prset->process(precord);
 
     /* Print record's fields if PRINT_MASK set in breakpoint field */
     if (lset_stack_count != 0) {
@@ -29,6 +29,27 @@ extern "C" {
 DBCORE_API extern struct dbBase *pdbbase;
 DBCORE_API extern volatile int interruptAccept;
 DBCORE_API extern int dbAccessDebugPUTF;
+DBCORE_API extern int dbProcessProfile;
+
+/** Processing time statistics of a record, collected while
+ * dbProcessProfile is non-zero.  Times are in nanoseconds and
+ * include the records processed synchronously through its links.
+ */
+typedef struct dbProfile {
+    epicsUInt64 count;      /* calls of the record's process routine */
+    epicsUInt64 total;      /* time spent in them */
+    epicsUInt64 max;        /* longest call */
+} dbProfile;
+
+/** Set dbProcessProfile, first giving every record the statistics which
+ * dbProcess() updates.  iocInit() calls this if dbProcessProfile is set.
+ */
+DBCORE_API long dbProfileEnable(int on);
+/** Copy the statistics of a record and clear them if reset is non-zero,
+ * returns zero if the record has none.
+ */
+DBCORE_API int dbProfileGet(struct dbCommon *precord, dbProfile *pprof,
+    int reset);
 
 /*  The database field and request types are defined in dbFldTypes.h*/
 /* Data Base Request Options    */
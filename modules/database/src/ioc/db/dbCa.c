@@ -27,6 +27,7 @@
 #include "epicsExit.h"
 #include "epicsMutex.h"
 #include "epicsPrint.h"
+#include "epicsStdio.h"
 #include "epicsString.h"
 #include "epicsThread.h"
 #include "epicsAtomic.h"
@@ -51,6 +52,7 @@
 #include "link.h"
 #include "recGbl.h"
 #include "recSup.h"
+#include "epicsExport.h"
 
 /* from dbAccessDefs.h which can't be included here */
 #define S_db_badDbrtype (M_dbAccess| 3)
@@ -61,17 +63,23 @@
 extern void dbServiceIOInit();
 extern int dbServiceIsolate;
 
-static ELLLIST workList = ELLLIST_INIT;    /* Work list for dbCaTask */
-static epicsMutexId workListLock; /*Mutual exclusions semaphores for workList*/
-static epicsEventId workListEvent; /*wakeup event for dbCaTask*/
-static int removesOutstanding = 0;
+int dbCaWorkers = 1;
+epicsExportAddress(int, dbCaWorkers);
+
+/* Links are spread over the workers by a hash of the PV name.  The
+ * workers are never freed, late references from a previous IOC run
+ * may still point to them.  A restart with more workers reuses the
+ * existing ones and only replaces the list of pointers.
+ */
+caWorker **dbCaWorkerList;
+int dbCaWorkerCount;
+static int dbCaWorkersAllocated;
+
 #define removesOutstandingWarning 10000
 
 static volatile enum dbCaCtl_t {
     ctlInit, ctlRun, ctlPause, ctlExit
 } dbCaCtl;
-static epicsEventId startStopEvent;
-static epicsThreadId dbCaWorker;
 
 struct ca_client_context * dbCaClientContext;
 
@@ -84,15 +92,13 @@ static lset dbCa_lset;
     errlogPrintf("%s has DB CA link to %s\n",\
         pcaLink->plink->precord->name, pcaLink->pvname)
 
-static int dbca_chan_count;
-
 /* caLink locking
  *
  * Lock ordering:
- *  dbScanLock -> caLink.lock -> workListLock
+ *  dbScanLock -> caLink.lock -> caWorker.workListLock
  *
  * workListLock:
- *   Guards access to workList.
+ *   Guards access to the workList of one caWorker.
  *
  * dbScanLock:
  *   All dbCa* functions operating on a single link may only be called when
@@ -115,10 +121,9 @@ static int dbca_chan_count;
  * During link modification or IOC shutdown the pca->plink pointer (guarded by caLink.lock)
  * is used as a flag to indicate that a link is no longer active.
  *
- * References to the struct caLink are owned by the dbCaTask, and any scanOnceCallback()
- * which is in progress.
+ * References to the struct caLink are owned by the dbCaTask.
  *
- * The libca and scanOnceCallback callbacks take no action if pca->plink==NULL.
+ * The libca callbacks take no action if pca->plink==NULL.
  *
  *   dbCaPutLinkCallback causes an additional complication because
  *   when dbCaRemoveLink is called the callback may not have occured.
@@ -130,9 +135,10 @@ static int dbca_chan_count;
 
 static void addAction(caLink *pca, short link_action)
 {
+    caWorker *pw = pca->worker;
     int callAdd;
 
-    epicsMutexMustLock(workListLock);
+    epicsMutexMustLock(pw->workListLock);
     callAdd = (pca->link_action == 0);
     if (pca->link_action & CA_CLEAR_CHANNEL) {
         errlogPrintf("dbCa::addAction %d with CA_CLEAR_CHANNEL set\n",
@@ -140,23 +146,22 @@ static void addAction(caLink *pca, short link_action)
         printLinks(pca);
         link_action = 0;
     }
-    if (link_action & CA_CLEAR_CHANNEL) {
-        if (++removesOutstanding >= removesOutstandingWarning) {
-            errlogPrintf("dbCa::addAction pausing, %d channels to clear\n",
-                removesOutstanding);
-        }
-        while (removesOutstanding >= removesOutstandingWarning) {
-            epicsMutexUnlock(workListLock);
-            epicsThreadSleep(1.0);
-            epicsMutexMustLock(workListLock);
-        }
-    }
+    /* Never wait here, the caller holds the record lock.  Each link is
+     * queued at most once, so the backlog is bounded by the links.
+     */
+    if (link_action & CA_CLEAR_CHANNEL &&
+        ++pw->removesOutstanding == removesOutstandingWarning)
+        errlogPrintf("dbCa::addAction %d channels waiting to be cleared\n",
+            pw->removesOutstanding);
     pca->link_action |= link_action;
+    if (callAdd) {
+        ellAdd(&pw->workList, &pca->node);
+        if (ellCount(&pw->workList) > pw->queueHighWater)
+            pw->queueHighWater = ellCount(&pw->workList);
+    }
+    epicsMutexUnlock(pw->workListLock);
     if (callAdd)
-        ellAdd(&workList, &pca->node);
-    epicsMutexUnlock(workListLock);
-    if (callAdd)
-        epicsEventSignal(workListEvent);
+        epicsEventSignal(pw->workListEvent);
 }
 
 static void caLinkInc(caLink *pca)
@@ -178,7 +183,7 @@ static void caLinkDec(caLink *pca)
 
     if (pca->chid) {
         ca_clear_channel(pca->chid);
-        --dbca_chan_count;
+        epicsAtomicDecrIntT(&pca->worker->chanCount);
     }
     callback = pca->putCallback;
     if (callback) {
@@ -187,6 +192,7 @@ static void caLinkDec(caLink *pca)
         pca->putType = 0;
     }
     free(pca->pgetNative);
+    free(pca->pgetSpare);
     free(pca->pputNative);
     free(pca->pgetString);
     free(pca->pputString);
@@ -267,10 +273,7 @@ void testdbCaWaitForUpdateCount(DBLINK *plink, unsigned long cnt)
     testdbCaWaitForEvent(plink, cnt, testEventCount);
 }
 
-/* Block until worker thread has processed all previously queued actions.
- * Does not prevent additional actions from being queued.
- */
-void dbCaSync(void)
+static void workerSync(caWorker *pw)
 {
     epicsEventId wake;
     caLink templink;
@@ -281,6 +284,7 @@ void dbCaSync(void)
      */
     memset(&templink, 0, sizeof(templink));
     templink.refcount = 1;
+    templink.worker = pw;
 
     wake = epicsEventMustCreate(epicsEventEmpty);
     templink.lock = epicsMutexMustCreate();
@@ -294,12 +298,23 @@ void dbCaSync(void)
      * we hold workListLock to ensure worker call to
      * epicsEventMustTrigger() returns before we destroy the event.
      */
-    epicsMutexMustLock(workListLock);
+    epicsMutexMustLock(pw->workListLock);
     assert(templink.refcount==1);
 
     epicsMutexDestroy(templink.lock);
     epicsEventDestroy(wake);
-    epicsMutexUnlock(workListLock);
+    epicsMutexUnlock(pw->workListLock);
+}
+
+/* Block until the worker threads have processed all previously queued
+ * actions.  Does not prevent additional actions from being queued.
+ */
+void dbCaSync(void)
+{
+    int i;
+
+    for (i = 0; i < dbCaWorkerCount; i++)
+        workerSync(dbCaWorkerList[i]);
 }
 
 void dbCaCallbackProcess(void *userPvt)
@@ -309,20 +324,36 @@ void dbCaCallbackProcess(void *userPvt)
     dbLinkAsyncComplete(plink);
 }
 
+static void wakeWorkers(void)
+{
+    int i;
+
+    for (i = 0; i < dbCaWorkerCount; i++)
+        epicsEventSignal(dbCaWorkerList[i]->workListEvent);
+}
+
 void dbCaShutdown(void)
 {
     enum dbCaCtl_t cur = dbCaCtl;
+    int i;
+
     assert(cur == ctlRun || cur == ctlPause);
     dbCaCtl = ctlExit;
-    epicsEventSignal(workListEvent);
-    epicsEventMustWait(startStopEvent);
-    if(dbCaWorker)
-        epicsThreadMustJoin(dbCaWorker);
+    wakeWorkers();
+    for (i = 0; i < dbCaWorkerCount; i++) {
+        caWorker *pw = dbCaWorkerList[i];
+
+        epicsEventMustWait(pw->startStopEvent);
+        if (pw->thread)
+            epicsThreadMustJoin(pw->thread);
+        pw->thread = NULL;
+    }
 }
 
 static void dbCaLinkInitImpl(int isolate)
 {
     epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int i;
 
     opts.stackSize = epicsThreadGetStackSize(epicsThreadStackBig);
     opts.priority = epicsThreadPriorityMedium;
@@ -331,18 +362,48 @@ static void dbCaLinkInitImpl(int isolate)
     dbServiceIsolate = isolate;
     dbServiceIOInit();
 
-    if (!workListLock)
-        workListLock = epicsMutexMustCreate();
-    if (!workListEvent)
-        workListEvent = epicsEventMustCreate(epicsEventEmpty);
-
-    if(!startStopEvent)
-        startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+    if (dbCaWorkers < 1)
+        dbCaWorkers = 1;
+    if (dbCaWorkers > dbCaWorkersAllocated) {
+        caWorker **list = dbCalloc(dbCaWorkers, sizeof(caWorker *));
+
+        for (i = 0; i < dbCaWorkersAllocated; i++)
+            list[i] = dbCaWorkerList[i];
+        free(dbCaWorkerList);
+        dbCaWorkerList = list;
+        for (i = dbCaWorkersAllocated; i < dbCaWorkers; i++) {
+            caWorker *pw = dbCalloc(1, sizeof(caWorker));
+
+            dbCaWorkerList[i] = pw;
+            ellInit(&pw->workList);
+            pw->workListLock = epicsMutexMustCreate();
+            pw->workListEvent = epicsEventMustCreate(epicsEventEmpty);
+            pw->startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+            pw->index = i;
+        }
+        dbCaWorkersAllocated = dbCaWorkers;
+    }
+    dbCaWorkerCount = dbCaWorkers;
     dbCaCtl = ctlPause;
 
-    dbCaWorker = epicsThreadCreateOpt("dbCaLink", dbCaTask, NULL, &opts);
-    /* wait for worker to startup and initialize dbCaClientContext */
-    epicsEventMustWait(startStopEvent);
+    for (i = 0; i < dbCaWorkerCount; i++) {
+        caWorker *pw = dbCaWorkerList[i];
+        char name[20];
+
+        /* dbcar counts from this run only */
+        pw->queueHighWater = 0;
+        pw->nActions = 0;
+        pw->nConnects = 0;
+        pw->connectTotal = 0.0;
+        pw->connectMax = 0.0;
+        if (i)
+            epicsSnprintf(name, sizeof(name), "dbCaLink%d", i);
+        else
+            strcpy(name, "dbCaLink");
+        pw->thread = epicsThreadCreateOpt(name, dbCaTask, pw, &opts);
+        /* wait for worker to startup and initialize its context */
+        epicsEventMustWait(pw->startStopEvent);
+    }
 }
 
 void dbCaLinkInitIsolated(void)
@@ -359,7 +420,7 @@ void dbCaRun(void)
 {
     if (dbCaCtl == ctlPause) {
         dbCaCtl = ctlRun;
-        epicsEventSignal(workListEvent);
+        wakeWorkers();
     }
 }
 
@@ -367,10 +428,17 @@ void dbCaPause(void)
 {
     if (dbCaCtl == ctlRun) {
         dbCaCtl = ctlPause;
-        epicsEventSignal(workListEvent);
+        wakeWorkers();
     }
 }
 
+struct ca_client_context * dbCaWorkerContext(int worker)
+{
+    if (worker < 0 || worker >= dbCaWorkerCount)
+        return NULL;
+    return dbCaWorkerList[worker]->context;
+}
+
 void dbCaAddLinkCallback(struct link *plink,
     dbCaCallback connect, dbCaCallback monitor, void *userPvt)
 {
@@ -383,6 +451,9 @@ void dbCaAddLinkCallback(struct link *plink,
     pca->lock = epicsMutexMustCreate();
     pca->plink = plink;
     pca->pvname = epicsStrDup(plink->value.pv_link.pvname);
+    pca->worker = dbCaWorkerList[dbCaWorkerCount > 1 ?
+        epicsStrHash(pca->pvname, 0) % dbCaWorkerCount : 0];
+    pca->connectRequested = epicsMonotonicGet();
     pca->connect = connect;
     pca->monitor = monitor;
     pca->userPvt = userPvt;
@@ -424,10 +495,14 @@ long dbCaGetLink(struct link *plink, short dbrType, void *pdest,
     long   status = 0;
     short  link_action = 0;
     int    newType;
+    epicsEnum16 stat, sevr;
 
     assert(pca);
     epicsMutexMustLock(pca->lock);
     assert(pca->plink);
+    /* of the value read, eventCallback may change them during aConvert */
+    stat = pca->stat;
+    sevr = pca->sevr;
     if (!pca->isConnected || !pca->hasReadAccess) {
         pca->sevr = INVALID_ALARM;
         pca->stat = LINK_ALARM;
@@ -492,15 +567,34 @@ long dbCaGetLink(struct link *plink, short dbrType, void *pdest,
         dbAddr.pfield = pca->pgetNative;
         /*Following will only be used for pca->dbrType == DBR_STRING*/
         dbAddr.field_size = MAX_STRING_SIZE;
-        /*Ignore error return*/
-        aConvert(&dbAddr, pdest, ntoget, ntoget, 0);
+        if (pca->nelements > 1) {
+            /* eventCallback won't reuse the buffer while we convert it */
+            void *pbuf = pca->pgetNative;
+            size_t getSize = pca->getSize;
+
+            pca->pgetReading = pbuf;
+            epicsMutexUnlock(pca->lock);
+            /*Ignore error return*/
+            aConvert(&dbAddr, pdest, ntoget, ntoget, 0);
+            epicsMutexMustLock(pca->lock);
+            pca->pgetReading = 0;
+            if (pbuf != pca->pgetNative) {
+                if (!pca->pgetSpare && pca->getSize == getSize)
+                    pca->pgetSpare = pbuf;
+                else
+                    free(pbuf);
+            }
+        } else {
+            /*Ignore error return*/
+            aConvert(&dbAddr, pdest, ntoget, ntoget, 0);
+        }
     }
 done:
     if (link_action)
         addAction(pca, link_action);
     if (!status)
         recGblInheritSevr(plink->value.pv_link.pvlMask & pvlOptMsMode,
-            plink->precord, pca->stat, pca->sevr);
+            plink->precord, stat, sevr);
     epicsMutexUnlock(pca->lock);
 
     return status;
@@ -788,36 +882,10 @@ static long doLocked(struct link *plink, dbLinkUserCallback rtn, void *priv)
     return status;
 }
 
-static void scanComplete(void *raw, dbCommon *prec)
-{
-    caLink *pca = raw;
-    epicsMutexMustLock(pca->lock);
-    if(!pca->plink) {
-        /* IOC shutdown or link re-targeted.  Do nothing. */
-    } else if(pca->scanningOnce==0) {
-        errlogPrintf("dbCa.c complete callback w/ scanningOnce==0\n");
-    } else if(--pca->scanningOnce){
-        /* another scan is queued */
-        if(scanOnceCallback(prec, scanComplete, raw)) {
-            errlogPrintf("dbCa.c failed to re-queue scanOnce\n");
-        } else
-            caLinkInc(pca);
-    }
-    epicsMutexUnlock(pca->lock);
-    caLinkDec(pca);
-}
-
-/* must be called with pca->lock held */
-static void scanLinkOnce(dbCommon *prec, caLink *pca) {
-    if(pca->scanningOnce==0) {
-        if(scanOnceCallback(prec, scanComplete, pca)) {
-            errlogPrintf("dbCa.c failed to queue scanOnce\n");
-        } else
-            caLinkInc(pca);
-    }
-    if(pca->scanningOnce<5)
-        pca->scanningOnce++;
-    /* else too many scans queued */
+/* Updates arriving while the record is queued are merged into one scan */
+static void scanLinkOnce(dbCommon *prec) {
+    if(scanOnceCoalesced(prec))
+        errlogPrintf("dbCa.c failed to queue scanOnce\n");
 }
 
 static lset dbCa_lset = {
@@ -856,13 +924,25 @@ static void connectionCallback(struct connection_handler_args arg)
         if (precord &&
             ((ppv_link->pvlMask & pvlOptCP) ||
              ((ppv_link->pvlMask & pvlOptCPP) && precord->scan == 0)))
-            scanLinkOnce(precord, pca);
+            scanLinkOnce(precord);
         goto done;
     }
     pca->hasReadAccess = ca_read_access(arg.chid);
     pca->hasWriteAccess = ca_write_access(arg.chid);
 
-    if (pca->gotFirstConnection) {
+    if (!pca->gotFirstConnection) {
+        caWorker *pw = pca->worker;
+        double connectTime =
+            (epicsMonotonicGet() - pca->connectRequested) * 1e-9;
+
+        epicsMutexMustLock(pw->workListLock);
+        pw->nConnects++;
+        pw->connectTotal += connectTime;
+        if (connectTime > pw->connectMax)
+            pw->connectMax = connectTime;
+        epicsMutexUnlock(pw->workListLock);
+    }
+    else {
         if (pca->nelements != ca_element_count(arg.chid) ||
             pca->dbrType != ca_field_type(arg.chid)) {
             /* Size or type changed, clear everything and let the next call
@@ -883,7 +963,12 @@ static void connectionCallback(struct connection_handler_args arg)
             pca->gotOutNative = 0;
             pca->gotInString  = 0;
             pca->gotOutString = 0;
-            free(pca->pgetNative); pca->pgetNative = 0;
+            /* dbCaGetLink frees it when done converting */
+            if (pca->pgetNative != pca->pgetReading)
+                free(pca->pgetNative);
+            pca->pgetNative = 0;
+            free(pca->pgetSpare); pca->pgetSpare = 0;
+            pca->getSize = 0;
             free(pca->pgetString); pca->pgetString = 0;
             free(pca->pputNative); pca->pputNative = 0;
             free(pca->pputString); pca->pputString = 0;
@@ -919,6 +1004,38 @@ done:
     if (connect) connect(userPvt);
 }
 
+/* Copy an array value into the spare buffer with pca->lock released,
+ * then make that the current one.  The old buffer becomes the spare
+ * unless dbCaGetLink() is still reading it.  Returns 0 if the link was
+ * removed or changed meanwhile, and the value was dropped.
+ */
+static int storeNative(caLink *pca, const void *pvalue, size_t size)
+{
+    size_t getSize = pca->getSize;
+    void *pbuf = pca->pgetSpare;
+    void *pold;
+
+    pca->pgetSpare = 0;
+    epicsMutexUnlock(pca->lock);
+    if (!pbuf)
+        pbuf = dbCalloc(1, getSize);
+    memcpy(pbuf, pvalue, size);
+    epicsMutexMustLock(pca->lock);
+    if (!pca->plink || !pca->pgetNative || pca->getSize != getSize) {
+        free(pbuf);
+        return 0;
+    }
+    pold = pca->pgetNative;
+    pca->pgetNative = pbuf;
+    if (pold != pca->pgetReading) {
+        if (!pca->pgetSpare)
+            pca->pgetSpare = pold;
+        else
+            free(pold);
+    }
+    return 1;
+}
+
 static void eventCallback(struct event_handler_args arg)
 {
     caLink *pca = (caLink *)arg.usr;
@@ -970,7 +1087,14 @@ static void eventCallback(struct event_handler_args arg)
     case DBR_TIME_LONG:
     case DBR_TIME_DOUBLE:
         assert(pca->pgetNative);
-        memcpy(pca->pgetNative, dbr_value_ptr(arg.dbr, arg.type), size);
+        if (pca->nelements > 1) {
+            if (!storeNative(pca, dbr_value_ptr(arg.dbr, arg.type), size)) {
+                monitor = 0;
+                goto done;
+            }
+        } else {
+            memcpy(pca->pgetNative, dbr_value_ptr(arg.dbr, arg.type), size);
+        }
         pca->usedelements = arg.count;
         pca->gotInNative = TRUE;
         break;
@@ -988,7 +1112,7 @@ static void eventCallback(struct event_handler_args arg)
 
         if ((ppv_link->pvlMask & pvlOptCP) ||
             ((ppv_link->pvlMask & pvlOptCPP) && precord->scan == 0))
-        scanLinkOnce(precord, pca);
+        scanLinkOnce(precord);
     }
 done:
     epicsMutexUnlock(pca->lock);
@@ -1061,7 +1185,7 @@ static void accessRightsCallback(struct access_rights_handler_args arg)
     if (precord &&
         ((ppv_link->pvlMask & pvlOptCP) ||
          ((ppv_link->pvlMask & pvlOptCPP) && precord->scan == 0)))
-        scanLinkOnce(precord, pca);
+        scanLinkOnce(precord);
 done:
     epicsMutexUnlock(pca->lock);
 }
@@ -1119,33 +1243,36 @@ static void getAttribEventCallback(struct event_handler_args arg)
 
 static void dbCaTask(void *arg)
 {
+    caWorker *pw = (caWorker *)arg;
     epicsEventId requestSync = NULL;
     taskwdInsert(0, NULL, NULL);
     SEVCHK(ca_context_create(ca_enable_preemptive_callback),
         "dbCaTask calling ca_context_create");
-    dbCaClientContext = ca_current_context ();
+    pw->context = ca_current_context ();
+    if (pw->index == 0)
+        dbCaClientContext = pw->context;
     SEVCHK(ca_add_exception_event(exceptionCallback,NULL),
         "ca_add_exception_event");
-    epicsEventSignal(startStopEvent);
+    epicsEventSignal(pw->startStopEvent);
 
     /* channel access event loop */
     while (TRUE){
         do {
-            epicsEventMustWait(workListEvent);
+            epicsEventMustWait(pw->workListEvent);
         } while (dbCaCtl == ctlPause);
         while (TRUE) { /* process all requests in workList*/
             caLink *pca;
             short  link_action;
             int    status;
 
-            epicsMutexMustLock(workListLock);
-            if (!(pca = (caLink *)ellGet(&workList))){  /* Take off list head */
+            epicsMutexMustLock(pw->workListLock);
+            if (!(pca = (caLink *)ellGet(&pw->workList))){  /* Take off list head */
                 if(requestSync) {
                     /* dbCaSync() requires workListLock to be held here */
                     epicsEventMustTrigger(requestSync);
                     requestSync = NULL;
                 }
-                epicsMutexUnlock(workListLock);
+                epicsMutexUnlock(pw->workListLock);
                 if (dbCaCtl == ctlExit) goto shutdown;
                 break; /* workList is empty */
             }
@@ -1155,8 +1282,10 @@ static void dbCaTask(void *arg)
                 requestSync = pca->userPvt;
             }
             pca->link_action = 0;
-            if (link_action & CA_CLEAR_CHANNEL) --removesOutstanding;
-            epicsMutexUnlock(workListLock);         /* Give back immediately */
+            pw->nActions++;
+            if (link_action & CA_CLEAR_CHANNEL)
+                --pw->removesOutstanding;
+            epicsMutexUnlock(pw->workListLock);     /* Give back immediately */
             if (link_action&CA_SYNC)
                 continue;
             if (link_action & CA_CLEAR_CHANNEL) {   /* This must be first */
@@ -1174,7 +1303,7 @@ static void dbCaTask(void *arg)
                     printLinks(pca);
                     continue;
                 }
-                dbca_chan_count++;
+                epicsAtomicIncrIntT(&pw->chanCount);
                 status = ca_replace_access_rights_event(pca->chid,
                     accessRightsCallback);
                 if (status != ECA_NORMAL) {
@@ -1247,6 +1376,7 @@ static void dbCaTask(void *arg)
                 epicsMutexMustLock(pca->lock);
                 pca->elementSize = dbr_value_size[ca_field_type(pca->chid)];
                 pca->pgetNative = dbCalloc(pca->nelements, pca->elementSize);
+                pca->getSize = pca->nelements * pca->elementSize;
                 epicsMutexUnlock(pca->lock);
 
                 status = ca_add_array_event(
@@ -1278,9 +1408,10 @@ static void dbCaTask(void *arg)
     }
 shutdown:
     taskwdRemove(0);
-    if (dbca_chan_count == 0)
+    if (epicsAtomicGetIntT(&pw->chanCount) == 0)
         ca_context_destroy();
     else
-        fprintf(stderr, "dbCa: chan_count = %d at shutdown\n", dbca_chan_count);
-    epicsEventSignal(startStopEvent);
+        fprintf(stderr, "dbCa: chan_count = %d at shutdown\n",
+            epicsAtomicGetIntT(&pw->chanCount));
+    epicsEventSignal(pw->startStopEvent);
 }
@@ -45,8 +45,20 @@ DBCORE_API long dbCaPutLinkCallback(struct link *plink,
 DBCORE_API long dbCaPutLink(struct link *plink,short dbrType,
     const void *pbuffer,long nRequest);
 
+/* Client context of the first CA link thread only.  With dbCaWorkers > 1
+ * links are spread over the threads by PV name, each with its own context,
+ * see dbCaWorkerContext().
+ */
 extern struct ca_client_context * dbCaClientContext;
 
+/* Number of CA link threads and client contexts, set before iocInit */
+DBCORE_API extern int dbCaWorkers;
+
+/* Client context of CA link thread 0 to dbCaWorkers-1, NULL if there is
+ * no such thread or it hasn't started yet.
+ */
+DBCORE_API struct ca_client_context * dbCaWorkerContext(int worker);
+
 #ifdef EPICS_DBCA_PRIVATE_API
 /* Wait CA link work queue to become empty.  eg. after from dbPut() to OUT */
 DBCORE_API void dbCaSync(void);
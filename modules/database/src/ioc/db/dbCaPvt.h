@@ -18,7 +18,9 @@
 
 #include "dbCa.h"
 #include "ellLib.h"
+#include "epicsEvent.h"
 #include "epicsMutex.h"
+#include "epicsThread.h"
 #include "epicsTypes.h"
 #include "link.h"
 
@@ -35,11 +37,36 @@
 #define CA_PUT          0x1
 #define CA_PUT_CALLBACK 0x2
 
+/* A thread with its own CA client context, servicing a share of the links */
+typedef struct caWorker
+{
+    ELLLIST         workList;
+    epicsMutexId    workListLock;   /* guards workList and the counters */
+    epicsEventId    workListEvent;  /* wakeup event for dbCaTask */
+    epicsEventId    startStopEvent;
+    epicsThreadId   thread;
+    struct ca_client_context *context;
+    int             index;
+    int             chanCount;
+    int             removesOutstanding;
+    /* The following are for dbcar */
+    unsigned long   queueHighWater;
+    unsigned long   nActions;
+    unsigned long   nConnects;
+    double          connectTotal;   /* seconds from link added to connected */
+    double          connectMax;
+} caWorker;
+
+extern caWorker **dbCaWorkerList;
+extern int dbCaWorkerCount;
+
 typedef struct caLink
 {
     ELLNODE         node;
     int             refcount;
     epicsMutexId    lock;
+    caWorker        *worker;
+    epicsUInt64     connectRequested;
     struct link     *plink;
     char            *pvname;
     chid            chid;
@@ -78,6 +105,9 @@ typedef struct caLink
     char            units[MAX_UNITS_SIZE];  /* units of value */
     /* The following are for handling data*/
     void            *pgetNative;
+    void            *pgetSpare;   /* next buffer for eventCallback to fill */
+    void            *pgetReading; /* in use by dbCaGetLink, not locked */
+    size_t          getSize;      /* of pgetNative and pgetSpare */
     char            *pgetString;
     void            *pputNative;
     char            *pputString;
@@ -89,7 +119,6 @@ typedef struct caLink
     char            gotOutString;
     char            newOutNative;
     char            newOutString;
-    unsigned char scanningOnce;
     /* The following are for dbcar*/
     unsigned long   nDisconnect;
     unsigned long   nNoWrite; /*only modified by dbCaPutLink*/
@@ -154,8 +154,28 @@ done:
            nDisconnect, nNoWrite);
     dbFinishEntry(pdbentry);
 
-    if ( level > 2  && dbCaClientContext != 0 ) {
-        ca_context_status ( dbCaClientContext, level - 2 );
+    if (dbCaWorkerCount > 0) {
+        printf("Worker  Channels  Queued  Max Queued    Actions  Connects"
+               "  Connect ms mean/max\n");
+        for (j = 0; j < dbCaWorkerCount; j++) {
+            caWorker *pw = dbCaWorkerList[j];
+
+            epicsMutexMustLock(pw->workListLock);
+            printf("%6d  %8d  %6d  %10lu  %9lu  %8lu  %9.3f/%.3f\n",
+                   j, pw->chanCount, ellCount(&pw->workList),
+                   pw->queueHighWater, pw->nActions, pw->nConnects,
+                   pw->nConnects ? pw->connectTotal * 1e3 / pw->nConnects : 0.0,
+                   pw->connectMax * 1e3);
+            epicsMutexUnlock(pw->workListLock);
+        }
+        printf("\n");
+    }
+
+    if ( level > 2 ) {
+        for (j = 0; j < dbCaWorkerCount; j++) {
+            if (dbCaWorkerList[j]->context)
+                ca_context_status ( dbCaWorkerList[j]->context, level - 2 );
+        }
     }
 
     return(0);
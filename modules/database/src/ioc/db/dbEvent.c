@@ -31,8 +31,10 @@
 #include "cantProceed.h"
 #include "dbDefs.h"
 #include "epicsAssert.h"
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMutex.h"
+#include "epicsStdio.h"
 #include "epicsThread.h"
 #include "errlog.h"
 #include "freeList.h"
@@ -46,11 +48,13 @@
 #include "dbChannel.h"
 #include "dbCommon.h"
 #include "dbEvent.h"
+#include "dbExtractArray.h"
 #include "db_field_log.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
 #include "link.h"
 #include "special.h"
+#include "epicsExport.h"
 
 /* Queue size based on Ethernet MTU of 1500 bytes.
  * Assume <=66 bytes of ethernet+IP+TCP overhead
@@ -59,26 +63,92 @@
  * (1500-66)/40 -> 35
  */
 #define EVENTSPERQUE    36
-#define EVENTENTRIES    4      /* the number of que entries for each event */
-#define EVENTQUESIZE    (EVENTENTRIES  * EVENTSPERQUE)
+#define EVENTENTRIES    4      /* default number of que entries for each event */
+#define EVENTENTRIESMAX 1024   /* limit on que entries for each event */
+#define EVENTGROWPASSES 4      /* backlogged event_read() passes before growing */
 #define EVENTQEMPTY     ((struct evSubscrip *)NULL)
 
+/* Non-zero to create new event users with a lock-free queue */
+int dbEventLockFree = 0;
+epicsExportAddress(int, dbEventLockFree);
+
+/* Default que entries for each event, and the limit for adaptive growth.
+ * No growth when dbEventQueueEntriesMax <= dbEventQueueEntries.
+ */
+int dbEventQueueEntries = EVENTENTRIES;
+epicsExportAddress(int, dbEventQueueEntries);
+int dbEventQueueEntriesMax = 0;
+epicsExportAddress(int, dbEventQueueEntriesMax);
+
+/* Non-zero to copy array fields once per post, shared by all monitors */
+int dbEventArraySnapshots = 0;
+epicsExportAddress(int, dbEventArraySnapshots);
+
+/*
+ * Reference counted copy of an array field taken by db_post_events(),
+ * the db_field_logs of all subscriptions to that field share it.
+ * The data follows this header and must not be modified once shared.
+ */
+typedef struct db_snapshot {
+    void                *pfield;        /* the record field copied */
+    long                capacity;       /* and how the channel sees it */
+    short               field_size;
+    short               field_type;
+    size_t              id;             /* unique while in use */
+    long                no_elements;
+    int                 refcount;
+    double              align;          /* data alignment */
+} db_snapshot;
+
+/* at most this many different fields share snapshots in one post */
+#define SNAPSHOTSPERPOST 4
+
+static size_t snapshotSeq;
+
 /*
  * really a ring buffer
+ *
+ * With the default (mutex) implementation writers and the reader
+ * serialize on writelock for each event.
+ *
+ * The lock-free implementation is a bounded multi-producer single
+ * consumer ring.  Producers reserve a position by compare-and-swap on
+ * putpos and publish the entry by setting seq[] of its slot.  The event
+ * task consumes from getpos.  writelock is then only taken by the event
+ * task, to free a canceled subscription, and db_cancel_event().
+ * Neither side ever spins or blocks waiting for the other, as under
+ * priority scheduling the other one might not get to run, and the
+ * producers hold the record lock which the event task's callbacks may
+ * need.  A producer replaces the last event of its subscription when
+ * the ring is (nearly) full, and only if the subscription has none
+ * queued drops the event.  The event task stops reading when it meets
+ * an entry a producer is still working on, to be woken through ppendsem.
  */
 struct event_que {
     /* lock writers to the ring buffer only */
     /* readers must never slow up writers */
     epicsMutexId            writelock;
-    db_field_log            *valque[EVENTQUESIZE];
-    struct evSubscrip       *evque[EVENTQUESIZE];
+    db_field_log            **valque;
+    struct evSubscrip       **evque;
     struct event_que        *nextque;       /* in case que quota exceeded */
     struct event_user       *evUser;        /* event user parent struct */
-    unsigned short          putix;
-    unsigned short          getix;
-    unsigned short          quota;          /* the number of assigned entries*/
-    unsigned short          nDuplicates;    /* N events duplicated on this q */
+    unsigned                size;           /* ring entries */
+    unsigned                putix;
+    unsigned                getix;
+    unsigned short          quota;          /* the number of assigned events */
+    int                     nDuplicates;    /* N events duplicated on this q */
     unsigned                possibleStall;
+    unsigned                highWater;      /* max ring entries used */
+    unsigned                nGrow;          /* N times ring was enlarged */
+    unsigned                backlog;        /* passes with spaceReplaced */
+    unsigned char           spaceReplaced;  /* replaced an event for space */
+    /* lock-free queue only, positions are modulo 2*size so that
+     * the slot sequence numbers can tell a free slot from a full one */
+    int                     putpos;         /* next position to reserve */
+    int                     getpos;         /* next position to consume */
+    int                     *seq;           /* position slot is ready for */
+    int                     readerWaiting;  /* event task waits for producer */
+    int                     nDropped;       /* events dropped for a full ring */
 };
 
 struct event_user {
@@ -100,10 +170,53 @@ struct event_user {
     unsigned char       extra_labor;    /* if set call extra labor func */
     unsigned char       flowCtrlMode;   /* replace existing monitor */
     unsigned char       extraLaborBusy;
+    unsigned char       lockFree;       /* use the lock-free event_que */
+    unsigned            nEntries;       /* que entries for each event */
+    unsigned            nEntriesMax;    /* limit for growing a que */
     void                (*init_func)(void *);
     void                *init_func_arg;
+    /* db_start_events_pool() only, guarded by event_pool::lock */
+    struct event_pool   *pool;
+    ELLNODE             poolNode;       /* event_pool::readyQ */
+    unsigned char       poolState;
 };
 
+/*
+ * Threads shared by event users, each pass of one of them takes the
+ * next event user from readyQ and does what its own event task would
+ * do after being woken.  An event user woken during a pass is queued
+ * again once the pass is over, so only one thread serves it at a time.
+ */
+enum { poolIdle, poolQueued, poolBusy, poolBusyAgain };
+
+struct event_pool {
+    epicsMutexId        lock;
+    epicsEventId        ready;          /* readyQ not empty, or exit */
+    ELLLIST             readyQ;         /* event_user::poolNode */
+    epicsThreadId       *tids;
+    unsigned            nThreads;
+    unsigned char       exit;
+};
+
+/*
+ * What db_add_event() allocates: the evSubscrip of dbChannel.h followed
+ * by state private to this file, so that the public layout is unchanged.
+ * The lock-free queue keeps its own count of queued events and uses
+ * flags rather than the public fields to hand over the subscription.
+ */
+typedef struct event_subscr {
+    struct evSubscrip   pub;            /* must be first */
+    unsigned long       npendMax;       /* max n times on the queue */
+    /* lock-free queue only, updated with epicsAtomic operations */
+    void                *pLastSlot;     /* valque entry of last event or NULL */
+    size_t              npend;          /* n times on the queue */
+    size_t              refs;           /* npend, plus one until canceled */
+    int                 inCallback;     /* event task is delivering */
+    int                 canceled;       /* db_cancel_event() was called */
+} event_subscr;
+
+#define EVSUBPVT(PEVENT) ((event_subscr *) (PEVENT))
+
 typedef struct {
     ELLNODE node; /* event_user::waiters */
     epicsEventId wake;
@@ -115,8 +228,17 @@ typedef struct {
  * into only 10 or 20 total steps part of the time.
  */
 
-#define RNGINC(OLD)\
-( (unsigned short) ( (OLD) >= (EVENTQUESIZE-1) ? 0 : (OLD)+1 ) )
+#define RNGINC(EVQ,OLD)\
+( (OLD) >= ((EVQ)->size-1) ? 0u : (OLD)+1 )
+
+/* lock-free queue position arithmetic, modulo 2*size */
+#define EVQSIZE(EVQ)    ( (int) (EVQ)->size )
+#define POSINC(EVQ,POS) ( (POS) >= (2*EVQSIZE(EVQ)-1) ? 0 : (POS)+1 )
+#define POSLAP(EVQ,POS)\
+( (POS) >= EVQSIZE(EVQ) ? (POS)-EVQSIZE(EVQ) : (POS)+EVQSIZE(EVQ) )
+#define POSIDX(EVQ,POS) ( (POS) >= EVQSIZE(EVQ) ? (POS)-EVQSIZE(EVQ) : (POS) )
+#define POSDIST(EVQ,PUT,GET)\
+( (PUT) >= (GET) ? (PUT)-(GET) : (PUT)+2*EVQSIZE(EVQ)-(GET) )
 
 #define LOCKEVQUE(EV_QUE)   epicsMutexMustLock((EV_QUE)->writelock)
 #define UNLOCKEVQUE(EV_QUE) epicsMutexUnlock((EV_QUE)->writelock)
@@ -132,20 +254,66 @@ static char *EVENT_PEND_NAME = "eventTask";
 
 static epicsMutexId stopSync;
 
-/* unused space in queue (EVENTQUESIZE when empty) */
-static unsigned short ringSpace ( const struct event_que *pevq )
+/* placed in event_subscr::pLastSlot while a producer examines that entry */
+static char lastSlotBusy;
+#define EVQSLOTBUSY ((void *) &lastSlotBusy)
+
+/* number of positions reserved in a lock-free queue */
+static int ringUsedLF ( const struct event_que *pevq )
 {
+    int putpos = epicsAtomicGetIntT ( &pevq->putpos );
+    int getpos = epicsAtomicGetIntT ( &pevq->getpos );
+    return POSDIST ( pevq, putpos, getpos );
+}
+
+/* unused space in queue (size when empty) */
+static unsigned ringSpace ( const struct event_que *pevq )
+{
+    if ( pevq->evUser->lockFree ) {
+        return pevq->size - ( unsigned ) ringUsedLF ( pevq );
+    }
     if ( pevq->evque[pevq->putix] == EVENTQEMPTY ) {
         if ( pevq->getix > pevq->putix ) {
-            return ( unsigned short ) ( pevq->getix - pevq->putix );
+            return pevq->getix - pevq->putix;
         }
         else {
-            return ( unsigned short ) ( ( EVENTQUESIZE + pevq->getix ) - pevq->putix );
+            return ( pevq->size + pevq->getix ) - pevq->putix;
         }
     }
     return 0;
 }
 
+/* n times a subscription is on its queue */
+static unsigned long eventNPend ( const struct evSubscrip *pevent )
+{
+    if ( pevent->ev_que->evUser->lockFree ) {
+        return (unsigned long)
+            epicsAtomicGetSizeT ( &EVSUBPVT(pevent)->npend );
+    }
+    return pevent->npend;
+}
+
+/* wake the event task, or queue the event user for its pool */
+static void event_wake ( struct event_user *evUser )
+{
+    struct event_pool * const pool = evUser->pool;
+
+    if ( ! pool ) {
+        epicsEventSignal ( evUser->ppendsem );
+        return;
+    }
+    epicsMutexMustLock ( pool->lock );
+    if ( evUser->poolState == poolIdle ) {
+        evUser->poolState = poolQueued;
+        ellAdd ( &pool->readyQ, &evUser->poolNode );
+        epicsEventSignal ( pool->ready );
+    }
+    else if ( evUser->poolState == poolBusy ) {
+        evUser->poolState = poolBusyAgain;
+    }
+    epicsMutexUnlock ( pool->lock );
+}
+
 int db_event_list ( const char *pname, unsigned level )
 {
     return dbel ( pname, level );
@@ -191,22 +359,23 @@ int dbel ( const char *pname, unsigned level )
             if ( pevent->select & DBE_PROPERTY ) printf( "PROPERTY " );
             printf ( "}" );
 
-            if ( pevent->npend ) {
-                printf ( " undelivered=%ld", pevent->npend );
+            if ( eventNPend ( pevent ) ) {
+                printf ( " undelivered=%lu", eventNPend ( pevent ) );
             }
 
             if ( level > 1 ) {
-                unsigned nEntriesFree;
+                unsigned nEntriesFree, size;
                 const void * taskId;
                 LOCKEVQUE(pevent->ev_que);
                 nEntriesFree = ringSpace ( pevent->ev_que );
+                size = pevent->ev_que->size;
                 taskId = ( void * ) pevent->ev_que->evUser->taskid;
                 UNLOCKEVQUE(pevent->ev_que);
                 if ( nEntriesFree == 0u ) {
                     printf ( ", thread=%p, queue full",
                         (void *) taskId );
                 }
-                else if ( nEntriesFree == EVENTQUESIZE ) {
+                else if ( nEntriesFree == size ) {
                     printf ( ", thread=%p, queue empty",
                         (void *) taskId );
                 }
@@ -217,18 +386,33 @@ int dbel ( const char *pname, unsigned level )
             }
 
             if ( level > 2 ) {
-                unsigned nDuplicates;
+                int nDuplicates, nDropped;
+                unsigned size, highWater, nGrow;
                 if ( pevent->nreplace ) {
                     printf (", discarded by replacement=%ld", pevent->nreplace);
                 }
+                if ( EVSUBPVT(pevent)->npendMax ) {
+                    printf (", high water=%lu", EVSUBPVT(pevent)->npendMax);
+                }
                 if ( ! pevent->useValque ) {
                     printf (", queueing disabled" );
                 }
                 LOCKEVQUE(pevent->ev_que);
-                nDuplicates = pevent->ev_que->nDuplicates;
+                nDuplicates = epicsAtomicGetIntT ( &pevent->ev_que->nDuplicates );
+                size = pevent->ev_que->size;
+                highWater = pevent->ev_que->highWater;
+                nGrow = pevent->ev_que->nGrow;
+                nDropped = epicsAtomicGetIntT ( &pevent->ev_que->nDropped );
                 UNLOCKEVQUE(pevent->ev_que);
-                if  ( nDuplicates ) {
-                    printf (", duplicate count =%u\n", nDuplicates );
+                printf (", que size=%u high water=%u", size, highWater );
+                if ( nGrow ) {
+                    printf (" grown=%u", nGrow );
+                }
+                if ( nDropped ) {
+                    printf (" dropped=%d", nDropped );
+                }
+                if  ( nDuplicates > 0 ) {
+                    printf (", duplicate count =%d\n", nDuplicates );
                 }
             }
 
@@ -274,7 +458,7 @@ void db_init_event_freelists (void)
     }
     if (!dbevEventSubscriptionFreeList) {
         freeListInitPvt(&dbevEventSubscriptionFreeList,
-            sizeof(struct evSubscrip),256);
+            sizeof(event_subscr),256);
     }
     if (!dbevFieldLogFreeList) {
         freeListInitPvt(&dbevFieldLogFreeList,
@@ -282,6 +466,104 @@ void db_init_event_freelists (void)
     }
 }
 
+/*
+ * alloc_ev_que_ring()
+ *
+ * (re)allocate an empty ring with nEntries for each event
+ */
+static int alloc_ev_que_ring ( struct event_que * const ev_que,
+    unsigned nEntries )
+{
+    const unsigned size = nEntries * EVENTSPERQUE;
+    db_field_log ** valque;
+    struct evSubscrip ** evque;
+    int * seq;
+    unsigned i;
+
+    valque = (db_field_log **) calloc ( size, sizeof(*valque) );
+    evque = (struct evSubscrip **) calloc ( size, sizeof(*evque) );
+    seq = (int *) calloc ( size, sizeof(*seq) );
+    if ( ! valque || ! evque || ! seq ) {
+        free ( valque );
+        free ( evque );
+        free ( seq );
+        return -1;
+    }
+    for ( i = 0; i < size; i++ ) {
+        seq[i] = (int) i;
+    }
+
+    free ( ev_que->valque );
+    free ( ev_que->evque );
+    free ( ev_que->seq );
+    ev_que->valque = valque;
+    ev_que->evque = evque;
+    ev_que->seq = seq;
+    ev_que->size = size;
+    ev_que->putix = ev_que->getix = 0u;
+    ev_que->putpos = ev_que->getpos = 0;
+    return 0;
+}
+
+static void free_ev_que_ring ( struct event_que * const ev_que )
+{
+    free ( ev_que->valque );
+    free ( ev_que->evque );
+    free ( ev_que->seq );
+}
+
+/*
+ * grow_ev_que()
+ *
+ * Enlarge a (mutex) que keeping the queued events.
+ * event queue lock _must_ be applied
+ */
+static void grow_ev_que ( struct event_que * const ev_que )
+{
+    const unsigned oldSize = ev_que->size;
+    const unsigned nEntries = oldSize / EVENTSPERQUE;
+    unsigned newEntries = nEntries * 2u;
+    unsigned size, used, i, ix;
+    db_field_log ** valque;
+    struct evSubscrip ** evque;
+
+    if ( newEntries > ev_que->evUser->nEntriesMax ) {
+        newEntries = ev_que->evUser->nEntriesMax;
+    }
+    if ( ev_que->evUser->lockFree || newEntries <= nEntries ) {
+        return;
+    }
+    size = newEntries * EVENTSPERQUE;
+
+    valque = (db_field_log **) calloc ( size, sizeof(*valque) );
+    evque = (struct evSubscrip **) calloc ( size, sizeof(*evque) );
+    if ( ! valque || ! evque ) {
+        free ( valque );
+        free ( evque );
+        return;
+    }
+
+    /* copy in order, the oldest event first */
+    used = oldSize - ringSpace ( ev_que );
+    for ( i = 0u, ix = ev_que->getix; i < used; i++, ix = RNGINC ( ev_que, ix ) ) {
+        struct evSubscrip * const pevent = ev_que->evque[ix];
+        evque[i] = pevent;
+        valque[i] = ev_que->valque[ix];
+        if ( pevent->pLastLog == &ev_que->valque[ix] ) {
+            pevent->pLastLog = &valque[i];
+        }
+    }
+
+    free ( ev_que->valque );
+    free ( ev_que->evque );
+    ev_que->valque = valque;
+    ev_que->evque = evque;
+    ev_que->size = size;
+    ev_que->getix = 0u;
+    ev_que->putix = used;
+    ev_que->nGrow++;
+}
+
 /*
  * DB_INIT_EVENTS()
  *
@@ -305,8 +587,19 @@ dbEventCtx db_init_events (void)
 
     /* Flag will be cleared when event task starts */
     evUser->pendexit = TRUE;
+    evUser->lockFree = dbEventLockFree ? TRUE : FALSE;
+    evUser->nEntries = EVENTENTRIES;
+    if ( dbEventQueueEntries > 0 ) {
+        evUser->nEntries = dbEventQueueEntries > EVENTENTRIESMAX ?
+            EVENTENTRIESMAX : (unsigned) dbEventQueueEntries;
+    }
+    evUser->nEntriesMax = dbEventQueueEntriesMax > EVENTENTRIESMAX ?
+        EVENTENTRIESMAX : dbEventQueueEntriesMax > 0 ?
+        (unsigned) dbEventQueueEntriesMax : 0u;
 
     evUser->firstque.evUser = evUser;
+    if ( alloc_ev_que_ring ( &evUser->firstque, evUser->nEntries ) )
+        goto fail;
     evUser->firstque.writelock = epicsMutexCreate();
     if (!evUser->firstque.writelock)
         goto fail;
@@ -329,6 +622,7 @@ fail:
         epicsMutexDestroy (evUser->lock);
     if(evUser->firstque.writelock)
         epicsMutexDestroy (evUser->firstque.writelock);
+    free_ev_que_ring (&evUser->firstque);
     if(evUser->ppendsem)
         epicsEventDestroy (evUser->ppendsem);
     if(evUser->pexitsem)
@@ -380,10 +674,11 @@ void db_close_events (dbEventCtx ctx)
         epicsMutexUnlock ( evUser->lock );
 
         /* notify the waiting task */
-        epicsEventSignal(evUser->ppendsem);
-        /* wait for task to exit */
+        event_wake(evUser);
+        /* wait for task to exit, or its pool to finish with it */
         epicsEventMustWait(evUser->pexitsem);
-        epicsThreadMustJoin(evUser->taskid);
+        if (!evUser->pool)
+            epicsThreadMustJoin(evUser->taskid);
 
         epicsMutexMustLock ( evUser->lock );
     }
@@ -411,12 +706,17 @@ static struct event_que * create_ev_que ( struct event_user * const evUser )
     if ( ! ev_que ) {
         return NULL;
     }
+    ev_que->evUser = evUser;
+    if ( alloc_ev_que_ring ( ev_que, evUser->nEntries ) ) {
+        freeListFree ( dbevEventQueueFreeList, ev_que );
+        return NULL;
+    }
     ev_que->writelock = epicsMutexCreate();
     if ( ! ev_que->writelock ) {
+        free_ev_que_ring ( ev_que );
         freeListFree ( dbevEventQueueFreeList, ev_que );
         return NULL;
     }
-    ev_que->evUser = evUser;
     return ev_que;
 }
 
@@ -450,9 +750,9 @@ dbEventSubscription db_add_event (
     while ( TRUE ) {
         int success = 0;
         LOCKEVQUE ( ev_que );
-        success = ( ev_que->quota < EVENTQUESIZE - EVENTENTRIES );
+        success = ( ev_que->quota < EVENTSPERQUE - 1 );
         if ( success ) {
-            ev_que->quota += EVENTENTRIES;
+            ev_que->quota++;
         }
         UNLOCKEVQUE ( ev_que );
         if ( success ) {
@@ -476,6 +776,12 @@ dbEventSubscription db_add_event (
 
     pevent->npend =     0ul;
     pevent->nreplace =  0ul;
+    EVSUBPVT(pevent)->npendMax = 0ul;
+    EVSUBPVT(pevent)->pLastSlot = NULL;
+    EVSUBPVT(pevent)->npend = 0u;
+    EVSUBPVT(pevent)->refs = 1u; /* until db_cancel_event() */
+    EVSUBPVT(pevent)->inCallback = FALSE;
+    EVSUBPVT(pevent)->canceled = FALSE;
     pevent->user_sub =  user_sub;
     pevent->user_arg =  user_arg;
     pevent->chan =      chan;
@@ -551,12 +857,38 @@ static void event_remove ( struct event_que *ev_que,
     }
     else {
         assert ( pevent->npend > 1u );
-        assert ( ev_que->nDuplicates >= 1u );
+        assert ( ev_que->nDuplicates >= 1 );
         ev_que->nDuplicates--;
     }
     pevent->npend--;
 }
 
+/*
+ * cancel_event_lf()
+ * event queue lock _must_ be applied
+ * returns true if the caller must wait for the event task
+ */
+static int cancel_event_lf ( struct evSubscrip *pevent )
+{
+    event_subscr * const ppvt = EVSUBPVT(pevent);
+    struct event_que * const ev_que = pevent->ev_que;
+    int sync;
+
+    /* pairs with the event task setting inCallback, then testing
+     * canceled, so that at least one of us sees the other */
+    epicsAtomicCmpAndSwapIntT ( &ppvt->canceled, FALSE, TRUE );
+    sync = epicsAtomicGetIntT ( &ppvt->inCallback ) &&
+        ev_que->evUser->taskid != epicsThreadGetIdSelf();
+
+    /* whoever drops the last reference frees, the event task
+     * once it has taken the events still queued */
+    if ( epicsAtomicDecrSizeT ( &ppvt->refs ) == 0u ) {
+        ev_que->quota--;
+        freeListFree ( dbevEventSubscriptionFreeList, pevent );
+    }
+    return sync;
+}
+
 /*
  * DB_CANCEL_EVENT()
  *
@@ -576,7 +908,11 @@ void db_cancel_event (dbEventSubscription event)
 
     pevent->user_sub = NULL; /* callback pointer doubles as canceled flag */
 
-    if(pevent->callBackInProgress) {
+    if(que->evUser->lockFree) {
+        /* event_read_lf() doesn't take the lock for each event */
+        sync = cancel_event_lf(pevent);
+
+    } else if(pevent->callBackInProgress) {
         /* this event callback is pending or in-progress in event_task. */
         if(pevent->ev_que->evUser->taskid != epicsThreadGetIdSelf())
             sync = 1; /* concurrent to event_task, so wait */
@@ -587,7 +923,7 @@ void db_cancel_event (dbEventSubscription event)
     } else {
         /* no other references, cleanup now */
 
-        pevent->ev_que->quota -= EVENTENTRIES;
+        pevent->ev_que->quota--;
         freeListFree ( dbevEventSubscriptionFreeList, pevent );
     }
 
@@ -607,7 +943,7 @@ void db_cancel_event (dbEventSubscription event)
         do {
             epicsMutexUnlock( evUser->lock );
             /* ensure worker will cycle at least once */
-            epicsEventMustTrigger(evUser->ppendsem);
+            event_wake(evUser);
 
             if(wait.wake) {
                 epicsEventMustWait(wait.wake);
@@ -682,7 +1018,7 @@ int db_post_extra_labor (dbEventCtx ctx)
     epicsMutexUnlock ( evUser->lock );
 
     if ( doit ) {
-        epicsEventSignal(evUser->ppendsem);
+        event_wake(evUser);
     }
 
     return DB_EVENT_OK;
@@ -728,6 +1064,109 @@ static db_field_log* db_create_field_log (struct dbChannel *chan, int use_val)
     return pLog;
 }
 
+static void snapshot_release (db_snapshot *snap)
+{
+    if ( epicsAtomicDecrIntT ( &snap->refcount ) == 0 ) {
+        free ( snap );
+    }
+}
+
+/* db_field_log::dtor of a log sharing a snapshot */
+static void snapshot_dtor (db_field_log *pfl)
+{
+    snapshot_release ( (db_snapshot *) pfl->u.r.pvt );
+}
+
+/*
+ * snapshot_create()
+ *
+ * Copy the current elements of an array field in order.
+ * NOTE: This assumes that the db scan lock is already applied
+ */
+static db_snapshot * snapshot_create (struct dbChannel *chan)
+{
+    void *pfield = dbChannelField(chan);
+    long capacity = dbChannelElements(chan);
+    long no_elements = capacity;
+    long offset = 0;
+    db_snapshot *snap;
+
+    dbChannelGetArrayInfo(chan, &pfield, &no_elements, &offset);
+    if (no_elements > capacity)
+        no_elements = capacity;
+
+    snap = (db_snapshot *) malloc(sizeof(*snap) +
+        (size_t) no_elements * dbChannelFieldSize(chan));
+    if (!snap)
+        return NULL;
+    snap->pfield = dbChannelField(chan);
+    snap->capacity = capacity;
+    snap->field_size = dbChannelFieldSize(chan);
+    snap->field_type = dbChannelFieldType(chan);
+    do {
+        snap->id = epicsAtomicIncrSizeT(&snapshotSeq);
+    } while (snap->id == 0u);
+    snap->no_elements = no_elements;
+    snap->refcount = 1;
+    dbExtractArray(pfield, snap + 1, dbChannelFieldSize(chan),
+        no_elements, capacity, offset, 1);
+    return snap;
+}
+
+/*
+ * snapshot_share()
+ *
+ * Make a reference type field log use a snapshot of its field, taking
+ * it from the table snaps (or adding it there).  The table holds one
+ * reference to each snapshot, to be released by the caller.  Channels
+ * of one field only share a snapshot if they have the same layout, a
+ * field modifier such as $ may make the same field look different.
+ */
+static void snapshot_share (db_field_log *pLog, struct dbChannel *chan,
+    db_snapshot **snaps, int *nsnaps)
+{
+    db_snapshot *snap = NULL;
+    int i;
+
+    for (i = 0; i < *nsnaps; i++) {
+        if (snaps[i]->pfield == dbChannelField(chan) &&
+                snaps[i]->capacity == dbChannelElements(chan) &&
+                snaps[i]->field_size == dbChannelFieldSize(chan) &&
+                snaps[i]->field_type == dbChannelFieldType(chan)) {
+            snap = snaps[i];
+            break;
+        }
+    }
+    if (!snap) {
+        snap = snapshot_create(chan);
+        if (!snap)
+            return;     /* fall back to referencing the field */
+        if (*nsnaps < SNAPSHOTSPERPOST) {
+            snaps[(*nsnaps)++] = snap;
+        }
+        else {
+            /* not shared, the log takes the creation reference */
+            epicsAtomicDecrIntT(&snap->refcount);
+        }
+    }
+
+    epicsAtomicIncrIntT(&snap->refcount);
+    pLog->u.r.field = snap + 1;
+    pLog->u.r.pvt = snap;
+    pLog->dtor = snapshot_dtor;
+    pLog->no_elements = snap->no_elements;
+}
+
+/*
+ * db_field_log_snapshot_id()
+ */
+size_t db_field_log_snapshot_id (const db_field_log *pfl)
+{
+    if (pfl && pfl->type == dbfl_type_ref && pfl->dtor == snapshot_dtor)
+        return ((const db_snapshot *) pfl->u.r.pvt)->id;
+    return 0u;
+}
+
 /*
  *  DB_CREATE_EVENT_LOG()
  *
@@ -760,6 +1199,146 @@ db_field_log* db_create_read_log (struct dbChannel *chan)
     return pLog;
 }
 
+/*
+ * The lock-free queue's wakeups pair a store and a load on each side,
+ * each side storing with compare-and-swap, which is a full barrier,
+ * so that at least one of them sees the other's store.
+ */
+
+/*
+ * Give back the last entry of a subscription after examining it, or
+ * pass on a new one, and wake the event task if it stopped at the
+ * entry we were examining.
+ */
+static void release_last_slot_lf ( evSubscrip *pevent, db_field_log **pLast )
+{
+    struct event_que * const ev_que = pevent->ev_que;
+
+    epicsAtomicCmpAndSwapPtrT ( &EVSUBPVT(pevent)->pLastSlot,
+        EVQSLOTBUSY, pLast );
+    if ( epicsAtomicCmpAndSwapIntT ( &ev_que->readerWaiting,
+            TRUE, FALSE ) == TRUE ) {
+        event_wake(ev_que->evUser);
+    }
+}
+
+/*
+ *  DB_QUEUE_EVENT_LOG_LF()
+ *
+ *  Lock-free version of db_queue_event_log().
+ *
+ *  Posts for any one subscription are serialized by the record lock,
+ *  so only the event task can race with us on pevent.  The event task
+ *  claims the last entry of a subscription by clearing pLastSlot, so
+ *  while we hold pLastSlot as EVQSLOTBUSY that entry can be examined
+ *  and replaced.
+ *
+ *  We must never wait here for the event task, the record lock we hold
+ *  may be needed by its callbacks (e.g. the CA server's read_reply).
+ */
+static void db_queue_event_log_lf (evSubscrip *pevent, db_field_log *pLog)
+{
+    struct event_que * const ev_que = pevent->ev_que;
+    event_subscr * const ppvt = EVSUBPVT(pevent);
+    db_field_log **pLast;
+    size_t npend;
+    int pos, idx;
+
+    pLast = (db_field_log **) epicsAtomicGetPtrT ( &ppvt->pLastSlot );
+    if ( pLast && epicsAtomicCmpAndSwapPtrT ( &ppvt->pLastSlot,
+            pLast, EVQSLOTBUSY ) != pLast ) {
+        /* the event task has just claimed it */
+        pLast = NULL;
+    }
+    if ( pLast ) {
+        /* if both the last event on the queue and the current event
+         * reference a record field, simply ignore duplicate events.
+         */
+        if ( !dbfl_has_copy(*pLast) && !dbfl_has_copy(pLog) ) {
+            release_last_slot_lf ( pevent, pLast );
+            db_delete_field_log(pLog);
+            return;
+        }
+
+        /*
+         * if one of {flowCtrlMode, not room for one more of each
+         * monitor attached} then replace the last event on the queue
+         */
+        if ( ev_que->evUser->flowCtrlMode ||
+                ringUsedLF ( ev_que ) >= EVQSIZE ( ev_que ) - EVENTSPERQUE ) {
+            goto replace;
+        }
+    }
+
+    /*
+     * Reserve the next position.  The replacement above keeps the ring
+     * from filling, however other producers may be between their test
+     * and their reservation, and the event task may briefly hold one
+     * entry which it has claimed but not yet released.
+     */
+    while ( TRUE ) {
+        pos = epicsAtomicGetIntT ( &ev_que->putpos );
+        if ( POSDIST ( ev_que, pos, epicsAtomicGetIntT ( &ev_que->getpos ) )
+                >= EVQSIZE ( ev_que ) ) {
+            if ( pLast ) {
+                goto replace;
+            }
+            /* nothing of ours queued which could be replaced */
+            epicsAtomicIncrIntT ( &ev_que->nDropped );
+            db_delete_field_log(pLog);
+            return;
+        }
+        if ( epicsAtomicCmpAndSwapIntT ( &ev_que->putpos,
+                pos, POSINC ( ev_que, pos ) ) == pos ) {
+            break;
+        }
+    }
+    idx = POSIDX ( ev_que, pos );
+    assert ( epicsAtomicGetIntT ( &ev_que->seq[idx] ) == pos );
+
+    ev_que->evque[idx] = pevent;
+    ev_que->valque[idx] = pLog;
+    epicsAtomicIncrSizeT ( &ppvt->refs );
+    npend = epicsAtomicIncrSizeT ( &ppvt->npend );
+    if ( npend > 1u ) {
+        epicsAtomicIncrIntT ( &ev_que->nDuplicates );
+    }
+    if ( npend > ppvt->npendMax ) {
+        ppvt->npendMax = (unsigned long) npend;
+    }
+    /* must be visible before the entry can be consumed */
+    if ( pLast ) {
+        release_last_slot_lf ( pevent, &ev_que->valque[idx] );
+    }
+    else {
+        epicsAtomicSetPtrT ( &ppvt->pLastSlot, &ev_que->valque[idx] );
+    }
+
+    /* publish */
+    epicsAtomicCmpAndSwapIntT ( &ev_que->seq[idx], pos, POSINC ( ev_que, pos ) );
+
+    /*
+     * Check for an empty queue only after publishing.  The event task
+     * moves getpos here before it tests seq[], so either it finds the
+     * entry or we wake it.
+     */
+    if ( epicsAtomicGetIntT ( &ev_que->getpos ) == pos ) {
+        event_wake(ev_que->evUser);
+    }
+    return;
+
+replace:
+    {
+        db_field_log * const pOld = *pLast;
+
+        *pLast = pLog;
+        release_last_slot_lf ( pevent, pLast );
+        db_delete_field_log(pOld);
+        pevent->nreplace++;
+        /* the event task has already been notified about this */
+    }
+}
+
 /*
  *  DB_QUEUE_EVENT_LOG()
  *
@@ -771,6 +1350,11 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
     unsigned rngSpace;
 
     ev_que = pevent->ev_que;
+
+    if ( ev_que->evUser->lockFree ) {
+        db_queue_event_log_lf ( pevent, pLog );
+        return;
+    }
     /*
      * evUser ring buffer must be locked for the multiple
      * threads writing/reading it
@@ -802,6 +1386,9 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
     rngSpace = ringSpace ( ev_que );
     if ( pevent->npend>0u &&
         (ev_que->evUser->flowCtrlMode || rngSpace<=EVENTSPERQUE) ) {
+        if ( ! ev_que->evUser->flowCtrlMode ) {
+            ev_que->spaceReplaced = TRUE;
+        }
         /*
          * replace last event if no space is left
          */
@@ -829,17 +1416,23 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
             ev_que->nDuplicates++;
         }
         pevent->npend++;
+        if (pevent->npend > EVSUBPVT(pevent)->npendMax) {
+            EVSUBPVT(pevent)->npendMax = pevent->npend;
+        }
+        if (ev_que->size - rngSpace + 1u > ev_que->highWater) {
+            ev_que->highWater = ev_que->size - rngSpace + 1u;
+        }
         /*
          * if the ring buffer was empty before
          * adding this event
          */
-        if (rngSpace==EVENTQUESIZE) {
+        if (rngSpace==ev_que->size) {
             firstEventFlag = 1;
         }
         else {
             firstEventFlag = 0;
         }
-        ev_que->putix = RNGINC ( ev_que->putix );
+        ev_que->putix = RNGINC ( ev_que, ev_que->putix );
     }
 
     UNLOCKEVQUE (ev_que);
@@ -854,7 +1447,7 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
         /*
          * notify the event handler
          */
-        epicsEventSignal(ev_que->evUser->ppendsem);
+        event_wake(ev_que->evUser);
     }
 }
 
@@ -872,6 +1465,8 @@ unsigned int    caEventMask
 {
     struct dbCommon   * const prec = (struct dbCommon *) pRecord;
     struct evSubscrip *pevent;
+    db_snapshot *snaps[SNAPSHOTSPERPOST];
+    int nsnaps = 0;
 
     if (prec->mlis.count == 0) return DB_EVENT_OK;       /* no monitors set */
 
@@ -887,14 +1482,21 @@ unsigned int    caEventMask
         if ( (dbChannelField(pevent->chan) == (void *)pField || pField==NULL) &&
             (caEventMask & pevent->select)) {
             db_field_log *pLog = db_create_event_log(pevent);
-            if(pLog)
+            if(pLog) {
                 pLog->mask = caEventMask & pevent->select;
+                if (dbEventArraySnapshots && pLog->type == dbfl_type_ref)
+                    snapshot_share(pLog, pevent->chan, snaps, &nsnaps);
+            }
             pLog = dbChannelRunPreChain(pevent->chan, pLog);
             if (pLog) db_queue_event_log(pevent, pLog);
         }
     }
 
     UNLOCKREC (prec);
+
+    while (nsnaps > 0)
+        snapshot_release(snaps[--nsnaps]);
+
     return DB_EVENT_OK;
 
 }
@@ -907,22 +1509,162 @@ void db_post_single_event (dbEventSubscription event)
     struct evSubscrip * const pevent = (struct evSubscrip *) event;
     struct dbCommon * const prec = dbChannelRecord(pevent->chan);
     db_field_log *pLog;
+    db_snapshot *snap;
+    int nsnaps = 0;
 
     dbScanLock (prec);
 
     pLog = db_create_event_log(pevent);
+    if (pLog && dbEventArraySnapshots && pLog->type == dbfl_type_ref)
+        snapshot_share(pLog, pevent->chan, &snap, &nsnaps);
+    if (nsnaps)
+        snapshot_release(snap);
     pLog = dbChannelRunPreChain(pevent->chan, pLog);
     if(pLog) db_queue_event_log(pevent, pLog);
 
     dbScanUnlock (prec);
 }
 
+/*
+ * Claim the entry at pSlot.  If it is the last one for its subscription
+ * and a producer is examining it then return FALSE, the producer wakes
+ * the event task when it is done.
+ */
+static int claim_entry_lf ( evSubscrip *pevent, db_field_log **pSlot )
+{
+    struct event_que * const ev_que = pevent->ev_que;
+    event_subscr * const ppvt = EVSUBPVT(pevent);
+
+    while ( TRUE ) {
+        void * const cur = epicsAtomicGetPtrT ( &ppvt->pLastSlot );
+        if ( cur == EVQSLOTBUSY ) {
+            epicsAtomicCmpAndSwapIntT ( &ev_que->readerWaiting, FALSE, TRUE );
+            if ( epicsAtomicGetPtrT ( &ppvt->pLastSlot ) == EVQSLOTBUSY ) {
+                return FALSE;
+            }
+            epicsAtomicCmpAndSwapIntT ( &ev_que->readerWaiting, TRUE, FALSE );
+        }
+        else if ( cur != (void *) pSlot ||
+                epicsAtomicCmpAndSwapPtrT ( &ppvt->pLastSlot,
+                    cur, NULL ) == cur ) {
+            return TRUE;
+        }
+    }
+}
+
+/*
+ * EVENT_READ_LF()
+ *
+ * Lock-free version of event_read().  Only the event task calls this.
+ */
+static int event_read_lf ( struct event_que *ev_que )
+{
+    int notifiedRemaining = 0;
+
+    /*
+     * if in flow control mode drain duplicates and then
+     * suspend processing events until flow control
+     * mode is over
+     */
+    if ( ev_que->evUser->flowCtrlMode &&
+            epicsAtomicGetIntT ( &ev_que->nDuplicates ) <= 0 ) {
+        return DB_EVENT_OK;
+    }
+
+    while ( TRUE ) {
+        const int pos = ev_que->getpos;
+        const int idx = POSIDX ( ev_que, pos );
+        db_field_log ** const pSlot = &ev_que->valque[idx];
+        struct evSubscrip *pevent;
+        event_subscr *ppvt;
+        EVENTFUNC *user_sub;
+        db_field_log *pfl;
+        int eventsRemaining;
+        unsigned used;
+
+        /* empty, or reserved but not yet published */
+        if ( epicsAtomicGetIntT ( &ev_que->seq[idx] ) != POSINC ( ev_que, pos ) ) {
+            break;
+        }
+        epicsAtomicReadMemoryBarrier ();
+        pevent = ev_que->evque[idx];
+        used = (unsigned) ringUsedLF ( ev_que );
+        if ( used > ev_que->highWater ) {
+            ev_que->highWater = used;
+        }
+
+        if ( ! claim_entry_lf ( pevent, pSlot ) ) {
+            break;
+        }
+
+        pfl = *pSlot;
+        ev_que->evque[idx] = EVENTQEMPTY;
+        *pSlot = NULL;
+
+        /* release the slot for the next lap, then advance */
+        epicsAtomicWriteMemoryBarrier ();
+        epicsAtomicSetIntT ( &ev_que->seq[idx], POSLAP ( ev_que, pos ) );
+        epicsAtomicCmpAndSwapIntT ( &ev_que->getpos, pos, POSINC ( ev_que, pos ) );
+        eventsRemaining =
+            epicsAtomicGetIntT ( &ev_que->putpos ) != POSINC ( ev_que, pos );
+
+        ppvt = EVSUBPVT(pevent);
+        if ( epicsAtomicDecrSizeT ( &ppvt->npend ) > 0u ) {
+            epicsAtomicDecrIntT ( &ev_que->nDuplicates );
+        }
+
+        /*
+         * No lock is taken here, db_cancel_event() sets canceled then
+         * tests inCallback, we do the reverse.  If it missed us it
+         * waits for this pass of the event task to end.
+         */
+        epicsAtomicCmpAndSwapIntT ( &ppvt->inCallback, FALSE, TRUE );
+        user_sub = epicsAtomicGetIntT ( &ppvt->canceled ) ?
+            NULL : pevent->user_sub;
+        if ( user_sub ) {
+            /* Run post-event-queue filter chain */
+            if (ellCount(&pevent->chan->post_chain)) {
+                pfl = dbChannelRunPostChain(pevent->chan, pfl);
+            }
+            if (pfl) {
+                /* Issue user callback */
+                ( *user_sub ) ( pevent->user_arg, pevent->chan,
+                                eventsRemaining, pfl );
+                notifiedRemaining = eventsRemaining;
+            }
+        }
+        epicsAtomicCmpAndSwapIntT ( &ppvt->inCallback, TRUE, FALSE );
+
+        /* callback may have called db_cancel_event() */
+        if ( epicsAtomicDecrSizeT ( &ppvt->refs ) == 0u ) {
+            LOCKEVQUE (ev_que);
+            ev_que->quota--;
+            freeListFree ( dbevEventSubscriptionFreeList, pevent );
+            UNLOCKEVQUE (ev_que);
+        }
+
+        db_delete_field_log(pfl);
+    }
+
+    if(notifiedRemaining && !ev_que->possibleStall) {
+        ev_que->possibleStall = 1;
+        errlogPrintf(ERL_WARNING " dbEvent possible queue stall\n");
+    }
+
+    return DB_EVENT_OK;
+}
+
 /*
  * EVENT_READ()
  */
 static int event_read ( struct event_que *ev_que )
 {
     int notifiedRemaining = 0;
+    int delivered = 0;
+
+    if ( ev_que->evUser->lockFree ) {
+        return event_read_lf ( ev_que );
+    }
 
     /*
      * evUser ring buffer must be locked for the multiple
@@ -935,7 +1677,7 @@ static int event_read ( struct event_que *ev_que )
      * suspend processing events until flow control
      * mode is over
      */
-    if ( ev_que->evUser->flowCtrlMode && ev_que->nDuplicates == 0u ) {
+    if ( ev_que->evUser->flowCtrlMode && ev_que->nDuplicates == 0 ) {
         UNLOCKEVQUE (ev_que);
         return DB_EVENT_OK;
     }
@@ -952,8 +1694,9 @@ static int event_read ( struct event_que *ev_que )
          */
 
         event_remove ( ev_que, ev_que->getix, EVENTQEMPTY );
-        ev_que->getix = RNGINC ( ev_que->getix );
+        ev_que->getix = RNGINC ( ev_que, ev_que->getix );
         eventsRemaining = ev_que->evque[ev_que->getix] != EVENTQEMPTY;
+        delivered = 1;
 
         /*
          * Next event pointer can be used by event tasks to determine
@@ -988,7 +1731,7 @@ static int event_read ( struct event_que *ev_que )
         }
         /* callback may have called db_cancel_event(), so must check user_sub again */
         if(!pevent->user_sub && !pevent->npend) {
-            pevent->ev_que->quota -= EVENTENTRIES;
+            pevent->ev_que->quota--;
             freeListFree ( dbevEventSubscriptionFreeList, pevent );
         }
         db_delete_field_log(pfl);
@@ -999,90 +1742,102 @@ static int event_read ( struct event_que *ev_que )
         errlogPrintf(ERL_WARNING " dbEvent possible queue stall\n");
     }
 
+    /*
+     * grow the ring if events were replaced for lack of space
+     * during several passes in a row which delivered events
+     */
+    if ( ev_que->spaceReplaced ) {
+        ev_que->spaceReplaced = FALSE;
+        if ( ++ev_que->backlog >= EVENTGROWPASSES ) {
+            ev_que->backlog = 0u;
+            grow_ev_que ( ev_que );
+        }
+    }
+    else if ( delivered ) {
+        ev_que->backlog = 0u;
+    }
+
     UNLOCKEVQUE (ev_que);
 
     return DB_EVENT_OK;
 }
 
-static void event_task (void *pParm)
+/*
+ * one pass of the event task after being woken, returns pendexit
+ */
+static unsigned char event_work ( struct event_user * const evUser )
 {
-    struct event_user * const evUser = (struct event_user *) pParm;
     struct event_que * ev_que;
     unsigned char pendexit;
+    void (*pExtraLaborSub) (void *);
+    void *pExtraLaborArg;
 
-    /* init hook */
-    if (evUser->init_func) {
-        (*evUser->init_func)(evUser->init_func_arg);
+    /*
+     * check to see if the caller has offloaded
+     * labor to this task
+     */
+    epicsMutexMustLock ( evUser->lock );
+    evUser->extraLaborBusy = TRUE;
+    if ( evUser->extra_labor && evUser->extralabor_sub ) {
+        evUser->extra_labor = FALSE;
+        pExtraLaborSub = evUser->extralabor_sub;
+        pExtraLaborArg = evUser->extralabor_arg;
     }
+    else {
+        pExtraLaborSub = NULL;
+        pExtraLaborArg = NULL;
+    }
+    if ( pExtraLaborSub ) {
+        epicsMutexUnlock ( evUser->lock );
+        (*pExtraLaborSub)(pExtraLaborArg);
+        epicsMutexMustLock ( evUser->lock );
+    }
+    evUser->extraLaborBusy = FALSE;
 
-    taskwdInsert ( epicsThreadGetIdSelf(), NULL, NULL );
-
-    do {
-        void (*pExtraLaborSub) (void *);
-        void *pExtraLaborArg;
-        epicsEventMustWait(evUser->ppendsem);
-
-        /*
-         * check to see if the caller has offloaded
-         * labor to this task
-         */
+    for ( ev_que = &evUser->firstque; ev_que; ev_que = ev_que->nextque ) {
+        /* unlock during iteration is safe as event_que will not be free'd */
+        epicsMutexUnlock ( evUser->lock );
+        event_read (ev_que);
         epicsMutexMustLock ( evUser->lock );
-        evUser->extraLaborBusy = TRUE;
-        if ( evUser->extra_labor && evUser->extralabor_sub ) {
-            evUser->extra_labor = FALSE;
-            pExtraLaborSub = evUser->extralabor_sub;
-            pExtraLaborArg = evUser->extralabor_arg;
-        }
-        else {
-            pExtraLaborSub = NULL;
-            pExtraLaborArg = NULL;
-        }
-        if ( pExtraLaborSub ) {
-            epicsMutexUnlock ( evUser->lock );
-            (*pExtraLaborSub)(pExtraLaborArg);
-            epicsMutexMustLock ( evUser->lock );
+    }
+    pendexit = evUser->pendexit;
+
+    evUser->pflush_seq++;
+    if(ellCount(&evUser->waiters)) {
+        /* hold lock throughout to avoid race between event trigger and destroy */
+        ELLNODE *cur;
+        for(cur = ellFirst(&evUser->waiters); cur; cur = ellNext(cur)) {
+            event_waiter *w = CONTAINER(cur, event_waiter, node);
+            if(w->wake)
+                epicsEventMustTrigger(w->wake);
         }
-        evUser->extraLaborBusy = FALSE;
+    }
 
-        for ( ev_que = &evUser->firstque; ev_que; ev_que = ev_que->nextque ) {
-            /* unlock during iteration is safe as event_que will not be free'd */
-            epicsMutexUnlock ( evUser->lock );
-            event_read (ev_que);
-            epicsMutexMustLock ( evUser->lock );
-        }
-        pendexit = evUser->pendexit;
-
-        evUser->pflush_seq++;
-        if(ellCount(&evUser->waiters)) {
-            /* hold lock throughout to avoid race between event trigger and destroy */
-            ELLNODE *cur;
-            for(cur = ellFirst(&evUser->waiters); cur; cur = ellNext(cur)) {
-                event_waiter *w = CONTAINER(cur, event_waiter, node);
-                if(w->wake)
-                    epicsEventMustTrigger(w->wake);
-            }
-        }
+    epicsMutexUnlock ( evUser->lock );
 
-        epicsMutexUnlock ( evUser->lock );
+    return pendexit;
+}
 
-    } while( ! pendexit );
+/*
+ * free the event queues after the last pass, and let
+ * db_close_events() go on
+ */
+static void event_exit ( struct event_user * const evUser )
+{
+    struct event_que *ev_que, *nextque;
 
     epicsMutexDestroy(evUser->firstque.writelock);
-
-    {
-        struct event_que    *nextque;
-
-        ev_que = evUser->firstque.nextque;
-        while (ev_que) {
-            nextque = ev_que->nextque;
-            epicsMutexDestroy(ev_que->writelock);
-            freeListFree(dbevEventQueueFreeList, ev_que);
-            ev_que = nextque;
-        }
+    free_ev_que_ring(&evUser->firstque);
+
+    ev_que = evUser->firstque.nextque;
+    while (ev_que) {
+        nextque = ev_que->nextque;
+        epicsMutexDestroy(ev_que->writelock);
+        free_ev_que_ring(ev_que);
+        freeListFree(dbevEventQueueFreeList, ev_que);
+        ev_que = nextque;
     }
 
-    taskwdRemove(epicsThreadGetIdSelf());
-
     /* use stopSync to ensure pexitsem is not destroy'd
      * until epicsEventSignal() has returned.
      */
@@ -1091,8 +1846,85 @@ static void event_task (void *pParm)
     epicsEventSignal(evUser->pexitsem);
 
     epicsMutexUnlock(stopSync);
+}
 
-    return;
+static void event_task (void *pParm)
+{
+    struct event_user * const evUser = (struct event_user *) pParm;
+    unsigned char pendexit;
+
+    /* init hook */
+    if (evUser->init_func) {
+        (*evUser->init_func)(evUser->init_func_arg);
+    }
+
+    taskwdInsert ( epicsThreadGetIdSelf(), NULL, NULL );
+
+    do {
+        epicsEventMustWait(evUser->ppendsem);
+        pendexit = event_work ( evUser );
+    } while( ! pendexit );
+
+    taskwdRemove(epicsThreadGetIdSelf());
+
+    event_exit ( evUser );
+}
+
+static void event_pool_task (void *pParm)
+{
+    struct event_pool * const pool = (struct event_pool *) pParm;
+
+    taskwdInsert ( epicsThreadGetIdSelf(), NULL, NULL );
+
+    epicsMutexMustLock ( pool->lock );
+    while ( ! pool->exit ) {
+        ELLNODE *pNode = ellGet ( &pool->readyQ );
+        struct event_user *evUser;
+        unsigned char pendexit;
+
+        if ( ! pNode ) {
+            epicsMutexUnlock ( pool->lock );
+            epicsEventMustWait ( pool->ready );
+            epicsMutexMustLock ( pool->lock );
+            continue;
+        }
+        if ( ellCount ( &pool->readyQ ) ) {
+            /* another thread may take the next one */
+            epicsEventSignal ( pool->ready );
+        }
+        evUser = CONTAINER ( pNode, struct event_user, poolNode );
+        evUser->poolState = poolBusy;
+        epicsMutexUnlock ( pool->lock );
+
+        /* for db_cancel_event() from a callback */
+        evUser->taskid = epicsThreadGetIdSelf();
+        if (evUser->init_func) {
+            (*evUser->init_func)(evUser->init_func_arg);
+        }
+        pendexit = event_work ( evUser );
+        evUser->taskid = NULL;
+
+        epicsMutexMustLock ( pool->lock );
+        if ( pendexit ) {
+            /* left poolBusy, so that it is never queued again */
+            epicsMutexUnlock ( pool->lock );
+            event_exit ( evUser );
+            epicsMutexMustLock ( pool->lock );
+        }
+        else if ( evUser->poolState == poolBusyAgain ) {
+            evUser->poolState = poolQueued;
+            ellAdd ( &pool->readyQ, &evUser->poolNode );
+        }
+        else {
+            evUser->poolState = poolIdle;
+        }
+    }
+    epicsMutexUnlock ( pool->lock );
+
+    /* wake the next thread to exit */
+    epicsEventSignal ( pool->ready );
+
+    taskwdRemove(epicsThreadGetIdSelf());
 }
 
 /*
@@ -1115,7 +1947,7 @@ int db_start_events (
       * only one ca_pend_event thread may be
       * started for each evUser
       */
-     if (evUser->taskid) {
+     if (evUser->taskid || evUser->pool) {
          epicsMutexUnlock ( evUser->lock );
          return DB_EVENT_OK;
      }
@@ -1136,16 +1968,187 @@ int db_start_events (
      return DB_EVENT_OK;
 }
 
+/*
+ * DB_EVENT_POOL_CREATE()
+ */
+dbEventPool db_event_pool_create ( const char *name,
+    unsigned nThreads, unsigned osiPriority )
+{
+    struct event_pool *pool;
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    unsigned i;
+
+    if ( nThreads == 0u ) {
+        return NULL;
+    }
+
+    pool = (struct event_pool *) calloc ( 1, sizeof ( *pool ) );
+    if ( ! pool ) {
+        return NULL;
+    }
+    pool->tids = (epicsThreadId *) calloc ( nThreads, sizeof ( epicsThreadId ) );
+    pool->lock = epicsMutexCreate ();
+    pool->ready = epicsEventCreate ( epicsEventEmpty );
+    if ( ! pool->tids || ! pool->lock || ! pool->ready ) {
+        goto fail;
+    }
+    ellInit ( &pool->readyQ );
+
+    opts.stackSize = epicsThreadGetStackSize(epicsThreadStackMedium);
+    opts.priority = osiPriority;
+    opts.joinable = 1;
+
+    for ( i = 0u; i < nThreads; i++ ) {
+        char taskname[32];
+
+        epicsSnprintf ( taskname, sizeof ( taskname ), "%s%u",
+            name ? name : EVENT_PEND_NAME, i );
+        pool->tids[i] = epicsThreadCreateOpt (
+            taskname, event_pool_task, (void *) pool, &opts );
+        if ( ! pool->tids[i] ) {
+            break;
+        }
+        pool->nThreads++;
+    }
+    if ( pool->nThreads > 0u ) {
+        return pool;
+    }
+
+fail:
+    if ( pool->ready )
+        epicsEventDestroy ( pool->ready );
+    if ( pool->lock )
+        epicsMutexDestroy ( pool->lock );
+    free ( pool->tids );
+    free ( pool );
+    return NULL;
+}
+
+/*
+ * DB_EVENT_POOL_DESTROY()
+ *
+ * db_close_events() must have been called for all event users
+ * started with the pool
+ */
+void db_event_pool_destroy ( dbEventPool pool )
+{
+    unsigned i;
+
+    if ( ! pool ) {
+        return;
+    }
+
+    epicsMutexMustLock ( pool->lock );
+    pool->exit = TRUE;
+    epicsMutexUnlock ( pool->lock );
+    epicsEventSignal ( pool->ready );
+
+    for ( i = 0u; i < pool->nThreads; i++ ) {
+        epicsThreadMustJoin ( pool->tids[i] );
+    }
+
+    epicsEventDestroy ( pool->ready );
+    epicsMutexDestroy ( pool->lock );
+    free ( pool->tids );
+    free ( pool );
+}
+
+/*
+ * DB_START_EVENTS_POOL()
+ *
+ * like db_start_events(), but served by the threads of a pool,
+ * which call init_func before each pass
+ */
+int db_start_events_pool (
+    dbEventCtx ctx, dbEventPool pool, void (*init_func)(void *),
+    void *init_func_arg )
+{
+     struct event_user * const evUser = (struct event_user *) ctx;
+
+     if ( ! pool ) {
+         return DB_EVENT_ERROR;
+     }
+
+     epicsMutexMustLock ( evUser->lock );
+
+     if (evUser->taskid || evUser->pool) {
+         epicsMutexUnlock ( evUser->lock );
+         return DB_EVENT_OK;
+     }
+
+     evUser->init_func = init_func;
+     evUser->init_func_arg = init_func_arg;
+     evUser->poolState = poolIdle;
+     evUser->pool = pool;
+     evUser->pendexit = FALSE;
+     epicsMutexUnlock ( evUser->lock );
+
+     /* for anything queued before */
+     event_wake ( evUser );
+     return DB_EVENT_OK;
+}
+
 /*
  * db_event_change_priority()
+ *
+ * the threads of a pool keep their priority
  */
 void db_event_change_priority ( dbEventCtx ctx,
                                         unsigned epicsPriority )
 {
     struct event_user * const evUser = ( struct event_user * ) ctx;
+
+    if ( evUser->pool ) {
+        return;
+    }
     epicsThreadSetPriority ( evUser->taskid, epicsPriority );
 }
 
+/*
+ * db_event_npend_max()
+ */
+unsigned long db_event_npend_max ( dbEventSubscription es )
+{
+    return EVSUBPVT(es)->npendMax;
+}
+
+/*
+ * db_event_set_queue_entries()
+ *
+ * Set the number of que entries for each event, and the limit for growing
+ * a backlogged que, before any events are added.  Queues are not grown
+ * when nEntriesMax <= nEntries, nor for a lock-free event user.
+ */
+int db_event_set_queue_entries ( dbEventCtx ctx,
+    unsigned nEntries, unsigned nEntriesMax )
+{
+    struct event_user * const evUser = (struct event_user *) ctx;
+    struct event_que * const ev_que = &evUser->firstque;
+    int status = DB_EVENT_ERROR;
+
+    if ( nEntries == 0u || nEntries > EVENTENTRIESMAX ) {
+        return DB_EVENT_ERROR;
+    }
+    if ( nEntriesMax > EVENTENTRIESMAX ) {
+        nEntriesMax = EVENTENTRIESMAX;
+    }
+
+    epicsMutexMustLock ( evUser->lock );
+    LOCKEVQUE ( ev_que );
+    if ( ev_que->quota == 0u && ! ev_que->nextque ) {
+        if ( nEntries * EVENTSPERQUE == ev_que->size ||
+                ! alloc_ev_que_ring ( ev_que, nEntries ) ) {
+            evUser->nEntries = nEntries;
+            evUser->nEntriesMax = nEntriesMax;
+            status = DB_EVENT_OK;
+        }
+    }
+    UNLOCKEVQUE ( ev_que );
+    epicsMutexUnlock ( evUser->lock );
+
+    return status;
+}
+
 /*
  * db_event_flow_ctrl_mode_on()
  */
@@ -1159,7 +2162,7 @@ void db_event_flow_ctrl_mode_on (dbEventCtx ctx)
     /*
      * notify the event handler task
      */
-    epicsEventSignal(evUser->ppendsem);
+    event_wake(evUser);
 }
 
 /*
@@ -1175,7 +2178,7 @@ void db_event_flow_ctrl_mode_off (dbEventCtx ctx)
     /*
      * notify the event handler task
      */
-    epicsEventSignal (evUser->ppendsem);
+    event_wake(evUser);
 }
 
 /*
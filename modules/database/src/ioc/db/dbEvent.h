@@ -41,6 +41,18 @@ typedef void * dbEventSubscription;
 typedef void * dbEventCtx;
 #endif
 
+/* Non-zero to create new event users with a lock-free event queue */
+DBCORE_API extern int dbEventLockFree;
+/* Default number of queue entries for each subscription of new event users,
+ * and the limit to which a backlogged queue may grow them (0 for no growth).
+ */
+DBCORE_API extern int dbEventQueueEntries;
+DBCORE_API extern int dbEventQueueEntriesMax;
+/* Non-zero for db_post_events() to copy each posted array field once,
+ * sharing the copy between the event logs of all its subscriptions.
+ */
+DBCORE_API extern int dbEventArraySnapshots;
+
 DBCORE_API int db_event_list (
     const char *name, unsigned level);
 DBCORE_API int dbel (
@@ -61,10 +73,28 @@ DBCORE_API int db_add_extra_labor_event (
 DBCORE_API void db_flush_extra_labor_event (dbEventCtx);
 DBCORE_API int db_post_extra_labor (dbEventCtx ctx);
 DBCORE_API void db_event_change_priority ( dbEventCtx ctx, unsigned epicsPriority );
+DBCORE_API int db_event_set_queue_entries ( dbEventCtx ctx,
+    unsigned nEntries, unsigned nEntriesMax );
+
+/* A pool of threads serving the event users started with
+ * db_start_events_pool(), in place of a thread for each of them.
+ * One slow callback delays the other event users of the pool, so callbacks
+ * must not wait for them, e.g. db_cancel_event() of their subscriptions.
+ * Destroy the pool only after db_close_events() for all its users.
+ */
+typedef struct event_pool * dbEventPool;
+DBCORE_API dbEventPool db_event_pool_create (
+    const char *name, unsigned nThreads, unsigned osiPriority );
+DBCORE_API void db_event_pool_destroy (dbEventPool pool);
+DBCORE_API int db_start_events_pool (
+    dbEventCtx ctx, dbEventPool pool, void (*init_func)(void *),
+    void *init_func_arg );
 
 #ifdef EPICS_PRIVATE_API
 DBCORE_API void db_cleanup_events(void);
 DBCORE_API void db_init_event_freelists (void);
+/* most times the subscription has been on its queue at once */
+DBCORE_API unsigned long db_event_npend_max (dbEventSubscription es);
 #endif
 
 typedef void EVENTFUNC (void *user_arg, struct dbChannel *chan,
@@ -82,6 +112,10 @@ DBCORE_API struct db_field_log* db_create_event_log (struct evSubscrip *pevent);
 DBCORE_API struct db_field_log* db_create_read_log (struct dbChannel *chan);
 DBCORE_API void db_delete_field_log (struct db_field_log *pfl);
 DBCORE_API int db_available_logs(void);
+/* Non-zero when pfl refers to an array copy shared by all event logs
+ * of one post (see dbEventArraySnapshots), the same for all of them.
+ */
+DBCORE_API size_t db_field_log_snapshot_id (const struct db_field_log *pfl);
 
 #define DB_EVENT_OK 0
 #define DB_EVENT_ERROR (-1)
@@ -145,7 +145,7 @@ static const iocshArg * const dbcarArgs[2] = {&dbcarArg0,&dbcarArg1};
 static const iocshFuncDef dbcarFuncDef = {"dbcar",2,dbcarArgs,
                                           "Database Channel Access Report.\n"
                                           "Shows status of Channel Access links (CA_LINK).\n"
-                                          " level 0 - Shows statistics for all links.\n"
+                                          " level 0 - Shows statistics for all links and link threads.\n"
                                           "       1 - Shows info. of only disconnected links.\n"
                                           "       2 - Shows info. for all links.\n"};
 static void dbcarCallFunc(const iocshArgBuf *args)
@@ -329,6 +329,34 @@ static const iocshFuncDef dbhcrFuncDef = {"dbhcr",0,0,
                                           "sort report > report.sorted\n"};
 static void dbhcrCallFunc(const iocshArgBuf *args) { dbhcr();}
 
+/* dbProfileShow */
+static const iocshArg dbProfileShowArg0 = { "count",iocshArgInt};
+static const iocshArg * const dbProfileShowArgs[1] = {&dbProfileShowArg0};
+static const iocshFuncDef dbProfileShowFuncDef = {"dbProfileShow",1,dbProfileShowArgs,
+                                          "Show the records with the longest total processing time.\n"
+                                          "Times are collected after dbProfileEnable 1, and include\n"
+                                          "records processed through links.\n"
+                                          "  count - number of records to show (default 20)\n"
+                                          "Example: dbProfileEnable 1\n"
+                                          "         dbProfileShow 10\n"};
+static void dbProfileShowCallFunc(const iocshArgBuf *args)
+{ dbProfileShow(args[0].ival);}
+
+/* dbProfileEnable */
+static const iocshArg dbProfileEnableArg0 = { "on",iocshArgInt};
+static const iocshArg * const dbProfileEnableArgs[1] = {&dbProfileEnableArg0};
+static const iocshFuncDef dbProfileEnableFuncDef = {"dbProfileEnable",1,dbProfileEnableArgs,
+                                          "Start (1) or stop (0) collecting record processing times.\n"
+                                          "Before iocInit setting the variable dbProcessProfile is\n"
+                                          "the same.\n"};
+static void dbProfileEnableCallFunc(const iocshArgBuf *args)
+{ iocshSetError(dbProfileEnable(args[0].ival));}
+
+/* dbProfileReset */
+static const iocshFuncDef dbProfileResetFuncDef = {"dbProfileReset",0,0,
+                                          "Clear the processing times collected for all records.\n"};
+static void dbProfileResetCallFunc(const iocshArgBuf *args) { dbProfileReset();}
+
 /* gft */
 static const iocshArg gftArg0 = { "record name",iocshArgStringRecord};
 static const iocshArg * const gftArgs[1] = {&gftArg0};
@@ -414,6 +442,30 @@ static const iocshFuncDef dbLockShowLockedFuncDef = {
 static void dbLockShowLockedCallFunc(const iocshArgBuf *args)
 { dbLockShowLocked(args[0].ival);}
 
+/* dbLockStatsShow */
+static const iocshArg dbLockStatsShowArg0 = { "count",iocshArgInt};
+static const iocshArg dbLockStatsShowArg1 = { "interest level",iocshArgInt};
+static const iocshArg * const dbLockStatsShowArgs[2] =
+    {&dbLockStatsShowArg0,&dbLockStatsShowArg1};
+static const iocshFuncDef dbLockStatsShowFuncDef = {
+    "dbLockStatsShow",2,dbLockStatsShowArgs,
+    "Show the lock sets threads waited longest for.\n"
+    "Statistics are collected while the variable dbLockStats is non-zero.\n"
+    "count - Number of lock sets to show, 20 if zero.\n"
+    "interest level 0 - Show lock set statistics only.\n"
+    "               1 - Show each record in the lock set.\n"
+    "               2 - Show each record and all database links in the lock set.\n\n"
+    "Example: dbLockStatsShow 10 2\n"
+};
+static void dbLockStatsShowCallFunc(const iocshArgBuf *args)
+{ dbLockStatsShow(args[0].ival,args[1].ival);}
+
+/* dbLockStatsReset */
+static const iocshFuncDef dbLockStatsResetFuncDef = {"dbLockStatsReset",0,0,
+    "Clear the lock set statistics.\n"};
+static void dbLockStatsResetCallFunc(const iocshArgBuf *args)
+{ dbLockStatsReset();}
+
 /* scanOnceSetQueueSize */
 static const iocshArg scanOnceSetQueueSizeArg0 = { "size",iocshArgInt};
 static const iocshArg * const scanOnceSetQueueSizeArgs[1] =
@@ -446,6 +498,21 @@ static const iocshFuncDef scanpplFuncDef = {"scanppl",1,scanpplArgs,
 static void scanpplCallFunc(const iocshArgBuf *args)
 { scanppl(args[0].dval);}
 
+/* scanTimingShow */
+static const iocshArg scanTimingShowArg0 = { "scan list",iocshArgString};
+static const iocshArg scanTimingShowArg1 = { "reset",iocshArgInt};
+static const iocshArg * const scanTimingShowArgs[2] =
+    {&scanTimingShowArg0,&scanTimingShowArg1};
+static const iocshFuncDef scanTimingShowFuncDef = {"scanTimingShow",2,scanTimingShowArgs,
+                                                   "Show how late scans started and how long they took.\n"
+                                                   "scan list is a periodic SCAN choice, \"I/O Intr <prio>\",\n"
+                                                   "\"Event <prio>\" or \"Once\", all lists if omitted.\n"
+                                                   "If reset is non-zero the statistics are cleared.\n"
+                                                   "Scans are only timed while the variable\n"
+                                                   "scanRecordTiming is non-zero.\n"};
+static void scanTimingShowCallFunc(const iocshArgBuf *args)
+{ scanTimingShow(args[0].sval, args[1].ival);}
+
 /* scanpel */
 static const iocshArg scanpelArg0 = { "event name",iocshArgString};
 static const iocshArg * const scanpelArgs[1] = {&scanpelArg0};
@@ -482,6 +549,21 @@ static void callbackSetQueueSizeCallFunc(const iocshArgBuf *args)
     callbackSetQueueSize(args[0].ival);
 }
 
+/* callbackSetQueueGrowth */
+static const iocshArg callbackSetQueueGrowthArg0 = { "kbytes",iocshArgInt};
+static const iocshArg * const callbackSetQueueGrowthArgs[1] =
+    {&callbackSetQueueGrowthArg0};
+static const iocshFuncDef callbackSetQueueGrowthFuncDef = {"callbackSetQueueGrowth",1,callbackSetQueueGrowthArgs,
+                                                           "Let each callback queue grow by up to kbytes of memory\n"
+                                                           "when full, rather than rejecting requests.\n"
+                                                           "It grows in whole blocks of 256 requests, about 4 KiB;\n"
+                                                           "kbytes is rounded down to a number of blocks.\n"
+                                                           "Must be called before iocInit().\n"};
+static void callbackSetQueueGrowthCallFunc(const iocshArgBuf *args)
+{
+    callbackSetQueueGrowth(args[0].ival);
+}
+
 /* callbackQueueShow */
 static const iocshArg callbackQueueShowArg0 = { "reset", iocshArgInt};
 static const iocshArg * const callbackQueueShowArgs[1] =
@@ -598,6 +680,9 @@ void dbIocRegister(void)
     iocshRegister(&dbtpfFuncDef,dbtpfCallFunc);
     iocshRegister(&dbiorFuncDef,dbiorCallFunc);
     iocshRegister(&dbhcrFuncDef,dbhcrCallFunc);
+    iocshRegister(&dbProfileShowFuncDef,dbProfileShowCallFunc);
+    iocshRegister(&dbProfileEnableFuncDef,dbProfileEnableCallFunc);
+    iocshRegister(&dbProfileResetFuncDef,dbProfileResetCallFunc);
     iocshRegister(&gftFuncDef,gftCallFunc);
     iocshRegister(&pftFuncDef,pftCallFunc);
     iocshRegister(&dbtpnFuncDef,dbtpnCallFunc);
@@ -606,15 +691,19 @@ void dbIocRegister(void)
     iocshRegister(&tpnFuncDef,tpnCallFunc);
     iocshRegister(&dblsrFuncDef,dblsrCallFunc);
     iocshRegister(&dbLockShowLockedFuncDef,dbLockShowLockedCallFunc);
+    iocshRegister(&dbLockStatsShowFuncDef,dbLockStatsShowCallFunc);
+    iocshRegister(&dbLockStatsResetFuncDef,dbLockStatsResetCallFunc);
 
     iocshRegister(&scanOnceSetQueueSizeFuncDef,scanOnceSetQueueSizeCallFunc);
     iocshRegister(&scanOnceQueueShowFuncDef,scanOnceQueueShowCallFunc);
     iocshRegister(&scanpplFuncDef,scanpplCallFunc);
+    iocshRegister(&scanTimingShowFuncDef,scanTimingShowCallFunc);
     iocshRegister(&scanpelFuncDef,scanpelCallFunc);
     iocshRegister(&postEventFuncDef,postEventCallFunc);
     iocshRegister(&scanpiolFuncDef,scanpiolCallFunc);
 
     iocshRegister(&callbackSetQueueSizeFuncDef,callbackSetQueueSizeCallFunc);
+    iocshRegister(&callbackSetQueueGrowthFuncDef,callbackSetQueueGrowthCallFunc);
     iocshRegister(&callbackQueueShowFuncDef,callbackQueueShowCallFunc);
     iocshRegister(&callbackParallelThreadsFuncDef,callbackParallelThreadsCallFunc);
 
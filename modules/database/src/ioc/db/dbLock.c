@@ -23,6 +23,7 @@
 #include "epicsSpin.h"
 #include "epicsStdio.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
 #include "errMdef.h"
 
 #include "dbAccessDefs.h"
@@ -33,6 +34,7 @@
 #include "dbFldTypes.h"
 #include "dbLockPvt.h"
 #include "dbStaticLib.h"
+#include "epicsExport.h"
 #include "link.h"
 
 typedef struct dbScanLockNode dbScanLockNode;
@@ -56,6 +58,9 @@ static epicsMutexId lockSetsGuard;
 static size_t recomputeCnt;
 #endif
 
+int dbLockStats = 0;
+epicsExportAddress(int, dbLockStats);
+
 /*private routines */
 static void dbLockOnce(void* ignore)
 {
@@ -88,6 +93,10 @@ static lockSet* makeSet(void)
 
 #ifndef LOCKSET_NOFREE
         epicsMutexMustLock(lockSetsGuard);
+    } else {
+        ls->depth = 0;
+        ls->lockedAt = 0;
+        memset(&ls->stats, 0, sizeof(ls->stats));
     }
 #endif
     /* the initial reference for the first lockRecord */
@@ -181,6 +190,47 @@ unsigned long dbLockGetLockId(dbCommon *precord)
     return id;
 }
 
+/* Lock and unlock a lockSet as a record lock,
+ * keeping the statistics while dbLockStats is set
+ */
+static void lockSetLock(lockSet *ls)
+{
+    epicsUInt64 now = 0;
+
+    if (!dbLockStats) {
+        epicsMutexMustLock(ls->lock);
+    } else if (epicsMutexTryLock(ls->lock) == epicsMutexLockOK) {
+        now = epicsMonotonicGet();
+        ls->stats.nLocks++;
+    } else {
+        epicsUInt64 start = epicsMonotonicGet(), wait;
+
+        epicsMutexMustLock(ls->lock);
+        now = epicsMonotonicGet();
+        wait = now - start;
+        ls->stats.nLocks++;
+        ls->stats.nContended++;
+        ls->stats.waitTotal += wait;
+        if (wait > ls->stats.waitMax)
+            ls->stats.waitMax = wait;
+    }
+    if (ls->depth++ == 0)
+        ls->lockedAt = now;
+}
+
+static void lockSetUnlock(lockSet *ls)
+{
+    /* records may have changed lockSet while locked */
+    if (ls->depth > 0 && --ls->depth == 0 && ls->lockedAt) {
+        epicsUInt64 hold = epicsMonotonicGet() - ls->lockedAt;
+
+        ls->stats.holdTotal += hold;
+        if (hold > ls->stats.holdMax)
+            ls->stats.holdMax = hold;
+    }
+    epicsMutexUnlock(ls->lock);
+}
+
 void dbScanLock(dbCommon *precord)
 {
     int cnt;
@@ -193,7 +243,7 @@ void dbScanLock(dbCommon *precord)
     assert(epicsAtomicGetIntT(&ls->refcount)>0);
 
 retry:
-    epicsMutexMustLock(ls->lock);
+    lockSetLock(ls);
 
     epicsSpinLock(lr->spin);
     if(ls!=lr->plockSet) {
@@ -205,7 +255,7 @@ retry:
         assert(newcnt>=2); /* at least lockRecord and us */
         epicsSpinUnlock(lr->spin);
 
-        epicsMutexUnlock(ls->lock);
+        lockSetUnlock(ls);
         dbLockDecRef(ls);
 
         ls = ls2;
@@ -245,7 +295,7 @@ void dbScanUnlock(dbCommon *precord)
     if(ls->ownercount==0)
         ls->owner = NULL;
 #endif
-    epicsMutexUnlock(ls->lock);
+    lockSetUnlock(ls);
     dbLockDecRef(ls);
 }
 
@@ -409,7 +459,7 @@ retry:
             continue;
         plock = ref->plockSet;
 
-        epicsMutexMustLock(plock->lock);
+        lockSetLock(plock);
         assert(plock->ownerlocker==NULL);
         plock->ownerlocker = locker;
         ellAdd(&locker->locked, &plock->lockernode);
@@ -465,7 +515,7 @@ void dbScanUnlockMany(dbLocker* locker)
             plock->owner = NULL;
 #endif
 
-        epicsMutexUnlock(plock->lock);
+        lockSetUnlock(plock);
         /* release ref for locked list */
         dbLockDecRef(plock);
     }
@@ -547,6 +597,7 @@ static int freeLockRecord(void* junk, DBENTRY* pdbentry)
     dbLockDecRef(ls);
 
     epicsSpinDestroy(lr->spin);
+    free(lr->prof);
     free(lr);
     return 0;
 }
@@ -657,7 +708,7 @@ void dbLockSetMerge(dbLocker *locker, dbCommon *pfirst, dbCommon *psecond)
         B->ownerlocker = NULL;
         epicsAtomicDecrIntT(&B->refcount);
 
-        epicsMutexUnlock(B->lock);
+        lockSetUnlock(B);
     }
 
     dbLockDecRef(B); /* last ref we hold */
@@ -795,7 +846,7 @@ void dbLockSetSplit(dbLocker *locker, dbCommon *pfirst, dbCommon *psecond)
 
         splitset = makeSet(); /* reference for locker->locked */
 
-        epicsMutexMustLock(splitset->lock);
+        lockSetLock(splitset);
 
         assert(splitset->ownerlocker==NULL);
         ellAdd(&locker->locked, &splitset->lockernode);
@@ -871,18 +922,51 @@ nosplit:
 
 static const char *msstring[4]={"NMS","MS","MSI","MSS"};
 
-long dblsr(char *recordname,int level)
+static void showLockSetRecords(lockSet *plockSet, int level)
 {
     int                 link;
+    dbCommon            *precord;
+    lockRecord          *plockRecord;
+    dbRecordType        *pdbRecordType;
+    dbFldDes            *pdbFldDes;
+    DBLINK              *plink;
+
+    for(plockRecord = (lockRecord *)ellFirst(&plockSet->lockRecordList);
+    plockRecord; plockRecord = (lockRecord *)ellNext(&plockRecord->node)) {
+        precord = plockRecord->precord;
+        pdbRecordType = precord->rdes;
+        printf("%s\n",precord->name);
+        if(level<=1) continue;
+        for(link=0; (link<pdbRecordType->no_links) ; link++) {
+            DBADDR  *pdbAddr;
+            pdbFldDes = pdbRecordType->papFldDes[pdbRecordType->link_ind[link]];
+            plink = (DBLINK *)((char *)precord + pdbFldDes->offset);
+            if(plink->type != DB_LINK) continue;
+            pdbAddr = &((dbChannel *)(plink->value.pv_link.pvt))->addr;
+            printf("\t%s",pdbFldDes->name);
+            if(pdbFldDes->field_type==DBF_INLINK) {
+                printf("\t INLINK");
+            } else if(pdbFldDes->field_type==DBF_OUTLINK) {
+                printf("\tOUTLINK");
+            } else if(pdbFldDes->field_type==DBF_FWDLINK) {
+                printf("\tFWDLINK");
+            }
+            printf(" %s %s",
+                ((plink->value.pv_link.pvlMask&pvlOptPP)?" PP":"NPP"),
+                msstring[plink->value.pv_link.pvlMask&pvlOptMsMode]);
+            printf(" %s\n",pdbAddr->precord->name);
+        }
+    }
+}
+
+long dblsr(char *recordname,int level)
+{
     DBENTRY             dbentry;
     DBENTRY             *pdbentry=&dbentry;
     long                status;
     dbCommon            *precord;
     lockSet             *plockSet;
     lockRecord          *plockRecord;
-    dbRecordType        *pdbRecordType;
-    dbFldDes            *pdbFldDes;
-    DBLINK              *plink;
 
     if (recordname && ((*recordname == '\0') || !strcmp(recordname,"*")))
         recordname = NULL;
@@ -907,37 +991,160 @@ long dblsr(char *recordname,int level)
             plockSet->id,ellCount(&plockSet->lockRecordList),plockSet->refcount,plockSet->lock);
 
         if(level==0) { if(recordname) break; continue; }
-        for(plockRecord = (lockRecord *)ellFirst(&plockSet->lockRecordList);
-        plockRecord; plockRecord = (lockRecord *)ellNext(&plockRecord->node)) {
-            precord = plockRecord->precord;
-            pdbRecordType = precord->rdes;
-            printf("%s\n",precord->name);
-            if(level<=1) continue;
-            for(link=0; (link<pdbRecordType->no_links) ; link++) {
-                DBADDR  *pdbAddr;
-                pdbFldDes = pdbRecordType->papFldDes[pdbRecordType->link_ind[link]];
-                plink = (DBLINK *)((char *)precord + pdbFldDes->offset);
-                if(plink->type != DB_LINK) continue;
-                pdbAddr = &((dbChannel *)(plink->value.pv_link.pvt))->addr;
-                printf("\t%s",pdbFldDes->name);
-                if(pdbFldDes->field_type==DBF_INLINK) {
-                    printf("\t INLINK");
-                } else if(pdbFldDes->field_type==DBF_OUTLINK) {
-                    printf("\tOUTLINK");
-                } else if(pdbFldDes->field_type==DBF_FWDLINK) {
-                    printf("\tFWDLINK");
-                }
-                printf(" %s %s",
-                    ((plink->value.pv_link.pvlMask&pvlOptPP)?" PP":"NPP"),
-                    msstring[plink->value.pv_link.pvlMask&pvlOptMsMode]);
-                printf(" %s\n",pdbAddr->precord->name);
-            }
-        }
+        showLockSetRecords(plockSet, level);
         if(recordname) break;
     }
     return 0;
 }
 
+long dbLockGetStats(dbCommon *precord, dbLockSetStats *pstats)
+{
+    lockRecord *plockRecord = precord->lset;
+    lockSet *plockSet;
+
+    if (!plockRecord) return -1; /* before iocInit */
+    plockSet = dbLockGetRef(plockRecord);
+    /* the statistics are updated with the lock set held */
+    epicsMutexMustLock(plockSet->lock);
+    *pstats = plockSet->stats;
+    epicsMutexUnlock(plockSet->lock);
+    dbLockDecRef(plockSet);
+    return 0;
+}
+
+/* Take a reference to each active lock set, so they can be locked one
+ * at a time after releasing lockSetsGuard, which may be taken while a
+ * lock set is held.  Returns the number of lock sets, or -1.
+ */
+static int lockSetsGetRefs(lockSet ***ppsets)
+{
+    lockSet *plockSet;
+    int nsets = 0;
+
+    epicsThreadOnce(&dbLockOnceInit, &dbLockOnce, NULL);
+    epicsMutexMustLock(lockSetsGuard);
+    *ppsets = malloc((ellCount(&lockSetsActive) + 1) * sizeof(lockSet *));
+    if (!*ppsets) {
+        epicsMutexUnlock(lockSetsGuard);
+        return -1;
+    }
+    for (plockSet = (lockSet *)ellFirst(&lockSetsActive); plockSet;
+         plockSet = (lockSet *)ellNext(&plockSet->node)) {
+        int cnt = epicsAtomicGetIntT(&plockSet->refcount);
+
+        /* skip a lock set whose last reference is being dropped */
+        while (cnt > 0) {
+            int prev = epicsAtomicCmpAndSwapIntT(&plockSet->refcount,
+                cnt, cnt + 1);
+
+            if (prev == cnt)
+                break;
+            cnt = prev;
+        }
+        if (cnt > 0)
+            (*ppsets)[nsets++] = plockSet;
+    }
+    epicsMutexUnlock(lockSetsGuard);
+    return nsets;
+}
+
+typedef struct {
+    lockSet *plockSet;
+    int nrecords;
+    dbLockSetStats stats;
+} lockSetStatsEntry;
+
+static int lockSetStatsCompare(const void *a, const void *b)
+{
+    const dbLockSetStats *sa = &((const lockSetStatsEntry *)a)->stats;
+    const dbLockSetStats *sb = &((const lockSetStatsEntry *)b)->stats;
+
+    if (sa->waitTotal != sb->waitTotal)
+        return sa->waitTotal < sb->waitTotal ? 1 : -1;
+    if (sa->nContended != sb->nContended)
+        return sa->nContended < sb->nContended ? 1 : -1;
+    return 0;
+}
+
+long dbLockStatsShow(int count, int level)
+{
+    lockSetStatsEntry *pentries;
+    lockSet **psets;
+    int nsets, nused = 0, i;
+
+    if (count <= 0)
+        count = 20;
+
+    nsets = lockSetsGetRefs(&psets);
+    pentries = nsets >= 0 ?
+        malloc((nsets + 1) * sizeof(lockSetStatsEntry)) : NULL;
+    if (!pentries) {
+        for (i = 0; i < nsets; i++)
+            dbLockDecRef(psets[i]);
+        if (nsets >= 0)
+            free(psets);
+        printf("dbLockStatsShow: Out of memory\n");
+        return -1;
+    }
+
+    /* copy each lock set's statistics while holding it, print later */
+    for (i = 0; i < nsets; i++) {
+        lockSet *plockSet = psets[i];
+
+        epicsMutexMustLock(plockSet->lock);
+        pentries[nused].plockSet = plockSet;
+        pentries[nused].nrecords = ellCount(&plockSet->lockRecordList);
+        pentries[nused].stats = plockSet->stats;
+        epicsMutexUnlock(plockSet->lock);
+        if (pentries[nused].stats.nLocks)
+            nused++;
+    }
+
+    printf("Lock set contention (dbLockStats=%d), %d of %d lock sets used\n",
+        dbLockStats, nused, nsets);
+    if (nused) {
+        qsort(pentries, nused, sizeof(lockSetStatsEntry), lockSetStatsCompare);
+        printf("      ID  RECORDS       LOCKS   CONTENDED"
+            "     WAIT ms      MAX us     HOLD ms      MAX us\n");
+    }
+    for (i = 0; i < nused && i < count; i++) {
+        const dbLockSetStats *pstats = &pentries[i].stats;
+
+        printf("%8lu %8d %11llu %11llu %11.3f %11.3f %11.3f %11.3f\n",
+            pentries[i].plockSet->id, pentries[i].nrecords,
+            (unsigned long long) pstats->nLocks,
+            (unsigned long long) pstats->nContended,
+            pstats->waitTotal * 1e-6, pstats->waitMax * 1e-3,
+            pstats->holdTotal * 1e-6, pstats->holdMax * 1e-3);
+        /* as dblsr, the members may change while they are listed */
+        if (level > 0)
+            showLockSetRecords(pentries[i].plockSet, level);
+    }
+    for (i = 0; i < nsets; i++)
+        dbLockDecRef(psets[i]);
+    free(psets);
+    free(pentries);
+    return 0;
+}
+
+long dbLockStatsReset(void)
+{
+    lockSet **psets;
+    int nsets, i;
+
+    nsets = lockSetsGetRefs(&psets);
+    if (nsets < 0)
+        return -1;
+    for (i = 0; i < nsets; i++) {
+        epicsMutexMustLock(psets[i]->lock);
+        memset(&psets[i]->stats, 0, sizeof(psets[i]->stats));
+        epicsMutexUnlock(psets[i]->lock);
+        dbLockDecRef(psets[i]);
+    }
+    free(psets);
+    return 0;
+}
+
 long dbLockShowLocked(int level)
 {
     int     indListType;
@@ -16,6 +16,7 @@
 #include <stddef.h>
 
 #include "ellLib.h"
+#include "epicsTypes.h"
 #include "dbCoreAPI.h"
 
 #ifdef __cplusplus
@@ -98,6 +99,35 @@ DBCORE_API long dblsr(char *recordname,int level);
 
 DBCORE_API long dbLockShowLocked(int level);
 
+/** @brief Lock set contention statistics
+ *
+ * Collected while dbLockStats is non-zero.  Times are in nanoseconds,
+ * hold times from the outermost lock to the matching unlock.
+ * @since UNRELEASED
+ */
+typedef struct dbLockSetStats {
+    epicsUInt64 nLocks;     /* acquisitions */
+    epicsUInt64 nContended; /* acquisitions which had to wait */
+    epicsUInt64 waitTotal;
+    epicsUInt64 waitMax;
+    epicsUInt64 holdTotal;
+    epicsUInt64 holdMax;
+} dbLockSetStats;
+
+DBCORE_API extern int dbLockStats;
+
+/** @brief Copy the statistics of the lock set of a record
+ * @return Zero on success, non-zero before iocInit
+ * @since UNRELEASED
+ */
+DBCORE_API long dbLockGetStats(struct dbCommon *precord,
+                               dbLockSetStats *pstats);
+/* Lock sets with the longest total wait time first.
+ * count lock sets (20 if 0), level = (0,1,2) as for dblsr
+ */
+DBCORE_API long dbLockStatsShow(int count, int level);
+DBCORE_API long dbLockStatsReset(void);
+
 /*KLUDGE to support field TPRO*/
 DBCORE_API int * dbLockSetAddrTrace(struct dbCommon *precord);
 
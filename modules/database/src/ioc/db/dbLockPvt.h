@@ -40,6 +40,10 @@ typedef struct dbLockSet {
     ELLNODE             lockernode;
 
     int                 trace; /*For field TPRO*/
+
+    int                 depth;    /* recursive locks held */
+    epicsUInt64         lockedAt; /* when depth became 1, 0 if not timed */
+    dbLockSetStats      stats;
 } lockSet;
 
 struct lockRecord;
@@ -66,6 +70,11 @@ typedef struct lockRecord {
      */
     ELLNODE     compnode;
     unsigned int compflag;
+
+    /* from dbProfileEnable(), updated by dbProcess() */
+    struct dbProfile *prof;
+    /* set while a scanOnceCoalesced() request waits in the once queue */
+    int oncq;
 } lockRecord;
 
 typedef struct {
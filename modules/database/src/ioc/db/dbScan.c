@@ -17,6 +17,7 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <math.h>
@@ -30,6 +31,7 @@
 #include "epicsMutex.h"
 #include "epicsPrint.h"
 #include "epicsRingBytes.h"
+#include "epicsSpin.h"
 #include "epicsStdio.h"
 #include "epicsStdlib.h"
 #include "epicsString.h"
@@ -44,9 +46,11 @@
 #include "dbCommon.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
+#include "dbLockPvt.h"
 #include "dbScan.h"
 #include "dbStaticLib.h"
 #include "devSup.h"
+#include "epicsExport.h"
 #include "link.h"
 #include "recGbl.h"
 
@@ -65,9 +69,119 @@ static int onceQueueSize = 1000;
 static epicsEventId onceSem;
 static epicsRingBytesId onceQ;
 static int onceQOverruns = 0;
-static epicsThreadId onceTaskId;
+static size_t onceCoalesced = 0;
+static size_t onceExecuted = 0;
+static int nOnceTasks;
+static epicsThreadId *onceTaskIds;
 static void *exitOnce;
 
+/* With scanOnceThreads > 1 the once queue is served by that many threads,
+ * so queued requests may be processed out of order.
+ */
+int scanOnceThreads = 1;
+epicsExportAddress(int, scanOnceThreads);
+
+
+/* Scan timing: histograms of how late scans start and how long they take,
+ * bin n counting times of 2^n to 2^(n+1) microseconds, and the longest
+ * time a single record took to process.  Nothing reads the clock for
+ * these unless scanRecordTiming is non-zero.
+ */
+#define TIMING_BINS 24
+
+int scanRecordTiming = 0;
+epicsExportAddress(int, scanRecordTiming);
+
+/* keeps recordMax and precordMax consistent */
+static epicsMutexId timingLock;
+
+typedef struct scan_timing {
+    const char          *name;
+    size_t              late[TIMING_BINS];  /* use atomic */
+    size_t              exec[TIMING_BINS];  /* use atomic */
+    epicsUInt64         lateMax;            /* ns */
+    epicsUInt64         execMax;
+    epicsUInt64         recordMax;
+    struct dbCommon     *precordMax;
+} scan_timing;
+
+static scan_timing onceTiming = {"Once"};
+static scan_timing eventTiming[NUM_CALLBACK_PRIORITIES] = {
+    {"Event Low"}, {"Event Medium"}, {"Event High"}
+};
+static scan_timing ioTiming[NUM_CALLBACK_PRIORITIES] = {
+    {"I/O Intr Low"}, {"I/O Intr Medium"}, {"I/O Intr High"}
+};
+
+static void timingAdd(size_t *hist, epicsUInt64 *pmax, epicsUInt64 ns)
+{
+    epicsUInt64 us = ns / 1000;
+    int bin = 0;
+
+    while (bin < TIMING_BINS - 1 && (us >> (bin + 1)))
+        bin++;
+    epicsAtomicIncrSizeT(&hist[bin]);
+    /* racy, but only statistics */
+    if (ns > *pmax)
+        *pmax = ns;
+}
+
+/* Start of a time, zero while timing is off */
+static epicsUInt64 timingStart(void)
+{
+    return scanRecordTiming ? epicsMonotonicGet() : 0;
+}
+
+static void timingEnd(size_t *hist, epicsUInt64 *pmax, epicsUInt64 start)
+{
+    if (start)
+        timingAdd(hist, pmax, epicsMonotonicGet() - start);
+}
+
+/* Requests of a scan which is already pending keep the time of the first,
+ * the scan taking them clears it before it starts.
+ */
+static void timingRequest(int *ppending, epicsUInt64 *prequested)
+{
+    if (scanRecordTiming && !epicsAtomicGetIntT(ppending)) {
+        *prequested = epicsMonotonicGet();
+        epicsAtomicSetIntT(ppending, 1);
+    }
+}
+
+static void timingLate(scan_timing *ptiming, int *ppending,
+    epicsUInt64 *prequested)
+{
+    if (epicsAtomicGetIntT(ppending)) {
+        epicsUInt64 start = *prequested;
+
+        epicsAtomicSetIntT(ppending, 0);
+        timingEnd(ptiming->late, &ptiming->lateMax, start);
+    }
+}
+
+static void timedProcess(scan_timing *ptiming, struct dbCommon *precord)
+{
+    epicsUInt64 start, ns;
+
+    if (!scanRecordTiming) {
+        dbProcess(precord);
+        return;
+    }
+
+    start = epicsMonotonicGet();
+    dbProcess(precord);
+    ns = epicsMonotonicGet() - start;
+    /* a new maximum is rare, don't lock until there may be one */
+    if (ns > ptiming->recordMax) {
+        epicsMutexMustLock(timingLock);
+        if (ns > ptiming->recordMax) {
+            ptiming->recordMax = ns;
+            ptiming->precordMax = precord;
+        }
+        epicsMutexUnlock(timingLock);
+    }
+}
 
 /* All other scan types */
 typedef struct scan_list{
@@ -87,6 +201,30 @@ typedef struct scan_element{
 
 #define OVERRUN_REPORT_DELAY 10.0   /* Time between initial reports */
 #define OVERRUN_REPORT_MAX 3600.0   /* Maximum time between reports */
+
+/* With scanPeriodicShards > 1 each periodic scan list is processed by that
+ * many shard threads.  Every period the list is split by lock set, so
+ * records sharing a lock set are processed by one thread in list order,
+ * and the records of each PHAS value are processed before the next.
+ */
+int scanPeriodicShards = 0;
+epicsExportAddress(int, scanPeriodicShards);
+
+struct periodic_scan_list;
+
+typedef struct periodic_shard {
+    struct periodic_scan_list *ppsl;
+    epicsThreadId       tid;
+    epicsEventId        go;
+    struct dbCommon     **precords; /* this pass */
+    int                 nrecords;
+    int                 size;
+    unsigned long       records;    /* in the last period */
+    unsigned long       overruns;   /* periods its records took longer */
+    double              busy;       /* seconds, in the last period */
+    double              busyMax;
+} periodic_shard;
+
 typedef struct periodic_scan_list {
     scan_list           scan_list;
     double              period;
@@ -94,6 +232,13 @@ typedef struct periodic_scan_list {
     unsigned long       overruns;
     volatile enum ctl   scanCtl;
     epicsEventId        loopEvent;
+    int                 nshards;
+    periodic_shard      *shards;
+    epicsEventId        shardsDone;
+    int                 shardsBusy; /* use atomic */
+    struct dbCommon     **precords; /* snapshot of the scan list */
+    int                 size;
+    scan_timing         timing;
 } periodic_scan_list;
 
 static int nPeriodic = 0;
@@ -111,6 +256,8 @@ static char *priorityName[NUM_CALLBACK_PRIORITIES] = {
 typedef struct event_list {
     epicsCallback            callback[NUM_CALLBACK_PRIORITIES];
     scan_list           scan_list[NUM_CALLBACK_PRIORITIES];
+    epicsUInt64         requested[NUM_CALLBACK_PRIORITIES];
+    int                 pending[NUM_CALLBACK_PRIORITIES]; /* use atomic */
     struct event_list   *next;
     char                eventname[1]; /* actually arbitrary size */
 } event_list;
@@ -122,6 +269,11 @@ static epicsMutexId event_lock;
 typedef struct io_scan_list {
     epicsCallback callback;
     scan_list scan_list;
+    epicsUInt64 requested;
+    int pending;                        /* requested is set, use atomic */
+    struct ioscan_head *piosh;
+    int batched;                        /* on the list of a batch */
+    struct io_scan_list *nextBatched;
 } io_scan_list;
 
 typedef struct ioscan_head {
@@ -134,19 +286,40 @@ typedef struct ioscan_head {
 static ioscan_head *pioscan_list = NULL;
 static epicsMutexId ioscan_lock;
 
+typedef struct io_batch_list {
+    epicsCallback callback;
+    io_scan_list *first;
+    io_scan_list *last;
+    int queued;
+} io_batch_list;
+
+typedef struct ioscan_batch {
+    struct ioscan_batch *next;
+    epicsSpinId lock;
+    unsigned int group;
+    io_batch_list list[NUM_CALLBACK_PRIORITIES];
+} ioscan_batch;
+
+static ioscan_batch *pioscan_batches = NULL;
+
 /* Private routines */
 static void onceTask(void *);
 static void initOnce(void);
 static void periodicTask(void *arg);
+static void spawnShards(periodic_scan_list *ppsl);
+static void stopShards(periodic_scan_list *ppsl);
+static void scanShards(periodic_scan_list *ppsl);
 static void initPeriodic(void);
 static void deletePeriodic(void);
 static void spawnPeriodic(int ind);
 static void eventCallback(epicsCallback *pcallback);
 static void ioscanInit(void);
 static void ioscanCallback(epicsCallback *pcallback);
+static void ioscanBatchCallback(epicsCallback *pcallback);
 static void ioscanDestroy(void);
 static void printList(scan_list *psl, char *message);
-static void scanList(scan_list *psl);
+static void printShards(periodic_scan_list *ppsl);
+static void scanList(scan_list *psl, scan_timing *ptiming);
 static void buildScanLists(void);
 static void addToList(struct dbCommon *precord, scan_list *psl);
 static void deleteFromList(struct dbCommon *precord, scan_list *psl);
@@ -172,9 +345,13 @@ void scanStop(void)
         epicsThreadMustJoin(periodicTaskId[i]);
     }
 
-    scanOnce((dbCommon *)&exitOnce);
-    epicsEventWait(startStopEvent);
-    epicsThreadMustJoin(onceTaskId);
+    for (i = 0; i < nOnceTasks; i++) {
+        scanOnce((dbCommon *)&exitOnce);
+        epicsEventWait(startStopEvent);
+    }
+    for (i = 0; i < nOnceTasks; i++) {
+        epicsThreadMustJoin(onceTaskIds[i]);
+    }
 }
 
 void scanCleanup(void)
@@ -184,6 +361,8 @@ void scanCleanup(void)
     ioscanDestroy();
 
     epicsRingBytesDelete(onceQ);
+    free(onceTaskIds);
+    onceTaskIds = NULL;
 
     free(periodicTaskId);
     papPeriodic = NULL;
@@ -196,6 +375,8 @@ long scanInit(void)
 
     if(!startStopEvent)
         startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+    if(!timingLock)
+        timingLock = epicsMutexMustCreate();
     scanCtl = ctlPause;
 
     initPeriodic();
@@ -404,6 +585,7 @@ int scanppl(double period)      /* print periodic scan list(s) */
         sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
             ppsl->name, ppsl->overruns);
         printList(&ppsl->scan_list, message);
+        printShards(ppsl);
     }
     return 0;
 }
@@ -452,12 +634,140 @@ int scanpiol(void)                  /* print pioscan_list */
     return 0;
 }
 
+/* The scan timing of periodic list i, or after those of I/O Intr, event
+ * and once scans, NULL for a rate that isn't scanned.
+ */
+#define NTIMING_OTHER (2*NUM_CALLBACK_PRIORITIES + 1)
+
+static scan_timing *getTiming(int i)
+{
+    if (i < nPeriodic)
+        return papPeriodic[i] ? &papPeriodic[i]->timing : NULL;
+    i -= nPeriodic;
+    if (i < NUM_CALLBACK_PRIORITIES)
+        return &ioTiming[i];
+    i -= NUM_CALLBACK_PRIORITIES;
+    if (i < NUM_CALLBACK_PRIORITIES)
+        return &eventTiming[i];
+    return &onceTiming;
+}
+
+/* Time in seconds not exceeded by the fraction frac of the times counted
+ * in hist, interpolated within its bin but not beyond the longest time.
+ */
+static double timingPercentile(const size_t *hist, double frac,
+    epicsUInt64 max)
+{
+    double count = 0.0, target, sum = 0.0;
+    int bin;
+
+    for (bin = 0; bin < TIMING_BINS; bin++)
+        count += hist[bin];
+    target = frac * count;
+    for (bin = 0; bin < TIMING_BINS; bin++) {
+        if (hist[bin] && sum + hist[bin] >= target) {
+            double lo = bin ? ldexp(1.0, bin) : 0.0;
+            double hi = ldexp(1.0, bin + 1);
+            double us = lo + (hi - lo) * (target - sum) / hist[bin];
+            return us * 1e3 < max ? us * 1e-6 : max * 1e-9;
+        }
+        sum += hist[bin];
+    }
+    return 0.0;
+}
+
+int scanTimingGet(const char *name, int reset, scanTimingStats *pstats)
+{
+    scan_timing *ptiming = NULL;
+    size_t late[TIMING_BINS], exec[TIMING_BINS];
+    int i;
+
+    if (!papPeriodic || !name)
+        return -1;
+    for (i = 0; i < nPeriodic + NTIMING_OTHER; i++) {
+        ptiming = getTiming(i);
+        if (ptiming && strcmp(ptiming->name, name) == 0)
+            break;
+    }
+    if (i == nPeriodic + NTIMING_OTHER)
+        return -1;
+
+    pstats->count = 0;
+    for (i = 0; i < TIMING_BINS; i++) {
+        late[i] = epicsAtomicGetSizeT(&ptiming->late[i]);
+        exec[i] = epicsAtomicGetSizeT(&ptiming->exec[i]);
+        pstats->count += exec[i];
+    }
+    pstats->lateP50 = timingPercentile(late, 0.5, ptiming->lateMax);
+    pstats->lateP99 = timingPercentile(late, 0.99, ptiming->lateMax);
+    pstats->lateMax = ptiming->lateMax * 1e-9;
+    pstats->execP50 = timingPercentile(exec, 0.5, ptiming->execMax);
+    pstats->execP99 = timingPercentile(exec, 0.99, ptiming->execMax);
+    pstats->execMax = ptiming->execMax * 1e-9;
+
+    epicsMutexMustLock(timingLock);
+    pstats->recordMax = ptiming->recordMax * 1e-9;
+    pstats->recordMaxName = ptiming->precordMax ?
+        ptiming->precordMax->name : "";
+    if (reset) {
+        ptiming->recordMax = 0;
+        ptiming->precordMax = NULL;
+    }
+    epicsMutexUnlock(timingLock);
+
+    if (reset) {
+        for (i = 0; i < TIMING_BINS; i++) {
+            epicsAtomicSetSizeT(&ptiming->late[i], 0);
+            epicsAtomicSetSizeT(&ptiming->exec[i], 0);
+        }
+        ptiming->lateMax = ptiming->execMax = 0;
+    }
+    return 0;
+}
+
+int scanTimingShow(const char *name, int reset)
+{
+    int i, found = 0;
+
+    if (!papPeriodic) {
+        printf("scanTimingShow: dbScan subsystem not initialized\n");
+        return -1;
+    }
+
+    printf("Times in ms       SCANS  LATE P50  LATE P99  LATE MAX"
+        "  EXEC P50  EXEC P99  EXEC MAX  SLOWEST RECORD\n");
+    for (i = 0; i < nPeriodic + NTIMING_OTHER; i++) {
+        scan_timing *ptiming = getTiming(i);
+        scanTimingStats stats;
+
+        if (!ptiming || (name && *name && strcmp(ptiming->name, name) != 0))
+            continue;
+        found = 1;
+        if (scanTimingGet(ptiming->name, reset, &stats) || !stats.count)
+            continue;
+        printf("%-15s %7lu  %8.3f  %8.3f  %8.3f  %8.3f  %8.3f  %8.3f  %s (%.3f)\n",
+            ptiming->name, stats.count, stats.lateP50 * 1e3,
+            stats.lateP99 * 1e3, stats.lateMax * 1e3, stats.execP50 * 1e3,
+            stats.execP99 * 1e3, stats.execMax * 1e3, stats.recordMaxName,
+            stats.recordMax * 1e3);
+    }
+    if (!found) {
+        printf("scanTimingShow: No scan list '%s'\n", name);
+        return -1;
+    }
+    return 0;
+}
+
 static void eventCallback(epicsCallback *pcallback)
 {
-    scan_list *psl;
+    event_list *pel;
+    int prio;
 
-    callbackGetUser(psl, pcallback);
-    scanList(psl);
+    callbackGetUser(pel, pcallback);
+    callbackGetPriority(prio, pcallback);
+    timingLate(&eventTiming[prio], &pel->pending[prio],
+        &pel->requested[prio]);
+    scanList(&pel->scan_list[prio], &eventTiming[prio]);
 }
 
 static void eventOnce(void *arg)
@@ -517,7 +827,7 @@ event_list *eventNameToHandle(const char *eventname)
         else
             strncpy(pel->eventname, eventname, namelength);
         for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            callbackSetUser(&pel->scan_list[prio], &pel->callback[prio]);
+            callbackSetUser(pel, &pel->callback[prio]);
             callbackSetPriority(prio, &pel->callback[prio]);
             callbackSetCallback(eventCallback, &pel->callback[prio]);
             pel->scan_list[prio].lock = epicsMutexMustCreate();
@@ -538,8 +848,10 @@ void postEvent(event_list *pel)
     if (scanCtl != ctlRun) return;
     if (!pel) return;
     for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-        if (ellCount(&pel->scan_list[prio].list) >0)
+        if (ellCount(&pel->scan_list[prio].list) >0) {
+            timingRequest(&pel->pending[prio], &pel->requested[prio]);
             callbackRequest(&pel->callback[prio]);
+        }
     }
 }
 
@@ -565,12 +877,22 @@ static void ioscanInit(void)
 static void ioscanDestroy(void)
 {
     ioscan_head *piosh;
+    ioscan_batch *pbatch;
 
     ioscanInit();
     epicsMutexMustLock(ioscan_lock);
     piosh = pioscan_list;
     pioscan_list = NULL;
+    pbatch = pioscan_batches;
+    pioscan_batches = NULL;
     epicsMutexUnlock(ioscan_lock);
+    while (pbatch) {
+        ioscan_batch *pnext = pbatch->next;
+
+        epicsSpinDestroy(pbatch->lock);
+        free(pbatch);
+        pbatch = pnext;
+    }
     while (piosh) {
         ioscan_head *pnext = piosh->next;
         int prio;
@@ -598,6 +920,7 @@ void scanIoInit(IOSCANPVT *pioscanpvt)
         callbackSetUser(piosh, &piosl->callback);
         ellInit(&piosl->scan_list.list);
         piosl->scan_list.lock = epicsMutexMustCreate();
+        piosl->piosh = piosh;
     }
     epicsMutexMustLock(ioscan_lock);
     piosh->next = pioscan_list;
@@ -620,9 +943,11 @@ unsigned int scanIoRequest(IOSCANPVT piosh)
     for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
         io_scan_list *piosl = &piosh->iosl[prio];
 
-        if (ellCount(&piosl->scan_list.list) > 0)
+        if (ellCount(&piosl->scan_list.list) > 0) {
+            timingRequest(&piosl->pending, &piosl->requested);
             if (!callbackRequest(&piosl->callback))
                 queued |= 1 << prio;
+        }
     }
 
     return queued;
@@ -642,7 +967,7 @@ unsigned int scanIoImmediate(IOSCANPVT piosh, int prio)
     if (ellCount(&piosl->scan_list.list) == 0)
         return 0;
 
-    scanList(&piosl->scan_list);
+    scanList(&piosl->scan_list, &ioTiming[prio]);
 
     if (piosh->cb)
         piosh->cb(piosh->arg, piosh, prio);
@@ -657,6 +982,100 @@ void scanIoSetComplete(IOSCANPVT piosh, io_scan_complete cb, void *arg)
     piosh->arg = arg;
 }
 
+void scanIoBatchInit(IOSCANBATCH *ppbatch, unsigned int group)
+{
+    ioscan_batch *pbatch = dbCalloc(1, sizeof(ioscan_batch));
+    int prio;
+
+    ioscanInit();
+    pbatch->lock = epicsSpinMustCreate();
+    pbatch->group = group;
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        io_batch_list *pbl = &pbatch->list[prio];
+
+        callbackSetCallback(ioscanBatchCallback, &pbl->callback);
+        callbackSetPriority(prio, &pbl->callback);
+        callbackSetUser(pbatch, &pbl->callback);
+    }
+    epicsMutexMustLock(ioscan_lock);
+    pbatch->next = pioscan_batches;
+    pioscan_batches = pbatch;
+    epicsMutexUnlock(ioscan_lock);
+    *ppbatch = pbatch;
+}
+
+/* Return a bit mask indicating each priority level on which the scan
+ * list was added.  A list already waiting in any batch is not added twice.
+ */
+unsigned int scanIoBatchAdd(IOSCANBATCH pbatch, IOSCANPVT piosh)
+{
+    int prio;
+    unsigned int added = 0;
+
+    if (scanCtl != ctlRun)
+        return 0;
+
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        io_batch_list *pbl = &pbatch->list[prio];
+        io_scan_list *piosl = &piosh->iosl[prio];
+
+        if (ellCount(&piosl->scan_list.list) == 0 ||
+            epicsAtomicCmpAndSwapIntT(&piosl->batched, 0, 1) != 0)
+            continue;
+
+        /* only while not yet batched, so the first request's time */
+        piosl->requested = timingStart();
+        piosl->nextBatched = NULL;
+        epicsSpinLock(pbatch->lock);
+        if (pbl->last)
+            pbl->last->nextBatched = piosl;
+        else
+            pbl->first = piosl;
+        pbl->last = piosl;
+        epicsSpinUnlock(pbatch->lock);
+        added |= 1 << prio;
+    }
+
+    return added;
+}
+
+/* Return a bit mask indicating each priority level
+ * on which a callback request is queued for the batch.
+ */
+unsigned int scanIoBatchRequest(IOSCANBATCH pbatch)
+{
+    int prio;
+    unsigned int queued = 0;
+
+    if (scanCtl != ctlRun)
+        return 0;
+
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        io_batch_list *pbl = &pbatch->list[prio];
+        int request;
+
+        epicsSpinLock(pbatch->lock);
+        request = pbl->first && !pbl->queued;
+        if (pbl->first)
+            pbl->queued = 1;
+        epicsSpinUnlock(pbatch->lock);
+
+        if (!request) {
+            if (pbl->first)
+                queued |= 1 << prio;
+        }
+        else if (!callbackRequest(&pbl->callback))
+            queued |= 1 << prio;
+        else {
+            epicsSpinLock(pbatch->lock);
+            pbl->queued = 0;
+            epicsSpinUnlock(pbatch->lock);
+        }
+    }
+
+    return queued;
+}
+
 int scanOnce(struct dbCommon *precord) {
     return scanOnceCallback(precord, NULL, NULL);
 }
@@ -665,9 +1084,12 @@ typedef struct {
     struct dbCommon *prec;
     once_complete cb;
     void *usr;
+    epicsUInt64 queued;
+    int coalesced;
 } onceEntry;
 
-int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
+static int queueOnce(struct dbCommon *precord, once_complete cb, void *usr,
+    int coalesced)
 {
     static int newOverflow = TRUE;
     onceEntry ent;
@@ -676,6 +1098,8 @@ int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
     ent.prec = precord;
     ent.cb = cb;
     ent.usr = usr;
+    ent.queued = timingStart();
+    ent.coalesced = coalesced;
 
     pushOK = epicsRingBytesPut(onceQ, (void*)&ent, sizeof(ent));
 
@@ -691,6 +1115,27 @@ int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
     return !pushOK;
 }
 
+int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
+{
+    return queueOnce(precord, cb, usr, 0);
+}
+
+int scanOnceCoalesced(struct dbCommon *precord)
+{
+    /* oncq is cleared when the queued request is taken, so a request made
+     * during processing queues another one and the change is not missed.
+     */
+    if (epicsAtomicCmpAndSwapIntT(&precord->lset->oncq, 0, 1)) {
+        epicsAtomicIncrSizeT(&onceCoalesced);
+        return 0;
+    }
+    if (queueOnce(precord, NULL, NULL, 1)) {
+        epicsAtomicSetIntT(&precord->lset->oncq, 0);
+        return -1;
+    }
+    return 0;
+}
+
 static void onceTask(void *arg)
 {
     taskwdInsert(0, NULL, NULL);
@@ -701,6 +1146,7 @@ static void onceTask(void *arg)
         epicsEventMustWait(onceSem);
         while(1) {
             onceEntry ent;
+            epicsUInt64 start;
             int bytes = epicsRingBytesGet(onceQ, (void*)&ent, sizeof(ent));
             if(bytes==0)
                 break;
@@ -710,9 +1156,19 @@ static void onceTask(void *arg)
                 continue; /* what to do? */
             } else if (ent.prec == (void*)&exitOnce) goto shutdown;
 
+            /* let another once thread take the next request */
+            if (nOnceTasks > 1 && !epicsRingBytesIsEmpty(onceQ))
+                epicsEventSignal(onceSem);
+            if (ent.coalesced)
+                epicsAtomicSetIntT(&ent.prec->lset->oncq, 0);
+            epicsAtomicIncrSizeT(&onceExecuted);
+
+            timingEnd(onceTiming.late, &onceTiming.lateMax, ent.queued);
+            start = timingStart();
             dbScanLock(ent.prec);
-            dbProcess(ent.prec);
+            timedProcess(&onceTiming, ent.prec);
             dbScanUnlock(ent.prec);
+            timingEnd(onceTiming.exec, &onceTiming.execMax, start);
             if(ent.cb)
                 ent.cb(ent.usr, ent.prec);
         }
@@ -748,24 +1204,39 @@ int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result)
     return ret;
 }
 
+int scanOnceQueueCountsGet(scanOnceQueueCounts *result)
+{
+    if (!onceQ) return -1;
+    result->numCoalesced = epicsAtomicGetSizeT(&onceCoalesced);
+    result->numExecuted = epicsAtomicGetSizeT(&onceExecuted);
+    return 0;
+}
+
 void scanOnceQueueShow(const int reset)
 {
     scanOnceQueueStats stats;
-    if (scanOnceQueueStatus(reset, &stats) == -1) {
+    scanOnceQueueCounts counts;
+    if (scanOnceQueueStatus(reset, &stats) == -1 ||
+        scanOnceQueueCountsGet(&counts) == -1) {
         fprintf(stderr, "scanOnce system not initialized, yet. Please run "
             "iocInit before using this command.\n");
     } else {
         double qusage = 100.0 * stats.numUsed / stats.size;
-        printf("PRIORITY  HIGH-WATER MARK  ITEMS IN Q  Q SIZE  %% USED  Q OVERFLOWS\n");
-        printf("%8s  %15d  %10d  %6d  %6.1f  %11d\n", "scanOnce", stats.maxUsed,
-               stats.numUsed, stats.size, qusage,
-               epicsAtomicGetIntT(&onceQOverruns));
+        printf("PRIORITY  HIGH-WATER MARK  ITEMS IN Q  Q SIZE  %% USED  Q OVERFLOWS"
+               "  COALESCED   EXECUTED\n");
+        printf("%8s  %15d  %10d  %6d  %6.1f  %11d  %9lu  %9lu\n", "scanOnce",
+               stats.maxUsed, stats.numUsed, stats.size, qusage,
+               stats.numOverflow, (unsigned long)counts.numCoalesced,
+               (unsigned long)counts.numExecuted);
+        if (nOnceTasks > 1)
+            printf("%d scanOnce threads\n", nOnceTasks);
     }
 }
 
 static void initOnce(void)
 {
     epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int i;
     opts.joinable = 1;
     opts.priority = epicsThreadPriorityScanLow + nPeriodic;
     opts.stackSize = epicsThreadStackBig;
@@ -774,9 +1245,19 @@ static void initOnce(void)
     }
     if(!onceSem)
         onceSem = epicsEventMustCreate(epicsEventEmpty);
-    onceTaskId = epicsThreadCreateOpt("scanOnce", onceTask, 0, &opts);
 
-    epicsEventWait(startStopEvent);
+    nOnceTasks = scanOnceThreads > 1 ? scanOnceThreads : 1;
+    onceTaskIds = dbCalloc(nOnceTasks, sizeof(epicsThreadId));
+    for (i = 0; i < nOnceTasks; i++) {
+        char taskName[20];
+
+        if (i == 0)
+            strcpy(taskName, "scanOnce");
+        else
+            epicsSnprintf(taskName, sizeof(taskName), "scanOnce-%d", i);
+        onceTaskIds[i] = epicsThreadCreateOpt(taskName, onceTask, 0, &opts);
+        epicsEventWait(startStopEvent);
+    }
 }
 
 static void periodicTask(void *arg)
@@ -791,6 +1272,7 @@ static void periodicTask(void *arg)
     const double penalty = (ppsl->period >= 2) ? 1 : (ppsl->period / 2);
 
     taskwdInsert(0, NULL, NULL);
+    spawnShards(ppsl);
     epicsEventSignal(startStopEvent);
 
     epicsTimeGetMonotonic(&next);
@@ -800,8 +1282,20 @@ static void periodicTask(void *arg)
         double delay;
         epicsTimeStamp now;
 
-        if (ppsl->scanCtl == ctlRun)
-            scanList(&ppsl->scan_list);
+        if (ppsl->scanCtl == ctlRun) {
+            double late;
+
+            if (scanRecordTiming) {
+                epicsTimeGetMonotonic(&now);
+                late = epicsTimeDiffInSeconds(&now, &next);
+                timingAdd(ppsl->timing.late, &ppsl->timing.lateMax,
+                    late > 0.0 ? (epicsUInt64) (late * 1e9) : 0);
+            }
+            if (ppsl->nshards > 1)
+                scanShards(ppsl);
+            else
+                scanList(&ppsl->scan_list, &ppsl->timing);
+        }
 
         epicsTimeAddSeconds(&next, ppsl->period);
         epicsTimeGetMonotonic(&now);
@@ -846,10 +1340,177 @@ static void periodicTask(void *arg)
         epicsEventWaitWithTimeout(ppsl->loopEvent, delay);
     }
 
+    stopShards(ppsl);
     taskwdRemove(0);
     epicsEventSignal(startStopEvent);
 }
 
+static void periodicShardTask(void *arg)
+{
+    periodic_shard *pshard = (periodic_shard *)arg;
+    periodic_scan_list *ppsl = pshard->ppsl;
+
+    taskwdInsert(0, NULL, NULL);
+
+    while (1) {
+        epicsUInt64 start;
+        int i;
+
+        epicsEventMustWait(pshard->go);
+        if (ppsl->scanCtl == ctlExit)
+            break;
+
+        start = epicsMonotonicGet();
+        for (i = 0; i < pshard->nrecords; i++) {
+            struct dbCommon *precord = pshard->precords[i];
+            scan_element *pse;
+
+            dbScanLock(precord);
+            /* SCAN is only changed with the record locked */
+            pse = precord->spvt;
+            if (pse && pse->pscan_list == &ppsl->scan_list)
+                timedProcess(&ppsl->timing, precord);
+            dbScanUnlock(precord);
+        }
+        pshard->busy += (epicsMonotonicGet() - start) * 1e-9;
+        pshard->records += pshard->nrecords;
+
+        if (!epicsAtomicDecrIntT(&ppsl->shardsBusy))
+            epicsEventMustTrigger(ppsl->shardsDone);
+    }
+
+    taskwdRemove(0);
+}
+
+static void spawnShards(periodic_scan_list *ppsl)
+{
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    char taskName[24];
+    int i;
+
+    if (ppsl->nshards <= 1)
+        return;
+
+    opts.joinable = 1;
+    opts.priority = epicsThreadGetPrioritySelf();
+    opts.stackSize = epicsThreadStackBig;
+
+    ppsl->shards = dbCalloc(ppsl->nshards, sizeof(periodic_shard));
+    ppsl->shardsDone = epicsEventMustCreate(epicsEventEmpty);
+    for (i = 0; i < ppsl->nshards; i++) {
+        periodic_shard *pshard = &ppsl->shards[i];
+
+        pshard->ppsl = ppsl;
+        pshard->go = epicsEventMustCreate(epicsEventEmpty);
+        epicsSnprintf(taskName, sizeof(taskName), "scan-%g-%d",
+            ppsl->period, i);
+        pshard->tid = epicsThreadCreateOpt(taskName, periodicShardTask,
+            pshard, &opts);
+        if (!pshard->tid)
+            cantProceed("Failed to spawn periodic scan shard %s\n", taskName);
+    }
+}
+
+static void stopShards(periodic_scan_list *ppsl)
+{
+    int i;
+
+    for (i = 0; i < ppsl->nshards && ppsl->shards; i++) {
+        periodic_shard *pshard = &ppsl->shards[i];
+
+        epicsEventMustTrigger(pshard->go);
+        epicsThreadMustJoin(pshard->tid);
+        epicsEventDestroy(pshard->go);
+        free(pshard->precords);
+    }
+    if (ppsl->shardsDone)
+        epicsEventDestroy(ppsl->shardsDone);
+    free(ppsl->shards);
+    free(ppsl->precords);
+    ppsl->shards = NULL;
+    ppsl->shardsDone = NULL;
+    ppsl->precords = NULL;
+}
+
+/* Process one PHAS value worth of records, those in precords[first, last),
+ * split across the shards by lock set.
+ */
+static void scanShardsPhase(periodic_scan_list *ppsl, int first, int last)
+{
+    int i, busy = 0;
+
+    for (i = 0; i < ppsl->nshards; i++)
+        ppsl->shards[i].nrecords = 0;
+
+    for (i = first; i < last; i++) {
+        struct dbCommon *precord = ppsl->precords[i];
+        periodic_shard *pshard =
+            &ppsl->shards[dbLockGetLockId(precord) % ppsl->nshards];
+
+        pshard->precords[pshard->nrecords++] = precord;
+    }
+
+    for (i = 0; i < ppsl->nshards; i++)
+        if (ppsl->shards[i].nrecords)
+            busy++;
+    epicsAtomicSetIntT(&ppsl->shardsBusy, busy);
+    for (i = 0; i < ppsl->nshards; i++)
+        if (ppsl->shards[i].nrecords)
+            epicsEventMustTrigger(ppsl->shards[i].go);
+    if (busy)
+        epicsEventMustWait(ppsl->shardsDone);
+}
+
+static void scanShards(periodic_scan_list *ppsl)
+{
+    scan_list *psl = &ppsl->scan_list;
+    scan_element *pse;
+    epicsUInt64 start = timingStart();
+    int n = 0, first, i;
+
+    /* Lock sets may merge and split until the records are processed, all
+     * records of a lock set in the snapshot are still processed in order.
+     */
+    epicsMutexMustLock(psl->lock);
+    if (ppsl->size < ellCount(&psl->list)) {
+        ppsl->size = ellCount(&psl->list);
+        free(ppsl->precords);
+        ppsl->precords = dbCalloc(ppsl->size, sizeof(struct dbCommon *));
+        for (i = 0; i < ppsl->nshards; i++) {
+            free(ppsl->shards[i].precords);
+            ppsl->shards[i].precords =
+                dbCalloc(ppsl->size, sizeof(struct dbCommon *));
+        }
+    }
+    for (pse = (scan_element *)ellFirst(&psl->list); pse;
+         pse = (scan_element *)ellNext(&pse->node))
+        ppsl->precords[n++] = pse->precord;
+    epicsMutexUnlock(psl->lock);
+
+    for (i = 0; i < ppsl->nshards; i++) {
+        ppsl->shards[i].records = 0;
+        ppsl->shards[i].busy = 0.0;
+    }
+
+    for (first = 0; first < n; first = i) {
+        short phas = ppsl->precords[first]->phas;
+
+        for (i = first + 1; i < n && ppsl->precords[i]->phas == phas; i++)
+            ;
+        scanShardsPhase(ppsl, first, i);
+    }
+
+    for (i = 0; i < ppsl->nshards; i++) {
+        periodic_shard *pshard = &ppsl->shards[i];
+
+        if (pshard->busy > pshard->busyMax)
+            pshard->busyMax = pshard->busy;
+        if (pshard->busy > ppsl->period)
+            pshard->overruns++;
+    }
+    timingEnd(ppsl->timing.exec, &ppsl->timing.execMax, start);
+}
+
 
 static void initPeriodic(void)
 {
@@ -904,6 +1565,8 @@ static void initPeriodic(void)
         ppsl->name = choice;
         ppsl->scanCtl = ctlPause;
         ppsl->loopEvent = epicsEventMustCreate(epicsEventEmpty);
+        ppsl->nshards = scanPeriodicShards;
+        ppsl->timing.name = choice;
 
         number = ppsl->period / quantum;
         if ((ppsl->period < 2 * quantum) ||
@@ -959,11 +1622,66 @@ static void ioscanCallback(epicsCallback *pcallback)
 
     callbackGetUser(piosh, pcallback);
     callbackGetPriority(prio, pcallback);
-    scanList(&piosh->iosl[prio].scan_list);
+    timingLate(&ioTiming[prio], &piosh->iosl[prio].pending,
+        &piosh->iosl[prio].requested);
+    scanList(&piosh->iosl[prio].scan_list, &ioTiming[prio]);
     if (piosh->cb)
         piosh->cb(piosh->arg, piosh, prio);
 }
 
+/* Take up to group lists off the batch and scan them, requesting
+ * another callback for the rest so other work can run in between.
+ */
+static void ioscanBatchCallback(epicsCallback *pcallback)
+{
+    ioscan_batch *pbatch;
+    io_batch_list *pbl;
+    io_scan_list *piosl, *plast;
+    unsigned int n = 1;
+    int more;
+    int prio;
+
+    callbackGetUser(pbatch, pcallback);
+    callbackGetPriority(prio, pcallback);
+    pbl = &pbatch->list[prio];
+
+    epicsSpinLock(pbatch->lock);
+    piosl = plast = pbl->first;
+    while (plast && plast->nextBatched && n++ != pbatch->group)
+        plast = plast->nextBatched;
+    if (plast) {
+        pbl->first = plast->nextBatched;
+        plast->nextBatched = NULL;
+        if (!pbl->first)
+            pbl->last = NULL;
+    }
+    more = pbl->first != NULL;
+    if (!more)
+        pbl->queued = 0;
+    epicsSpinUnlock(pbatch->lock);
+
+    if (more && callbackRequest(pcallback)) {
+        /* queue full, wait for the next scanIoBatchRequest() */
+        epicsSpinLock(pbatch->lock);
+        pbl->queued = 0;
+        epicsSpinUnlock(pbatch->lock);
+    }
+
+    while (piosl) {
+        io_scan_list *pnext = piosl->nextBatched;
+        ioscan_head *piosh = piosl->piosh;
+
+        timingEnd(ioTiming[prio].late, &ioTiming[prio].lateMax,
+            piosl->requested);
+        /* may be added again from here on */
+        epicsAtomicSetIntT(&piosl->batched, 0);
+        scanList(&piosl->scan_list, &ioTiming[prio]);
+        if (piosh->cb)
+            piosh->cb(piosh->arg, piosh, prio);
+        piosl = pnext;
+    }
+}
+
 static void printList(scan_list *psl, char *message)
 {
     scan_element *pse;
@@ -989,7 +1707,23 @@ static void printList(scan_list *psl, char *message)
     }
 }
 
-static void scanList(scan_list *psl)
+static void printShards(periodic_scan_list *ppsl)
+{
+    int i;
+
+    if (!ppsl->shards || !ellCount(&ppsl->scan_list.list))
+        return;
+
+    for (i = 0; i < ppsl->nshards; i++) {
+        periodic_shard *pshard = &ppsl->shards[i];
+
+        printf("    Shard %d: %lu records, %.3f ms busy (max %.3f ms),"
+            " %lu over-runs\n", i, pshard->records, pshard->busy * 1e3,
+            pshard->busyMax * 1e3, pshard->overruns);
+    }
+}
+
+static void scanList(scan_list *psl, scan_timing *ptiming)
 {
     /* When reading this code remember that the call to dbProcess can result
      * in the SCAN field being changed in an arbitrary number of records.
@@ -998,6 +1732,7 @@ static void scanList(scan_list *psl)
     scan_element *pse;
     scan_element *prev = NULL;
     scan_element *next = NULL;
+    epicsUInt64 start = timingStart();
 
     epicsMutexMustLock(psl->lock);
     psl->modified = FALSE;
@@ -1009,7 +1744,7 @@ static void scanList(scan_list *psl)
         struct dbCommon *precord = pse->precord;
 
         dbScanLock(precord);
-        dbProcess(precord);
+        timedProcess(ptiming, precord);
         dbScanUnlock(precord);
 
         epicsMutexMustLock(psl->lock);
@@ -1040,10 +1775,11 @@ static void scanList(scan_list *psl)
         } else {
             /*Too many changes. Just wait till next period*/
             epicsMutexUnlock(psl->lock);
-            return;
+            break;
         }
         epicsMutexUnlock(psl->lock);
     }
+    timingEnd(ptiming->exec, &ptiming->execMax, start);
 }
 
 static void buildScanLists(void)
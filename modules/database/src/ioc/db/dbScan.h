@@ -37,9 +37,18 @@ extern "C" {
 /*definitions for I/O Interrupt Scanning */
 /* IOSCANPVT now defined in devSup.h */
 typedef struct event_list *EVENTPVT;
+typedef struct ioscan_batch *IOSCANBATCH;
 
 struct dbCommon;
 
+/* Threads per periodic scan rate, set before iocInit */
+DBCORE_API extern int scanPeriodicShards;
+/* Threads serving the scanOnce queue, set before iocInit.
+ * With more than one, queued requests may be processed out of order. */
+DBCORE_API extern int scanOnceThreads;
+/* Collect the scan timing and find the slowest records, see scanTimingGet() */
+DBCORE_API extern int scanRecordTiming;
+
 typedef void (*io_scan_complete)(void *usr, IOSCANPVT, int prio);
 typedef void (*once_complete)(void *usr, struct dbCommon*);
 
@@ -50,6 +59,12 @@ typedef struct scanOnceQueueStats {
     int numOverflow;
 } scanOnceQueueStats;
 
+/* Request counters of the scanOnce queue, since iocInit */
+typedef struct scanOnceQueueCounts {
+    size_t numCoalesced;    /* requests merged with a queued one */
+    size_t numExecuted;     /* requests taken from the queue */
+} scanOnceQueueCounts;
+
 DBCORE_API long scanInit(void);
 DBCORE_API void scanRun(void);
 DBCORE_API void scanPause(void);
@@ -77,20 +92,67 @@ DBCORE_API int scanOnce(struct dbCommon *prec);
  * @return Zero on success.  Non-zero if the request could not be queued.
  */
 DBCORE_API int scanOnceCallback(struct dbCommon *prec, once_complete cb, void *usr);
+/** @brief Request record processing, unless a request is already queued
+ *
+ * Like scanOnce(), but if an earlier request made by this routine for the
+ * same record is still waiting in the queue, nothing more is queued.  For
+ * requests that only need the record processed once after a change, such
+ * as CP input links.
+ *
+ * @param prec Record to process
+ * @return Zero on success.  Non-zero if the request could not be queued.
+ * @since UNRELEASED
+ */
+DBCORE_API int scanOnceCoalesced(struct dbCommon *prec);
 /** @brief Set Once queue size
  *
  * Must be called prior to iocInit()
  *
+ * Requests are taken from the queue in order, but with scanOnceThreads
+ * greater than 1 several threads process them concurrently, so a request
+ * may be processed before an earlier one has finished or even started.
+ *
  * @param size New size.  May be smaller
  * @return Zero on success
  */
 DBCORE_API int scanOnceSetQueueSize(int size);
 DBCORE_API int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result);
+DBCORE_API int scanOnceQueueCountsGet(scanOnceQueueCounts *result);
 DBCORE_API void scanOnceQueueShow(const int reset);
 
 /*print periodic lists*/
 DBCORE_API int scanppl(double rate);
 
+/** @brief Scan timing statistics of a scan list
+ *
+ * Times are in seconds: how late scans started after they were due or
+ * requested, how long the whole list took to process, and the longest
+ * time a single record took, since the last reset.  Scans are only
+ * timed while scanRecordTiming is non-zero.
+ */
+typedef struct scanTimingStats {
+    unsigned long count;        /* scans */
+    double lateP50;
+    double lateP99;
+    double lateMax;
+    double execP50;
+    double execP99;
+    double execMax;
+    double recordMax;
+    const char *recordMaxName;  /* empty if none yet */
+} scanTimingStats;
+
+/** @brief Get the scan timing of a scan list
+ *
+ * The list is named by a periodic SCAN menu choice, or is one of
+ * "I/O Intr Low|Medium|High", "Event Low|Medium|High" or "Once".
+ * Returns 0, or -1 if there is no such list or scanning isn't initialized.
+ */
+DBCORE_API int scanTimingGet(const char *name, int reset,
+    scanTimingStats *pstats);
+/*print scan timing of one or all lists*/
+DBCORE_API int scanTimingShow(const char *name, int reset);
+
 /*print event lists*/
 DBCORE_API int scanpel(const char *event_name);
 
@@ -132,6 +194,41 @@ DBCORE_API unsigned int scanIoImmediate(IOSCANPVT pios, int prio);
  */
 DBCORE_API void scanIoSetComplete(IOSCANPVT, io_scan_complete, void *usr);
 
+/** @brief Initialize a batch of "I/O Intr" sources
+ * @param ppbatch Pointer to the batch to be initialized
+ * @param group Most scan lists processed by one callback, 0 for no limit
+ *
+ * A driver with many scan lists adds those that are ready with
+ * scanIoBatchAdd() and then makes a single scanIoBatchRequest(), instead
+ * of calling scanIoRequest() for each of them.  The lists are processed
+ * in the order added, using one callback queue entry per priority for the
+ * whole batch.  With a group size the callback re-queues itself after
+ * that many lists, letting other callbacks run in between.
+ *
+ * @since UNRELEASED
+ */
+DBCORE_API void scanIoBatchInit(IOSCANBATCH *ppbatch, unsigned int group);
+/** @brief Mark a scan list ready to be processed with the batch
+ * @param pbatch The batch
+ * @param pios The scan list, initialized by scanIoInit()
+ * @return A bit mask of the priorities on which the list was added.  A
+ *         list already waiting to be processed is not added again.
+ *
+ * May be called from interrupt context.  The completion callback set by
+ * scanIoSetComplete() is run after each list is processed.
+ * @since UNRELEASED
+ */
+DBCORE_API unsigned int scanIoBatchAdd(IOSCANBATCH pbatch, IOSCANPVT pios);
+/** @brief Request processing of the lists added to a batch
+ * @param pbatch The batch
+ * @return A bit mask of the priorities on which a callback is queued
+ *
+ * Lists added while the batch is being processed are included if the
+ * callback has not yet reached them, otherwise another request is needed.
+ * @since UNRELEASED
+ */
+DBCORE_API unsigned int scanIoBatchRequest(IOSCANBATCH pbatch);
+
 #ifdef __cplusplus
 }
 #endif
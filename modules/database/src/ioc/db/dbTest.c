@@ -11,6 +11,7 @@
 /* database access test subroutines */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
@@ -752,6 +753,115 @@ int dbhcr(void)
     dbReportDeviceConfig(pdbbase, stdout);
     return 0;
 }
+
+typedef struct profileEntry {
+    const char *name;
+    dbProfile prof;
+} profileEntry;
+
+static int profileCompare(const void *a, const void *b)
+{
+    const profileEntry *pa = a;
+    const profileEntry *pb = b;
+
+    if (pa->prof.total != pb->prof.total)
+        return pa->prof.total < pb->prof.total ? 1 : -1;
+    return strcmp(pa->name, pb->name);
+}
+
+long dbProfileShow(int count)
+{
+    DBENTRY dbentry;
+    DBENTRY *pdbentry = &dbentry;
+    profileEntry *pentries;
+    long status;
+    int nrecords = 0, nprofiled = 0, i;
+
+    if (!pdbbase) {
+        printf("No database loaded\n");
+        return 0;
+    }
+    if (count <= 0)
+        count = 20;
+
+    dbInitEntry(pdbbase, pdbentry);
+    status = dbFirstRecordType(pdbentry);
+    while (!status) {
+        nrecords += dbGetNRecords(pdbentry);
+        status = dbNextRecordType(pdbentry);
+    }
+    pentries = nrecords ? malloc(nrecords * sizeof(profileEntry)) : NULL;
+    if (nrecords && !pentries) {
+        dbFinishEntry(pdbentry);
+        printf("dbProfileShow: Out of memory\n");
+        return -1;
+    }
+
+    status = dbFirstRecordType(pdbentry);
+    while (!status) {
+        status = dbFirstRecord(pdbentry);
+        while (!status) {
+            dbCommon *precord = pdbentry->precnode->precord;
+
+            if (!dbIsAlias(pdbentry) &&
+                dbProfileGet(precord, &pentries[nprofiled].prof, 0) &&
+                pentries[nprofiled].prof.count) {
+                pentries[nprofiled].name = precord->name;
+                nprofiled++;
+            }
+            status = dbNextRecord(pdbentry);
+        }
+        status = dbNextRecordType(pdbentry);
+    }
+    dbFinishEntry(pdbentry);
+
+    printf("Record processing profile (dbProcessProfile=%d), "
+        "%d records processed\n", dbProcessProfile, nprofiled);
+    if (nprofiled) {
+        qsort(pentries, nprofiled, sizeof(profileEntry), profileCompare);
+        printf("     CALLS    TOTAL ms     MEAN us      MAX us  RECORD\n");
+        for (i = 0; i < nprofiled && i < count; i++) {
+            const dbProfile *prof = &pentries[i].prof;
+
+            printf("%10llu %11.3f %11.3f %11.3f  %s\n",
+                (unsigned long long) prof->count, prof->total * 1e-6,
+                prof->total * 1e-3 / prof->count, prof->max * 1e-3,
+                pentries[i].name);
+        }
+    }
+    free(pentries);
+    return 0;
+}
+
+long dbProfileReset(void)
+{
+    DBENTRY dbentry;
+    DBENTRY *pdbentry = &dbentry;
+    long status;
+
+    if (!pdbbase) {
+        printf("No database loaded\n");
+        return 0;
+    }
+
+    dbInitEntry(pdbbase, pdbentry);
+    status = dbFirstRecordType(pdbentry);
+    while (!status) {
+        status = dbFirstRecord(pdbentry);
+        while (!status) {
+            dbCommon *precord = pdbentry->precnode->precord;
+
+            dbProfile prof;
+
+            if (!dbIsAlias(pdbentry))
+                dbProfileGet(precord, &prof, 1);
+            status = dbNextRecord(pdbentry);
+        }
+        status = dbNextRecordType(pdbentry);
+    }
+    dbFinishEntry(pdbentry);
+    return 0;
+}
 
 static long nameToAddr(const char *pname, DBADDR *paddr)
 {
@@ -47,6 +47,10 @@ DBCORE_API long dbior(
     const char *pdrvName,int interest_level);
 /*Hardware Configuration Report*/
 DBCORE_API int dbhcr(void);
+/*Records with the longest processing times, see dbProcessProfile*/
+DBCORE_API long dbProfileShow(int count);
+/*Clear the processing times of all records*/
+DBCORE_API long dbProfileReset(void);
 
 #ifdef __cplusplus
 }
@@ -168,6 +168,11 @@ typedef struct dbRecordType {
     /*The following are only available on run time system*/
     rset            *prset;
     int             rec_size;       /*record size in bytes          */
+    /*Perfect hash of the field names, see dbFieldHashInit()*/
+    short           *fldHash;       /* ind in papFldDes, -1 if unused*/
+    short           *fldHashSeed;   /* second hash seed of each bucket*/
+    unsigned int    fldHashMask;    /* number of fldHash entries - 1*/
+    unsigned int    fldHashSeedMask;/* number of buckets - 1        */
 }dbRecordType;
 
 struct dbPvd;           /* Contents private to dbPvdLib code */
@@ -778,6 +778,7 @@ static void dbRecordtypeBody(void)
             }
         }
     }
+    dbFieldHashInit(pdbRecordType);
     /*Initialize lists*/
     ellInit(&pdbRecordType->attributeList);
     ellInit(&pdbRecordType->recList);
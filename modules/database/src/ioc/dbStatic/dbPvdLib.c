@@ -17,31 +17,297 @@
 
 #include "dbDefs.h"
 #include "ellLib.h"
+#include "epicsAtomic.h"
 #include "epicsMutex.h"
 #include "epicsStdio.h"
 #include "epicsString.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
 
 #include "dbBase.h"
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
 
+/* The directory is an open addressing hash table with linear probing.
+ * Lookups don't lock: they load the current table and read its slots
+ * with atomic operations, while adds and deletes are serialized by the
+ * directory lock.  A slot keeps the hash of its name so most probes
+ * don't touch the name, and each entry has its own copy of the name
+ * since the record's may be freed while a lookup compares it.  Deleted
+ * names leave a tombstone so the probe sequences of other names stay
+ * intact, and the table is replaced by a larger (or cleaned up) copy when
+ * names and tombstones fill half of it.
+ *
+ * Replaced tables and filters and deleted entries may still be read by
+ * lookups in progress.  Lookups count themselves in one of two counters,
+ * and a rebuild waits for the lookups that may have seen the old copy
+ * before freeing what was retired.  So no replaced table outlives the
+ * rebuild, and deleted entries are freed the same way at the latest once
+ * DELETED_MAX have piled up.
+ */
 typedef struct {
-    ELLLIST      list;
-    epicsMutexId lock;
-} dbPvdBucket;
+    unsigned int hash;
+    PVDENTRY *entry;        /* NULL if never used */
+} dbPvdSlot;
+
+typedef struct dbPvdTable {
+    ELLNODE node;           /* on retired list once replaced */
+    unsigned int size;      /* power of 2 */
+    unsigned int shift;     /* 32 - log2(size) */
+    dbPvdSlot slots[1];
+} dbPvdTable;
+
+static PVDENTRY tombstone;
+#define TOMBSTONE (&tombstone)
+
+/* Counting bloom filter of the names in the directory, so that lookups
+ * of names hosted elsewhere (most CA name searches) fail without probing
+ * the table.  Cells are 4-bit counters, two to a byte; a counter that has
+ * saturated is never decremented again.
+ */
+typedef struct dbPvdFilter {
+    ELLNODE node;           /* on retired list once replaced */
+    unsigned int mask;      /* number of cells - 1 */
+    unsigned char cells[1];
+} dbPvdFilter;
 
 typedef struct dbPvd {
-    unsigned int size;
-    unsigned int mask;
-    dbPvdBucket **buckets;
+    dbPvdTable *table;
+    epicsMutexId lock;      /* serializes adds, deletes and rebuilds */
+    unsigned int count;     /* names in the directory */
+    unsigned int tombstones;
+    unsigned int resizes;
+    dbPvdFilter *filter;    /* NULL until dbPvdFilterInit() */
+    ELLLIST retired;        /* replaced tables and filters */
+    ELLLIST deleted;        /* deleted entries */
+    int epoch;              /* readers[] counter of new lookups */
+    int readers[2];         /* lookups in progress */
 } dbPvd;
 
 unsigned int dbPvdHashTableSize = 0;
 
 #define MIN_SIZE 256
+#define DELETED_MAX 64
 #define DEFAULT_SIZE 512
 #define MAX_SIZE 65536
 
+/* Home slot of a hash, Fibonacci hashing spreads similar names */
+#define HOME_SLOT(ptable, hash) \
+    ((unsigned int) ((hash) * 0x9E3779B1u) >> (ptable)->shift)
+
+static dbPvdTable *tableCreate(unsigned int size)
+{
+    dbPvdTable *ptable = dbCalloc(1,
+        sizeof(dbPvdTable) + (size - 1) * sizeof(dbPvdSlot));
+    unsigned int bits = 0;
+
+    while ((1u << bits) < size)
+        bits++;
+    ptable->size = size;
+    ptable->shift = 32 - bits;
+    return ptable;
+}
+
+/* Insert into a table not yet visible to lookups */
+static void tableInsert(dbPvdTable *ptable, unsigned int hash,
+    PVDENTRY *ppvdNode)
+{
+    unsigned int mask = ptable->size - 1;
+    unsigned int i = HOME_SLOT(ptable, hash);
+
+    while (ptable->slots[i].entry)
+        i = (i + 1) & mask;
+    ptable->slots[i].hash = hash;
+    ptable->slots[i].entry = ppvdNode;
+}
+
+/* Publish an object whose contents were written by this thread */
+static void publish(void **ptarget, void *pobject)
+{
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetPtrT(ptarget, pobject);
+}
+
+/* Count a lookup in the readers of the current epoch */
+static int lookupEnter(dbPvd *ppvd)
+{
+    int epoch = epicsAtomicGetIntT(&ppvd->epoch);
+
+    /* a full barrier, the lookup's loads can't move before it */
+    epicsAtomicIncrIntT(&ppvd->readers[epoch]);
+    return epoch;
+}
+
+static void lookupExit(dbPvd *ppvd, int epoch)
+{
+    epicsAtomicDecrIntT(&ppvd->readers[epoch]);
+}
+
+/* Free the retired tables and filters and the deleted entries once the
+ * lookups which may still see them are done.  New lookups count in the
+ * other epoch, and load the objects published before the switch.  Two
+ * switches, as a lookup that read the epoch just before one may count
+ * itself in the counter we have already found drained.  Lookups never
+ * block, so this doesn't wait long.  Caller holds ppvd->lock.
+ */
+static void reclaim(dbPvd *ppvd)
+{
+    ELLNODE *pnode;
+    int pass;
+
+    if (!ellCount(&ppvd->retired) && !ellCount(&ppvd->deleted))
+        return;
+
+    for (pass = 0; pass < 2; pass++) {
+        int old = ppvd->epoch;
+
+        epicsAtomicCmpAndSwapIntT(&ppvd->epoch, old, !old);
+        /* really sleep, the lookups may run at a lower priority */
+        while (epicsAtomicAddIntT(&ppvd->readers[old], 0))
+            epicsThreadSleep(epicsThreadSleepQuantum());
+    }
+
+    while ((pnode = ellGet(&ppvd->deleted)))
+        free(pnode);
+    while ((pnode = ellGet(&ppvd->retired)))
+        free(pnode);
+}
+
+/* Replace the table by one with room for at least 4 times the names.
+ * Caller holds ppvd->lock.
+ */
+static void tableRebuild(dbPvd *ppvd)
+{
+    dbPvdTable *pold = ppvd->table;
+    dbPvdTable *pnew;
+    unsigned int size = pold->size;
+    unsigned int i;
+
+    while (size < 0x80000000u && size < (ppvd->count + 1) * 4)
+        size <<= 1;
+
+    pnew = tableCreate(size);
+    for (i = 0; i < pold->size; i++) {
+        PVDENTRY *ppvdNode = pold->slots[i].entry;
+
+        if (ppvdNode && ppvdNode != TOMBSTONE)
+            tableInsert(pnew, pold->slots[i].hash, ppvdNode);
+    }
+
+    publish((void **) &ppvd->table, pnew);
+    ellAdd(&ppvd->retired, &pold->node);
+    ppvd->tombstones = 0;
+    if (size != pold->size)
+        ppvd->resizes++;
+    reclaim(ppvd);
+}
+
+#define FILTER_HASHES 4
+#define FILTER_CELLS_PER_NAME 8
+#define FILTER_MIN_CELLS 1024
+#define FILTER_MAX_CELL 15
+
+/* Derive the cell indexes of a name from the hash of the directory */
+static void filterProbes(unsigned int hash, unsigned int mask,
+    unsigned int *probes)
+{
+    epicsUInt64 mix;
+    epicsUInt32 h1, h2;
+    int i;
+
+    mix = (hash ^ (hash >> 16)) * 0x9E3779B97F4A7C15ull;
+    h1 = (epicsUInt32) mix;
+    h2 = (epicsUInt32) (mix >> 32) | 1;
+    for (i = 0; i < FILTER_HASHES; i++)
+        probes[i] = (h1 + i * h2) & mask;
+}
+
+static unsigned int filterGet(const dbPvdFilter *pfilter, unsigned int cell)
+{
+    return (pfilter->cells[cell >> 1] >> ((cell & 1) << 2)) & 0xf;
+}
+
+static void filterSet(dbPvdFilter *pfilter, unsigned int cell,
+    unsigned int val)
+{
+    unsigned char *pbyte = &pfilter->cells[cell >> 1];
+    unsigned int shift = (cell & 1) << 2;
+
+    *pbyte = (unsigned char) ((*pbyte & ~(0xf << shift)) | (val << shift));
+}
+
+static void filterAdd(dbPvdFilter *pfilter, unsigned int hash)
+{
+    unsigned int probes[FILTER_HASHES];
+    int i;
+
+    filterProbes(hash, pfilter->mask, probes);
+    for (i = 0; i < FILTER_HASHES; i++) {
+        unsigned int val = filterGet(pfilter, probes[i]);
+
+        if (val < FILTER_MAX_CELL)
+            filterSet(pfilter, probes[i], val + 1);
+    }
+}
+
+static void filterRemove(dbPvdFilter *pfilter, unsigned int hash)
+{
+    unsigned int probes[FILTER_HASHES];
+    int i;
+
+    filterProbes(hash, pfilter->mask, probes);
+    for (i = 0; i < FILTER_HASHES; i++) {
+        unsigned int val = filterGet(pfilter, probes[i]);
+
+        if (val > 0 && val < FILTER_MAX_CELL)
+            filterSet(pfilter, probes[i], val - 1);
+    }
+}
+
+static int filterMayContain(const dbPvdFilter *pfilter, unsigned int hash)
+{
+    unsigned int probes[FILTER_HASHES];
+    int i;
+
+    filterProbes(hash, pfilter->mask, probes);
+    for (i = 0; i < FILTER_HASHES; i++) {
+        if (!filterGet(pfilter, probes[i]))
+            return 0;
+    }
+    return 1;
+}
+
+/* Build a filter sized for the current names and publish it.
+ * Caller holds ppvd->lock.
+ */
+static void filterBuild(dbPvd *ppvd)
+{
+    dbPvdTable *ptable = ppvd->table;
+    dbPvdFilter *pfilter;
+    unsigned int ncells = FILTER_MIN_CELLS;
+    unsigned int i;
+
+    while (ncells < 0x80000000u &&
+           ncells < (ppvd->count + 1) * FILTER_CELLS_PER_NAME)
+        ncells <<= 1;
+
+    pfilter = dbCalloc(1, sizeof(dbPvdFilter) + ncells / 2);
+    pfilter->mask = ncells - 1;
+
+    for (i = 0; i < ptable->size; i++) {
+        PVDENTRY *ppvdNode = ptable->slots[i].entry;
+
+        if (ppvdNode && ppvdNode != TOMBSTONE)
+            filterAdd(pfilter, ptable->slots[i].hash);
+    }
+
+    /* Lookups may still be reading the old filter */
+    if (ppvd->filter)
+        ellAdd(&ppvd->retired, &ppvd->filter->node);
+    publish((void **) &ppvd->filter, pfilter);
+    reclaim(ppvd);
+}
+
 
 int dbPvdTableSize(int size)
 {
@@ -70,131 +336,225 @@ void dbPvdInitPvt(dbBase *pdbbase)
         dbPvdHashTableSize = DEFAULT_SIZE;
     }
 
-    ppvd = (dbPvd *)dbMalloc(sizeof(dbPvd));
-    ppvd->size    = dbPvdHashTableSize;
-    ppvd->mask    = dbPvdHashTableSize - 1;
-    ppvd->buckets = dbCalloc(ppvd->size, sizeof(dbPvdBucket *));
+    ppvd = dbCalloc(1, sizeof(dbPvd));
+    ppvd->table = tableCreate(dbPvdHashTableSize);
+    ppvd->lock  = epicsMutexMustCreate();
+    ellInit(&ppvd->retired);
+    ellInit(&ppvd->deleted);
 
     pdbbase->ppvd = ppvd;
     return;
 }
 
-PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
+void dbPvdFilterInit(dbBase *pdbbase)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
-    PVDENTRY *ppvdNode;
 
-    pbucket = ppvd->buckets[epicsMemHash(name, lenName, 0) & ppvd->mask];
-    if (pbucket == NULL) return NULL;
+    if (ppvd == NULL) return;
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        const char *recordname = ppvdNode->precnode->recordname;
+    epicsMutexMustLock(ppvd->lock);
+    filterBuild(ppvd);
+    epicsMutexUnlock(ppvd->lock);
+}
 
-        if (strncmp(name, recordname, lenName) == 0 &&
-            strlen(recordname) == lenName)
-            break;
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
+/* Probe for a name, without locking */
+static PVDENTRY *tableFind(const dbPvdTable *ptable, unsigned int hash,
+    const char *name, size_t lenName)
+{
+    unsigned int mask = ptable->size - 1;
+    unsigned int i = HOME_SLOT(ptable, hash);
+    PVDENTRY *ppvdNode;
+
+    while ((ppvdNode = epicsAtomicGetPtrT((void **) &ptable->slots[i].entry))) {
+        if (ppvdNode != TOMBSTONE && ptable->slots[i].hash == hash) {
+            if (strncmp(name, ppvdNode->name, lenName) == 0 &&
+                ppvdNode->name[lenName] == '\0')
+                return ppvdNode;
+        }
+        i = (i + 1) & mask;
     }
-    epicsMutexUnlock(pbucket->lock);
+    return NULL;
+}
+
+PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
+{
+    dbPvd *ppvd = pdbbase->ppvd;
+    unsigned int hash = epicsMemHash(name, lenName, 0);
+    int epoch = lookupEnter(ppvd);
+    dbPvdFilter *pfilter = epicsAtomicGetPtrT((void **) &ppvd->filter);
+    PVDENTRY *ppvdNode = NULL;
+
+    if (!pfilter || filterMayContain(pfilter, hash))
+        ppvdNode = tableFind(epicsAtomicGetPtrT((void **) &ppvd->table),
+            hash, name, lenName);
+
+    lookupExit(ppvd, epoch);
     return ppvdNode;
 }
-
+
 PVDENTRY *dbPvdAdd(dbBase *pdbbase, dbRecordType *precordType,
     dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
+    dbPvdTable *ptable;
     PVDENTRY *ppvdNode;
     char *name = precnode->recordname;
-    unsigned int h;
-
-    h = epicsStrHash(name, 0) & ppvd->mask;
-    pbucket = ppvd->buckets[h];
-    if (pbucket == NULL) {
-        pbucket = dbCalloc(1, sizeof(dbPvdBucket));
-        ellInit(&pbucket->list);
-        pbucket->lock = epicsMutexCreate();
-        ppvd->buckets[h] = pbucket;
-    }
-
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        if (strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            epicsMutexUnlock(pbucket->lock);
-            return NULL;
+    size_t lenName = strlen(name);
+    unsigned int hash = epicsStrHash(name, 0);
+    unsigned int mask, i, reuse = 0;
+    int found = 0;
+
+    epicsMutexMustLock(ppvd->lock);
+    if (tableFind(ppvd->table, hash, name, lenName)) {
+        epicsMutexUnlock(ppvd->lock);
+        return NULL;
+    }
+
+    if ((ppvd->count + ppvd->tombstones + 1) * 2 > ppvd->table->size)
+        tableRebuild(ppvd);
+    ptable = ppvd->table;
+    mask = ptable->size - 1;
+
+    /* The first tombstone or free slot of the probe sequence */
+    i = HOME_SLOT(ptable, hash);
+    while (ptable->slots[i].entry) {
+        if (ptable->slots[i].entry == TOMBSTONE && !found) {
+            reuse = i;
+            found = 1;
         }
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
+        i = (i + 1) & mask;
     }
-    ppvdNode = dbCalloc(1, sizeof(PVDENTRY));
+    if (found) {
+        i = reuse;
+        ppvd->tombstones--;
+    }
+
+    ppvdNode = dbCalloc(1, sizeof(PVDENTRY) + lenName + 1);
     ppvdNode->precordType = precordType;
     ppvdNode->precnode = precnode;
-    ellAdd(&pbucket->list, (ELLNODE *)ppvdNode);
-    epicsMutexUnlock(pbucket->lock);
+    ppvdNode->name = memcpy(ppvdNode + 1, name, lenName + 1);
+    ptable->slots[i].hash = hash;
+    publish((void **) &ptable->slots[i].entry, ppvdNode);
+
+    ppvd->count++;
+    if (ppvd->filter) {
+        /* Grow once the false positive rate would have risen much */
+        if (ppvd->count * (FILTER_CELLS_PER_NAME / 2) > ppvd->filter->mask)
+            filterBuild(ppvd);
+        else
+            filterAdd(ppvd->filter, hash);
+    }
+    epicsMutexUnlock(ppvd->lock);
     return ppvdNode;
 }
 
 void dbPvdDelete(dbBase *pdbbase, dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
-    PVDENTRY *ppvdNode;
+    dbPvdTable *ptable;
     char *name = precnode->recordname;
+    unsigned int hash = epicsStrHash(name, 0);
+    unsigned int mask, i;
+    PVDENTRY *ppvdNode;
 
-    pbucket = ppvd->buckets[epicsStrHash(name, 0) & ppvd->mask];
-    if (pbucket == NULL) return;
-
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        if (ppvdNode->precnode &&
-            ppvdNode->precnode->recordname &&
-            strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
-            free(ppvdNode);
+    epicsMutexMustLock(ppvd->lock);
+    ptable = ppvd->table;
+    mask = ptable->size - 1;
+    i = HOME_SLOT(ptable, hash);
+    while ((ppvdNode = ptable->slots[i].entry)) {
+        if (ppvdNode != TOMBSTONE && ptable->slots[i].hash == hash &&
+            strcmp(name, ppvdNode->name) == 0) {
+            epicsAtomicSetPtrT((void **) &ptable->slots[i].entry, TOMBSTONE);
+            /* lookups in progress may still compare its name */
+            ellAdd(&ppvd->deleted, &ppvdNode->node);
+            ppvd->count--;
+            ppvd->tombstones++;
+            if (ppvd->filter)
+                filterRemove(ppvd->filter, hash);
+            if (ellCount(&ppvd->deleted) >= DELETED_MAX)
+                reclaim(ppvd);
             break;
         }
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
+        i = (i + 1) & mask;
     }
-    epicsMutexUnlock(pbucket->lock);
+    epicsMutexUnlock(ppvd->lock);
     return;
 }
 
 void dbPvdFreeMem(dbBase *pdbbase)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    unsigned int h;
+    dbPvdTable *ptable;
+    ELLNODE *pnode;
+    unsigned int i;
 
     if (ppvd == NULL) return;
     pdbbase->ppvd = NULL;
 
-    for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
-        PVDENTRY *ppvdNode;
+    ptable = ppvd->table;
+    for (i = 0; i < ptable->size; i++) {
+        PVDENTRY *ppvdNode = ptable->slots[i].entry;
 
-        if (pbucket == NULL) continue;
-        epicsMutexMustLock(pbucket->lock);
-        ppvd->buckets[h] = NULL;
-        while ((ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list))) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
+        if (ppvdNode && ppvdNode != TOMBSTONE)
             free(ppvdNode);
-        }
-        epicsMutexUnlock(pbucket->lock);
-        epicsMutexDestroy(pbucket->lock);
-        free(pbucket);
     }
-    free(ppvd->buckets);
+    free(ptable);
+    while ((pnode = ellGet(&ppvd->deleted)))
+        free(pnode);
+    while ((pnode = ellGet(&ppvd->retired)))
+        free(pnode);
+    free(ppvd->filter);
+    epicsMutexDestroy(ppvd->lock);
     free(ppvd);
 }
 
+/* Occupancy of the table and the filter.  Caller holds ppvd->lock. */
+static void pvdSummary(dbPvd *ppvd, int verbose)
+{
+    dbPvdTable *ptable = ppvd->table;
+    unsigned int maxProbe = 0;
+    double sumProbe = 0;
+    unsigned int i;
+
+    printf("Process Variable Directory has %u slots, %u names, "
+        "%u deleted names", ptable->size, ppvd->count, ppvd->tombstones);
+
+    for (i = 0; i < ptable->size; i++) {
+        PVDENTRY *ppvdNode = ptable->slots[i].entry;
+        unsigned int probe;
+
+        if (!ppvdNode || ppvdNode == TOMBSTONE)
+            continue;
+        /* slots between the home slot and this one */
+        probe = (i - HOME_SLOT(ptable, ptable->slots[i].hash)) &
+            (ptable->size - 1);
+        sumProbe += probe;
+        if (probe > maxProbe)
+            maxProbe = probe;
+        if (verbose)
+            printf("\n [%8u] +%-3u %s", i, probe, ppvdNode->name);
+    }
+    printf("\nLoad factor %.3f, %u resizes, probe length mean %.2f max %u.\n",
+        (double) (ppvd->count + ppvd->tombstones) / ptable->size,
+        ppvd->resizes, ppvd->count ? 1.0 + sumProbe / ppvd->count : 0.0,
+        maxProbe + 1);
+
+    if (ppvd->filter) {
+        unsigned int used = 0;
+
+        for (i = 0; i <= ppvd->filter->mask; i++) {
+            if (filterGet(ppvd->filter, i))
+                used++;
+        }
+        printf("Lookup filter has %u cells for %u names, %.1f%% in use.\n",
+            ppvd->filter->mask + 1, ppvd->count,
+            100.0 * used / (ppvd->filter->mask + 1));
+    }
+}
+
 void dbPvdDump(dbBase *pdbbase, int verbose)
 {
-    unsigned int empty = 0;
     dbPvd *ppvd;
-    unsigned int h;
 
     if (!pdbbase) {
         fprintf(stderr,"pdbbase not specified\n");
@@ -203,27 +563,85 @@ void dbPvdDump(dbBase *pdbbase, int verbose)
     ppvd = pdbbase->ppvd;
     if (ppvd == NULL) return;
 
-    printf("Process Variable Directory has %u buckets", ppvd->size);
+    epicsMutexMustLock(ppvd->lock);
+    pvdSummary(ppvd, verbose);
+    epicsMutexUnlock(ppvd->lock);
+}
 
-    for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
-        PVDENTRY *ppvdNode;
-        int i = 1;
+#define STATS_NAMES 65536
 
-        if (pbucket == NULL) {
-            empty++;
-            continue;
-        }
-        epicsMutexMustLock(pbucket->lock);
-        ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-        printf("\n [%4u] %4d  ", h, ellCount(&pbucket->list));
-        while (ppvdNode && verbose) {
-            if (!(++i % 4))
-                printf("\n         ");
-            printf("  %s", ppvdNode->precnode->recordname);
-            ppvdNode = (PVDENTRY *) ellNext((ELLNODE*)ppvdNode);
+/* Lookups per second of the given names, repeated for about 0.2 sec */
+static double lookupRate(dbBase *pdbbase, char **names, unsigned int n)
+{
+    epicsUInt64 start = epicsMonotonicGet();
+    epicsUInt64 elapsed;
+    double lookups = 0;
+    unsigned int i;
+
+    do {
+        for (i = 0; i < n; i++)
+            dbPvdFind(pdbbase, names[i], strlen(names[i]));
+        lookups += n;
+        elapsed = epicsMonotonicGet() - start;
+    } while (elapsed < 200000000u);
+
+    return lookups * 1e9 / elapsed;
+}
+
+void dbPvdStats(dbBase *pdbbase)
+{
+    dbPvd *ppvd;
+    dbPvdTable *ptable;
+    char **names;
+    unsigned int i, step, n = 0;
+
+    if (!pdbbase) {
+        fprintf(stderr,"pdbbase not specified\n");
+        return;
+    }
+    ppvd = pdbbase->ppvd;
+    if (ppvd == NULL) return;
+
+    epicsMutexMustLock(ppvd->lock);
+    pvdSummary(ppvd, 0);
+
+    ptable = ppvd->table;
+    if (ppvd->count == 0) {
+        epicsMutexUnlock(ppvd->lock);
+        return;
+    }
+
+    /* Sample names from all over the table, and make absent names of
+     * them by appending a character that no record name contains.
+     */
+    names = dbCalloc(2 * STATS_NAMES, sizeof(char *));
+    step = ptable->size / (4 * STATS_NAMES);
+    if (step == 0)
+        step = 1;
+    for (i = 0; i < ptable->size && n < STATS_NAMES; i += step) {
+        PVDENTRY *ppvdNode = ptable->slots[i].entry;
+
+        if (ppvdNode && ppvdNode != TOMBSTONE) {
+            size_t len = strlen(ppvdNode->name);
+
+            names[n] = epicsStrDup(ppvdNode->name);
+            names[STATS_NAMES + n] = dbMalloc(len + 2);
+            memcpy(names[STATS_NAMES + n], ppvdNode->name, len);
+            names[STATS_NAMES + n][len] = '\t';
+            names[STATS_NAMES + n][len + 1] = '\0';
+            n++;
         }
-        epicsMutexUnlock(pbucket->lock);
     }
-    printf("\n%u buckets empty.\n", empty);
+    epicsMutexUnlock(ppvd->lock);
+
+    /* Lookups don't lock, adds and deletes may go on meanwhile */
+    printf("Lookups of %u names: %.0f/sec present, %.0f/sec absent.\n", n,
+        lookupRate(pdbbase, names, n),
+        lookupRate(pdbbase, &names[STATS_NAMES], n));
+
+    for (i = 0; i < n; i++) {
+        free(names[i]);
+        free(names[STATS_NAMES + i]);
+    }
+    free(names);
 }
@@ -181,16 +181,32 @@ static const iocshFuncDef dbPvdDumpFuncDef = {
     "dbPvdDump",
     2,
     dbPvdDumpArgs,
-    "Dump the various buckets of the process variable directory.\n"
-    "If verbose is greater than 0, also print the process variables in each bucket.\n"
+    "Dump the occupancy of the process variable directory.\n"
+    "If verbose is greater than 0, also print the process variable in each slot.\n"
     "Example: dbPvdDump pdbbase 1\n"
-    "If the last argument(s) are missing, dump all buckets as though verbose is 0.\n",
+    "If the last argument(s) are missing, dump as though verbose is 0.\n",
 };
 static void dbPvdDumpCallFunc(const iocshArgBuf *args)
 {
     dbPvdDump(*iocshPpdbbase,args[1].ival);
 }
 
+/* dbPvdStats */
+static const iocshArg * const dbPvdStatsArgs[] = {&argPdbbase};
+static const iocshFuncDef dbPvdStatsFuncDef = {
+    "dbPvdStats",
+    1,
+    dbPvdStatsArgs,
+    "Report the load factor and probe lengths of the process variable\n"
+    "directory, and measure how many record name lookups per second it\n"
+    "answers for names present and absent.\n\n"
+    "Example: dbPvdStats pdbbase\n",
+};
+static void dbPvdStatsCallFunc(const iocshArgBuf *args)
+{
+    dbPvdStats(*iocshPpdbbase);
+}
+
 /* dbPvdTableSize */
 static const iocshArg dbPvdTableSizeArg0 = { "size",iocshArgInt};
 static const iocshArg * const dbPvdTableSizeArgs[1] =
@@ -199,9 +215,9 @@ static const iocshFuncDef dbPvdTableSizeFuncDef = {
     "dbPvdTableSize",
     1,
     dbPvdTableSizeArgs,
-    "Change the number of buckets in the process variable directory.\n\n"
+    "Change the initial number of slots in the process variable directory.\n\n"
     "The process variable directory size should be set before loading the database.\n"
-    "The size of the process variable directory can automatically grow.\n"
+    "The process variable directory grows automatically as records are added.\n"
     "The size must be a power of 2.\n\n"
     "Example: dbPvdTableSize 1024\n",
 };
@@ -275,6 +291,7 @@ void dbStaticIocRegister(void)
     iocshRegister(&dbDumpVariableFuncDef, dbDumpVariableCallFunc);
     iocshRegister(&dbDumpBreaktableFuncDef, dbDumpBreaktableCallFunc);
     iocshRegister(&dbPvdDumpFuncDef, dbPvdDumpCallFunc);
+    iocshRegister(&dbPvdStatsFuncDef, dbPvdStatsCallFunc);
     iocshRegister(&dbPvdTableSizeFuncDef,dbPvdTableSizeCallFunc);
     iocshRegister(&dbReportDeviceConfigFuncDef, dbReportDeviceConfigCallFunc);
     iocshRegister(&dbCreateAliasFuncDef, dbCreateAliasCallFunc);
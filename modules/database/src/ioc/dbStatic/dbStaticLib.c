@@ -511,6 +511,7 @@ void dbFreeBase(dbBase *pdbbase)
         free((void *)pdbRecordType->link_ind);
         free((void *)pdbRecordType->papsortFldName);
         free((void *)pdbRecordType->sortFldInd);
+        free((void *)pdbRecordType->fldHash);
         free((void *)pdbRecordType->papFldDes);
         free((void *)pdbRecordType);
         pdbRecordType = pdbRecordTypeNext;
@@ -1778,6 +1779,115 @@ long dbCopyRecord(DBENTRY *pdbentry,const char *newRecordName,int overWriteOK)
     return(dbFindRecord(pdbentry,newRecordName));
 }
 
+/* Mix a field name hash with a seed.  The seed must change which names
+ * collide, so it can't just be the initial value of the string hash.
+ */
+static unsigned int fieldHashMix(unsigned int hash, unsigned int seed)
+{
+    hash ^= seed * 0x9E3779B9u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/* Build a perfect hash of the field names of a record type, by hash and
+ * displace: the names are put into buckets of about two, then, starting
+ * with the largest buckets, a seed is searched for each bucket that puts
+ * its names into entries of the table that are still free.  A lookup
+ * costs one hash of the name, two mixes and one compare.
+ */
+void dbFieldHashInit(dbRecordType *precordType)
+{
+    int no_fields = precordType->no_fields;
+    unsigned int nbuckets = 1, size = 8;
+    unsigned int *hash = dbCalloc(no_fields + 1, sizeof(unsigned int));
+    short *bucket = dbCalloc(no_fields + 1, sizeof(short));
+    short *seeds, *table;
+    int i, j, largest;
+
+    while (2u * nbuckets < (unsigned int) no_fields)
+        nbuckets <<= 1;
+    while (size < 2u * no_fields)
+        size <<= 1;
+
+    largest = 0;
+    for (i = 0; i < no_fields; i++) {
+        int n = 0;
+
+        hash[i] = epicsStrHash(precordType->papFldDes[i]->name, 0);
+        bucket[i] = (short) (fieldHashMix(hash[i], 0) & (nbuckets - 1));
+        for (j = 0; j <= i; j++)
+            if (bucket[j] == bucket[i]) n++;
+        if (n > largest) largest = n;
+    }
+
+    for (; size <= 4096; size <<= 1) {
+        int fill;
+
+        table = dbMalloc((size + nbuckets) * sizeof(short));
+        seeds = table + size;
+        for (i = 0; i < (int) size; i++)
+            table[i] = -1;
+        for (i = 0; i < (int) nbuckets; i++)
+            seeds[i] = 0;
+
+        for (fill = largest; fill > 0; fill--) {
+            unsigned int b;
+
+            for (b = 0; b < nbuckets; b++) {
+                int n = 0;
+                short seed;
+
+                for (i = 0; i < no_fields; i++)
+                    if (bucket[i] == (short) b) n++;
+                if (n != fill)
+                    continue;
+
+                for (seed = 1; seed < 0x7fff; seed++) {
+                    /* place the names, undo on collision */
+                    for (i = 0; i < no_fields; i++) {
+                        unsigned int h;
+
+                        if (bucket[i] != (short) b)
+                            continue;
+                        h = fieldHashMix(hash[i], seed) & (size - 1);
+                        if (table[h] >= 0)
+                            break;
+                        table[h] = i;
+                    }
+                    if (i == no_fields)
+                        break;
+                    for (j = 0; j < i; j++) {
+                        if (bucket[j] == (short) b)
+                            table[fieldHashMix(hash[j], seed) & (size - 1)] = -1;
+                    }
+                }
+                if (seed == 0x7fff)
+                    goto retry;
+                seeds[b] = seed;
+            }
+        }
+
+        precordType->fldHash = table;
+        precordType->fldHashSeed = seeds;
+        precordType->fldHashMask = size - 1;
+        precordType->fldHashSeedMask = nbuckets - 1;
+        free(bucket);
+        free(hash);
+        return;
+retry:
+        free(table);
+    }
+    /* dbFindFieldPart() falls back to a binary search */
+    precordType->fldHash = NULL;
+    precordType->fldHashSeed = NULL;
+    free(bucket);
+    free(hash);
+}
+
 long dbFindFieldPart(DBENTRY *pdbentry,const char **ppname)
 {
     dbRecordType *precordType = pdbentry->precordType;
@@ -1814,6 +1924,29 @@ long dbFindFieldPart(DBENTRY *pdbentry,const char **ppname)
         return dbGetFieldAddress(pdbentry);
     }
 
+    if (precordType->fldHash) {
+        unsigned int hash = epicsMemHash(pname, nameLen, 0);
+        short seed = precordType->fldHashSeed[fieldHashMix(hash, 0) &
+            precordType->fldHashSeedMask];
+        short ind;
+        dbFldDes *pflddes;
+
+        if (seed == 0)
+            return S_dbLib_fieldNotFound;
+        ind = precordType->fldHash[fieldHashMix(hash, seed) &
+            precordType->fldHashMask];
+        if (ind < 0)
+            return S_dbLib_fieldNotFound;
+        pflddes = precordType->papFldDes[ind];
+        if (strncmp(pflddes->name, pname, nameLen) != 0 ||
+            pflddes->name[nameLen] != '\0')
+            return S_dbLib_fieldNotFound;
+        pdbentry->pflddes = pflddes;
+        pdbentry->indfield = ind;
+        *ppname = &pname[nameLen];
+        return dbGetFieldAddress(pdbentry);
+    }
+
     /* binary search through ordered field names */
     top = precordType->no_fields - 1;
     bottom = 0;
@@ -240,6 +240,7 @@ DBCORE_API void dbDumpVariable(DBBASE *pdbbase);
 DBCORE_API void dbDumpBreaktable(DBBASE *pdbbase,
     const char *name);
 DBCORE_API void dbPvdDump(DBBASE *pdbbase, int verbose);
+DBCORE_API void dbPvdStats(DBBASE *pdbbase);
 DBCORE_API void dbReportDeviceConfig(DBBASE *pdbbase,
     FILE *report);
 
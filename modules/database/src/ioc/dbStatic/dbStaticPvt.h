@@ -102,16 +102,21 @@ typedef struct dbGuiGroup {
     char        *name;
 } dbGuiGroup;
 
+/*In dbStaticLib.c*/
+void dbFieldHashInit(dbRecordType *precordType);
+
 /*The following are in dbPvdLib.c*/
 /*directory*/
 typedef struct{
     ELLNODE         node;
     dbRecordType    *precordType;
     dbRecordNode    *precnode;
+    const char      *name;  /* copy of the record name, kept until freed */
 }PVDENTRY;
 DBCORE_API int dbPvdTableSize(int size);
 extern int dbStaticDebug;
 void dbPvdInitPvt(DBBASE *pdbbase);
+void dbPvdFilterInit(DBBASE *pdbbase);
 PVDENTRY *dbPvdFind(DBBASE *pdbbase,const char *name,size_t lenname);
 PVDENTRY *dbPvdAdd(DBBASE *pdbbase,dbRecordType *precordType,dbRecordNode *precnode);
 void dbPvdDelete(DBBASE *pdbbase,dbRecordNode *precnode);
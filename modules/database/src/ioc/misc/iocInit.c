@@ -129,6 +129,8 @@ static int iocBuild_1(void)
         errlogPrintf("iocBuild: " ERL_ERROR " Aborting, bad database definition (DBD)!\n");
         return -1;
     }
+    /* record names and aliases are known now, build the lookup filter */
+    dbPvdFilterInit(pdbbase);
     epicsSignalInstallSigHupIgnore();
     initHookAnnounce(initHookAtBeginning);
 
@@ -164,6 +166,8 @@ static int iocBuild_2(void)
     iterateRecords(prepareLinks, NULL);
 
     dbLockInitRecords(pdbbase);
+    if (dbProcessProfile)
+        dbProfileEnable(dbProcessProfile);
     initDatabase();
     dbBkptInit();
     initHookAnnounce(initHookAfterInitDatabase); /* used by autosave pass 1 */
@@ -24,6 +24,7 @@
 #include <stdarg.h>
 #include <limits.h>
 
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsStdio.h"
@@ -425,7 +426,12 @@ static int tcp_echo_action ( caHdrLargeArray *mp,
 static int events_on_action ( caHdrLargeArray *mp,
                        void *pPayload, struct client *pClient )
 {
-    db_event_flow_ctrl_mode_off ( pClient->evuser );
+    if ( pClient->poller ) {
+        casPollEventsOff ( pClient, FALSE );
+    }
+    else {
+        db_event_flow_ctrl_mode_off ( pClient->evuser );
+    }
     return RSRV_OK;
 }
 
@@ -435,7 +441,12 @@ static int events_on_action ( caHdrLargeArray *mp,
 static int events_off_action ( caHdrLargeArray *mp,
                        void *pPayload, struct client *pClient )
 {
-    db_event_flow_ctrl_mode_on ( pClient->evuser );
+    if ( pClient->poller ) {
+        casPollEventsOff ( pClient, TRUE );
+    }
+    else {
+        db_event_flow_ctrl_mode_on ( pClient->evuser );
+    }
     return RSRV_OK;
 }
 
@@ -479,6 +490,164 @@ static void no_read_access_event ( struct client *pClient,
     }
 }
 
+/*
+ * Subscription updates of arrays posted with dbEventArraySnapshots set
+ * share the same data, so the network format payload produced for the
+ * first client is kept here and copied by the others.
+ */
+typedef struct rsrv_payload {
+    size_t          snapId;     /* db_field_log_snapshot_id() */
+    ca_uint32_t     reqCount;   /* requested count, 0 for autosize */
+    ca_uint16_t     dataType;
+    ca_uint32_t     count;      /* elements in the payload */
+    ca_uint32_t     size;       /* bytes of payload, 0 until encoded */
+    ca_uint32_t     capacity;   /* bytes of payload following */
+    unsigned        refcount;   /* guarded by payloadCacheLock */
+    epicsMutexId    lock;       /* held by the client encoding it */
+} rsrv_payload;
+
+#define PAYLOAD_CACHE_ENTRIES 16u
+
+static epicsMutexId payloadCacheLock;
+static rsrv_payload *payloadCache[PAYLOAD_CACHE_ENTRIES];
+static size_t payloadCacheBytes;
+static unsigned long payloadCacheHits, payloadCacheMisses;
+
+void initializePayloadCache (void)
+{
+    if ( ! payloadCacheLock ) {
+        payloadCacheLock = epicsMutexMustCreate ();
+    }
+}
+
+static unsigned payload_cache_index ( size_t snapId,
+    const caHdrLargeArray *mp )
+{
+    return (unsigned) ( snapId + mp->m_dataType * 7u + mp->m_count )
+        % PAYLOAD_CACHE_ENTRIES;
+}
+
+/*
+ * The id of the shared snapshot an update refers to, or 0 if
+ * its payload may differ from that of other clients.
+ */
+static size_t payload_cache_key ( struct dbChannel *dbch,
+    const caHdrLargeArray *mp, const db_field_log *pfl )
+{
+    if ( rsrvPayloadCacheBytes <= 0 || ! payloadCacheLock ||
+            mp->m_dataType >= DBR_GR_STRING ||
+            ellCount ( &dbch->pre_chain ) || ellCount ( &dbch->post_chain ) ) {
+        return 0u;
+    }
+    return db_field_log_snapshot_id ( pfl );
+}
+
+/* !! payloadCacheLock must be held by caller !! */
+static void payload_cache_unref ( rsrv_payload *pEnc )
+{
+    if ( --pEnc->refcount == 0u ) {
+        epicsMutexDestroy ( pEnc->lock );
+        free ( pEnc );
+    }
+}
+
+/*
+ * payload_cache_acquire ()
+ *
+ * Find the payload of an update, or add an entry for it which the
+ * caller (*pOwner set) is to fill in.  Returns with the entry locked,
+ * so that other clients wait until its payload has been encoded.
+ * Entries are released with payload_cache_release().
+ */
+static rsrv_payload * payload_cache_acquire ( size_t snapId,
+    const caHdrLargeArray *mp, ca_uint32_t capacity, int *pOwner )
+{
+    unsigned i = payload_cache_index ( snapId, mp ), j;
+    rsrv_payload *pEnc;
+
+    epicsMutexMustLock ( payloadCacheLock );
+    pEnc = payloadCache[i];
+    if ( pEnc && pEnc->snapId == snapId &&
+            pEnc->dataType == mp->m_dataType &&
+            pEnc->reqCount == mp->m_count ) {
+        pEnc->refcount++;
+        payloadCacheHits++;
+        epicsMutexUnlock ( payloadCacheLock );
+        epicsMutexMustLock ( pEnc->lock );
+        *pOwner = FALSE;
+        return pEnc;
+    }
+    payloadCacheMisses++;
+
+    pEnc = NULL;
+    if ( capacity <= (unsigned) rsrvPayloadCacheBytes ) {
+        pEnc = malloc ( sizeof ( *pEnc ) + capacity );
+    }
+    if ( pEnc ) {
+        pEnc->lock = epicsMutexCreate ();
+        if ( ! pEnc->lock ) {
+            free ( pEnc );
+            pEnc = NULL;
+        }
+    }
+    if ( ! pEnc ) {
+        epicsMutexUnlock ( payloadCacheLock );
+        return NULL;
+    }
+    pEnc->snapId = snapId;
+    pEnc->reqCount = mp->m_count;
+    pEnc->dataType = mp->m_dataType;
+    pEnc->count = 0u;
+    pEnc->size = 0u;
+    pEnc->capacity = capacity;
+    pEnc->refcount = 2u; /* the cache's and the caller's */
+    epicsMutexMustLock ( pEnc->lock );
+
+    /* replace the entry in this slot, evicting others until it fits */
+    for ( j = i; payloadCache[i] ||
+            payloadCacheBytes + capacity > (unsigned) rsrvPayloadCacheBytes;
+            j = ( j + 1u ) % PAYLOAD_CACHE_ENTRIES ) {
+        if ( payloadCache[j] ) {
+            payloadCacheBytes -= payloadCache[j]->capacity;
+            payload_cache_unref ( payloadCache[j] );
+            payloadCache[j] = NULL;
+        }
+    }
+    payloadCache[i] = pEnc;
+    payloadCacheBytes += capacity;
+    epicsMutexUnlock ( payloadCacheLock );
+
+    *pOwner = TRUE;
+    return pEnc;
+}
+
+static void payload_cache_release ( rsrv_payload *pEnc )
+{
+    epicsMutexUnlock ( pEnc->lock );
+    epicsMutexMustLock ( payloadCacheLock );
+    payload_cache_unref ( pEnc );
+    epicsMutexUnlock ( payloadCacheLock );
+}
+
+void rsrvPayloadCacheReport (void)
+{
+    unsigned i, n = 0u;
+
+    if ( ! payloadCacheLock ) {
+        return;
+    }
+    epicsMutexMustLock ( payloadCacheLock );
+    for ( i = 0u; i < PAYLOAD_CACHE_ENTRIES; i++ ) {
+        if ( payloadCache[i] ) {
+            n++;
+        }
+    }
+    printf ( "Encoded payload cache: %u entries, %lu bytes, "
+        "%lu hits, %lu misses\n", n, (unsigned long) payloadCacheBytes,
+        payloadCacheHits, payloadCacheMisses );
+    epicsMutexUnlock ( payloadCacheLock );
+}
+
 /*
  *  read_reply()
  */
@@ -496,6 +665,9 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
     int local_fl = 0;
     long item_count;
     ca_uint32_t payload_size;
+    size_t snapId;
+    rsrv_payload *pEnc = NULL;
+    int encOwner = FALSE;
     dbAddr *paddr=&dbch->addr;
 
     SEND_LOCK ( pClient );
@@ -545,6 +717,24 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
         }
     }
 
+    snapId = local_fl ? 0u : payload_cache_key ( dbch, &pevext->msg, pfl );
+    if ( snapId ) {
+        pEnc = payload_cache_acquire ( snapId, &pevext->msg,
+            payload_size, &encOwner );
+        if ( pEnc && pEnc->size ) {
+            memcpy ( pPayload, pEnc + 1, pEnc->size );
+            if ( autosize )
+                cas_set_header_count ( pClient, pEnc->count );
+            cas_commit_msg ( pClient, pEnc->size );
+            payload_cache_release ( pEnc );
+            if ( ! eventsRemaining )
+                cas_send_bs_msg ( pClient, FALSE );
+            SEND_UNLOCK ( pClient );
+            return;
+        }
+        /* otherwise encode it here, as the first or after a failure */
+    }
+
     status = dbChannel_get_count ( dbch, pevext->msg.m_dataType,
                   pPayload, &item_count, pfl);
 
@@ -582,6 +772,11 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
             else if (payload_size > data_size)
                 memset(
                     (char *) pPayload + data_size, 0, payload_size - data_size);
+            if ( encOwner ) {
+                memcpy ( pEnc + 1, pPayload, payload_size );
+                pEnc->count = item_count;
+                pEnc->size = payload_size;
+            }
         }
         else {
             if (autosize) {
@@ -594,6 +789,9 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
         cas_commit_msg ( pClient, payload_size );
     }
 
+    if ( pEnc )
+        payload_cache_release ( pEnc );
+
     /*
      * Ensures timely response for events, but does queue
      * them up like db requests when the OPI does not keep up.
@@ -1452,7 +1650,12 @@ static void write_notify_reply ( struct client * pClient )
     /*
      * wakeup the TCP thread if it is waiting for a cb to complete
      */
-    epicsEventSignal ( pClient->blockSem );
+    if ( pClient->poller ) {
+        casPollResume ( pClient );
+    }
+    else {
+        epicsEventSignal ( pClient->blockSem );
+    }
 }
 
 /*
@@ -1690,8 +1893,22 @@ static int write_notify_action ( caHdrLargeArray *mp, void *pPayload,
          */
         epicsMutexMustLock(client->putNotifyLock);
         while(pciu->pPutNotify->busy){
+            if ( client->poller && casPollPark ( client ) ) {
+                /*
+                 * an I/O thread must not block, it comes back to this
+                 * request when a put callback completes
+                 */
+                epicsMutexUnlock(client->putNotifyLock);
+                return RSRV_PARKED;
+            }
             epicsMutexUnlock(client->putNotifyLock);
-            status = epicsEventWaitWithTimeout(client->blockSem,60.0);
+            if ( client->poller ) {
+                /* parked for the whole timeout already */
+                status = epicsEventWaitTimeout;
+            }
+            else {
+                status = epicsEventWaitWithTimeout(client->blockSem,60.0);
+            }
             if ( status != epicsEventWaitOK ) {
                 char busyTmp;
                 void * asWritePvtTmp = 0;
@@ -1730,6 +1947,8 @@ static int write_notify_action ( caHdrLargeArray *mp, void *pPayload,
             epicsMutexMustLock(client->putNotifyLock);
         }
         epicsMutexUnlock(client->putNotifyLock);
+        /* the next request to wait has its own timeout */
+        client->parkWaiting = FALSE;
     }
     else {
         pciu->pPutNotify = rsrvAllocPutNotify ( pciu );
@@ -2174,8 +2393,11 @@ static int search_reply_udp ( caHdrLargeArray *mp, void *pPayload, struct client
     size_t          spaceNeeded;
     size_t          reasonableMonitorSpace = 10;
 
+    epicsAtomicIncrSizeT ( &rsrvSearchesReceived );
+
     if (!CA_VSUPPORTED(mp->m_count)) {
         DLOG ( 2, ( "CAS: Ignore search from unsupported client %u\n", mp->m_count ) );
+        epicsAtomicIncrSizeT ( &rsrvSearchesDropped );
         return RSRV_ERROR;
     }
 
@@ -2203,6 +2425,7 @@ static int search_reply_udp ( caHdrLargeArray *mp, void *pPayload, struct client
     spaceNeeded = sizeof (struct channel_in_use) +
         reasonableMonitorSpace * sizeof (struct event_ext);
     if ( ! ( osiSufficentSpaceInPool(spaceNeeded) || spaceAvailOnFreeList ) ) {
+        epicsAtomicIncrSizeT ( &rsrvSearchesDropped );
         return RSRV_ERROR;
     }
 
@@ -2223,6 +2446,7 @@ static int search_reply_udp ( caHdrLargeArray *mp, void *pPayload, struct client
     }
     else {
         /* shouldn't actually get here due to VSUPPORTED test */
+        epicsAtomicIncrSizeT ( &rsrvSearchesDropped );
         return RSRV_ERROR;
     }
 
@@ -2233,6 +2457,7 @@ static int search_reply_udp ( caHdrLargeArray *mp, void *pPayload, struct client
         ( void * ) &pMinorVersion );
     if ( status != ECA_NORMAL ) {
         SEND_UNLOCK ( client );
+        epicsAtomicIncrSizeT ( &rsrvSearchesDropped );
         return RSRV_ERROR;
     }
 
@@ -2244,8 +2469,11 @@ static int search_reply_udp ( caHdrLargeArray *mp, void *pPayload, struct client
     *pMinorVersion = htons ( CA_MINOR_PROTOCOL_REVISION );
 
     cas_commit_msg ( client, sizeof ( *pMinorVersion ) );
+    client->nSearchReplies++;
     SEND_UNLOCK ( client );
 
+    epicsAtomicIncrSizeT ( &rsrvSearchesMatched );
+
     return RSRV_OK;
 }
 
@@ -2544,6 +2772,11 @@ int camessage ( struct client *client )
         else {
             if ( msg.m_cmmd < NELEMENTS(tcpJumpTable) ) {
                 status = ( *tcpJumpTable[msg.m_cmmd] ) ( &msg, pBody, client );
+                if ( status == RSRV_PARKED ) {
+                    /* keep this request in the buffer */
+                    status = RSRV_OK;
+                    break;
+                }
                 if ( status != RSRV_OK ) {
                     status = RSRV_ERROR;
                     break;
@@ -20,7 +20,10 @@
 #include <string.h>
 #include <errno.h>
 
+#include "cantProceed.h"
 #include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsSignal.h"
 #include "epicsStdio.h"
 #include "epicsTime.h"
 #include "errlog.h"
@@ -30,9 +33,159 @@
 #include "caerr.h"
 
 #include "db_access.h"
+#include "dbEvent.h"
 #include "rsrv.h"
 #include "server.h"
 
+#ifdef RSRV_EPOLL
+#  include <unistd.h>
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#endif
+
+/*
+ *  camsgprocess()
+ *
+ *  process the requests in the receive buffer,
+ *  returns RSRV_ERROR when the client must be disconnected
+ */
+static int camsgprocess ( struct client *client )
+{
+    int status;
+
+    client->recv.stk = 0;
+    status = camessage ( client );
+    if (status == 0) {
+        /*
+         * if there is a partial message
+         * align it with the start of the buffer
+         */
+        if (client->recv.cnt > client->recv.stk) {
+            unsigned bytes_left;
+
+            bytes_left = client->recv.cnt - client->recv.stk;
+
+            /*
+             * overlapping regions handled
+             * properly by memmove
+             */
+            memmove (client->recv.buf,
+                &client->recv.buf[client->recv.stk], bytes_left);
+            client->recv.cnt = bytes_left;
+        }
+        else {
+            client->recv.cnt = 0ul;
+        }
+    }
+    else {
+        char buf[64];
+
+        /* flush any queued messages before shutdown */
+        cas_send_bs_msg(client, 1);
+
+        client->recv.cnt = 0ul;
+
+        /*
+         * disconnect when there are severe message errors
+         */
+        ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+        epicsPrintf ("CAS: forcing disconnect from %s\n", buf);
+        return RSRV_ERROR;
+    }
+    return RSRV_OK;
+}
+
+/*
+ *  camsgrecv()
+ *
+ *  receive and process whatever the client has sent,
+ *  returns RSRV_ERROR when the client must be disconnected
+ */
+static int camsgrecv ( struct client *client, int nonBlocking )
+{
+    long nchars;
+
+    assert ( client->recv.maxstk >= client->recv.cnt );
+    nchars = recv ( client->sock, &client->recv.buf[client->recv.cnt],
+            (int) ( client->recv.maxstk - client->recv.cnt ), 0 );
+    if ( nchars == 0 ){
+        if ( CASDEBUG > 0 ) {
+            /* convert to u long so that %lu works on both 32 and 64 bit archs */
+            unsigned long cnt = sizeof ( client->recv.buf ) - client->recv.cnt;
+            errlogPrintf ( "CAS: nill message disconnect ( %lu bytes request )\n",
+                cnt );
+        }
+        return RSRV_ERROR;
+    }
+    else if ( nchars < 0 ) {
+        int anerrno = SOCKERRNO;
+
+        if ( anerrno == SOCK_EINTR ) {
+            return RSRV_OK;
+        }
+
+        if ( nonBlocking && anerrno == SOCK_EWOULDBLOCK ) {
+            return RSRV_OK;
+        }
+
+        if ( anerrno == SOCK_ENOBUFS ) {
+            if ( nonBlocking ) {
+                /* level triggered, so the I/O thread will try again */
+                return RSRV_OK;
+            }
+            errlogPrintf (
+                "CAS: Out of network buffers, retring receive in 15 seconds\n" );
+            epicsThreadSleep ( 15.0 );
+            return RSRV_OK;
+        }
+
+        /*
+         * normal conn lost conditions
+         */
+        if (    ( anerrno != SOCK_ECONNABORTED &&
+            anerrno != SOCK_ECONNRESET &&
+            anerrno != SOCK_ETIMEDOUT ) ||
+            CASDEBUG > 2 ) {
+            char sockErrBuf[64];
+
+            epicsSocketConvertErrorToString(
+                sockErrBuf, sizeof ( sockErrBuf ), anerrno);
+            errlogPrintf ( "CAS: Client disconnected - %s\n",
+                sockErrBuf );
+        }
+        return RSRV_ERROR;
+    }
+
+    epicsTimeGetCurrent ( &client->time_at_last_recv );
+    client->recv.cnt += ( unsigned ) nchars;
+
+    return camsgprocess ( client );
+}
+
+/*
+ * flush the send buffer unless more requests are already waiting,
+ * which allows responses to batch up
+ */
+static void camsgflush ( struct client *client )
+{
+    osiSockIoctl_t check_nchars;
+    int status;
+
+    status = socket_ioctl (client->sock, FIONREAD, &check_nchars);
+    if (status < 0) {
+        char sockErrBuf[64];
+
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf("CAS: FIONREAD " ERL_ERROR ": %s\n",
+            sockErrBuf);
+        cas_send_bs_msg(client, TRUE);
+    }
+    else if (check_nchars == 0){
+        cas_send_bs_msg(client, TRUE);
+    }
+}
+
 /*
  *  camsgtask()
  *
@@ -45,121 +198,802 @@ void camsgtask ( void *pParm )
     casAttachThreadToClient ( client );
 
     while (castcp_ctl == ctlRun && !client->disconnect) {
-        osiSockIoctl_t check_nchars;
-        long nchars;
-        int status;
+        camsgflush ( client );
 
-        /*
-         * allow message to batch up if more are coming
-         */
-        status = socket_ioctl (client->sock, FIONREAD, &check_nchars);
-        if (status < 0) {
-            char sockErrBuf[64];
+        if ( camsgrecv ( client, FALSE ) != RSRV_OK ) {
+            break;
+        }
+    }
+
+    LOCK_CLIENTQ;
+    ellDelete ( &clientQ, &client->node );
+    UNLOCK_CLIENTQ;
+
+    destroy_tcp_client ( client );
+}
+
+#ifdef RSRV_EPOLL
+
+/*
+ * Event driven service of TCP clients.
+ *
+ * While rsrvIoThreads is set, new clients are served by a pool of I/O
+ * threads, each with its own epoll set, which receive and process the
+ * requests of all their clients.  The pool is sized on first use.
+ * Sockets are non-blocking, and responses which the socket can't take
+ * right away are copied to the client's send queue, which the I/O thread
+ * flushes when the socket becomes writable.  Their subscriptions are
+ * served by an event pool of as many "CAS-event" threads, rather than by
+ * an event task for each client.  While a client's queue is over
+ * RSRV_SENDQ_MAX reading from it stops, and its events are held with
+ * the flow control of EVENTS_OFF, so that no thread waits for one client.
+ *
+ * A put callback request for a channel with one still in progress is
+ * parked rather than waited for: the request stays in the receive buffer
+ * and reading from the client stops until a put callback completes, or
+ * RSRV_PARK_TIMEOUT passes.  Closed clients are destroyed by the
+ * CAS-reaper thread, as that waits for the client's events.
+ *
+ * casPollStop() joins these threads when the IOC is shut down, after
+ * closing the clients they serve.
+ */
+
+#define RSRV_SENDQ_MAX ( 4u * MAX_TCP )
+#define RSRV_POLL_EVENTS 64
+#define RSRV_PARK_TIMEOUT 60.0 /* sec */
+
+typedef struct rsrv_poller {
+    int epfd;
+    int wakefd;             /* eventfd, for resuming parked clients */
+    epicsThreadId tid;
+    unsigned nclients;
+    epicsMutexId lock;
+    ELLLIST parkedQ;        /* client::parkNode */
+} rsrv_poller;
+
+typedef struct rsrv_send_chunk {
+    ELLNODE node;
+    size_t size;
+    size_t sent;
+    /* data follows */
+} rsrv_send_chunk;
+
+static rsrv_poller *pollers;
+static int nPollers;
+static int nextPoller;
+static epicsThreadOnceId pollOnce = EPICS_THREAD_ONCE_INIT;
+static dbEventPool eventPool;
+/* no more clients, set under LOCK_CLIENTQ */
+static volatile int pollExit;
+
+/* closed clients waiting for destroy_tcp_client(), client::node */
+static ELLLIST reapQ;
+static epicsMutexId reapLock;
+static epicsEventId reapSignal;
+static epicsThreadId reapTid;
+static int reapExit;
 
-            epicsSocketConvertErrnoToString (
-                sockErrBuf, sizeof ( sockErrBuf ) );
-            errlogPrintf("CAS: FIONREAD " ERL_ERROR ": %s\n",
-                sockErrBuf);
-            cas_send_bs_msg(client, TRUE);
-        }
-        else if (check_nchars == 0){
-            cas_send_bs_msg(client, TRUE);
-        }
-
-        client->recv.stk = 0;
-        assert ( client->recv.maxstk >= client->recv.cnt );
-        nchars = recv ( client->sock, &client->recv.buf[client->recv.cnt],
-                (int) ( client->recv.maxstk - client->recv.cnt ), 0 );
-        if ( nchars == 0 ){
-            if ( CASDEBUG > 0 ) {
-                /* convert to u long so that %lu works on both 32 and 64 bit archs */
-                unsigned long cnt = sizeof ( client->recv.buf ) - client->recv.cnt;
-                errlogPrintf ( "CAS: nill message disconnect ( %lu bytes request )\n",
-                    cnt );
+/*
+ * hold or release the events of a client whose send queue is full,
+ * or which asked for none, caller holds sendQLock
+ */
+static void pollEventFlow ( struct client *client )
+{
+    int hold = client->eventsOff ||
+        ( client->sendQBytes > RSRV_SENDQ_MAX && ! client->disconnect );
+
+    if ( hold != client->eventsHeld ) {
+        client->eventsHeld = hold;
+        if ( hold ) {
+            db_event_flow_ctrl_mode_on ( client->evuser );
+        }
+        else {
+            db_event_flow_ctrl_mode_off ( client->evuser );
+        }
+    }
+}
+
+/* caller holds sendQLock */
+static void pollUpdateEvents ( struct client *client )
+{
+    unsigned events = EPOLLIN;
+
+    if ( ! client->disconnect ) {
+        if ( client->parked ) {
+            /* only to see the client going away */
+            events = EPOLLRDHUP;
+        }
+        else if ( client->sendQBytes > RSRV_SENDQ_MAX ) {
+            events = 0u;
+        }
+        if ( ellCount ( &client->sendQ ) ) {
+            events |= EPOLLOUT;
+        }
+    }
+
+    if ( events != client->pollEvents ) {
+        struct epoll_event ev;
+
+        ev.events = events;
+        ev.data.ptr = client;
+        if ( epoll_ctl ( client->poller->epfd, EPOLL_CTL_MOD,
+                client->sock, &ev ) == 0 ) {
+            client->pollEvents = events;
+        }
+    }
+}
+
+static void pollDiscardSendQ ( struct client *client )
+{
+    ELLNODE *pNode;
+
+    while ( ( pNode = ellGet ( &client->sendQ ) ) ) {
+        free ( pNode );
+    }
+    client->sendQBytes = 0u;
+}
+
+/*
+ * send as much of the queue as the socket will take,
+ * caller holds sendQLock
+ */
+static void pollFlushSendQ ( struct client *client )
+{
+    rsrv_send_chunk *pChunk;
+
+    while ( ( pChunk = (rsrv_send_chunk *) ellFirst ( &client->sendQ ) ) &&
+            ! client->disconnect ) {
+        char *pData = (char *) ( pChunk + 1 );
+        int status = send ( client->sock, &pData[pChunk->sent],
+            pChunk->size - pChunk->sent, 0 );
+
+        if ( status >= 0 ) {
+            pChunk->sent += (unsigned) status;
+            client->sendQBytes -= (unsigned) status;
+            if ( pChunk->sent >= pChunk->size ) {
+                ellDelete ( &client->sendQ, &pChunk->node );
+                free ( pChunk );
             }
-            break;
         }
-        else if ( nchars < 0 ) {
+        else {
             int anerrno = SOCKERRNO;
 
             if ( anerrno == SOCK_EINTR ) {
                 continue;
             }
-
-            if ( anerrno == SOCK_ENOBUFS ) {
-                errlogPrintf (
-                    "CAS: Out of network buffers, retring receive in 15 seconds\n" );
-                epicsThreadSleep ( 15.0 );
-                continue;
+            if ( anerrno == SOCK_EWOULDBLOCK || anerrno == SOCK_ENOBUFS ) {
+                break;
             }
-
-            /*
-             * normal conn lost conditions
-             */
-            if (    ( anerrno != SOCK_ECONNABORTED &&
-                anerrno != SOCK_ECONNRESET &&
-                anerrno != SOCK_ETIMEDOUT ) ||
-                CASDEBUG > 2 ) {
+            if ( anerrno != SOCK_ECONNABORTED &&
+                 anerrno != SOCK_ECONNRESET &&
+                 anerrno != SOCK_EPIPE &&
+                 anerrno != SOCK_ETIMEDOUT ) {
+                char buf[64];
                 char sockErrBuf[64];
 
-                epicsSocketConvertErrorToString(
-                    sockErrBuf, sizeof ( sockErrBuf ), anerrno);
-                errlogPrintf ( "CAS: Client disconnected - %s\n",
-                    sockErrBuf );
+                ipAddrToDottedIP ( &client->addr, buf, sizeof(buf) );
+                epicsSocketConvertErrorToString (
+                    sockErrBuf, sizeof ( sockErrBuf ), anerrno );
+                errlogPrintf ( "CAS: TCP send to %s failed: %s\n",
+                    buf, sockErrBuf);
             }
-            break;
+            client->disconnect = TRUE;
+            /* the I/O thread sees the hangup and cleans up */
+            shutdown ( client->sock, SHUT_RDWR );
         }
+    }
+
+    if ( client->disconnect ) {
+        pollDiscardSendQ ( client );
+    }
+    else if ( ! ellCount ( &client->sendQ ) ) {
+        epicsTimeGetCurrent ( &client->time_at_last_send );
+    }
+}
 
-        epicsTimeGetCurrent ( &client->time_at_last_recv );
-        client->recv.cnt += ( unsigned ) nchars;
+/*
+ *  casPollSend()
+ *
+ *  cas_send_bs_msg() for a client served by an I/O thread,
+ *  caller holds SEND_LOCK()
+ */
+void casPollSend ( struct client *client )
+{
+    epicsMutexMustLock ( client->sendQLock );
 
-        status = camessage ( client );
-        if (status == 0) {
-            /*
-             * if there is a partial message
-             * align it with the start of the buffer
-             */
-            if (client->recv.cnt > client->recv.stk) {
-                unsigned bytes_left;
-
-                bytes_left = client->recv.cnt - client->recv.stk;
-
-                /*
-                 * overlapping regions handled
-                 * properly by memmove
-                 */
-                memmove (client->recv.buf,
-                    &client->recv.buf[client->recv.stk], bytes_left);
-                client->recv.cnt = bytes_left;
+    if ( cas_send_pending ( client ) ) {
+        pollFlushSendQ ( client );
+        if ( ! client->disconnect ) {
+            size_t pending = cas_send_pending ( client );
+            size_t sent = 0u;
+
+            if ( ! ellCount ( &client->sendQ ) ) {
+                int status = cas_send_some ( client, 0u );
+                if ( status >= 0 ) {
+                    sent = (unsigned) status;
+                    if ( sent >= pending ) {
+                        epicsTimeGetCurrent ( &client->time_at_last_send );
+                    }
+                }
+                /* errors are reported when the queue is flushed */
             }
-            else {
-                client->recv.cnt = 0ul;
+
+            if ( sent < pending ) {
+                size_t size = pending - sent;
+                rsrv_send_chunk *pChunk = malloc ( sizeof ( *pChunk ) + size );
+
+                if ( pChunk ) {
+                    pChunk->size = size;
+                    pChunk->sent = 0u;
+                    cas_send_copy_out ( client, sent, (char *) ( pChunk + 1 ) );
+                    ellAdd ( &client->sendQ, &pChunk->node );
+                    client->sendQBytes += size;
+                    pollFlushSendQ ( client );
+                }
+                else {
+                    errlogPrintf ( "CAS: no memory to queue %lu response bytes\n",
+                        (unsigned long) size );
+                    client->disconnect = TRUE;
+                    shutdown ( client->sock, SHUT_RDWR );
+                    pollDiscardSendQ ( client );
+                }
             }
         }
+        cas_send_discard ( client );
+    }
+
+    /* hold the events until the I/O thread has sent the queue */
+    pollEventFlow ( client );
+    pollUpdateEvents ( client );
+
+    epicsMutexUnlock ( client->sendQLock );
+}
+
+static void pollWritable ( struct client *client )
+{
+    /* no SEND_LOCK(), an event thread may hold it while it sends */
+    epicsMutexMustLock ( client->sendQLock );
+    pollFlushSendQ ( client );
+    pollEventFlow ( client );
+    pollUpdateEvents ( client );
+    epicsMutexUnlock ( client->sendQLock );
+}
+
+static void pollRearm ( struct client *client )
+{
+    epicsMutexMustLock ( client->sendQLock );
+    pollUpdateEvents ( client );
+    epicsMutexUnlock ( client->sendQLock );
+}
+
+static void pollClose ( struct client *client )
+{
+    rsrv_poller *poller = client->poller;
+
+    epoll_ctl ( poller->epfd, EPOLL_CTL_DEL, client->sock, NULL );
+
+    /* after this casPollResume() leaves the client alone */
+    epicsMutexMustLock ( poller->lock );
+    if ( client->parked ) {
+        ellDelete ( &poller->parkedQ, &client->parkNode );
+        epicsMutexMustLock ( client->sendQLock );
+        client->parked = FALSE;
+        epicsMutexUnlock ( client->sendQLock );
+    }
+    epicsMutexUnlock ( poller->lock );
+
+    client->disconnect = TRUE;
+    shutdown ( client->sock, SHUT_RDWR );
+
+    LOCK_CLIENTQ;
+    ellDelete ( &clientQ, &client->node );
+    poller->nclients--;
+    UNLOCK_CLIENTQ;
+
+    epicsMutexMustLock ( reapLock );
+    ellAdd ( &reapQ, &client->node );
+    epicsMutexUnlock ( reapLock );
+    epicsEventSignal ( reapSignal );
+}
+
+/*
+ * process what a client has sent, or with recvSocket FALSE
+ * the requests which are left in the receive buffer
+ */
+static void pollService ( struct client *client, int recvSocket )
+{
+    int status;
+
+    epicsThreadPrivateSet ( rsrvCurrentClient, client );
+    if ( recvSocket ) {
+        status = camsgrecv ( client, TRUE );
+    }
+    else {
+        status = camsgprocess ( client );
+    }
+    if ( status == RSRV_OK ) {
+        if ( client->parked ) {
+            /* send the responses so far, there is no telling when
+             * this client's next requests are processed */
+            cas_send_bs_msg ( client, TRUE );
+        }
         else {
-            char buf[64];
+            camsgflush ( client );
+        }
+    }
+    epicsThreadPrivateSet ( rsrvCurrentClient, NULL );
+
+    if ( status != RSRV_OK ) {
+        pollClose ( client );
+    }
+    else {
+        pollRearm ( client );
+    }
+}
 
-            /* flush any queued messages before shutdown */
-            cas_send_bs_msg(client, 1);
+/*
+ * resume parked clients whose put callback completed or which waited
+ * too long, returns the epoll_wait() timeout for the rest in ms
+ */
+static int pollResumeParked ( rsrv_poller *poller )
+{
+    ELLLIST resume = ELLLIST_INIT;
+    ELLNODE *pNode, *pNext;
+    epicsTimeStamp now;
+    double wait = -1.0;
 
-            client->recv.cnt = 0ul;
+    epicsTimeGetCurrent ( &now );
 
-            /*
-             * disconnect when there are severe message errors
-             */
-            ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-            epicsPrintf ("CAS: forcing disconnect from %s\n", buf);
+    epicsMutexMustLock ( poller->lock );
+    for ( pNode = ellFirst ( &poller->parkedQ ); pNode; pNode = pNext ) {
+        struct client *client = CONTAINER ( pNode, struct client, parkNode );
+        double left = RSRV_PARK_TIMEOUT -
+            epicsTimeDiffInSeconds ( &now, &client->parkTime );
+
+        pNext = ellNext ( pNode );
+        if ( left <= 0.0 && ! client->parkResume ) {
+            client->parkTimedOut = TRUE;
+        }
+        if ( client->parkResume || client->parkTimedOut ) {
+            ellDelete ( &poller->parkedQ, pNode );
+            ellAdd ( &resume, pNode );
+            client->parkResume = FALSE;
+            epicsMutexMustLock ( client->sendQLock );
+            client->parked = FALSE;
+            epicsMutexUnlock ( client->sendQLock );
+        }
+        else if ( wait < 0.0 || left < wait ) {
+            wait = left;
+        }
+    }
+    epicsMutexUnlock ( poller->lock );
+
+    while ( ( pNode = ellGet ( &resume ) ) ) {
+        pollService ( CONTAINER ( pNode, struct client, parkNode ), FALSE );
+    }
+
+    return wait < 0.0 ? -1 : (int) ( wait * 1000.0 ) + 1;
+}
+
+static void pollTask ( void *pParm )
+{
+    rsrv_poller *poller = (rsrv_poller *) pParm;
+    struct epoll_event events[RSRV_POLL_EVENTS];
+    int timeout = -1;
+
+    epicsSignalInstallSigPipeIgnore ();
+    taskwdInsert ( epicsThreadGetIdSelf (), NULL, NULL );
+
+    while ( ! pollExit ) {
+        int i, n;
+
+        n = epoll_wait ( poller->epfd, events, NELEMENTS ( events ), timeout );
+        if ( n < 0 ) {
+            if ( errno != EINTR ) {
+                errlogPrintf ( "CAS: epoll_wait " ERL_ERROR ": %s\n",
+                    strerror ( errno ) );
+                epicsThreadSleep ( 1.0 );
+            }
+            continue;
+        }
+
+        for ( i = 0; i < n; i++ ) {
+            struct client *client = (struct client *) events[i].data.ptr;
+
+            if ( ! client ) {
+                /* the wakefd, casPollResume() or casPollStop() was called */
+                epicsUInt64 count;
+                if ( read ( poller->wakefd, &count, sizeof ( count ) ) < 0 ) {
+                    /* nothing to read, another thread got there first */
+                }
+                continue;
+            }
+
+            if ( events[i].events & EPOLLOUT ) {
+                pollWritable ( client );
+            }
+
+            if ( pollExit ) {
+                /* casPollStop() closes the clients */
                 break;
+            }
+            if ( castcp_ctl != ctlRun || client->disconnect ) {
+                pollClose ( client );
+            }
+            else if ( client->parked ) {
+                if ( events[i].events & ( EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) {
+                    pollClose ( client );
+                }
+            }
+            else if ( events[i].events & ( EPOLLIN | EPOLLHUP | EPOLLERR ) ) {
+                pollService ( client, TRUE );
+            }
+        }
+
+        timeout = pollResumeParked ( poller );
+    }
+
+    taskwdRemove ( 0 );
+}
+
+/*
+ * destroy closed clients, which waits for their event tasks
+ */
+static void reapTask ( void *pParm )
+{
+    int exit = FALSE;
+
+    taskwdInsert ( epicsThreadGetIdSelf (), NULL, NULL );
+
+    while ( ! exit ) {
+        ELLNODE *pNode;
+
+        epicsEventMustWait ( reapSignal );
+
+        epicsMutexMustLock ( reapLock );
+        while ( ( pNode = ellGet ( &reapQ ) ) ) {
+            epicsMutexUnlock ( reapLock );
+            destroy_tcp_client ( CONTAINER ( pNode, struct client, node ) );
+            epicsMutexMustLock ( reapLock );
+        }
+        exit = reapExit;
+        epicsMutexUnlock ( reapLock );
+    }
+
+    taskwdRemove ( 0 );
+}
+
+/*
+ *  casPollInit()
+ *
+ *  start the I/O threads, their number is fixed on first use
+ */
+static void casPollInit ( void *arg )
+{
+    int i, n = rsrvIoThreads;
+    unsigned priorityOfEvents;
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+
+    opts.priority = epicsThreadPriorityCAServerLow;
+    opts.joinable = 1;
+
+    pollers = callocMustSucceed ( n, sizeof ( *pollers ), "casPollInit" );
+
+    /* the priority of a client's own event task */
+    if ( epicsThreadHighestPriorityLevelBelow ( epicsThreadPriorityCAServerLow,
+            &priorityOfEvents ) != epicsThreadBooleanStatusSuccess ) {
+        priorityOfEvents = epicsThreadPriorityCAServerLow;
+    }
+    eventPool = db_event_pool_create ( "CAS-event", n, priorityOfEvents );
+    if ( ! eventPool ) {
+        errlogPrintf ( "CAS: CAS-event thread creation failed\n" );
+        return;
+    }
+
+    reapLock = epicsMutexMustCreate ();
+    reapSignal = epicsEventMustCreate ( epicsEventEmpty );
+    opts.stackSize = epicsThreadGetStackSize ( epicsThreadStackMedium );
+    reapTid = epicsThreadCreateOpt ( "CAS-reaper", reapTask, NULL, &opts );
+    if ( ! reapTid ) {
+        errlogPrintf ( "CAS: CAS-reaper thread creation failed\n" );
+        return;
+    }
+
+    for ( i = 0; i < n; i++ ) {
+        rsrv_poller *poller = &pollers[nPollers];
+        struct epoll_event ev;
+        char name[16];
+
+        poller->epfd = epoll_create1 ( EPOLL_CLOEXEC );
+        if ( poller->epfd < 0 ) {
+            errlogPrintf ( "CAS: epoll_create1 " ERL_ERROR ": %s\n",
+                strerror ( errno ) );
+            break;
+        }
+        poller->wakefd = eventfd ( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        if ( poller->wakefd < 0 ||
+                epoll_ctl ( poller->epfd, EPOLL_CTL_ADD,
+                    poller->wakefd, &ev ) < 0 ) {
+            errlogPrintf ( "CAS: eventfd " ERL_ERROR ": %s\n",
+                strerror ( errno ) );
+            if ( poller->wakefd >= 0 ) {
+                close ( poller->wakefd );
+            }
+            close ( poller->epfd );
+            break;
+        }
+        poller->lock = epicsMutexMustCreate ();
+        ellInit ( &poller->parkedQ );
+
+        epicsSnprintf ( name, sizeof ( name ), "CAS-io%d", i );
+        opts.stackSize = epicsThreadGetStackSize ( epicsThreadStackBig );
+        poller->tid = epicsThreadCreateOpt ( name, pollTask, poller, &opts );
+        if ( ! poller->tid ) {
+            errlogPrintf ( "CAS: %s thread creation failed\n", name );
+            epicsMutexDestroy ( poller->lock );
+            close ( poller->wakefd );
+            close ( poller->epfd );
+            break;
+        }
+        nPollers++;
+    }
+
+    if ( nPollers == 0 ) {
+        errlogPrintf ( "CAS: no I/O threads, serving each client "
+            "with its own thread\n" );
+    }
+}
+
+/*
+ *  casPollAttach()
+ *
+ *  hand a new TCP client to one of the I/O threads,
+ *  returns RSRV_ERROR if it needs a thread of its own
+ */
+int casPollAttach ( struct client *client )
+{
+    rsrv_poller *poller;
+    osiSockIoctl_t yes = TRUE;
+    struct epoll_event ev;
+    int n;
+
+    if ( rsrvIoThreads <= 0 || pollExit ) {
+        return RSRV_ERROR;
+    }
+
+    epicsThreadOnce ( &pollOnce, casPollInit, NULL );
+    n = nPollers;
+    if ( n == 0 ) {
+        return RSRV_ERROR;
+    }
+
+    client->sendQLock = epicsMutexCreate ();
+    if ( ! client->sendQLock ) {
+        return RSRV_ERROR;
+    }
+
+    if ( socket_ioctl ( client->sock, FIONBIO, &yes ) < 0 ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "CAS: FIONBIO " ERL_ERROR ": %s\n", sockErrBuf );
+        return RSRV_ERROR;
+    }
+
+    poller = &pollers[(unsigned) epicsAtomicIncrIntT ( &nextPoller ) % n];
+    client->pollEvents = EPOLLIN;
+    ev.events = EPOLLIN;
+    ev.data.ptr = client;
+
+    /* casPollStop() closes the clients attached before it */
+    LOCK_CLIENTQ;
+    client->poller = poller;
+    if ( pollExit ||
+            epoll_ctl ( poller->epfd, EPOLL_CTL_ADD, client->sock, &ev ) < 0 ) {
+        if ( ! pollExit ) {
+            errlogPrintf ( "CAS: epoll_ctl " ERL_ERROR ": %s\n",
+                strerror ( errno ) );
+        }
+        client->poller = NULL;
+        UNLOCK_CLIENTQ;
+        yes = FALSE;
+        socket_ioctl ( client->sock, FIONBIO, &yes );
+        return RSRV_ERROR;
+    }
+    poller->nclients++;
+    db_start_events_pool ( client->evuser, eventPool, NULL, NULL );
+    UNLOCK_CLIENTQ;
+
+    return RSRV_OK;
+}
+
+/*
+ *  casPollPark()
+ *
+ *  stop processing the requests of a client on an I/O thread until
+ *  a put callback completes, returns FALSE instead if the request has
+ *  been parked for RSRV_PARK_TIMEOUT, caller holds putNotifyLock
+ */
+int casPollPark ( struct client *client )
+{
+    rsrv_poller *poller = client->poller;
+
+    if ( client->parkTimedOut ) {
+        client->parkTimedOut = FALSE;
+        client->parkWaiting = FALSE;
+        return FALSE;
+    }
+    if ( ! client->parkWaiting ) {
+        client->parkWaiting = TRUE;
+        epicsTimeGetCurrent ( &client->parkTime );
+    }
+
+    epicsMutexMustLock ( poller->lock );
+    if ( ! client->parked ) {
+        epicsMutexMustLock ( client->sendQLock );
+        client->parked = TRUE;
+        epicsMutexUnlock ( client->sendQLock );
+        client->parkResume = FALSE;
+        ellAdd ( &poller->parkedQ, &client->parkNode );
+    }
+    epicsMutexUnlock ( poller->lock );
+
+    return TRUE;
+}
+
+/*
+ *  casPollResume()
+ *
+ *  called when put callbacks of a client served by an I/O thread have
+ *  completed, the I/O thread looks again at a parked request
+ */
+void casPollResume ( struct client *client )
+{
+    rsrv_poller *poller = client->poller;
+
+    epicsMutexMustLock ( poller->lock );
+    if ( client->parked && ! client->parkResume ) {
+        epicsUInt64 one = 1u;
+
+        client->parkResume = TRUE;
+        if ( write ( poller->wakefd, &one, sizeof ( one ) ) < 0 ) {
+            /* the counter is already non-zero */
         }
     }
+    epicsMutexUnlock ( poller->lock );
+}
+
+/*
+ *  casPollEventsOff()
+ *
+ *  EVENTS_OFF and EVENTS_ON from a client served by an I/O thread,
+ *  whose events are also held while its send queue is full
+ */
+void casPollEventsOff ( struct client *client, int off )
+{
+    epicsMutexMustLock ( client->sendQLock );
+    client->eventsOff = off;
+    pollEventFlow ( client );
+    epicsMutexUnlock ( client->sendQLock );
+}
+
+/*
+ *  casPollStop()
+ *
+ *  join the I/O threads, then close their clients and join the
+ *  CAS-reaper and CAS-event threads once these are destroyed
+ */
+void casPollStop ( void )
+{
+    epicsUInt64 one = 1u;
+    int i;
 
     LOCK_CLIENTQ;
-    ellDelete ( &clientQ, &client->node );
+    pollExit = TRUE;
     UNLOCK_CLIENTQ;
 
-    destroy_tcp_client ( client );
+    for ( i = 0; i < nPollers; i++ ) {
+        if ( write ( pollers[i].wakefd, &one, sizeof ( one ) ) < 0 ) {
+            /* the counter is already non-zero */
+        }
+    }
+    for ( i = 0; i < nPollers; i++ ) {
+        epicsThreadMustJoin ( pollers[i].tid );
+    }
+
+    while ( TRUE ) {
+        struct client *client;
+
+        LOCK_CLIENTQ;
+        for ( client = (struct client *) ellFirst ( &clientQ );
+                client && ! client->poller;
+                client = (struct client *) ellNext ( &client->node ) ) {
+        }
+        UNLOCK_CLIENTQ;
+        if ( ! client ) {
+            break;
+        }
+        pollClose ( client );
+    }
+
+    if ( reapTid ) {
+        epicsMutexMustLock ( reapLock );
+        reapExit = TRUE;
+        epicsMutexUnlock ( reapLock );
+        epicsEventSignal ( reapSignal );
+        epicsThreadMustJoin ( reapTid );
+        reapTid = NULL;
+    }
+
+    db_event_pool_destroy ( eventPool );
+    eventPool = NULL;
+
+    /* pollers and their locks are left for casPollAttach() racing with us */
+    for ( i = 0; i < nPollers; i++ ) {
+        close ( pollers[i].wakefd );
+        close ( pollers[i].epfd );
+    }
+    nPollers = 0;
+}
+
+void casPollReport ( unsigned level )
+{
+    int i;
+
+    if ( nPollers == 0 ) {
+        return;
+    }
+
+    printf ( "%d I/O thread%s serving TCP clients\n",
+        nPollers, nPollers == 1 ? "" : "s" );
+    if ( level >= 2u ) {
+        LOCK_CLIENTQ;
+        for ( i = 0; i < nPollers; i++ ) {
+            int nparked;
+
+            epicsMutexMustLock ( pollers[i].lock );
+            nparked = ellCount ( &pollers[i].parkedQ );
+            epicsMutexUnlock ( pollers[i].lock );
+            printf ( "    CAS-io%d: %u client%s, %d waiting for a put callback\n",
+                i, pollers[i].nclients, pollers[i].nclients == 1 ? "" : "s",
+                nparked );
+        }
+        UNLOCK_CLIENTQ;
+    }
+}
+
+#else /* RSRV_EPOLL */
+
+int casPollAttach ( struct client *client )
+{
+    static int warned;
+
+    if ( rsrvIoThreads > 0 && ! warned ) {
+        warned = 1;
+        errlogPrintf ( "CAS: rsrvIoThreads is not supported on this target, "
+            "serving each client with its own thread\n" );
+    }
+    return RSRV_ERROR;
 }
 
+void casPollSend ( struct client *client ) {}
+
+int casPollPark ( struct client *client )
+{
+    return FALSE;
+}
+
+void casPollResume ( struct client *client ) {}
+
+void casPollReport ( unsigned level ) {}
+
+void casPollEventsOff ( struct client *client, int off ) {}
+
+void casPollStop ( void ) {}
+
+#endif /* RSRV_EPOLL */
 
 int casClientInitiatingCurrentThread ( char * pBuf, size_t bufSize )
 {
@@ -22,9 +22,11 @@
 #include <limits.h>
 
 #include "dbDefs.h"
+#include "epicsAtomic.h"
 #include "epicsSignal.h"
 #include "epicsTime.h"
 #include "errlog.h"
+#include "freeList.h"
 #include "osiSock.h"
 
 #include "caerr.h"
@@ -32,6 +34,243 @@
 
 #include "server.h"
 
+#if defined(_WIN32)
+/* the segments of a response, sent one at a time */
+struct iovec {
+    void *iov_base;
+    size_t iov_len;
+};
+#else
+#  include <sys/uio.h>
+#endif
+
+#define SEND_SEGMENTS ( 2 * RSRV_SEND_SPLICES + 1 )
+
+/*
+ * describe the unsent response bytes, after the first skip of them,
+ * as a list of segments of the send buffer and the spliced payloads
+ */
+static unsigned cas_send_segments ( struct client *pclient, size_t skip,
+    struct iovec *pSeg )
+{
+    unsigned nseg = 0u;
+    unsigned pos = 0u;
+    unsigned i;
+
+    for ( i = 0u; i <= pclient->nSendSplices; i++ ) {
+        struct send_splice *pSplice = i < pclient->nSendSplices ?
+            &pclient->sendSplices[i] : NULL;
+        unsigned end = pSplice ? pSplice->offset : pclient->send.stk;
+        char *pBase = &pclient->send.buf[pos];
+        size_t size = end - pos;
+        int j;
+
+        /* the send buffer up to the splice, then the spliced payload */
+        for ( j = 0; j < 2; j++ ) {
+            if ( skip >= size ) {
+                skip -= size;
+            }
+            else {
+                pSeg[nseg].iov_base = pBase + skip;
+                pSeg[nseg].iov_len = size - skip;
+                nseg++;
+                skip = 0u;
+            }
+            if ( ! pSplice ) {
+                break;
+            }
+            pBase = pSplice->buf;
+            size = pSplice->size;
+        }
+        pos = end;
+    }
+    return nseg;
+}
+
+/*
+ *  cas_send_pending()
+ *
+ *  number of response bytes waiting to be sent
+ */
+size_t cas_send_pending ( struct client *pclient )
+{
+    return pclient->send.stk + pclient->sendSpliceBytes;
+}
+
+/*
+ *  cas_send_some()
+ *
+ *  one send() of the response bytes after the first skip of them,
+ *  returns the number of bytes sent, or -1 with SOCKERRNO set
+ */
+int cas_send_some ( struct client *pclient, size_t skip )
+{
+    struct iovec seg[SEND_SEGMENTS];
+    unsigned nseg = cas_send_segments ( pclient, skip, seg );
+
+    if ( nseg == 0u ) {
+        return 0;
+    }
+#if defined(_WIN32)
+    /* no sendmsg(), the caller comes back for the other segments */
+    return send ( pclient->sock, seg[0].iov_base, (int) seg[0].iov_len, 0 );
+#else
+    {
+        struct msghdr msg;
+
+        memset ( &msg, 0, sizeof ( msg ) );
+        msg.msg_iov = seg;
+        msg.msg_iovlen = nseg;
+        return (int) sendmsg ( pclient->sock, &msg, 0 );
+    }
+#endif
+}
+
+/*
+ *  cas_send_copy_out()
+ *
+ *  copy the response bytes after the first skip of them to pDest
+ */
+void cas_send_copy_out ( struct client *pclient, size_t skip, char *pDest )
+{
+    struct iovec seg[SEND_SEGMENTS];
+    unsigned nseg = cas_send_segments ( pclient, skip, seg );
+    unsigned i;
+
+    for ( i = 0u; i < nseg; i++ ) {
+        memcpy ( pDest, seg[i].iov_base, seg[i].iov_len );
+        pDest += seg[i].iov_len;
+    }
+}
+
+/*
+ *  cas_payload_alloc()
+ *
+ *  a buffer for a payload too large for the send buffer, taken from
+ *  the large buffer free list or from the client's spares
+ */
+static char * cas_payload_alloc ( struct client *pclient,
+    unsigned size, unsigned *pCapacity )
+{
+    unsigned i, best = pclient->nSendSpares;
+    char *buf;
+
+    if ( rsrvLargeBufFreeListTCP ) {
+        *pCapacity = rsrvSizeofLargeBufTCP;
+        return freeListMalloc ( rsrvLargeBufFreeListTCP );
+    }
+
+    for ( i = 0u; i < pclient->nSendSpares; i++ ) {
+        if ( pclient->sendSpares[i].capacity >= size &&
+                ( best == pclient->nSendSpares ||
+                    pclient->sendSpares[i].capacity <
+                        pclient->sendSpares[best].capacity ) ) {
+            best = i;
+        }
+    }
+    if ( best < pclient->nSendSpares ) {
+        buf = pclient->sendSpares[best].buf;
+        *pCapacity = pclient->sendSpares[best].capacity;
+        pclient->sendSpareBytes -= *pCapacity;
+        pclient->sendSpares[best] =
+            pclient->sendSpares[--pclient->nSendSpares];
+        return buf;
+    }
+
+    /* round up to the page size, as casExpandBuffer() does */
+    if ( size <= UINT_MAX - 4095u ) {
+        unsigned rounded = ( ( size - 1u ) | 0xfff ) + 1u;
+        size = rounded > rsrvSizeofLargeBufTCP && size <= rsrvSizeofLargeBufTCP ?
+            rsrvSizeofLargeBufTCP : rounded;
+    }
+    buf = malloc ( size );
+    *pCapacity = buf ? size : 0u;
+    return buf;
+}
+
+/*
+ *  cas_payload_free()
+ *
+ *  keep a sent payload buffer for reuse, the smallest spares are freed
+ *  to hold no more than RSRV_SEND_SPLICES spares totalling no more
+ *  than rsrvSizeofLargeBufTCP
+ */
+static void cas_payload_free ( struct client *pclient,
+    char *buf, unsigned capacity )
+{
+    struct send_splice *pSpare;
+    unsigned i;
+
+    if ( rsrvLargeBufFreeListTCP ) {
+        freeListFree ( rsrvLargeBufFreeListTCP, buf );
+        return;
+    }
+    if ( capacity > rsrvSizeofLargeBufTCP ) {
+        free ( buf );
+        return;
+    }
+
+    while ( pclient->nSendSpares >= RSRV_SEND_SPLICES ||
+            pclient->sendSpareBytes + capacity > rsrvSizeofLargeBufTCP ) {
+        pSpare = &pclient->sendSpares[0];
+        for ( i = 1u; i < pclient->nSendSpares; i++ ) {
+            if ( pclient->sendSpares[i].capacity < pSpare->capacity ) {
+                pSpare = &pclient->sendSpares[i];
+            }
+        }
+        free ( pSpare->buf );
+        pclient->sendSpareBytes -= pSpare->capacity;
+        *pSpare = pclient->sendSpares[--pclient->nSendSpares];
+    }
+
+    pSpare = &pclient->sendSpares[pclient->nSendSpares++];
+    pSpare->buf = buf;
+    pSpare->capacity = capacity;
+    pSpare->size = 0u;
+    pSpare->offset = 0u;
+    pclient->sendSpareBytes += capacity;
+}
+
+/*
+ *  cas_send_free_payloads()
+ *
+ *  release every payload buffer during client cleanup
+ */
+void cas_send_free_payloads ( struct client *pclient )
+{
+    unsigned i;
+
+    cas_send_discard ( pclient );
+    if ( pclient->pSendPayload ) {
+        cas_payload_free ( pclient, pclient->pSendPayload,
+            pclient->sendPayloadCapacity );
+        pclient->pSendPayload = NULL;
+    }
+    for ( i = 0u; i < pclient->nSendSpares; i++ ) {
+        free ( pclient->sendSpares[i].buf );
+    }
+    pclient->nSendSpares = 0u;
+    pclient->sendSpareBytes = 0u;
+}
+
+/*
+ *  cas_send_discard()
+ *
+ *  empty the send buffer and keep the spliced payload buffers for reuse
+ */
+void cas_send_discard ( struct client *pclient )
+{
+    unsigned i;
+
+    for ( i = 0u; i < pclient->nSendSplices; i++ ) {
+        cas_payload_free ( pclient, pclient->sendSplices[i].buf,
+            pclient->sendSplices[i].capacity );
+    }
+    pclient->nSendSplices = 0u;
+    pclient->sendSpliceBytes = 0u;
+    pclient->send.stk = 0u;
+}
+
 /*
  *  cas_send_bs_msg()
  *
@@ -42,14 +281,18 @@
  */
 void cas_send_bs_msg ( struct client *pclient, int lock_needed )
 {
+    size_t pending, sent = 0u;
     int status;
 
     if ( lock_needed ) {
         SEND_LOCK ( pclient );
     }
 
-    if ( CASDEBUG > 2 && pclient->send.stk ) {
-        errlogPrintf ( "CAS: Sending a message of %d bytes\n", pclient->send.stk );
+    pending = cas_send_pending ( pclient );
+
+    if ( CASDEBUG > 2 && pending ) {
+        errlogPrintf ( "CAS: Sending a message of %lu bytes\n",
+            (unsigned long) pending );
     }
 
     if ( pclient->disconnect ) {
@@ -57,27 +300,27 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
             errlogPrintf ( "CAS: msg Discard for sock %d addr %x\n",
                 (int)pclient->sock, (unsigned) pclient->addr.sin_addr.s_addr );
         }
-        pclient->send.stk = 0u;
+        cas_send_discard ( pclient );
         if(lock_needed)
             SEND_UNLOCK(pclient);
         return;
     }
 
-    while ( pclient->send.stk && ! pclient->disconnect ) {
-        status = send ( pclient->sock, pclient->send.buf, pclient->send.stk, 0 );
+    if ( pclient->poller ) {
+        /* non-blocking socket, what doesn't fit is queued */
+        casPollSend ( pclient );
+        pending = cas_send_pending ( pclient );
+    }
+
+    while ( sent < pending && ! pclient->disconnect ) {
+        /* partial sends just skip what was already sent */
+        status = cas_send_some ( pclient, sent );
         if ( status >= 0 ) {
-            unsigned transferSize = (unsigned) status;
-            if ( transferSize >= pclient->send.stk ) {
-                pclient->send.stk = 0;
+            sent += (unsigned) status;
+            if ( sent >= pending ) {
                 epicsTimeGetCurrent ( &pclient->time_at_last_send );
                 break;
             }
-            else {
-                unsigned bytesLeft = pclient->send.stk - transferSize;
-                memmove ( pclient->send.buf, &pclient->send.buf[transferSize],
-                    bytesLeft );
-                pclient->send.stk = bytesLeft;
-            }
         }
         else {
             int causeWasSocketHangup = 0;
@@ -85,7 +328,6 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
             char buf[64];
 
             if ( pclient->disconnect ) {
-                pclient->send.stk = 0u;
                 break;
             }
 
@@ -117,7 +359,6 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
                     buf, sockErrBuf);
             }
             pclient->disconnect = TRUE;
-            pclient->send.stk = 0u;
 
             /*
              * wakeup the receive thread
@@ -155,6 +396,8 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
         }
     }
 
+    cas_send_discard ( pclient );
+
     if ( lock_needed ) {
         SEND_UNLOCK(pclient);
     }
@@ -164,6 +407,115 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
     return;
 }
 
+#ifdef RSRV_MMSG
+
+/*
+ * UDP replies to the datagrams of one recvmmsg() are collected
+ * here and sent with a single sendmmsg()
+ */
+#define RSRV_DG_BATCH 16
+
+struct rsrv_dg_batch {
+    unsigned n;
+    unsigned nSearchReplies[RSRV_DG_BATCH];
+    struct mmsghdr msgs[RSRV_DG_BATCH];
+    struct iovec iov[RSRV_DG_BATCH];
+    struct sockaddr_in addr[RSRV_DG_BATCH];
+    char buf[RSRV_DG_BATCH][MAX_UDP_SEND];
+};
+
+struct rsrv_dg_batch *cas_dg_batch_create ( void )
+{
+    return calloc ( 1, sizeof ( struct rsrv_dg_batch ) );
+}
+
+/*
+ *  cas_dg_batch_flush()
+ *
+ *  send the collected UDP replies
+ */
+void cas_dg_batch_flush ( struct client *pclient )
+{
+    struct rsrv_dg_batch *pBatch = pclient->dgBatch;
+    unsigned i = 0u;
+
+    if ( ! pBatch ) {
+        return;
+    }
+
+    SEND_LOCK ( pclient );
+    while ( i < pBatch->n ) {
+        int status = sendmmsg ( pclient->sock, &pBatch->msgs[i],
+            pBatch->n - i, 0 );
+        if ( status > 0 ) {
+            unsigned end = i + (unsigned) status;
+            for ( ; i < end; i++ ) {
+                if ( pBatch->msgs[i].msg_len < pBatch->iov[i].iov_len ) {
+                    errlogPrintf (
+                        "CAS: System failed to send entire udp frame?\n" );
+                }
+            }
+            epicsTimeGetCurrent ( &pclient->time_at_last_send );
+        }
+        else if ( status < 0 && SOCKERRNO == SOCK_EINTR ) {
+            continue;
+        }
+        else {
+            /* this one can't be sent, try the others */
+            char sockErrBuf[64];
+            char buf[128];
+            epicsSocketConvertErrnoToString (
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            ipAddrToDottedIP ( &pBatch->addr[i], buf, sizeof(buf) );
+            errlogPrintf( "CAS: UDP send to %s failed: %s\n",
+                buf, sockErrBuf);
+            epicsAtomicAddSizeT ( &rsrvSearchesDropped,
+                pBatch->nSearchReplies[i] );
+            i++;
+        }
+    }
+    pBatch->n = 0u;
+    SEND_UNLOCK ( pclient );
+}
+
+static void cas_dg_batch_add ( struct client *pclient,
+    const char *pDG, unsigned sizeDG )
+{
+    struct rsrv_dg_batch *pBatch = pclient->dgBatch;
+    struct msghdr *pHdr;
+    unsigned n;
+
+    if ( pBatch->n >= RSRV_DG_BATCH ) {
+        cas_dg_batch_flush ( pclient );
+    }
+    n = pBatch->n++;
+
+    assert ( sizeDG <= sizeof ( pBatch->buf[n] ) );
+    memcpy ( pBatch->buf[n], pDG, sizeDG );
+    pBatch->iov[n].iov_base = pBatch->buf[n];
+    pBatch->iov[n].iov_len = sizeDG;
+    pBatch->addr[n] = pclient->addr;
+    pBatch->nSearchReplies[n] = pclient->nSearchReplies;
+
+    pHdr = &pBatch->msgs[n].msg_hdr;
+    memset ( pHdr, 0, sizeof ( *pHdr ) );
+    pHdr->msg_name = &pBatch->addr[n];
+    pHdr->msg_namelen = sizeof ( pBatch->addr[n] );
+    pHdr->msg_iov = &pBatch->iov[n];
+    pHdr->msg_iovlen = 1;
+}
+
+#else /* RSRV_MMSG */
+
+struct rsrv_dg_batch *cas_dg_batch_create ( void )
+{
+    return NULL;
+}
+
+void cas_dg_batch_flush ( struct client *pclient ) {}
+
+#endif /* RSRV_MMSG */
+
 /*
  *  cas_send_dg_msg()
  *
@@ -200,28 +552,39 @@ void cas_send_dg_msg ( struct client * pclient )
         sizeDG -= sizeof (caHdr);
     }
 
-    status = sendto ( pclient->sock, pDG, sizeDG, 0,
-       (struct sockaddr *)&pclient->addr, sizeof(pclient->addr) );
-    if ( status >= 0 ) {
-        if ( status >= sizeDG ) {
-            epicsTimeGetCurrent ( &pclient->time_at_last_send );
+#ifdef RSRV_MMSG
+    if ( pclient->dgBatch ) {
+        cas_dg_batch_add ( pclient, pDG, (unsigned) sizeDG );
+    }
+    else
+#endif
+    {
+        status = sendto ( pclient->sock, pDG, sizeDG, 0,
+           (struct sockaddr *)&pclient->addr, sizeof(pclient->addr) );
+        if ( status >= 0 ) {
+            if ( status >= sizeDG ) {
+                epicsTimeGetCurrent ( &pclient->time_at_last_send );
+            }
+            else {
+                errlogPrintf (
+                    "CAS: System failed to send entire udp frame?\n" );
+            }
         }
         else {
-            errlogPrintf (
-                "CAS: System failed to send entire udp frame?\n" );
+            char sockErrBuf[64];
+            char buf[128];
+            epicsSocketConvertErrnoToString (
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
+            errlogPrintf( "CAS: UDP send to %s failed: %s\n",
+                buf, sockErrBuf);
+            epicsAtomicAddSizeT ( &rsrvSearchesDropped,
+                pclient->nSearchReplies );
         }
     }
-    else {
-        char sockErrBuf[64];
-        char buf[128];
-        epicsSocketConvertErrnoToString (
-            sockErrBuf, sizeof ( sockErrBuf ) );
-        ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
-        errlogPrintf( "CAS: UDP send to %s failed: %s\n",
-            buf, sockErrBuf);
-    }
 
     pclient->send.stk = 0u;
+    pclient->nSearchReplies = 0u;
 
     /*
      * add placeholder for the first version message should it be needed
@@ -270,16 +633,45 @@ int cas_copy_in_header (
         msgSize += 2 * sizeof ( ca_uint32_t );
     }
 
+    /* a previous reservation which wasn't committed */
+    if ( pclient->pSendPayload && ( msgSize <= pclient->send.maxstk ||
+            pclient->sendPayloadCapacity < alignedPayloadSize ) ) {
+        cas_payload_free ( pclient, pclient->pSendPayload,
+            pclient->sendPayloadCapacity );
+        pclient->pSendPayload = NULL;
+    }
+
     if ( msgSize > pclient->send.maxstk ) {
-        casExpandSendBuffer ( pclient, msgSize );
-        if ( msgSize > pclient->send.maxstk ) {
+        /*
+         * only the header goes in the send buffer, the payload
+         * is spliced in when it is sent
+         */
+        if ( pclient->proto != IPPROTO_TCP ||
+                ( rsrvLargeBufFreeListTCP && msgSize > rsrvSizeofLargeBufTCP ) ) {
             return ECA_TOLARGE;
         }
+        if ( ! pclient->pSendPayload ) {
+            pclient->pSendPayload = cas_payload_alloc ( pclient,
+                alignedPayloadSize, &pclient->sendPayloadCapacity );
+            if ( ! pclient->pSendPayload ) {
+                return ECA_ALLOCMEM;
+            }
+        }
+        msgSize -= alignedPayloadSize;
+
+        /*
+         * never keep more than a maximum size array waiting
+         */
+        if ( pclient->nSendSplices >= RSRV_SEND_SPLICES ||
+                pclient->sendSpliceBytes + alignedPayloadSize >
+                    rsrvSizeofLargeBufTCP ) {
+            cas_send_bs_msg ( pclient, FALSE );
+        }
     }
 
     if ( pclient->send.stk > pclient->send.maxstk - msgSize ) {
         if ( pclient->disconnect ) {
-            pclient->send.stk = 0;
+            cas_send_discard ( pclient );
         }
         else{
             if ( pclient->proto == IPPROTO_TCP) {
@@ -314,6 +706,9 @@ int cas_copy_in_header (
         if (ppPayload)
             *ppPayload = (void *) (pW32 + 2);
     }
+    if (pclient->pSendPayload && ppPayload) {
+        *ppPayload = (void *) pclient->pSendPayload;
+    }
 
     /* zero out pad bytes */
     if ( alignedPayloadSize > payloadSize ) {
@@ -350,19 +745,35 @@ void cas_set_header_count (struct client *pClient, ca_uint32_t count)
 void cas_commit_msg ( struct client *pClient, ca_uint32_t size )
 {
     caHdr * pMsg = ( caHdr * ) &pClient->send.buf[pClient->send.stk];
+    unsigned headerSize;
     size = CA_MESSAGE_ALIGN ( size );
     if ( pMsg->m_postsize == htons ( 0xffff ) ) {
         ca_uint32_t * pLW = ( ca_uint32_t * ) ( pMsg + 1 );
         assert ( size <= ntohl ( *pLW ) );
         pLW[0] = htonl ( size );
-        size += sizeof ( caHdr ) + 2 * sizeof ( *pLW );
+        headerSize = sizeof ( caHdr ) + 2 * sizeof ( *pLW );
     }
     else {
         assert ( size <= ntohs ( pMsg->m_postsize ) );
         pMsg->m_postsize = htons ( (ca_uint16_t) size );
-        size += sizeof ( caHdr );
+        headerSize = sizeof ( caHdr );
+    }
+    pClient->send.stk += headerSize;
+
+    if ( pClient->pSendPayload ) {
+        struct send_splice *pSplice =
+            &pClient->sendSplices[pClient->nSendSplices++];
+        assert ( pClient->nSendSplices <= RSRV_SEND_SPLICES );
+        pSplice->buf = pClient->pSendPayload;
+        pSplice->capacity = pClient->sendPayloadCapacity;
+        pSplice->size = size;
+        pSplice->offset = pClient->send.stk;
+        pClient->sendSpliceBytes += size;
+        pClient->pSendPayload = NULL;
+    }
+    else {
+        pClient->send.stk += size;
     }
-    pClient->send.stk += size;
 }
 
 /*
@@ -23,6 +23,7 @@
 #include <errno.h>
 
 #include "addrList.h"
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsSignal.h"
@@ -106,6 +107,19 @@ static void req_server (void *pParm)
             ellAdd ( &clientQ, &pClient->node );
             UNLOCK_CLIENTQ;
 
+            if ( casPollAttach ( pClient ) == RSRV_OK ) {
+                continue;
+            }
+
+            if ( rsrv_start_events ( pClient ) != RSRV_OK ) {
+                LOCK_CLIENTQ;
+                ellDelete ( &clientQ, &pClient->node );
+                UNLOCK_CLIENTQ;
+                destroy_tcp_client ( pClient );
+                epicsThreadSleep ( 15.0 );
+                continue;
+            }
+
             id = epicsThreadCreate ( "CAS-client", epicsThreadPriorityCAServerLow,
                     epicsThreadGetStackSize ( epicsThreadStackBig ),
                     camsgtask, pClient );
@@ -484,6 +498,7 @@ void rsrv_init (void)
     freeListInitPvt ( &rsrvEventFreeList, sizeof(struct event_ext), 512 );
     freeListInitPvt ( &rsrvSmallBufFreeListTCP, MAX_TCP, 16 );
     initializePutNotifyFreeList ();
+    initializePayloadCache ();
 
     epicsSignalInstallSigPipeIgnore ();
 
@@ -779,6 +794,17 @@ void rsrv_pause (void)
     castcp_ctl = ctlPause;
 }
 
+/*
+ * Join the threads shared by the clients of the I/O threads, a client
+ * with a thread of its own is left to see castcp_ctl paused
+ */
+static
+void rsrv_stop (void)
+{
+    rsrv_pause ();
+    casPollStop ();
+}
+
 static unsigned countChanListBytes (
     struct client *client, ELLLIST * pList )
 {
@@ -861,17 +887,21 @@ static void log_one_client (struct client *client, unsigned level)
 
         printf ("\tTask Id = %p, Socket FD = %d\n",
             (void *) client->tid, (int)client->sock);
+        if ( client->poller ) {
+            printf ("\tServed by an I/O thread, Queued response bytes = %lu\n",
+                (unsigned long) client->sendQBytes);
+        }
         printf(
         "\t%.2f secs since last send, %.2f secs since last receive\n",
             send_delay, recv_delay);
         printf(
-        "\tUnprocessed request bytes = %u, Undelivered response bytes = %u\n",
+        "\tUnprocessed request bytes = %u, Undelivered response bytes = %lu\n",
             client->recv.cnt - client->recv.stk,
-            client->send.stk );
+            (unsigned long) ( client->send.stk + client->sendSpliceBytes ) );
         printf(
         "\tState = %s%s%s\n",
             state[client->disconnect?1:0],
-            client->send.type == mbtLargeTCP ? " jumbo-send-buf" : "",
+            client->nSendSplices ? " spliced-send-payloads" : "",
             client->recv.type == mbtLargeTCP ? " jumbo-recv-buf" : "");
     }
 
@@ -1016,6 +1046,22 @@ void casr (unsigned level)
         }
     }
 
+    if (level>=1u) {
+        size_t received, matched, dropped;
+
+        casSearchStatsFetch ( &received, &matched, &dropped );
+        printf ( "UDP name searches: %lu received, %lu matched, %lu dropped, "
+            "%lu datagrams dropped\n",
+            (unsigned long) received, (unsigned long) matched,
+            (unsigned long) dropped,
+            (unsigned long) epicsAtomicGetSizeT ( &rsrvDatagramsDropped ) );
+        casPollReport (level);
+    }
+
+    if (level>=2u) {
+        rsrvPayloadCacheReport ();
+    }
+
     if (level>=4u) {
         bytes_reserved = 0u;
         bytes_reserved += sizeof (struct client) *
@@ -1069,16 +1115,11 @@ void destroy_client ( struct client *client )
     }
 
     if ( client->proto == IPPROTO_TCP ) {
+        cas_send_free_payloads ( client );
         if ( client->send.buf ) {
             if ( client->send.type == mbtSmallTCP ) {
                 freeListFree ( rsrvSmallBufFreeListTCP,  client->send.buf );
             }
-            else if ( client->send.type == mbtLargeTCP ) {
-                if(rsrvLargeBufFreeListTCP)
-                    freeListFree ( rsrvLargeBufFreeListTCP,  client->send.buf );
-                else
-                    free(client->send.buf);
-            }
             else {
                 errlogPrintf ( "CAS: Corrupt send buffer free list type code=%u during client cleanup?\n",
                     client->send.type );
@@ -1101,6 +1142,9 @@ void destroy_client ( struct client *client )
         }
     }
     else if ( client->proto == IPPROTO_UDP ) {
+        if ( client->dgBatch ) {
+            free ( client->dgBatch );
+        }
         if ( client->send.buf ) {
             free ( client->send.buf );
         }
@@ -1109,6 +1153,15 @@ void destroy_client ( struct client *client )
         }
     }
 
+    if ( client->sendQLock ) {
+        ELLNODE *pNode;
+
+        while ( ( pNode = ellGet ( &client->sendQ ) ) ) {
+            free ( pNode );
+        }
+        epicsMutexDestroy ( client->sendQLock );
+    }
+
     if ( client->eventqLock ) {
         epicsMutexDestroy ( client->eventqLock );
     }
@@ -1324,7 +1377,7 @@ void casAttachThreadToClient ( struct client *pClient )
 }
 
 static
-void casExpandBuffer ( struct message_buffer *buf, ca_uint32_t size, int sendbuf )
+void casExpandBuffer ( struct message_buffer *buf, ca_uint32_t size )
 {
     char *newbuf = NULL;
     unsigned newsize;
@@ -1360,14 +1413,7 @@ void casExpandBuffer ( struct message_buffer *buf, ca_uint32_t size, int sendbuf
 
     if (newbuf) {
         /* copy existing buffer */
-        if (sendbuf) {
-            /* send buffer uses [0, stk) */
-            if (!rsrvLargeBufFreeListTCP && buf->type==mbtLargeTCP) {
-                /* realloc already copied */
-            } else {
-                memcpy ( newbuf, buf->buf, buf->stk );
-            }
-        } else {
+        {
             /* recv buffer uses [stk, cnt) */
             unsigned used;
             assert ( buf->cnt >= buf->stk );
@@ -1396,14 +1442,9 @@ void casExpandBuffer ( struct message_buffer *buf, ca_uint32_t size, int sendbuf
     }
 }
 
-void casExpandSendBuffer ( struct client *pClient, ca_uint32_t size )
-{
-    casExpandBuffer (&pClient->send, size, 1);
-}
-
 void casExpandRecvBuffer ( struct client *pClient, ca_uint32_t size )
 {
-    casExpandBuffer (&pClient->recv, size, 0);
+    casExpandBuffer (&pClient->recv, size);
 }
 
 /*
@@ -1414,7 +1455,6 @@ struct client *create_tcp_client (SOCKET sock , const osiSockAddr *peerAddr)
     int                     status;
     struct client           *client;
     int                     intTrue = TRUE;
-    unsigned                priorityOfEvents;
 
     /* socket passed in is destroyed here if unsuccessful */
     client = create_client ( sock, IPPROTO_TCP );
@@ -1503,23 +1543,6 @@ struct client *create_tcp_client (SOCKET sock , const osiSockAddr *peerAddr)
         return NULL;
     }
 
-    {
-        epicsThreadBooleanStatus    tbs;
-
-        tbs  = epicsThreadHighestPriorityLevelBelow ( epicsThreadPriorityCAServerLow, &priorityOfEvents );
-        if ( tbs != epicsThreadBooleanStatusSuccess ) {
-            priorityOfEvents = epicsThreadPriorityCAServerLow;
-        }
-    }
-
-    status = db_start_events ( client->evuser, "CAS-event",
-                NULL, NULL, priorityOfEvents );
-    if ( status != DB_EVENT_OK ) {
-        errlogPrintf ( "CAS: unable to start the event facility\n" );
-        destroy_tcp_client ( client );
-        return NULL;
-    }
-
     /*
      * add first version message should it be needed
      */
@@ -1534,6 +1557,32 @@ struct client *create_tcp_client (SOCKET sock , const osiSockAddr *peerAddr)
     return client;
 }
 
+/*
+ *  rsrv_start_events ()
+ *
+ *  the event task of a client with a thread of its own,
+ *  the I/O threads share the CAS-event threads instead
+ */
+int rsrv_start_events ( struct client *client )
+{
+    epicsThreadBooleanStatus    tbs;
+    unsigned                    priorityOfEvents;
+    int                         status;
+
+    tbs  = epicsThreadHighestPriorityLevelBelow ( epicsThreadPriorityCAServerLow, &priorityOfEvents );
+    if ( tbs != epicsThreadBooleanStatusSuccess ) {
+        priorityOfEvents = epicsThreadPriorityCAServerLow;
+    }
+
+    status = db_start_events ( client->evuser, "CAS-event",
+                NULL, NULL, priorityOfEvents );
+    if ( status != DB_EVENT_OK ) {
+        errlogPrintf ( "CAS: unable to start the event facility\n" );
+        return RSRV_ERROR;
+    }
+    return RSRV_OK;
+}
+
 void casStatsFetch ( unsigned *pChanCount, unsigned *pCircuitCount )
 {
     LOCK_CLIENTQ;
@@ -1550,6 +1599,14 @@ void casStatsFetch ( unsigned *pChanCount, unsigned *pCircuitCount )
     UNLOCK_CLIENTQ;
 }
 
+void casSearchStatsFetch ( size_t *pReceived, size_t *pMatched,
+    size_t *pDropped )
+{
+    *pReceived = epicsAtomicGetSizeT ( &rsrvSearchesReceived );
+    *pMatched = epicsAtomicGetSizeT ( &rsrvSearchesMatched );
+    *pDropped = epicsAtomicGetSizeT ( &rsrvSearchesDropped );
+}
+
 
 static dbServer rsrv_server = {
     ELLNODE_INIT,
@@ -1559,7 +1616,8 @@ static dbServer rsrv_server = {
     casClientInitiatingCurrentThread,
     rsrv_init,
     rsrv_run,
-    rsrv_pause
+    rsrv_pause,
+    rsrv_stop
 };
 
 void rsrv_register_server(void)
@@ -39,6 +39,7 @@
 
 #include "dbDefs.h"
 #include "envDefs.h"
+#include "epicsAtomic.h"
 #include "epicsMutex.h"
 #include "epicsTime.h"
 #include "errlog.h"
@@ -104,6 +105,204 @@ static void clean_addrq(struct client *client)
     }
 }
 
+/*
+ * cast_ignored
+ *
+ * true if datagrams from this sender are to be ignored
+ */
+static int cast_ignored(const struct sockaddr_in *pAddr)
+{
+    size_t idx;
+    for(idx=0; casIgnoreAddrs[idx]; idx++)
+    {
+        if(pAddr->sin_addr.s_addr==casIgnoreAddrs[idx]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * cast_process
+ *
+ * process one datagram of nchars bytes in client->recv.buf
+ */
+static void cast_process(struct client *client, unsigned nchars,
+    const struct sockaddr_in *pAddr)
+{
+    int status;
+    int count=0;
+
+    client->recv.cnt = nchars;
+    client->recv.stk = 0ul;
+    epicsTimeGetCurrent(&client->time_at_last_recv);
+
+    client->minor_version_number = CA_UKN_MINOR_VERSION;
+    client->seqNoOfReq = 0;
+
+    /*
+     * If we are talking to a new client flush to the old one
+     * in case we are holding UDP messages waiting to
+     * see if the next message is for this same client.
+     */
+    if (client->send.stk>sizeof(caHdr)) {
+        status = memcmp(&client->addr,
+            pAddr, sizeof(*pAddr));
+        if(status){
+            /*
+             * if the address is different
+             */
+            cas_send_dg_msg(client);
+            client->addr = *pAddr;
+        }
+    }
+    else {
+        client->addr = *pAddr;
+    }
+
+    if (CASDEBUG>1) {
+        char    buf[40];
+
+        ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+        errlogPrintf ("CAS: cast server msg of %d bytes from addr %s\n",
+            client->recv.cnt, buf);
+    }
+
+    if (CASDEBUG>2)
+        count = ellCount (&client->chanList);
+
+    status = camessage ( client );
+    if(status == RSRV_OK){
+        if(client->recv.cnt !=
+            client->recv.stk){
+            char buf[40];
+
+            ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+
+            epicsPrintf ("CAS: partial (damaged?) UDP msg of %d bytes from %s ?\n",
+                client->recv.cnt - client->recv.stk, buf);
+
+            epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
+                &client->time_at_last_recv);
+            epicsPrintf ("CAS: message received at %s\n", buf);
+        }
+    }
+    else if (CASDEBUG>0){
+        char buf[40];
+
+        ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+
+        epicsPrintf ("CAS: invalid (damaged?) UDP request from %s ?\n", buf);
+
+        epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
+            &client->time_at_last_recv);
+        epicsPrintf ("CAS: message received at %s\n", buf);
+    }
+
+    if (CASDEBUG>2) {
+        if ( ellCount (&client->chanList) ) {
+            errlogPrintf ("CAS: Fnd %d name matches (%d tot)\n",
+                ellCount(&client->chanList)-count,
+                ellCount(&client->chanList));
+        }
+    }
+}
+
+static void cast_recv_error(void)
+{
+    if (SOCKERRNO != SOCK_EINTR) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        epicsPrintf ("CAS: UDP recv error: %s\n",
+                sockErrBuf);
+        epicsThreadSleep(1.0);
+    }
+}
+
+#ifdef RSRV_MMSG
+
+/*
+ * Datagrams received with one recvmmsg().  CA clients send searches
+ * in frames of at most ETHERNET_MAX_UDP, so this has room for a jumbo
+ * frame.  Anything larger is truncated, and dropped.
+ */
+#define CAST_BATCH 16
+#define CAST_BATCH_BUF 9216
+
+typedef struct cast_batch {
+    struct mmsghdr msgs[CAST_BATCH];
+    struct iovec iov[CAST_BATCH];
+    struct sockaddr_in addr[CAST_BATCH];
+    char buf[CAST_BATCH][CAST_BATCH_BUF];
+} cast_batch;
+
+static void cast_datagram(struct client *client, cast_batch *pBatch, int i)
+{
+    struct msghdr *pHdr = &pBatch->msgs[i].msg_hdr;
+    unsigned nchars = pBatch->msgs[i].msg_len;
+
+    if ((pHdr->msg_flags & MSG_TRUNC) || nchars > client->recv.maxstk ||
+            pHdr->msg_namelen < sizeof(pBatch->addr[i]) ||
+            cast_ignored(&pBatch->addr[i]) || casudp_ctl != ctlRun) {
+        epicsAtomicIncrSizeT(&rsrvDatagramsDropped);
+        return;
+    }
+
+    memcpy(client->recv.buf, pBatch->buf[i], nchars);
+    cast_process(client, nchars, &pBatch->addr[i]);
+}
+
+/*
+ * cast_recv_batch
+ *
+ * receive and process the datagrams waiting, up to CAST_BATCH
+ */
+static void cast_recv_batch(struct client *client, SOCKET recv_sock,
+    cast_batch *pBatch)
+{
+    char done[CAST_BATCH];
+    int i, j, n;
+
+    for (i=0; i<CAST_BATCH; i++) {
+        struct msghdr *pHdr = &pBatch->msgs[i].msg_hdr;
+
+        memset(pHdr, 0, sizeof(*pHdr));
+        pHdr->msg_name = &pBatch->addr[i];
+        pHdr->msg_namelen = sizeof(pBatch->addr[i]);
+        pBatch->iov[i].iov_base = pBatch->buf[i];
+        pBatch->iov[i].iov_len = sizeof(pBatch->buf[i]);
+        pHdr->msg_iov = &pBatch->iov[i];
+        pHdr->msg_iovlen = 1;
+    }
+
+    n = recvmmsg(recv_sock, pBatch->msgs, CAST_BATCH, MSG_WAITFORONE, NULL);
+    if (n < 0) {
+        cast_recv_error();
+        return;
+    }
+
+    /*
+     * all datagrams of one sender in turn, so the replies to
+     * them are coalesced
+     */
+    memset(done, 0, sizeof(done));
+    for (i=0; i<n; i++) {
+        if (done[i])
+            continue;
+        for (j=i; j<n; j++) {
+            if (!done[j] &&
+                    pBatch->addr[j].sin_addr.s_addr == pBatch->addr[i].sin_addr.s_addr &&
+                    pBatch->addr[j].sin_port == pBatch->addr[i].sin_port) {
+                done[j] = 1;
+                cast_datagram(client, pBatch, j);
+            }
+        }
+    }
+}
+
+#endif /* RSRV_MMSG */
+
 /*
  * CAST_SERVER
  *
@@ -114,13 +313,15 @@ void cast_server(void *pParm)
 {
     rsrv_iface_config *conf = pParm;
     int                 status;
-    int                 count=0;
     int                 mysocket=0;
     struct sockaddr_in  new_recv_addr;
     osiSocklen_t        recv_addr_size;
     osiSockIoctl_t      nchars;
     SOCKET              recv_sock, reply_sock;
     struct client      *client;
+#ifdef RSRV_MMSG
+    cast_batch         *pBatch = malloc(sizeof(*pBatch));
+#endif
 
     recv_addr_size = sizeof(new_recv_addr);
 
@@ -147,6 +348,10 @@ void cast_server(void *pParm)
         conf->client = client;
     }
     client->udpRecv = recv_sock;
+#ifdef RSRV_MMSG
+    if (pBatch)
+        client->dgBatch = cas_dg_batch_create();
+#endif
 
     casAttachThreadToClient ( client );
 
@@ -161,107 +366,29 @@ void cast_server(void *pParm)
     epicsEventSignal(casudp_startStopEvent);
 
     while (TRUE) {
-        status = recvfrom (
-            recv_sock,
-            client->recv.buf,
-            client->recv.maxstk,
-            0,
-            (struct sockaddr *)&new_recv_addr,
-            &recv_addr_size);
-        if (status < 0) {
-            if (SOCKERRNO != SOCK_EINTR) {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString (
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-                epicsPrintf ("CAS: UDP recv error: %s\n",
-                        sockErrBuf);
-                epicsThreadSleep(1.0);
-            }
-
-        } else {
-            size_t idx;
-            for(idx=0; casIgnoreAddrs[idx]; idx++)
-            {
-                if(new_recv_addr.sin_addr.s_addr==casIgnoreAddrs[idx]) {
-                    status = -1; /* ignore */
-                    break;
-                }
-            }
+#ifdef RSRV_MMSG
+        if (pBatch && client->dgBatch) {
+            cast_recv_batch(client, recv_sock, pBatch);
         }
-
-        if (status >= 0 && casudp_ctl == ctlRun) {
-            client->recv.cnt = (unsigned) status;
-            client->recv.stk = 0ul;
-            epicsTimeGetCurrent(&client->time_at_last_recv);
-
-            client->minor_version_number = CA_UKN_MINOR_VERSION;
-            client->seqNoOfReq = 0;
-
-            /*
-             * If we are talking to a new client flush to the old one
-             * in case we are holding UDP messages waiting to
-             * see if the next message is for this same client.
-             */
-            if (client->send.stk>sizeof(caHdr)) {
-                status = memcmp(&client->addr,
-                    &new_recv_addr, recv_addr_size);
-                if(status){
-                    /*
-                     * if the address is different
-                     */
-                    cas_send_dg_msg(client);
-                    client->addr = new_recv_addr;
-                }
-            }
-            else {
-                client->addr = new_recv_addr;
-            }
-
-            if (CASDEBUG>1) {
-                char    buf[40];
-
-                ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-                errlogPrintf ("CAS: cast server msg of %d bytes from addr %s\n",
-                    client->recv.cnt, buf);
-            }
-
-            if (CASDEBUG>2)
-                count = ellCount (&client->chanList);
-
-            status = camessage ( client );
-            if(status == RSRV_OK){
-                if(client->recv.cnt !=
-                    client->recv.stk){
-                    char buf[40];
-
-                    ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-
-                    epicsPrintf ("CAS: partial (damaged?) UDP msg of %d bytes from %s ?\n",
-                        client->recv.cnt - client->recv.stk, buf);
-
-                    epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
-                        &client->time_at_last_recv);
-                    epicsPrintf ("CAS: message received at %s\n", buf);
-                }
+        else
+#endif
+        {
+            recv_addr_size = sizeof(new_recv_addr);
+            status = recvfrom (
+                recv_sock,
+                client->recv.buf,
+                client->recv.maxstk,
+                0,
+                (struct sockaddr *)&new_recv_addr,
+                &recv_addr_size);
+            if (status < 0) {
+                cast_recv_error();
             }
-            else if (CASDEBUG>0){
-                char buf[40];
-
-                ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-
-                epicsPrintf ("CAS: invalid (damaged?) UDP request from %s ?\n", buf);
-
-                epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
-                    &client->time_at_last_recv);
-                epicsPrintf ("CAS: message received at %s\n", buf);
+            else if (cast_ignored(&new_recv_addr) || casudp_ctl != ctlRun) {
+                epicsAtomicIncrSizeT(&rsrvDatagramsDropped);
             }
-
-            if (CASDEBUG>2) {
-                if ( ellCount (&client->chanList) ) {
-                    errlogPrintf ("CAS: Fnd %d name matches (%d tot)\n",
-                        ellCount(&client->chanList)-count,
-                        ellCount(&client->chanList));
-                }
+            else {
+                cast_process(client, (unsigned) status, &new_recv_addr);
             }
         }
 
@@ -279,10 +406,14 @@ void cast_server(void *pParm)
             cas_send_dg_msg (client);
             clean_addrq (client);
         }
+        cas_dg_batch_flush (client);
     }
 
     /* ATM never reached, just a placeholder */
 
+#ifdef RSRV_MMSG
+    free(pBatch);
+#endif
     if(!mysocket)
         client->sock = INVALID_SOCKET; /* only one cast_server should destroy the reply socket */
     destroy_client(client);
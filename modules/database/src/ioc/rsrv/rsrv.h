@@ -35,6 +35,8 @@ DBCORE_API int casClientInitiatingCurrentThread (
                         char * pBuf, size_t bufSize );
 DBCORE_API void casStatsFetch (
                         unsigned *pChanCount, unsigned *pConnCount );
+DBCORE_API void casSearchStatsFetch ( size_t *pReceived,
+                        size_t *pMatched, size_t *pDropped );
 
 #ifdef __cplusplus
 }
@@ -38,4 +38,6 @@ void rsrvRegistrar(void)
 }
 
 epicsExportAddress(int, CASDEBUG);
+epicsExportAddress(int, rsrvPayloadCacheBytes);
+epicsExportAddress(int, rsrvIoThreads);
 epicsExportRegistrar(rsrvRegistrar);
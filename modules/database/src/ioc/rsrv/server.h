@@ -30,6 +30,13 @@
 #include "epicsAssert.h"
 #include "osiSock.h"
 
+#if defined(__linux__)
+/* TCP clients may be served by a pool of epoll I/O threads */
+#  define RSRV_EPOLL
+/* UDP requests are received and replied to in batches */
+#  define RSRV_MMSG
+#endif
+
 /* a modified ca header with capacity for large arrays */
 typedef struct caHdrLargeArray {
     ca_uint32_t m_postsize;     /* size of message extension */
@@ -63,12 +70,38 @@ struct message_buffer {
   enum messageBufferType    type;
 };
 
+/*
+ * A payload too large for the TCP send buffer is kept in its own
+ * allocation and sent in place, following the send buffer bytes
+ * before offset.
+ */
+#define RSRV_SEND_SPLICES 8
+struct send_splice {
+  char                      *buf;
+  unsigned                  size;
+  /*! bytes allocated at buf */
+  unsigned                  capacity;
+  /*! position in client::send.buf */
+  unsigned                  offset;
+};
+
 extern epicsThreadPrivateId rsrvCurrentClient;
 
 typedef struct client {
   ELLNODE               node;
   /*! guarded by SEND_LOCK()  aka. client::lock */
   struct message_buffer send;
+  /*! guarded by SEND_LOCK(), committed payloads outside of send.buf */
+  struct send_splice    sendSplices[RSRV_SEND_SPLICES];
+  unsigned              nSendSplices;
+  size_t                sendSpliceBytes;
+  /*! reserved by cas_copy_in_header(), not yet committed */
+  char                  *pSendPayload;
+  unsigned              sendPayloadCapacity;
+  /*! guarded by SEND_LOCK(), sent payload buffers kept for reuse */
+  struct send_splice    sendSpares[RSRV_SEND_SPLICES];
+  unsigned              nSendSpares;
+  size_t                sendSpareBytes;
   /*! accessed by receive thread w/o locks cf. camsgtask() */
   struct message_buffer recv;
   epicsMutexId          lock;
@@ -93,6 +126,32 @@ typedef struct client {
   unsigned              recvBytesToDrain;
   unsigned              priority;
   char                  disconnect; /* disconnect detected */
+  /*! epoll I/O thread serving this client, NULL when it has its own thread */
+  struct rsrv_poller    *poller;
+  /*! unsent responses when poller!=NULL, guarded by sendQLock */
+  epicsMutexId          sendQLock;
+  ELLLIST               sendQ;
+  size_t                sendQBytes;
+  unsigned              pollEvents;
+  /*! I/O thread waits for a put callback before it processes more
+   *  requests, guarded by both rsrv_poller::lock and sendQLock */
+  char                  parked;
+  /*! a put callback completed, guarded by rsrv_poller::lock */
+  char                  parkResume;
+  /*! I/O thread only, the parked request has waited too long */
+  char                  parkTimedOut;
+  /*! I/O thread only, parkTime is when the parked request began to wait */
+  char                  parkWaiting;
+  epicsTimeStamp        parkTime;
+  ELLNODE               parkNode; /* rsrv_poller::parkedQ */
+  /*! the client asked for no events, guarded by sendQLock */
+  char                  eventsOff;
+  /*! events held while sendQ is full, guarded by sendQLock */
+  char                  eventsHeld;
+  /*! UDP only, replies collected for one sendmmsg() */
+  struct rsrv_dg_batch  *dgBatch;
+  /*! UDP only, search replies in send.buf */
+  unsigned              nSearchReplies;
 } client;
 
 /* Channel state shows which struct client list a
@@ -197,6 +256,8 @@ GLBLTYPE void               *rsrvLargeBufFreeListTCP;
 GLBLTYPE unsigned           rsrvSizeofLargeBufTCP;
 GLBLTYPE void               *rsrvPutNotifyFreeList;
 GLBLTYPE unsigned           rsrvChannelCount; /* locked by clientQlock */
+GLBLTYPE int                rsrvPayloadCacheBytes GLBLTYPE_INIT(16*1024*1024);
+GLBLTYPE int                rsrvIoThreads;
 
 GLBLTYPE epicsEventId       casudp_startStopEvent;
 GLBLTYPE epicsEventId       beacon_startStopEvent;
@@ -207,6 +268,12 @@ GLBLTYPE volatile enum ctl  castcp_ctl;
 
 GLBLTYPE unsigned int       threadPrios[5];
 
+/* UDP name search counters, updated with epicsAtomic */
+GLBLTYPE size_t             rsrvSearchesReceived;
+GLBLTYPE size_t             rsrvSearchesMatched;
+GLBLTYPE size_t             rsrvSearchesDropped;
+GLBLTYPE size_t             rsrvDatagramsDropped;
+
 #define CAS_HASH_TABLE_SIZE 4096
 
 #define SEND_LOCK(CLIENT) epicsMutexMustLock((CLIENT)->lock)
@@ -215,13 +282,31 @@ GLBLTYPE unsigned int       threadPrios[5];
 #define LOCK_CLIENTQ    epicsMutexMustLock (clientQlock);
 #define UNLOCK_CLIENTQ  epicsMutexUnlock (clientQlock);
 
+/* request handler status, the request is to be processed again later */
+#define RSRV_PARKED 1
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void camsgtask (void *client);
+int casPollAttach ( struct client *client );
+void casPollSend ( struct client *pclient );
+int casPollPark ( struct client *client );
+void casPollResume ( struct client *client );
+void casPollReport (unsigned level);
+void casPollEventsOff ( struct client *client, int off );
+void casPollStop (void);
+int rsrv_start_events ( struct client *client );
 void cas_send_bs_msg ( struct client *pclient, int lock_needed );
+size_t cas_send_pending ( struct client *pclient );
+int cas_send_some ( struct client *pclient, size_t skip );
+void cas_send_copy_out ( struct client *pclient, size_t skip, char *pDest );
+void cas_send_discard ( struct client *pclient );
+void cas_send_free_payloads ( struct client *pclient );
 void cas_send_dg_msg ( struct client *pclient );
+struct rsrv_dg_batch *cas_dg_batch_create ( void );
+void cas_dg_batch_flush ( struct client *pclient );
 void rsrv_online_notify_task (void *);
 void cast_server (void *);
 struct client *create_client ( SOCKET sock, int proto );
@@ -236,6 +321,8 @@ int rsrv_version_reply ( struct client *client );
 void rsrvFreePutNotify ( struct client *pClient,
                         struct rsrv_put_notify *pNotify );
 void initializePutNotifyFreeList (void);
+void initializePayloadCache (void);
+void rsrvPayloadCacheReport (void);
 unsigned rsrvSizeOfPutNotify ( struct rsrv_put_notify *pNotify );
 
 /*
@@ -246,7 +333,6 @@ void casExpandRecvBuffer ( struct client *pClient, ca_uint32_t size );
 /*
  * outgoing protocol maintenance
  */
-void casExpandSendBuffer ( struct client *pClient, ca_uint32_t size );
 int cas_copy_in_header (
     struct client *pClient, ca_uint16_t response, ca_uint32_t payloadSize,
     ca_uint16_t dataType, ca_uint32_t nElem, ca_uint32_t cid,
@@ -0,0 +1,183 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *   EPICS device support for the scan timing statistics of dbScan
+ *
+ *   ai:       INP "@<scan list> <statistic>"
+ *   stringin: INP "@<scan list>", name of the slowest record
+ *
+ *   The scan list is a periodic SCAN choice such as ".1 second", or
+ *   "I/O Intr <prio>", "Event <prio>" or "Once".  The statistic is
+ *   COUNT, or one of the times in seconds LATE_P50, LATE_P99, LATE_MAX,
+ *   EXEC_P50, EXEC_P99, EXEC_MAX and RECORD_MAX.  Scans are only timed
+ *   while the variable scanRecordTiming is set.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "dbDefs.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "epicsString.h"
+#include "recGbl.h"
+#include "devSup.h"
+
+#include "aiRecord.h"
+#include "stringinRecord.h"
+#include "epicsExport.h"
+
+static const struct {
+    const char *name;
+    size_t offset;
+} statistics[] = {
+    {"LATE_P50", offsetof(scanTimingStats, lateP50)},
+    {"LATE_P99", offsetof(scanTimingStats, lateP99)},
+    {"LATE_MAX", offsetof(scanTimingStats, lateMax)},
+    {"EXEC_P50", offsetof(scanTimingStats, execP50)},
+    {"EXEC_P99", offsetof(scanTimingStats, execP99)},
+    {"EXEC_MAX", offsetof(scanTimingStats, execMax)},
+    {"RECORD_MAX", offsetof(scanTimingStats, recordMax)},
+};
+#define STAT_COUNT -1
+
+typedef struct scanTimingDpvt {
+    int stat;       /* index into statistics[], or STAT_COUNT */
+    char list[1];   /* actually larger */
+} scanTimingDpvt;
+
+/* The scan lists exist only after init_record, look them up when read */
+static scanTimingDpvt *parseInp(dbCommon *prec, DBLINK *plink, int withStat)
+{
+    const char *parm;
+    const char *stat = NULL;
+    size_t len;
+    scanTimingDpvt *pdpvt;
+
+    if (plink->type != INST_IO) {
+        recGblRecordError(S_db_badField, prec,
+                          "devScanTiming: Illegal INP field");
+        return NULL;
+    }
+    parm = plink->value.instio.string;
+    len = strlen(parm);
+
+    if (withStat) {
+        stat = strrchr(parm, ' ');
+        if (!stat) {
+            recGblRecordError(S_db_badField, prec,
+                              "devScanTiming: No statistic in INP");
+            return NULL;
+        }
+        len = stat - parm;
+        stat++;
+    }
+
+    pdpvt = calloc(1, sizeof(scanTimingDpvt) + len);
+    if (!pdpvt)
+        return NULL;
+    memcpy(pdpvt->list, parm, len);
+
+    if (withStat) {
+        int i;
+
+        pdpvt->stat = -2;
+        if (!epicsStrCaseCmp(stat, "COUNT"))
+            pdpvt->stat = STAT_COUNT;
+        for (i = 0; i < NELEMENTS(statistics); i++)
+            if (!epicsStrCaseCmp(stat, statistics[i].name))
+                pdpvt->stat = i;
+        if (pdpvt->stat == -2) {
+            recGblRecordError(S_db_badField, prec,
+                              "devScanTiming: Bad statistic in INP");
+            free(pdpvt);
+            return NULL;
+        }
+    }
+    return pdpvt;
+}
+
+
+/********* ai record **********/
+static long init_ai(dbCommon *pcommon)
+{
+    aiRecord *prec = (aiRecord *)pcommon;
+
+    prec->dpvt = parseInp(pcommon, &prec->inp, 1);
+    if (!prec->dpvt) {
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    return 0;
+}
+
+static long read_ai(aiRecord *prec)
+{
+    scanTimingDpvt *pdpvt = (scanTimingDpvt *)prec->dpvt;
+    scanTimingStats stats;
+
+    if (!pdpvt) return -1;
+
+    if (scanTimingGet(pdpvt->list, 0, &stats)) {
+        recGblSetSevr(prec, READ_ALARM, INVALID_ALARM);
+        return 2;
+    }
+
+    if (pdpvt->stat == STAT_COUNT)
+        prec->val = stats.count;
+    else
+        prec->val = *(double *)((char *)&stats +
+            statistics[pdpvt->stat].offset);
+    prec->udf = FALSE;
+    return 2;
+}
+
+aidset devAiScanTiming = {
+    {6, NULL, NULL, init_ai, NULL},
+    read_ai,  NULL
+};
+epicsExportAddress(dset, devAiScanTiming);
+
+
+/********** stringin record **********/
+static long init_si(dbCommon *pcommon)
+{
+    stringinRecord *prec = (stringinRecord *)pcommon;
+
+    prec->dpvt = parseInp(pcommon, &prec->inp, 0);
+    if (!prec->dpvt) {
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    return 0;
+}
+
+static long read_si(stringinRecord *prec)
+{
+    scanTimingDpvt *pdpvt = (scanTimingDpvt *)prec->dpvt;
+    scanTimingStats stats;
+
+    if (!pdpvt) return -1;
+
+    if (scanTimingGet(pdpvt->list, 0, &stats)) {
+        recGblSetSevr(prec, READ_ALARM, INVALID_ALARM);
+        return 0;
+    }
+
+    strncpy(prec->val, stats.recordMaxName, sizeof(prec->val));
+    prec->val[sizeof(prec->val) - 1] = 0;
+    prec->udf = FALSE;
+    return 0;
+}
+
+stringindset devSiScanTiming = {
+    {5, NULL, NULL, init_si, NULL},
+    read_si
+};
+epicsExportAddress(dset, devSiScanTiming);
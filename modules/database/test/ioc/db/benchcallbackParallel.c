@@ -0,0 +1,154 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Parallel callback throughput benchmark.
+ *
+ * A number of producer threads, standing in for I/O Intr scans and
+ * asynchronous device completions, request short callbacks as fast as
+ * the queue accepts them, with 1..N parallel callback threads and the
+ * locked and the lock-free callback queues.  Reports callbacks/sec and
+ * how often a request found the queue full.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "callback.h"
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NPRODUCERS 2
+#define NPENDING 256      /* callbacks in flight per producer */
+#define NREQUESTS 200000  /* per producer */
+
+typedef struct {
+    epicsCallback cb;
+    int busy;
+    size_t count;
+} benchCallback;
+
+typedef struct {
+    epicsEventId done;
+    benchCallback cbs[NPENDING];
+    size_t nfull;
+} benchProducer;
+
+static volatile double sink;
+
+static void benchCB(epicsCallback *pcb)
+{
+    benchCallback *bcb;
+    double x = 1.0;
+    int i;
+
+    callbackGetUser(bcb, pcb);
+    /* a little work, like a short record processing */
+    for(i=0; i<50; i++)
+        x = x * 1.000001 + 0.5;
+    sink = x;
+    bcb->count++;
+    epicsAtomicSetIntT(&bcb->busy, 0);
+}
+
+static void producerThread(void *raw)
+{
+    benchProducer *prod = (benchProducer *) raw;
+    int i;
+
+    for(i=0; i<NREQUESTS; i++) {
+        benchCallback *bcb = &prod->cbs[i % NPENDING];
+
+        /* wait for the previous request of this callback to run */
+        while(epicsAtomicGetIntT(&bcb->busy))
+            epicsThreadSleep(0.0);
+        epicsAtomicSetIntT(&bcb->busy, 1);
+        while(callbackRequest(&bcb->cb)) {
+            prod->nfull++;
+            epicsThreadSleep(0.0);
+        }
+    }
+    for(i=0; i<NPENDING; i++) {
+        while(epicsAtomicGetIntT(&prod->cbs[i].busy))
+            epicsThreadSleep(0.0);
+    }
+    epicsEventMustTrigger(prod->done);
+}
+
+static void runBench(int lockFree, int nthreads)
+{
+    benchProducer *prods = callocMustSucceed(NPRODUCERS, sizeof(*prods),
+                                             "runBench");
+    size_t count = 0, nfull = 0;
+    epicsUInt64 start;
+    double elapsed;
+    int p, i;
+
+    callbackLockFree = lockFree;
+    callbackParallelThreads(nthreads, "");
+    callbackInit();
+
+    for(p=0; p<NPRODUCERS; p++) {
+        prods[p].done = epicsEventMustCreate(epicsEventEmpty);
+        for(i=0; i<NPENDING; i++) {
+            callbackSetCallback(benchCB, &prods[p].cbs[i].cb);
+            callbackSetPriority(priorityMedium, &prods[p].cbs[i].cb);
+            callbackSetUser(&prods[p].cbs[i], &prods[p].cbs[i].cb);
+        }
+    }
+
+    start = epicsMonotonicGet();
+    for(p=0; p<NPRODUCERS; p++) {
+        epicsThreadMustCreate("benchProd", epicsThreadPriorityLow,
+                              epicsThreadGetStackSize(epicsThreadStackSmall),
+                              producerThread, &prods[p]);
+    }
+    for(p=0; p<NPRODUCERS; p++) {
+        epicsEventMustWait(prods[p].done);
+        epicsEventDestroy(prods[p].done);
+        nfull += prods[p].nfull;
+        for(i=0; i<NPENDING; i++)
+            count += prods[p].cbs[i].count;
+    }
+    elapsed = (epicsMonotonicGet() - start) * 1e-9;
+
+    callbackStop();
+    callbackCleanup();
+    callbackLockFree = 0;
+
+    testOk(count == NPRODUCERS * NREQUESTS,
+           "%s queue, %d threads: %lu of %d callbacks run",
+           lockFree ? "lock-free" : "locked", nthreads,
+           (unsigned long) count, NPRODUCERS * NREQUESTS);
+    testDiag("%.0f callbacks/s, %lu requests found the queue full",
+             count / elapsed, (unsigned long) nfull);
+
+    free(prods);
+}
+
+MAIN(benchcallbackParallel)
+{
+    int noCpus = epicsThreadGetCPUs();
+    int nthreads[8], nconfig = 0, n, i;
+
+    nthreads[nconfig++] = 1;
+    for(n=2; n<noCpus && nconfig<NELEMENTS(nthreads)-1; n*=2)
+        nthreads[nconfig++] = n;
+    nthreads[nconfig++] = noCpus > 2 ? noCpus : 2;
+
+    testPlan(2*nconfig);
+
+    for(i=0; i<nconfig; i++) {
+        runBench(0, nthreads[i]);
+        runBench(1, nthreads[i]);
+    }
+
+    return testDone();
+}
@@ -0,0 +1,115 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Channel creation benchmark.
+ *
+ * Creates and deletes channels to every field of a number of records,
+ * as a CA server does when clients connect, with the field names looked
+ * up by the perfect hash of the record type and by a binary search of
+ * the sorted field names.  Reports channels created per second.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "epicsStdio.h"
+#include "epicsTime.h"
+
+#include "dbAccess.h"
+#include "dbBase.h"
+#include "dbChannel.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NRECORDS 1000
+#define NPASSES 5
+
+typedef char chanName[48];
+
+static chanName *names;
+static int nnames;
+
+static void runBench(dbRecordType *precordType, int hashed)
+{
+    short *fldHash = precordType->fldHash;
+    epicsUInt64 start;
+    double elapsed;
+    int i, pass, nok = 0;
+
+    if(!hashed)
+        precordType->fldHash = NULL;
+
+    start = epicsMonotonicGet();
+    for(pass=0; pass<NPASSES; pass++) {
+        for(i=0; i<nnames; i++) {
+            dbChannel *chan = dbChannelCreate(names[i]);
+            if(chan) {
+                nok++;
+                dbChannelDelete(chan);
+            }
+        }
+    }
+    elapsed = (epicsMonotonicGet() - start) * 1e-9;
+
+    precordType->fldHash = fldHash;
+
+    testOk(nok == NPASSES * nnames, "%s: %d of %d channels created",
+           hashed ? "perfect hash" : "binary search", nok,
+           NPASSES * nnames);
+    testDiag("%.0f dbChannelCreate()/s", NPASSES * nnames / elapsed);
+}
+
+MAIN(benchdbChannel)
+{
+    DBENTRY entry;
+    dbRecordType *precordType;
+    int r, f;
+
+    testPlan(2);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    dbInitEntry(pdbbase, &entry);
+    if(dbFindRecordType(&entry, "x"))
+        testAbort("No record type x");
+    precordType = entry.precordType;
+    for(r=0; r<NRECORDS; r++) {
+        char name[16];
+        epicsSnprintf(name, sizeof(name), "ch%d", r);
+        if(dbCreateRecord(&entry, name))
+            testAbort("Can't create %s", name);
+    }
+    dbFinishEntry(&entry);
+
+    testIocInitOk();
+
+    names = callocMustSucceed(NRECORDS * precordType->no_fields,
+                              sizeof(chanName), "benchdbChannel");
+    for(r=0; r<NRECORDS; r++) {
+        for(f=0; f<precordType->no_fields; f++) {
+            epicsSnprintf(names[nnames++], sizeof(chanName), "ch%d.%s", r,
+                          precordType->papFldDes[f]->name);
+        }
+    }
+    testDiag("%d records of type %s with %d fields", NRECORDS,
+             precordType->name, precordType->no_fields);
+
+    runBench(precordType, 0);
+    runBench(precordType, 1);
+
+    free(names);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,275 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Event queue contention benchmark.
+ *
+ * A number of "scan" threads post DBE_VALUE events for their own share
+ * of the records while a number of event users subscribe to every record.
+ * Reports posts/sec and the distribution of time spent in db_post_events()
+ * for the mutex and the lock-free event queue implementations.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define EPICS_PRIVATE_API
+
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "dbAccess.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "db_field_log.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NRECORDS 128
+#define NBUCKETS 64
+#define FINALVAL -1
+
+typedef struct {
+    int irec;
+    struct benchUser *user;
+    dbChannel *chan;
+    dbEventSubscription sub;
+} benchSub;
+
+typedef struct benchUser {
+    dbEventCtx ctx;
+    benchSub subs[NRECORDS];
+    int last[NRECORDS];
+    size_t nupdates;
+} benchUser;
+
+typedef struct {
+    epicsEventId done;
+    xRecord *recs[NRECORDS];
+    int first, last; /* record range [first, last) */
+    size_t niter;
+    double elapsed;
+    epicsUInt64 maxns;
+    size_t hist[NBUCKETS]; /* log2(ns) of each db_post_events() */
+} benchScan;
+
+static xRecord *records[NRECORDS];
+
+static void benchCallback(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    benchSub *sub = (benchSub *) user_arg;
+    epicsInt32 val;
+
+    memcpy(&val, dbfl_pfield(pfl), sizeof(val));
+    sub->user->last[sub->irec] = val;
+    epicsAtomicIncrSizeT(&sub->user->nupdates);
+}
+
+static unsigned log2ns(epicsUInt64 ns)
+{
+    unsigned n = 0;
+    while(ns >>= 1)
+        n++;
+    return n < NBUCKETS ? n : NBUCKETS-1;
+}
+
+static void scanThread(void *raw)
+{
+    benchScan *scan = (benchScan *) raw;
+    epicsUInt64 start = epicsMonotonicGet();
+    size_t i;
+    int r;
+
+    for(i=0; i<scan->niter; i++) {
+        for(r=scan->first; r<scan->last; r++) {
+            xRecord *prec = records[r];
+            epicsUInt64 t0, dt;
+
+            dbScanLock((dbCommon*)prec);
+            prec->val++;
+            t0 = epicsMonotonicGet();
+            db_post_events(prec, &prec->val, DBE_VALUE);
+            dt = epicsMonotonicGet() - t0;
+            dbScanUnlock((dbCommon*)prec);
+
+            scan->hist[log2ns(dt)]++;
+            if(dt > scan->maxns)
+                scan->maxns = dt;
+        }
+    }
+
+    scan->elapsed = (epicsMonotonicGet() - start) * 1e-9;
+    epicsEventMustTrigger(scan->done);
+}
+
+/* upper bound of the bucket containing the given fraction of samples */
+static double percentile(const size_t *hist, size_t total, double frac)
+{
+    size_t sum = 0;
+    unsigned b;
+
+    for(b=0; b<NBUCKETS; b++) {
+        sum += hist[b];
+        if(sum >= frac*total)
+            break;
+    }
+    return (double)(2ull << b) * 1e-3; /* us */
+}
+
+static int allFinal(benchUser *users, int nusers)
+{
+    int u, r;
+    for(u=0; u<nusers; u++)
+        for(r=0; r<NRECORDS; r++)
+            if(users[u].last[r] != FINALVAL)
+                return 0;
+    return 1;
+}
+
+static void runBench(int lockFree, int nscan, int nusers, size_t niter)
+{
+    benchUser *users = callocMustSucceed(nusers, sizeof(*users), "runBench");
+    benchScan *scans = callocMustSucceed(nscan, sizeof(*scans), "runBench");
+    size_t hist[NBUCKETS];
+    size_t total = 0, nupdates = 0;
+    epicsUInt64 maxns = 0;
+    double elapsed = 0.0;
+    int u, r, s, wait;
+
+    dbEventLockFree = lockFree;
+
+    for(u=0; u<nusers; u++) {
+        users[u].ctx = db_init_events();
+        if(!users[u].ctx)
+            testAbort("db_init_events() fails");
+        if(db_start_events(users[u].ctx, "benchEv", NULL, NULL,
+                           epicsThreadPriorityCAServerLow))
+            testAbort("db_start_events() fails");
+
+        for(r=0; r<NRECORDS; r++) {
+            benchSub *sub = &users[u].subs[r];
+            sub->irec = r;
+            sub->user = &users[u];
+            sub->chan = dbChannelCreate(records[r]->name);
+            if(!sub->chan || dbChannelOpen(sub->chan))
+                testAbort("Can't open channel to %s", records[r]->name);
+            sub->sub = db_add_event(users[u].ctx, sub->chan,
+                                    benchCallback, sub, DBE_VALUE);
+            if(!sub->sub)
+                testAbort("db_add_event() fails");
+            db_event_enable(sub->sub);
+        }
+    }
+
+    for(s=0; s<nscan; s++) {
+        scans[s].done = epicsEventMustCreate(epicsEventEmpty);
+        scans[s].first = s * NRECORDS / nscan;
+        scans[s].last = (s + 1) * NRECORDS / nscan;
+        scans[s].niter = niter;
+    }
+    for(s=0; s<nscan; s++) {
+        epicsThreadMustCreate("benchScan", epicsThreadPriorityScanLow,
+                              epicsThreadGetStackSize(epicsThreadStackSmall),
+                              scanThread, &scans[s]);
+    }
+
+    memset(hist, 0, sizeof(hist));
+    for(s=0; s<nscan; s++) {
+        unsigned b;
+        epicsEventMustWait(scans[s].done);
+        epicsEventDestroy(scans[s].done);
+        for(b=0; b<NBUCKETS; b++) {
+            hist[b] += scans[s].hist[b];
+            total += scans[s].hist[b];
+        }
+        if(scans[s].maxns > maxns)
+            maxns = scans[s].maxns;
+        if(scans[s].elapsed > elapsed)
+            elapsed = scans[s].elapsed;
+    }
+
+    /* the latest value must always be delivered */
+    for(r=0; r<NRECORDS; r++) {
+        dbScanLock((dbCommon*)records[r]);
+        records[r]->val = FINALVAL;
+        db_post_events(records[r], &records[r]->val, DBE_VALUE);
+        dbScanUnlock((dbCommon*)records[r]);
+    }
+    for(wait=0; wait<1000 && !allFinal(users, nusers); wait++)
+        epicsThreadSleep(0.01);
+
+    for(u=0; u<nusers; u++)
+        nupdates += epicsAtomicGetSizeT(&users[u].nupdates);
+
+    testOk(allFinal(users, nusers),
+           "%s queue, %d scan threads, %d event users: final values delivered",
+           lockFree ? "lock-free" : "mutex", nscan, nusers);
+    testDiag("%.0f posts/s, %.0f updates/s, post latency us p50 %.2f"
+             " p99 %.2f p99.9 %.2f max %.2f",
+             total/elapsed, nupdates/elapsed,
+             percentile(hist, total, 0.5),
+             percentile(hist, total, 0.99),
+             percentile(hist, total, 0.999),
+             maxns*1e-3);
+
+    for(u=0; u<nusers; u++) {
+        for(r=0; r<NRECORDS; r++) {
+            db_cancel_event(users[u].subs[r].sub);
+            dbChannelDelete(users[u].subs[r].chan);
+        }
+        db_close_events(users[u].ctx);
+    }
+
+    free(scans);
+    free(users);
+    dbEventLockFree = 0;
+}
+
+MAIN(benchdbEvent)
+{
+    static const int config[][2] = {
+        {1, 1}, {2, 2}, {4, 4}, {4, 16}, {8, 8}, {8, 32},
+    };
+    unsigned i;
+    int r;
+
+    testPlan(2*NELEMENTS(config));
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for(r=0; r<NRECORDS; r++) {
+        char macros[16];
+        epicsSnprintf(macros, sizeof(macros), "N=%d", r);
+        testdbReadDatabase("benchdbEvent.db", NULL, macros);
+    }
+
+    testIocInitOk();
+
+    for(r=0; r<NRECORDS; r++) {
+        char name[16];
+        epicsSnprintf(name, sizeof(name), "ev%d", r);
+        records[r] = (xRecord*)testdbRecordPtr(name);
+    }
+
+    for(i=0; i<NELEMENTS(config); i++) {
+        runBench(0, config[i][0], config[i][1], 2000);
+        runBench(1, config[i][0], config[i][1], 2000);
+    }
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
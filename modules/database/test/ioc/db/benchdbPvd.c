@@ -0,0 +1,235 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Record name lookup benchmark.
+ *
+ * A database of half a million records is searched by a number of
+ * threads with dbChannelTest(), as the CA server does for each name
+ * search it receives, for names that exist (hits) and for names hosted
+ * elsewhere (misses).  Reports searches/sec before and after the
+ * lookup filter of the process variable directory is built, and the
+ * dbPvdStats report.  Then searches run while other records are deleted
+ * and created again, so that the directory frees what it has replaced
+ * under the lookups.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "dbAccess.h"
+#include "dbChannel.h"
+#include "dbStaticLib.h"
+#include "dbStaticPvt.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NRECORDS 500000
+#define NSEARCHES 1000000 /* of each kind, shared by the threads */
+#define MAXTHREADS 4
+#define NCHURN 1000 /* records deleted and created again */
+
+typedef char pvName[24];
+
+static pvName *hitNames, *missNames;
+
+typedef struct {
+    epicsEventId done;
+    const pvName *names;
+    int first, count;
+    int nfound;
+} benchSearch;
+
+static void searchThread(void *raw)
+{
+    benchSearch *search = (benchSearch *) raw;
+    int i;
+
+    for(i=0; i<search->count; i++) {
+        /* a stride through the table, not in order of creation */
+        int n = (int) (((search->first + i) * 7919ull) % NRECORDS);
+        if(dbChannelTest(search->names[n]) == 0)
+            search->nfound++;
+    }
+    epicsEventMustTrigger(search->done);
+}
+
+static double runSearches(const pvName *names, int nthreads, int *nfound)
+{
+    benchSearch search[MAXTHREADS];
+    epicsUInt64 start;
+    int t;
+
+    *nfound = 0;
+    for(t=0; t<nthreads; t++) {
+        search[t].done = epicsEventMustCreate(epicsEventEmpty);
+        search[t].names = names;
+        search[t].first = t * (NSEARCHES / nthreads);
+        search[t].count = NSEARCHES / nthreads;
+        search[t].nfound = 0;
+    }
+
+    start = epicsMonotonicGet();
+    for(t=0; t<nthreads; t++) {
+        epicsThreadMustCreate("benchSearch", epicsThreadPriorityCAServerLow,
+                              epicsThreadGetStackSize(epicsThreadStackSmall),
+                              searchThread, &search[t]);
+    }
+    for(t=0; t<nthreads; t++) {
+        epicsEventMustWait(search[t].done);
+        epicsEventDestroy(search[t].done);
+        *nfound += search[t].nfound;
+    }
+    return NSEARCHES / ((epicsMonotonicGet() - start) * 1e-9);
+}
+
+static void runBench(const char *mode, int nthreads)
+{
+    double hitRate, missRate;
+    int hits, falseHits;
+
+    hitRate = runSearches(hitNames, nthreads, &hits);
+    missRate = runSearches(missNames, nthreads, &falseHits);
+
+    testOk(hits == NSEARCHES && falseHits == 0,
+           "%s, %d threads: %d of %d hits found, %d misses found",
+           mode, nthreads, hits, NSEARCHES, falseHits);
+    testDiag("%.0f hit searches/s, %.0f miss searches/s", hitRate, missRate);
+}
+
+static int churnStop;
+
+static void churnThread(void *raw)
+{
+    epicsEventId done = (epicsEventId) raw;
+    DBENTRY entry;
+    int cycles = 0;
+    int r;
+
+    dbInitEntry(pdbbase, &entry);
+    while(!epicsAtomicGetIntT(&churnStop)) {
+        for(r=0; r<NCHURN; r++) {
+            pvName name;
+            epicsSnprintf(name, sizeof(name), "churn%d", r);
+            if(dbFindRecord(&entry, name) || dbDeleteRecord(&entry))
+                testAbort("Can't delete %s", name);
+        }
+        if(dbFindRecordType(&entry, "x"))
+            testAbort("No record type x");
+        for(r=0; r<NCHURN; r++) {
+            pvName name;
+            epicsSnprintf(name, sizeof(name), "churn%d", r);
+            if(dbCreateRecord(&entry, name))
+                testAbort("Can't create %s", name);
+        }
+        cycles++;
+        /* let the searches run, we preempt them in mid lookup */
+        epicsThreadSleep(0.001);
+    }
+    dbFinishEntry(&entry);
+    testDiag("%d records deleted and created %d times", NCHURN, cycles);
+    epicsEventMustTrigger(done);
+}
+
+static void runChurn(void)
+{
+    epicsEventId done = epicsEventMustCreate(epicsEventEmpty);
+    int hits, r, nfound = 0;
+
+    epicsAtomicSetIntT(&churnStop, 0);
+    epicsThreadMustCreate("benchChurn", epicsThreadPriorityCAServerHigh,
+                          epicsThreadGetStackSize(epicsThreadStackSmall),
+                          churnThread, done);
+    runSearches(hitNames, MAXTHREADS, &hits);
+    epicsAtomicSetIntT(&churnStop, 1);
+    epicsEventMustWait(done);
+    epicsEventDestroy(done);
+
+    for(r=0; r<NCHURN; r++) {
+        pvName name;
+        epicsSnprintf(name, sizeof(name), "churn%d", r);
+        if(dbChannelTest(name) == 0)
+            nfound++;
+    }
+    testOk(hits == NSEARCHES && nfound == NCHURN,
+           "churn, %d threads: %d of %d hits found, %d of %d churned",
+           MAXTHREADS, hits, NSEARCHES, nfound, NCHURN);
+}
+
+MAIN(benchdbPvd)
+{
+    static const int nthreads[] = {1, MAXTHREADS};
+    DBENTRY entry;
+    epicsUInt64 start;
+    unsigned i;
+    int r;
+
+    testPlan(2*NELEMENTS(nthreads) + 1);
+
+    hitNames = callocMustSucceed(NRECORDS, sizeof(pvName), "benchdbPvd");
+    missNames = callocMustSucceed(NRECORDS, sizeof(pvName), "benchdbPvd");
+    for(r=0; r<NRECORDS; r++) {
+        epicsSnprintf(hitNames[r], sizeof(pvName), "BL%02d:pvd%d.VAL",
+                      r % 100, r);
+        epicsSnprintf(missNames[r], sizeof(pvName), "BL%02d:elsewhere%d",
+                      r % 100, r);
+    }
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    start = epicsMonotonicGet();
+    dbInitEntry(pdbbase, &entry);
+    if(dbFindRecordType(&entry, "x"))
+        testAbort("No record type x");
+    for(r=0; r<NRECORDS; r++) {
+        pvName name;
+        epicsSnprintf(name, sizeof(name), "BL%02d:pvd%d", r % 100, r);
+        if(dbCreateRecord(&entry, name))
+            testAbort("Can't create %s", name);
+    }
+    for(r=0; r<NCHURN; r++) {
+        pvName name;
+        epicsSnprintf(name, sizeof(name), "churn%d", r);
+        if(dbCreateRecord(&entry, name))
+            testAbort("Can't create %s", name);
+    }
+    dbFinishEntry(&entry);
+    testDiag("%d records created in %.2f s", NRECORDS,
+             (epicsMonotonicGet() - start) * 1e-9);
+
+    for(i=0; i<NELEMENTS(nthreads); i++)
+        runBench("no filter", nthreads[i]);
+
+    /* as iocInit() does */
+    start = epicsMonotonicGet();
+    dbPvdFilterInit(pdbbase);
+    testDiag("lookup filter built in %.3f s",
+             (epicsMonotonicGet() - start) * 1e-9);
+
+    for(i=0; i<NELEMENTS(nthreads); i++)
+        runBench("filter", nthreads[i]);
+
+    dbPvdStats(pdbbase);
+
+    runChurn();
+    dbPvdDump(pdbbase, 0);
+
+    testdbCleanup();
+    free(missNames);
+    free(hitNames);
+
+    return testDone();
+}
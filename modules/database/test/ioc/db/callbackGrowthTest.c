@@ -0,0 +1,148 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "callback.h"
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "epicsEvent.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+/*
+ * A callback thread is held up while many more requests are made than
+ * its queue holds.  With enough growth allowed they must all be accepted
+ * and run in the order of the requests, beyond the memory allowed some
+ * are rejected.
+ */
+
+#define QUEUE_SIZE 20
+#define NREQUESTS 2000
+
+static epicsCallback blocker;
+static epicsCallback cbs[NREQUESTS];
+static epicsEventId blocked, release, done;
+static int order[NREQUESTS];
+static int nrun, outOfOrder;
+
+static void blockCallback(epicsCallback *pcb)
+{
+    epicsEventMustTrigger(blocked);
+    epicsEventMustWait(release);
+}
+
+static void countCallback(epicsCallback *pcb)
+{
+    int i = (int) (size_t) pcb->user;
+
+    if (nrun && i <= order[nrun-1])
+        outOfOrder++;
+    order[nrun++] = i;
+}
+
+static void doneCallback(epicsCallback *pcb)
+{
+    epicsEventMustTrigger(done);
+}
+
+static void runRequests(int lockFree, int kbytes)
+{
+    callbackQueueStats stats;
+    epicsCallback last;
+    int i, accepted = 0;
+    const char *mode = lockFree ? "lock-free" : "locked";
+
+    testDiag("%s queue of %d, growth by up to %d KiB", mode, QUEUE_SIZE,
+             kbytes);
+
+    callbackLockFree = lockFree;
+    callbackQueueTiming = 1;
+    callbackSetQueueSize(QUEUE_SIZE);
+    callbackSetQueueGrowth(kbytes);
+    callbackParallelThreads(1, "");
+    callbackInit();
+
+    nrun = outOfOrder = 0;
+    callbackRequest(&blocker);
+    epicsEventMustWait(blocked);
+
+    for (i = 0; i < NREQUESTS; i++) {
+        if (callbackRequest(&cbs[i]) == 0)
+            accepted++;
+    }
+
+    testOk1(callbackQueueStatus(0, &stats) == 0);
+    testOk(stats.numUsed[priorityMedium] == accepted,
+           "%d requests queued, %d accepted",
+           stats.numUsed[priorityMedium], accepted);
+    testOk(stats.maxUsed[priorityMedium] >= accepted,
+           "high-water mark %d", stats.maxUsed[priorityMedium]);
+    if (kbytes >= 64) {
+        testOk(accepted == NREQUESTS, "all %d requests accepted", NREQUESTS);
+        testOk(stats.numOverflow[priorityMedium] == 0, "no overflows");
+    } else {
+        testOk(accepted > QUEUE_SIZE && accepted < NREQUESTS,
+               "%d of %d requests accepted", accepted, NREQUESTS);
+        testOk(stats.numOverflow[priorityMedium] > 0, "%d overflows",
+               stats.numOverflow[priorityMedium]);
+    }
+
+    epicsEventMustTrigger(release);
+
+    /* queued behind the accepted requests once they have started */
+    callbackSetCallback(doneCallback, &last);
+    callbackSetPriority(priorityMedium, &last);
+    while (callbackRequest(&last))
+        epicsEventWaitWithTimeout(done, 0.01);
+    epicsEventMustWait(done);
+
+    testOk(nrun == accepted, "%d of %d requests run", nrun, accepted);
+    testOk(outOfOrder == 0, "%d requests run out of order", outOfOrder);
+
+    callbackQueueShow(0);
+
+    callbackStop();
+    callbackCleanup();
+
+    callbackLockFree = 0;
+    callbackQueueTiming = 0;
+    callbackSetQueueGrowth(0);
+}
+
+MAIN(callbackGrowthTest)
+{
+    int i;
+
+    testPlan(4*7);
+
+    blocked = epicsEventMustCreate(epicsEventEmpty);
+    release = epicsEventMustCreate(epicsEventEmpty);
+    done = epicsEventMustCreate(epicsEventEmpty);
+
+    callbackSetCallback(blockCallback, &blocker);
+    callbackSetPriority(priorityMedium, &blocker);
+    for (i = 0; i < NREQUESTS; i++) {
+        callbackSetCallback(countCallback, &cbs[i]);
+        callbackSetPriority(priorityMedium, &cbs[i]);
+        callbackSetUser((size_t) i, &cbs[i]);
+    }
+
+    runRequests(0, 64);
+    runRequests(1, 64);
+    /* one overflow block */
+    runRequests(0, 5);
+    runRequests(1, 5);
+
+    callbackSetQueueSize(2000);
+
+    epicsEventDestroy(blocked);
+    epicsEventDestroy(release);
+    epicsEventDestroy(done);
+
+    return testDone();
+}
@@ -27,6 +27,7 @@
 #include "dbAccess.h"
 #include "epicsStdio.h"
 #include "dbEvent.h"
+#include "dbCaTest.h"
 #include "shareLib.h"
 
 /* Declarations from cadef.h and db_access.h which we can't include here */
@@ -366,6 +367,7 @@ static void testArrayLink(unsigned nsrc, unsigned ntarg)
     char buf[100];
     arrRecord *psrc, *ptarg;
     DBLINK *psrclnk;
+    caLink *pca;
     epicsInt32 *bufsrc, *buftarg, *tmpbuf;
     long nReq;
     unsigned num_min, num_max;
@@ -439,6 +441,15 @@ static void testArrayLink(unsigned nsrc, unsigned ntarg)
     }
     dbScanUnlock((dbCommon*)psrc);
 
+    pca = (caLink *)psrclnk->value.pv_link.pvt;
+    epicsMutexMustLock(pca->lock);
+    if (ntarg > 1)
+        testOk(pca->pgetSpare && pca->pgetSpare != pca->pgetNative,
+               "previous array value kept as spare buffer");
+    else
+        testOk(!pca->pgetSpare, "scalar value copied in place");
+    epicsMutexUnlock(pca->lock);
+
     fillArray(bufsrc, psrc->nelm, 2);
     /* write buffer allocated on first put */
     putLink(psrclnk, DBR_LONG, bufsrc, psrc->nelm);
@@ -610,9 +621,84 @@ static void testCAC(void)
     free(buftarg2);
 }
 
+#define NWORKERLINKS 16
+
+static void testWorkers(void)
+{
+    caWorker *workers[NWORKERLINKS];
+    unsigned long nconnects = 0;
+    int nchans = 0, nworkers = 0;
+    int i, j;
+
+    testDiag("CA links spread over several worker threads");
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    for (i = 0; i < NWORKERLINKS; i++) {
+        char macros[16];
+
+        epicsSnprintf(macros, sizeof(macros), "N=%d", i);
+        testdbReadDatabase("dbCaLinkTest4.db", NULL, macros);
+    }
+
+    dbCaWorkers = 4;
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOp("%d", dbCaWorkerCount, ==, 4);
+    testOk(dbCaWorkerContext(0) == dbCaClientContext &&
+           dbCaWorkerContext(3) && dbCaWorkerContext(3) != dbCaClientContext &&
+           !dbCaWorkerContext(4),
+           "each worker has its own context, worker 0 dbCaClientContext");
+
+    for (i = 0; i < NWORKERLINKS; i++) {
+        char name[16];
+        xRecord *psrc;
+        caLink *pca;
+
+        epicsSnprintf(name, sizeof(name), "wsource%d", i);
+        psrc = (xRecord *)testdbRecordPtr(name);
+        testdbCaWaitForConnect(&psrc->lnk);
+
+        dbScanLock((dbCommon *)psrc);
+        pca = (caLink *)psrc->lnk.value.pv_link.pvt;
+        workers[i] = pca->worker;
+        dbScanUnlock((dbCommon *)psrc);
+
+        for (j = 0; j < i; j++)
+            if (workers[j] == workers[i])
+                break;
+        if (j == i)
+            nworkers++;
+    }
+    testOk(nworkers > 1, "links on %d workers", nworkers);
+
+    for (i = 0; i < dbCaWorkerCount; i++) {
+        epicsMutexMustLock(dbCaWorkerList[i]->workListLock);
+        nconnects += dbCaWorkerList[i]->nConnects;
+        nchans += dbCaWorkerList[i]->chanCount;
+        epicsMutexUnlock(dbCaWorkerList[i]->workListLock);
+    }
+    testOp("%lu", nconnects, ==, (unsigned long)NWORKERLINKS);
+    testOp("%d", nchans, ==, NWORKERLINKS);
+
+    dbcar(NULL, 0);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    dbCaWorkers = 1;
+}
+
 MAIN(dbCaLinkTest)
 {
-    testPlan(101);
+    testPlan(110);
     testNativeLink();
     testStringLink();
     testCP();
@@ -622,5 +708,6 @@ MAIN(dbCaLinkTest)
     testArrayLink(10,10);
     testreTargetTypeChange();
     testCAC();
+    testWorkers();
     return testDone();
 }
@@ -0,0 +1,307 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Event queue depth, growth and statistics */
+
+#include <string.h>
+
+#define EPICS_PRIVATE_API
+#define USE_TYPED_DBEVENT
+
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+
+#include "dbAccess.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "db_field_log.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+#include "arrRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static epicsEventId entered, gate;
+static int blockNext;
+static int lastVal;
+static xRecord *prec;
+static arrRecord *parr;
+
+#define NARRPOSTS 3
+
+typedef struct {
+    int n;
+    long no_elements[NARRPOSTS];
+    void *pfield[NARRPOSTS];
+    epicsInt32 val[NARRPOSTS][4];
+} arrUpdates;
+
+static void testCallback(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    epicsInt32 val;
+
+    memcpy(&val, dbfl_pfield(pfl), sizeof(val));
+    epicsAtomicSetIntT(&lastVal, val);
+    if(epicsAtomicGetIntT(&blockNext)) {
+        epicsAtomicSetIntT(&blockNext, 0);
+        epicsEventMustTrigger(entered);
+        epicsEventMustWait(gate);
+    }
+}
+
+static void arrCallback(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    arrUpdates *upd = (arrUpdates *) user_arg;
+    int n = upd->n;
+
+    if(n < NARRPOSTS && pfl) {
+        upd->no_elements[n] = pfl->no_elements;
+        upd->pfield[n] = dbfl_pfield(pfl);
+        if(pfl->no_elements <= 4)
+            memcpy(upd->val[n], dbfl_pfield(pfl),
+                   pfl->no_elements * sizeof(epicsInt32));
+    }
+    epicsAtomicSetIntT(&upd->n, n + 1);
+    if(epicsAtomicGetIntT(&blockNext)) {
+        epicsAtomicSetIntT(&blockNext, 0);
+        epicsEventMustTrigger(entered);
+        epicsEventMustWait(gate);
+    }
+}
+
+/* Post base, base+1, ... starting at element off of the ring buffer */
+static void postArr(epicsInt32 base, epicsUInt32 off)
+{
+    epicsInt32 *buf = (epicsInt32 *) parr->bptr;
+    int i;
+
+    dbScanLock((dbCommon*)parr);
+    for(i=0; i<4; i++)
+        buf[(off + i) % 4] = base + i;
+    parr->nord = 4;
+    parr->off = off;
+    db_post_events(parr, &parr->val, DBE_VALUE);
+    dbScanUnlock((dbCommon*)parr);
+}
+
+static void postVal(epicsInt32 val)
+{
+    dbScanLock((dbCommon*)prec);
+    prec->val = val;
+    db_post_events(prec, &prec->val, DBE_VALUE);
+    dbScanUnlock((dbCommon*)prec);
+}
+
+/* Stall the event task in a callback while posting nposts events */
+static void backlogPass(int pass, int nposts)
+{
+    int i, wait;
+
+    epicsAtomicSetIntT(&blockNext, 1);
+    postVal(pass*1000);
+    epicsEventMustWait(entered);
+    for(i=1; i<=nposts; i++)
+        postVal(pass*1000 + i);
+    epicsEventMustTrigger(gate);
+
+    for(wait=0; wait<500; wait++) {
+        if(epicsAtomicGetIntT(&lastVal) == pass*1000 + nposts)
+            break;
+        epicsThreadSleep(0.01);
+    }
+    testOk(epicsAtomicGetIntT(&lastVal) == pass*1000 + nposts,
+           "pass %d latest value %d delivered", pass,
+           epicsAtomicGetIntT(&lastVal));
+    /* let the event task finish this pass */
+    epicsThreadSleep(0.1);
+}
+
+static void testQueue(int lockFree)
+{
+    dbEventCtx ctx;
+    dbChannel *chan;
+    dbEventSubscription sub;
+    int pass;
+
+    testDiag("%s event queue", lockFree ? "lock-free" : "mutex");
+
+    dbEventLockFree = lockFree;
+    ctx = db_init_events();
+    dbEventLockFree = 0;
+    if(!ctx)
+        testAbort("db_init_events() fails");
+
+    /* one entry per event, ie. no room for a second of the same event */
+    testOk1(db_event_set_queue_entries(ctx, 1, 2) == DB_EVENT_OK);
+    testOk1(db_start_events(ctx, "testEv", NULL, NULL,
+                            epicsThreadPriorityCAServerLow) == DB_EVENT_OK);
+
+    chan = dbChannelCreate("x");
+    if(!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel");
+    sub = db_add_event(ctx, chan, testCallback, NULL, DBE_VALUE);
+    if(!sub)
+        testAbort("db_add_event() fails");
+    db_event_enable(sub);
+
+    testOk(db_event_set_queue_entries(ctx, 4, 0) == DB_EVENT_ERROR,
+           "Can't change queue entries after db_add_event()");
+
+    backlogPass(1, 50);
+    testOk(db_event_npend_max(sub) == 1, "npendMax %lu == 1",
+           db_event_npend_max(sub));
+    testOk(sub->nreplace == 49, "nreplace %lu == 49", sub->nreplace);
+
+    /* the mutex queue grows after several backlogged passes */
+    for(pass=2; pass<=5; pass++)
+        backlogPass(pass, 50);
+
+    testOk(db_event_npend_max(sub) > 1 ? !lockFree : lockFree,
+           "npendMax %lu %s", db_event_npend_max(sub),
+           lockFree ? "lock-free queue doesn't grow" : "queue has grown");
+
+    db_cancel_event(sub);
+    dbChannelDelete(chan);
+    db_close_events(ctx);
+}
+
+static void testLockFreeEntries(void)
+{
+    dbEventCtx ctx;
+    dbChannel *chan;
+    dbEventSubscription sub;
+
+    testDiag("lock-free event queue with two entries per event");
+
+    dbEventLockFree = 1;
+    ctx = db_init_events();
+    dbEventLockFree = 0;
+    if(!ctx)
+        testAbort("db_init_events() fails");
+
+    testOk1(db_event_set_queue_entries(ctx, 2, 0) == DB_EVENT_OK);
+    testOk1(db_start_events(ctx, "testEv", NULL, NULL,
+                            epicsThreadPriorityCAServerLow) == DB_EVENT_OK);
+
+    chan = dbChannelCreate("x");
+    if(!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel");
+    sub = db_add_event(ctx, chan, testCallback, NULL, DBE_VALUE);
+    if(!sub)
+        testAbort("db_add_event() fails");
+    db_event_enable(sub);
+
+    backlogPass(10, 50);
+    /* replacement starts with EVENTSPERQUE (36) entries left */
+    testOk(db_event_npend_max(sub) == 36, "npendMax %lu == 36",
+           db_event_npend_max(sub));
+    testOk(sub->nreplace == 14, "nreplace %lu == 14", sub->nreplace);
+
+    db_cancel_event(sub);
+    dbChannelDelete(chan);
+    db_close_events(ctx);
+}
+
+/* Queued updates of an array keep their own copy of the elements */
+static void testArraySnapshots(void)
+{
+    dbEventCtx ctx;
+    dbChannel *chan;
+    dbEventSubscription subA, subB;
+    arrUpdates updA, updB;
+    int i, wait;
+
+    testDiag("array snapshots");
+
+    memset(&updA, 0, sizeof(updA));
+    memset(&updB, 0, sizeof(updB));
+
+    ctx = db_init_events();
+    if(!ctx)
+        testAbort("db_init_events() fails");
+    testOk1(db_start_events(ctx, "testEv", NULL, NULL,
+                            epicsThreadPriorityCAServerLow) == DB_EVENT_OK);
+
+    chan = dbChannelCreate("arr");
+    if(!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel");
+    subA = db_add_event(ctx, chan, arrCallback, &updA, DBE_VALUE);
+    subB = db_add_event(ctx, chan, arrCallback, &updB, DBE_VALUE);
+    if(!subA || !subB)
+        testAbort("db_add_event() fails");
+    db_event_enable(subA);
+    db_event_enable(subB);
+
+    dbEventArraySnapshots = 1;
+    epicsAtomicSetIntT(&blockNext, 1);
+    postArr(0, 0);
+    epicsEventMustWait(entered);
+    postArr(10, 1);
+    postArr(20, 3);
+    epicsEventMustTrigger(gate);
+    dbEventArraySnapshots = 0;
+
+    for(wait=0; wait<500; wait++) {
+        if(epicsAtomicGetIntT(&updA.n) >= NARRPOSTS &&
+           epicsAtomicGetIntT(&updB.n) >= NARRPOSTS)
+            break;
+        epicsThreadSleep(0.01);
+    }
+    testOk(updA.n == NARRPOSTS && updB.n == NARRPOSTS,
+           "%d and %d updates delivered", updA.n, updB.n);
+
+    for(i=0; i<NARRPOSTS; i++) {
+        epicsInt32 base = i*10;
+        testOk(updA.no_elements[i] == 4 && updB.no_elements[i] == 4 &&
+               updA.val[i][0] == base && updA.val[i][3] == base + 3 &&
+               updB.val[i][0] == base && updB.val[i][3] == base + 3,
+               "update %d has its own elements %d..%d", i,
+               updA.val[i][0], updA.val[i][3]);
+        testOk(updA.pfield[i] == updB.pfield[i] &&
+               updA.pfield[i] != parr->bptr,
+               "update %d shares one copy between subscriptions", i);
+    }
+
+    db_cancel_event(subA);
+    db_cancel_event(subB);
+    dbChannelDelete(chan);
+    db_close_events(ctx);
+}
+
+MAIN(dbEventTest)
+{
+    testPlan(35);
+
+    entered = epicsEventMustCreate(epicsEventEmpty);
+    gate = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+    testdbReadDatabase("dbEventTest.db", NULL, NULL);
+
+    testIocInitOk();
+    prec = (xRecord*)testdbRecordPtr("x");
+    parr = (arrRecord*)testdbRecordPtr("arr");
+
+    testQueue(0);
+    testQueue(1);
+    testLockFreeEntries();
+    testArraySnapshots();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    epicsEventDestroy(gate);
+    epicsEventDestroy(entered);
+
+    return testDone();
+}
@@ -14,6 +14,7 @@
 
 #include "epicsSpin.h"
 #include "epicsMutex.h"
+#include "epicsEvent.h"
 #include "dbCommon.h"
 #include "epicsThread.h"
 
@@ -414,12 +415,87 @@ static void testLinkNOP(void)
     testdbCleanup();
 }
 
+static epicsEventId contender;
+
+static void contendThread(void *raw)
+{
+    dbCommon *prec = raw;
+
+    dbScanLock(prec);
+    dbScanUnlock(prec);
+    epicsEventMustTrigger(contender);
+}
+
+static void testStats(void)
+{
+    dbCommon *precA, *precB;
+    dbLockSetStats stats;
+    testDiag("Test lock set statistics");
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    precA = testdbRecordPtr("reca");
+    precB = testdbRecordPtr("recb");
+    contender = epicsEventMustCreate(epicsEventEmpty);
+
+    dbLockStats = 1;
+
+    dbScanLock(precA);
+    dbScanLock(precA);
+    epicsThreadSleep(0.05);
+    dbScanUnlock(precA);
+    dbScanUnlock(precA);
+
+    testOk1(dbLockGetStats(precA, &stats)==0);
+    testOk(stats.nLocks==2 && stats.nContended==0,
+           "%u locks, %u contended", (unsigned)stats.nLocks,
+           (unsigned)stats.nContended);
+    testOk(stats.holdMax >= 40000000u && stats.holdTotal == stats.holdMax,
+           "held once for %.3f ms", stats.holdMax * 1e-6);
+
+    dbScanLock(precB);
+    epicsThreadMustCreate("contender", epicsThreadPriorityMedium,
+                          epicsThreadGetStackSize(epicsThreadStackSmall),
+                          contendThread, precB);
+    epicsThreadSleep(0.1);
+    dbScanUnlock(precB);
+    epicsEventMustWait(contender);
+
+    testOk1(dbLockGetStats(precB, &stats)==0);
+    testOk(stats.nLocks==2 && stats.nContended==1,
+           "%u locks, %u contended", (unsigned)stats.nLocks,
+           (unsigned)stats.nContended);
+    testOk(stats.waitMax >= 50000000u && stats.waitTotal == stats.waitMax,
+           "waited %.3f ms", stats.waitMax * 1e-6);
+
+    dbLockStatsShow(0, 2);
+
+    dbLockStatsReset();
+    testOk1(dbLockGetStats(precB, &stats)==0);
+    testOk1(stats.nLocks==0 && stats.waitMax==0 && stats.holdMax==0);
+
+    dbLockStats = 0;
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+    epicsEventDestroy(contender);
+}
+
 MAIN(dbLockTest)
 {
 #ifdef LOCKSET_DEBUG
-    testPlan(100);
+    testPlan(108);
 #else
-    testPlan(88);
+    testPlan(96);
 #endif
     testSets();
     testSingleLock();
@@ -428,5 +504,6 @@ MAIN(dbLockTest)
     testLinkMake();
     testLinkChange();
     testLinkNOP();
+    testStats();
     return testDone();
 }
@@ -0,0 +1,100 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "dbAccess.h"
+#include "dbTest.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+/*
+ * Processing times collected by dbProcess() after dbProfileEnable(),
+ * including the records processed through forward links.
+ */
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void slowHook(xRecord *prec)
+{
+    epicsThreadSleep(0.01);
+}
+
+static dbProfile prof(dbCommon *prec)
+{
+    dbProfile p = {0, 0, 0};
+
+    dbProfileGet(prec, &p, 0);
+    return p;
+}
+
+static epicsUInt64 profCount(dbCommon *prec)
+{
+    return prof(prec).count;
+}
+
+MAIN(dbProfileTest)
+{
+    dbCommon *phead, *ptail, *pother;
+    dbProfile p;
+    int i;
+
+    testPlan(21);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbProfileTest.db", NULL, NULL);
+
+    phead = testdbRecordPtr("head");
+    ptail = testdbRecordPtr("tail");
+    pother = testdbRecordPtr("other");
+    ((xRecord *)ptail)->clbk = slowHook;
+
+    testIocInitOk();
+
+    testDiag("Not profiling");
+    testdbPutFieldOk("head.PROC", DBF_LONG, 1);
+    testOk1(!dbProfileGet(phead, &p, 0) && !dbProfileGet(ptail, &p, 0));
+
+    testDiag("Setting dbProcessProfile alone collects nothing after iocInit");
+    dbProcessProfile = 1;
+    testdbPutFieldOk("head.PROC", DBF_LONG, 1);
+    testOk1(!dbProfileGet(phead, &p, 0));
+
+    testDiag("Profiling");
+    testOk1(dbProfileEnable(1) == 0 && dbProcessProfile == 1);
+    for (i = 0; i < 3; i++)
+        testdbPutFieldOk("head.PROC", DBF_LONG, 1);
+    testOk1(dbProfileEnable(0) == 0 && dbProcessProfile == 0);
+
+    testOk(profCount(phead) == 3, "head processed %u times",
+           (unsigned) profCount(phead));
+    testOk(profCount(ptail) == 3, "tail processed %u times",
+           (unsigned) profCount(ptail));
+    testOk1(dbProfileGet(pother, &p, 0) && p.count == 0);
+    testOk(prof(ptail).max >= 10000000u, "tail max %.3f ms",
+           prof(ptail).max * 1e-6);
+    testOk(prof(phead).total >= prof(ptail).total,
+           "head total %.3f ms includes tail total %.3f ms",
+           prof(phead).total * 1e-6, prof(ptail).total * 1e-6);
+    testOk1(prof(phead).max <= prof(phead).total);
+
+    testdbPutFieldOk("head.PROC", DBF_LONG, 1);
+    testOk(profCount(phead) == 3, "not counted while disabled");
+
+    testOk1(dbProfileShow(1) == 0);
+
+    testOk1(dbProfileReset() == 0);
+    testOk1(profCount(phead) == 0 && profCount(ptail) == 0);
+    testOk1(prof(phead).total == 0 && prof(ptail).max == 0);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
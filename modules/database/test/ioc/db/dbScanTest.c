@@ -13,12 +13,15 @@
 #include <string.h>
 
 #include "dbScan.h"
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
+#include "epicsThread.h"
 
 #include "dbUnitTest.h"
 #include "testMain.h"
 
 #include "dbAccess.h"
+#include "dbLockPvt.h"
 #include "errlog.h"
 
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
@@ -66,9 +69,127 @@ static void testOnce(void)
     epicsEventDestroy(waiter);
 }
 
+static epicsEventId blocked, release;
+static int ncomplete;
+
+static void onceBlock(void *junk, dbCommon *prec)
+{
+    epicsEventMustTrigger(blocked);
+    epicsEventMustWait(release);
+}
+
+static void onceCount(void *junk, dbCommon *prec)
+{
+    epicsAtomicIncrIntT(&ncomplete);
+    epicsEventMustTrigger(waiter);
+}
+
+static void testCoalesce(void)
+{
+    scanOnceQueueStats before, after;
+    scanOnceQueueCounts countsBefore, countsAfter;
+    int i;
+
+    testDiag("check scanOnceCoalesced()");
+    waiter = epicsEventMustCreate(epicsEventEmpty);
+    blocked = epicsEventMustCreate(epicsEventEmpty);
+    release = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = testdbRecordPtr("reca");
+
+    /* hold up the once thread while requests are made */
+    scanOnceCallback(prec, onceBlock, NULL);
+    epicsEventMustWait(blocked);
+    testOk1(scanOnceQueueStatus(0, &before) == 0 &&
+            scanOnceQueueCountsGet(&countsBefore) == 0);
+
+    for (i = 0; i < 10; i++)
+        testOk1(scanOnceCoalesced(prec) == 0);
+    testOk1(prec->lset->oncq);
+    testOk1(scanOnceQueueStatus(0, &after) == 0 &&
+            scanOnceQueueCountsGet(&countsAfter) == 0);
+    testOk(after.numUsed == before.numUsed + 1, "%d requests queued",
+           after.numUsed - before.numUsed);
+    testOk(countsAfter.numCoalesced == countsBefore.numCoalesced + 9,
+           "%lu coalesced", (unsigned long)
+           (countsAfter.numCoalesced - countsBefore.numCoalesced));
+
+    ncomplete = 0;
+    scanOnceCallback(prec, onceCount, NULL);
+    epicsEventMustTrigger(release);
+    epicsEventMustWait(waiter);
+
+    testOk1(!prec->lset->oncq);
+    testOk1(scanOnceQueueCountsGet(&countsAfter) == 0);
+    /* the coalesced request and the last one */
+    testOk(countsAfter.numExecuted == countsBefore.numExecuted + 2,
+           "%lu executed", (unsigned long)
+           (countsAfter.numExecuted - countsBefore.numExecuted));
+    scanOnceQueueShow(0);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+    epicsEventDestroy(waiter);
+    epicsEventDestroy(blocked);
+    epicsEventDestroy(release);
+}
+
+#define NREQUESTS 100
+
+static void testOnceThreads(void)
+{
+    int i, waited;
+
+    testDiag("check several scanOnce threads");
+    waiter = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    scanOnceThreads = 3;
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk1(epicsThreadGetId("scanOnce-2") != NULL);
+
+    ncomplete = 0;
+    for (i = 0; i < NREQUESTS; i++)
+        scanOnceCallback(testdbRecordPtr(i % 2 ? "reca" : "recb"),
+                         onceCount, NULL);
+    for (waited = 0; epicsAtomicGetIntT(&ncomplete) < NREQUESTS &&
+         waited < 100; waited++)
+        epicsEventWaitWithTimeout(waiter, 0.1);
+    testOk(ncomplete == NREQUESTS, "%d requests completed", ncomplete);
+
+    testIocShutdownOk();
+    scanOnceThreads = 1;
+
+    testOk1(epicsThreadGetId("scanOnce-2") == NULL);
+
+    testdbCleanup();
+    epicsEventDestroy(waiter);
+}
+
 MAIN(dbScanTest)
 {
-    testPlan(3);
+    testPlan(3 + 18 + 3);
     testOnce();
+    testCoalesce();
+    testOnceThreads();
     return testDone();
 }
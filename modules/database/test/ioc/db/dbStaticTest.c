@@ -9,10 +9,12 @@
 #include <errlog.h>
 #include <osiFileName.h>
 #include <dbAccess.h>
+#include <dbChannel.h>
 #include <dbStaticLib.h>
 #include <dbStaticPvt.h>
 #include <dbUnitTest.h>
 #include <testMain.h>
+#include <epicsStdio.h>
 #include <epicsString.h>
 
 
@@ -321,6 +323,99 @@ static void testDbVerify(const char *record)
     dbFinishEntry(&entry);
 }
 
+/* Records and aliases added or removed after the lookup filter was built */
+static void testPvdFilter(void)
+{
+    DBENTRY entry;
+    char name[32];
+    int i, nfound = 0;
+
+    testDiag("testPvdFilter()");
+
+    dbInitEntry(pdbbase, &entry);
+    if(dbFindRecordType(&entry, "x"))
+        testAbort("No record type x");
+    /* enough to grow the filter */
+    for(i=0; i<1000; i++) {
+        epicsSnprintf(name, sizeof(name), "testfilt%d", i);
+        if(dbCreateRecord(&entry, name))
+            testAbort("Can't create %s", name);
+    }
+    testOk1(dbCreateAlias(&entry, "testfiltalias")==0);
+    dbFinishEntry(&entry);
+
+    for(i=0; i<1000; i++) {
+        epicsSnprintf(name, sizeof(name), "testfilt%d.VAL", i);
+        if(dbChannelTest(name)==0)
+            nfound++;
+    }
+    testOk(nfound==1000, "%d of 1000 new records found", nfound);
+    testEntryPresent("testfiltalias");
+
+    dbInitEntry(pdbbase, &entry);
+    for(i=0; i<1000; i++) {
+        epicsSnprintf(name, sizeof(name), "testfilt%d", i);
+        if(dbFindRecord(&entry, name) || dbDeleteRecord(&entry))
+            testAbort("Can't delete %s", name);
+    }
+    dbFinishEntry(&entry);
+
+    testEntryRemoved("testfilt0");
+    testEntryRemoved("testfilt999");
+    testEntryRemoved("testfiltalias");
+    testEntryPresent("testrec");
+    testEntryPresent("testalias3");
+}
+
+/* Every field name found through the field name hash, and no others */
+static void testFieldHash(void)
+{
+    static const char * const absent[] = {"VAX", "VALX", "VA", "V", "Z",
+                                          "_", "NAMES", "DESCRIPTION"};
+    DBENTRY entry;
+    int nfields = 0, nfound = 0, nabsent = 0;
+    long status;
+    unsigned i;
+
+    testDiag("testFieldHash()");
+
+    dbInitEntry(pdbbase, &entry);
+    for(status = dbFirstRecordType(&entry); !status;
+        status = dbNextRecordType(&entry)) {
+        dbRecordType *precordType = entry.precordType;
+        DBENTRY recEntry;
+        int f;
+
+        testOk(precordType->fldHash != NULL,
+               "Record type %s has a field name hash", precordType->name);
+
+        dbInitEntry(pdbbase, &recEntry);
+        recEntry.precordType = precordType;
+        if(dbFirstRecord(&recEntry))
+            continue;
+        for(f=0; f<precordType->no_fields; f++) {
+            const char *name = precordType->papFldDes[f]->name;
+
+            nfields++;
+            if(dbFindFieldPart(&recEntry, &name)==0 && recEntry.indfield==f)
+                nfound++;
+        }
+        for(i=0; i<NELEMENTS(absent); i++) {
+            const char *name = absent[i];
+
+            if(dbFindFieldPart(&recEntry, &name)==S_dbLib_fieldNotFound)
+                nabsent++;
+        }
+        dbFinishEntry(&recEntry);
+    }
+    dbFinishEntry(&entry);
+
+    testOk(nfields > 0 && nfound==nfields, "%d of %d fields found",
+           nfound, nfields);
+    testOk(nabsent > 0 && nabsent % NELEMENTS(absent) == 0,
+           "%d absent field names not found", nabsent);
+}
+
 static void testWrongAliasRecord(const char *filename)
 {
     FILE *fp = NULL;
@@ -341,7 +436,7 @@ MAIN(dbStaticTest)
     char *ldirDup;
     FILE *fp = NULL;
 
-    testPlan(340);
+    testPlan(352);
     testdbPrepare();
 
     testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
@@ -435,8 +530,12 @@ MAIN(dbStaticTest)
 
     testDbVerify("testrec");
 
+    testFieldHash();
+
     testIocShutdownOk();
 
+    testPvdFilter();
+
     testdbCleanup();
 
     return testDone();
@@ -20,18 +20,22 @@
 int testdbConvert(void);
 int callbackTest(void);
 int callbackParallelTest(void);
+int callbackGrowthTest(void);
 int dbStateTest(void);
 int dbServerTest(void);
 int dbCaStatsTest(void);
 int dbShutdownTest(void);
 int dbScanTest(void);
 int scanIoTest(void);
+int scanShardTest(void);
+int dbProfileTest(void);
 int dbLockTest(void);
 int dbPutLinkTest(void);
 int dbStaticTest(void);
 int dbCaLinkTest(void);
 int dbDbLinkTest(void);
 int testDbChannel(void);
+int dbEventTest(void);
 int chfPluginTest(void);
 int arrShorthandTest(void);
 int recGblCheckDeadbandTest(void);
@@ -43,18 +47,22 @@ void epicsRunDbTests(void)
     runTest(testdbConvert);
     runTest(callbackTest);
     runTest(callbackParallelTest);
+    runTest(callbackGrowthTest);
     runTest(dbStateTest);
     runTest(dbServerTest);
     runTest(dbCaStatsTest);
     runTest(dbShutdownTest);
     runTest(dbScanTest);
     runTest(scanIoTest);
+    runTest(scanShardTest);
+    runTest(dbProfileTest);
     runTest(dbLockTest);
     runTest(dbPutLinkTest);
     runTest(dbStaticTest);
     runTest(dbCaLinkTest);
     runTest(dbDbLinkTest);
     runTest(testDbChannel);
+    runTest(dbEventTest);
     runTest(arrShorthandTest);
     runTest(recGblCheckDeadbandTest);
     runTest(chfPluginTest);
@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMessageQueue.h"
 #include "epicsPrint.h"
@@ -296,14 +297,136 @@ static void testMultiThreading(void)
     }
 }
 
+#define NBATCH 8
+
+typedef struct {
+    int processed[NBATCH];
+    int completed[NBATCH];
+    epicsEventId blocked;
+    epicsEventId release;
+} testbatch;
+
+static void testcbbatch(xpriv *priv, void *raw)
+{
+    testbatch *td = raw;
+
+    epicsAtomicIncrIntT(&td->processed[priv->drv->group]);
+}
+
+static void testcompbatch(void *raw, IOSCANPVT scan, int prio)
+{
+    int *completed = raw;
+
+    epicsAtomicIncrIntT(completed);
+}
+
+static void testblockbatch(epicsCallback *pcb)
+{
+    testbatch *td;
+
+    callbackGetUser(td, pcb);
+    epicsEventMustTrigger(td->blocked);
+    epicsEventMustWait(td->release);
+}
+
+static int testwaitbatch(testbatch *td, int count)
+{
+    int i, tries;
+
+    for(tries=0; tries<100; tries++) {
+        for(i=0; i<NBATCH; i++)
+            if(epicsAtomicGetIntT(&td->completed[i]) < count)
+                break;
+        if(i==NBATCH)
+            break;
+        epicsThreadSleep(0.05);
+    }
+    /* catch any extra scans */
+    epicsThreadSleep(0.1);
+    for(i=0; i<NBATCH; i++)
+        if(td->processed[i]!=count || td->completed[i]!=count)
+            return 0;
+    return 1;
+}
+
+static void testBatch(void)
+{
+    testbatch data;
+    epicsCallback blocker;
+    IOSCANBATCH batch;
+    xdrv *drvs[NBATCH];
+    unsigned int added = 0x2;
+    int i;
+
+    memset(&data, 0, sizeof(data));
+    data.blocked = epicsEventMustCreate(epicsEventEmpty);
+    data.release = epicsEventMustCreate(epicsEventEmpty);
+
+    testDiag("Test batched I/O Intr scanning");
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    /* one record on each of NBATCH scan lists */
+    for(i=0; i<NBATCH; i++) {
+        loadRecord(i, 0, "MEDIUM");
+        drvs[i] = xdrv_add(i, &testcbbatch, &data);
+        scanIoSetComplete(drvs[i]->scan, &testcompbatch, &data.completed[i]);
+    }
+
+    callbackParallelThreads(1, "MEDIUM");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    /* three lists per callback */
+    scanIoBatchInit(&batch, 3);
+
+    callbackSetCallback(testblockbatch, &blocker);
+    callbackSetPriority(priorityMedium, &blocker);
+    callbackSetUser(&data, &blocker);
+    callbackRequest(&blocker);
+    epicsEventMustWait(data.blocked);
+
+    for(i=0; i<NBATCH; i++)
+        added &= scanIoBatchAdd(batch, drvs[i]->scan);
+    testOk(added==0x2, "all lists added on MEDIUM (0x%x)", added);
+    testOk1(scanIoBatchAdd(batch, drvs[0]->scan)==0);
+    testOk1(scanIoBatchRequest(batch)==0x2);
+    testOk1(scanIoBatchRequest(batch)==0x2);
+
+    epicsEventMustTrigger(data.release);
+    testOk(testwaitbatch(&data, 1), "each list processed and completed once");
+
+    testDiag("Add the lists again once processed");
+    added = 0x2;
+    for(i=0; i<NBATCH; i++)
+        added &= scanIoBatchAdd(batch, drvs[i]->scan);
+    testOk(added==0x2, "all lists added again (0x%x)", added);
+    testOk1(scanIoBatchRequest(batch)==0x2);
+    testOk(testwaitbatch(&data, 2), "each list processed and completed twice");
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    xdrv_reset();
+
+    epicsEventDestroy(data.blocked);
+    epicsEventDestroy(data.release);
+}
+
 MAIN(scanIoTest)
 {
-    testPlan(152);
+    testPlan(160);
     testSingleThreading();
     testDiag("run a second time to verify shutdown and restart works");
     testSingleThreading();
     testMultiThreading();
     testDiag("run a second time to verify shutdown and restart works");
     testMultiThreading();
+    testBatch();
     return testDone();
 }
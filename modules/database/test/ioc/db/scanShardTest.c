@@ -0,0 +1,137 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "dbUnitTest.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+/*
+ * A periodic scan list processed by several shard threads.  Records of
+ * PHAS 1 must only be processed once all records of PHAS 0 have been in
+ * the same period, and of two records in one lock set the first in the
+ * list must be processed first.
+ */
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NPHASE 16               /* records of each PHAS */
+#define NRECS (2*NPHASE + 2)    /* and the chain */
+#define CHAIN_A (2*NPHASE)
+#define CHAIN_B (2*NPHASE + 1)
+#define NSHARDS 4
+
+static int nproc[NRECS];
+static epicsThreadId procThread[NRECS];
+static int phaseFaults, chainFaults;
+
+static void procHook(xRecord *prec)
+{
+    int i = prec->i32;
+    int k = epicsAtomicIncrIntT(&nproc[i]);
+    int j;
+
+    procThread[i] = epicsThreadGetIdSelf();
+
+    if (i < NPHASE) {
+        for (j = NPHASE; j < 2*NPHASE; j++)
+            if (epicsAtomicGetIntT(&nproc[j]) < k - 1)
+                epicsAtomicIncrIntT(&phaseFaults);
+    } else if (i < 2*NPHASE) {
+        for (j = 0; j < NPHASE; j++)
+            if (epicsAtomicGetIntT(&nproc[j]) < k)
+                epicsAtomicIncrIntT(&phaseFaults);
+    } else if (i == CHAIN_B) {
+        if (epicsAtomicGetIntT(&nproc[CHAIN_A]) < k)
+            epicsAtomicIncrIntT(&chainFaults);
+    }
+}
+
+static int minProcessed(void)
+{
+    int i, min = epicsAtomicGetIntT(&nproc[0]);
+
+    for (i = 1; i < NRECS; i++)
+        if (epicsAtomicGetIntT(&nproc[i]) < min)
+            min = epicsAtomicGetIntT(&nproc[i]);
+    return min;
+}
+
+MAIN(scanShardTest)
+{
+    char macros[32];
+    int i, j, nthreads = 0, waited;
+
+    testPlan(5);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    for (i = 0; i < 2*NPHASE; i++) {
+        epicsSnprintf(macros, sizeof(macros), "N=%d,PHAS=%d", i, i / NPHASE);
+        testdbReadDatabase("scanShardTest.db", NULL, macros);
+    }
+    epicsSnprintf(macros, sizeof(macros), "A=%d,B=%d", CHAIN_A, CHAIN_B);
+    testdbReadDatabase("scanShardChain.db", NULL, macros);
+
+    for (i = 0; i < NRECS; i++) {
+        char name[16];
+        xRecord *prec;
+
+        if (i == CHAIN_A)
+            strcpy(name, "chainA");
+        else if (i == CHAIN_B)
+            strcpy(name, "chainB");
+        else
+            epicsSnprintf(name, sizeof(name), "ss%d", i);
+        prec = (xRecord *)testdbRecordPtr(name);
+        prec->clbk = procHook;
+    }
+
+    scanPeriodicShards = NSHARDS;
+    testIocInitOk();
+
+    for (waited = 0; minProcessed() < 5 && waited < 100; waited++)
+        epicsThreadSleep(0.1);
+    testOk(minProcessed() >= 5, "all records processed %d times or more",
+           minProcessed());
+
+    scanppl(0.1);
+
+    testIocShutdownOk();
+    scanPeriodicShards = 0;
+
+    testOk(phaseFaults == 0, "%d records processed before a lower PHAS",
+           phaseFaults);
+    testOk(chainFaults == 0, "%d lock set members processed out of order",
+           chainFaults);
+    testOk1(procThread[CHAIN_A] == procThread[CHAIN_B]);
+
+    for (i = 0; i < NRECS; i++) {
+        for (j = 0; j < i; j++)
+            if (procThread[j] == procThread[i])
+                break;
+        if (j == i)
+            nthreads++;
+    }
+    testOk(nthreads > 1 && nthreads <= NSHARDS,
+           "records processed by %d threads", nthreads);
+
+    testdbCleanup();
+
+    return testDone();
+}
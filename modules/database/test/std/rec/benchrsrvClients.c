@@ -0,0 +1,236 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* CA server client count benchmark.
+ *
+ * A number of CA client contexts, each with its own circuit to the
+ * server of this IOC, subscribe to a scalar record.  Each update is
+ * posted and waited for by all subscribers.  Reports the number of CA
+ * server threads, their CPU time (on Linux, elsewhere of the whole
+ * process) and the round trip time per update, with a thread per
+ * client and with clients served by epoll I/O threads (rsrvIoThreads).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#  include <dirent.h>
+#endif
+
+#include "cadef.h"
+#include "dbDefs.h"
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "db_access_routines.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "iocInit.h"
+#include "iocsh.h"
+#include "testMain.h"
+
+#include "aiRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define MAXCLIENTS 200
+
+typedef struct {
+    struct ca_client_context *ctx;
+    chid chan;
+    evid sub;
+} benchClient;
+
+static benchClient clients[MAXCLIENTS];
+static aiRecord *prec;
+static epicsEventId delivered;
+static int nupdates, target, nbad;
+
+static void monitorCB(struct event_handler_args args)
+{
+    if(args.status != ECA_NORMAL)
+        epicsAtomicIncrIntT(&nbad);
+    if(epicsAtomicIncrIntT(&nupdates) == epicsAtomicGetIntT(&target))
+        epicsEventMustTrigger(delivered);
+}
+
+static int waitFor(int n)
+{
+    epicsAtomicSetIntT(&target, n);
+    if(epicsAtomicGetIntT(&nupdates) >= n)
+        return 1;
+    return epicsEventWaitWithTimeout(delivered, 10.0) == epicsEventOK
+        || epicsAtomicGetIntT(&nupdates) >= n;
+}
+
+/* CPU seconds used by the CA server threads, and how many there are */
+static double serverCPU(int *nthreads)
+{
+#ifdef __linux__
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *ent;
+    unsigned long long ns = 0;
+
+    *nthreads = 0;
+    while(dir && (ent = readdir(dir))) {
+        char path[64], comm[32];
+        unsigned long long runtime;
+        FILE *fp;
+        int ok;
+
+        if(ent->d_name[0] == '.')
+            continue;
+        epicsSnprintf(path, sizeof(path), "/proc/self/task/%s/comm",
+                      ent->d_name);
+        if(!(fp = fopen(path, "r")))
+            continue;
+        ok = fscanf(fp, "%31s", comm) == 1 && strncmp(comm, "CAS-", 4) == 0;
+        fclose(fp);
+        if(!ok)
+            continue;
+
+        /* per thread run time in ns, finer than the ticks of .../stat */
+        epicsSnprintf(path, sizeof(path), "/proc/self/task/%s/schedstat",
+                      ent->d_name);
+        if(!(fp = fopen(path, "r")))
+            continue;
+        if(fscanf(fp, "%llu", &runtime) == 1) {
+            ns += runtime;
+            (*nthreads)++;
+        }
+        fclose(fp);
+    }
+    if(dir)
+        closedir(dir);
+    return ns * 1e-9;
+#else
+    *nthreads = -1;
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void postUpdate(double val)
+{
+    dbScanLock((dbCommon*)prec);
+    prec->val = val;
+    db_post_events(prec, &prec->val, DBE_VALUE | DBE_LOG);
+    dbScanUnlock((dbCommon*)prec);
+}
+
+static void runBench(int ioThreads, int nclients, int niter)
+{
+    epicsUInt64 start;
+    double cpu, elapsed;
+    char cmd[32];
+    int c, i, ok, nthreads;
+
+    /* applies to the circuits created below */
+    epicsSnprintf(cmd, sizeof(cmd), "var rsrvIoThreads %d", ioThreads);
+    iocshCmd(cmd);
+    epicsAtomicSetIntT(&nupdates, 0);
+    epicsAtomicSetIntT(&nbad, 0);
+
+    for(c=0; c<nclients; c++) {
+        ca_attach_context(clients[c].ctx);
+        if(ca_create_channel("val", NULL, NULL, 0, &clients[c].chan)
+                != ECA_NORMAL ||
+           ca_pend_io(5.0) != ECA_NORMAL)
+            testAbort("Can't connect to val");
+        if(ca_create_subscription(DBR_DOUBLE, 1, clients[c].chan,
+                                  DBE_VALUE, monitorCB, &clients[c],
+                                  &clients[c].sub) != ECA_NORMAL)
+            testAbort("ca_create_subscription() fails");
+        ca_flush_io();
+        ca_detach_context();
+    }
+    /* initial updates */
+    ok = waitFor(nclients);
+
+    cpu = serverCPU(&nthreads);
+    start = epicsMonotonicGet();
+    for(i=1; ok && i<=niter; i++) {
+        postUpdate(i);
+        ok = waitFor(nclients * (i + 1));
+    }
+    elapsed = (epicsMonotonicGet() - start) * 1e-9;
+    cpu = serverCPU(&nthreads) - cpu;
+
+    testOk(ok && !epicsAtomicGetIntT(&nbad),
+           "%s, %d clients: %d updates delivered",
+           ioThreads ? "I/O threads" : "thread per client", nclients,
+           epicsAtomicGetIntT(&nupdates));
+    testDiag("%d server threads, %.1f us CPU per update, %.1f us per update"
+             " round trip", nthreads, cpu * 1e6 / niter, elapsed * 1e6 / niter);
+
+    for(c=0; c<nclients; c++) {
+        ca_attach_context(clients[c].ctx);
+        ca_clear_subscription(clients[c].sub);
+        ca_clear_channel(clients[c].chan);
+        ca_flush_io();
+        ca_detach_context();
+    }
+    /* let the server notice the circuits closing */
+    epicsThreadSleep(1.0);
+}
+
+MAIN(benchrsrvClients)
+{
+    static const int nclients[] = {10, 50, MAXCLIENTS};
+    unsigned i;
+    int c;
+
+    testPlan(2*NELEMENTS(nclients));
+
+    /* Keep traffic local */
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "localhost");
+    epicsEnvSet("EPICS_CA_SERVER_PORT", "55086");
+    epicsEnvSet("EPICS_CAS_BEACON_PORT", "55087");
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "localhost");
+
+    delivered = epicsEventMustCreate(epicsEventEmpty);
+
+    /* Client contexts created after iocInit() would access the
+     * database directly rather than through the CA server.
+     */
+    for(c=0; c<MAXCLIENTS; c++) {
+        if(ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+            testAbort("ca_context_create() fails");
+        clients[c].ctx = ca_current_context();
+        ca_detach_context();
+    }
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("benchrsrvClients.db", NULL, NULL);
+
+    /* the full IOC, with the CA server */
+    if(iocInit())
+        testAbort("iocInit() fails");
+    prec = (aiRecord*)testdbRecordPtr("val");
+
+    for(i=0; i<NELEMENTS(nclients); i++) {
+        runBench(0, nclients[i], 200);
+        runBench(2, nclients[i], 200);
+    }
+
+    for(c=0; c<MAXCLIENTS; c++) {
+        ca_attach_context(clients[c].ctx);
+        ca_context_destroy();
+    }
+
+    /* The CA server can't be stopped, so the database is not freed */
+    iocShutdown();
+
+    return testDone();
+}
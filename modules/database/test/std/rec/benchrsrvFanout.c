@@ -0,0 +1,235 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* CA server monitor fan-out benchmark.
+ *
+ * A number of CA client contexts, each with its own circuit to the
+ * server of this IOC, subscribe to a large waveform.  Each update is
+ * posted and waited for by all subscribers.  Reports the CPU time of
+ * the CA server threads (on Linux, elsewhere of the whole process) per
+ * update with each client's payload encoded separately and with
+ * payloads encoded once and shared (dbEventArraySnapshots).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#  include <dirent.h>
+#  include <unistd.h>
+#endif
+
+#include "cadef.h"
+#include "dbDefs.h"
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+
+#include "db_access_routines.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "iocInit.h"
+#include "testMain.h"
+
+#include "waveformRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NELM 100000
+#define MAXCLIENTS 40
+
+typedef struct {
+    struct ca_client_context *ctx;
+    chid chan;
+    evid sub;
+    double last;
+} benchClient;
+
+static benchClient clients[MAXCLIENTS];
+static waveformRecord *prec;
+static epicsEventId delivered;
+static int nupdates, target, nbad;
+
+static void monitorCB(struct event_handler_args args)
+{
+    benchClient *client = (benchClient *) args.usr;
+    const struct dbr_time_double *pval = args.dbr;
+
+    if(args.status != ECA_NORMAL || args.count != NELM) {
+        epicsAtomicIncrIntT(&nbad);
+    }
+    else {
+        /* the first and last element carry the same update number */
+        if((&pval->value)[0] != (&pval->value)[NELM-1])
+            epicsAtomicIncrIntT(&nbad);
+        client->last = (&pval->value)[NELM-1];
+    }
+    if(epicsAtomicIncrIntT(&nupdates) == epicsAtomicGetIntT(&target))
+        epicsEventMustTrigger(delivered);
+}
+
+static int waitFor(int n)
+{
+    epicsAtomicSetIntT(&target, n);
+    if(epicsAtomicGetIntT(&nupdates) >= n)
+        return 1;
+    return epicsEventWaitWithTimeout(delivered, 10.0) == epicsEventOK
+        || epicsAtomicGetIntT(&nupdates) >= n;
+}
+
+/* CPU seconds used by the CA server threads */
+static double serverCPU(void)
+{
+#ifdef __linux__
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *ent;
+    unsigned long ticks = 0;
+
+    while(dir && (ent = readdir(dir))) {
+        char path[64], comm[32];
+        unsigned long utime, stime;
+        FILE *fp;
+
+        epicsSnprintf(path, sizeof(path), "/proc/self/task/%s/stat",
+                      ent->d_name);
+        if(ent->d_name[0] == '.' || !(fp = fopen(path, "r")))
+            continue;
+        if(fscanf(fp, "%*d (%31[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u"
+                  " %*u %*u %lu %lu", comm, &utime, &stime) == 3 &&
+           strncmp(comm, "CAS-", 4) == 0)
+            ticks += utime + stime;
+        fclose(fp);
+    }
+    if(dir)
+        closedir(dir);
+    return (double)ticks / sysconf(_SC_CLK_TCK);
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void postUpdate(double val)
+{
+    double *buf = (double *) prec->bptr;
+    int i;
+
+    dbScanLock((dbCommon*)prec);
+    for(i=0; i<NELM; i++)
+        buf[i] = val;
+    prec->nord = NELM;
+    db_post_events(prec, &prec->val, DBE_VALUE | DBE_LOG);
+    dbScanUnlock((dbCommon*)prec);
+}
+
+static void runBench(int snapshots, int nclients, int niter)
+{
+    double cpu;
+    int c, i, ok;
+
+    dbEventArraySnapshots = snapshots;
+    epicsAtomicSetIntT(&nupdates, 0);
+    epicsAtomicSetIntT(&nbad, 0);
+
+    for(c=0; c<nclients; c++) {
+        ca_attach_context(clients[c].ctx);
+        if(ca_create_channel("wf", NULL, NULL, 0, &clients[c].chan)
+                != ECA_NORMAL ||
+           ca_pend_io(5.0) != ECA_NORMAL)
+            testAbort("Can't connect to wf");
+        if(ca_create_subscription(DBR_TIME_DOUBLE, 0, clients[c].chan,
+                                  DBE_VALUE, monitorCB, &clients[c],
+                                  &clients[c].sub) != ECA_NORMAL)
+            testAbort("ca_create_subscription() fails");
+        ca_flush_io();
+        ca_detach_context();
+    }
+    /* initial updates */
+    ok = waitFor(nclients);
+
+    cpu = serverCPU();
+    for(i=1; ok && i<=niter; i++) {
+        postUpdate(i);
+        ok = waitFor(nclients * (i + 1));
+    }
+    cpu = serverCPU() - cpu;
+
+    testOk(ok && !epicsAtomicGetIntT(&nbad),
+           "%s payloads, %d subscribers: %d updates delivered intact",
+           snapshots ? "shared" : "per client", nclients,
+           epicsAtomicGetIntT(&nupdates));
+    testDiag("%.0f us CPU per update, %.1f us per subscriber",
+             cpu * 1e6 / niter, cpu * 1e6 / niter / nclients);
+
+    for(c=0; c<nclients; c++) {
+        ca_attach_context(clients[c].ctx);
+        ca_clear_subscription(clients[c].sub);
+        ca_clear_channel(clients[c].chan);
+        ca_flush_io();
+        ca_detach_context();
+    }
+
+    dbEventArraySnapshots = 0;
+}
+
+MAIN(benchrsrvFanout)
+{
+    static const int nclients[] = {1, 4, 16, MAXCLIENTS};
+    char macros[32];
+    unsigned i;
+    int c;
+
+    testPlan(2*NELEMENTS(nclients));
+
+    /* Keep traffic local */
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "localhost");
+    epicsEnvSet("EPICS_CA_SERVER_PORT", "55084");
+    epicsEnvSet("EPICS_CAS_BEACON_PORT", "55085");
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "localhost");
+    epicsEnvSet("EPICS_CA_MAX_ARRAY_BYTES", "1000000");
+
+    delivered = epicsEventMustCreate(epicsEventEmpty);
+
+    /* Client contexts created after iocInit() would access the
+     * database directly rather than through the CA server.
+     */
+    for(c=0; c<MAXCLIENTS; c++) {
+        if(ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+            testAbort("ca_context_create() fails");
+        clients[c].ctx = ca_current_context();
+        ca_detach_context();
+    }
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    epicsSnprintf(macros, sizeof(macros), "NELM=%d", NELM);
+    testdbReadDatabase("benchrsrvFanout.db", NULL, macros);
+
+    /* the full IOC, with the CA server */
+    if(iocInit())
+        testAbort("iocInit() fails");
+    prec = (waveformRecord*)testdbRecordPtr("wf");
+    postUpdate(0);
+
+    for(i=0; i<NELEMENTS(nclients); i++) {
+        runBench(0, nclients[i], 100);
+        runBench(1, nclients[i], 100);
+    }
+
+    for(c=0; c<MAXCLIENTS; c++) {
+        ca_attach_context(clients[c].ctx);
+        ca_context_destroy();
+    }
+
+    /* The CA server can't be stopped, so the database is not freed */
+    iocShutdown();
+
+    return testDone();
+}
@@ -0,0 +1,266 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* CA server name search benchmark.
+ *
+ * A number of UDP sockets take turns sending datagrams of search
+ * requests, half of them for names of this IOC, to its CA server and
+ * collect the replies.  Reports searches/sec, the number of reply
+ * datagrams, the CPU time of the CA server UDP threads (on Linux,
+ * elsewhere of the whole process) and the server's search counters.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#  include <dirent.h>
+#endif
+
+#include "dbDefs.h"
+#include "envDefs.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "osiSock.h"
+
+#define CA_MINOR_PROTOCOL_REVISION 13
+#include "caProto.h"
+
+#include "db_access_routines.h"
+#include "dbUnitTest.h"
+#include "iocInit.h"
+#include "rsrv.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NRECORDS 64
+#define NSENDERS 8
+#define NDATAGRAMS 2      /* per sender and round */
+#define NSEARCHES 16      /* per datagram, every other one a match */
+#define SERVER_PORT 55088
+
+static SOCKET senders[NSENDERS];
+static osiSockAddr server;
+
+/* CPU seconds used by the CA server UDP threads */
+static double serverCPU(void)
+{
+#ifdef __linux__
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *ent;
+    unsigned long long ns = 0;
+
+    while(dir && (ent = readdir(dir))) {
+        char path[64], comm[32];
+        unsigned long long runtime;
+        FILE *fp;
+        int ok;
+
+        if(ent->d_name[0] == '.')
+            continue;
+        epicsSnprintf(path, sizeof(path), "/proc/self/task/%s/comm",
+                      ent->d_name);
+        if(!(fp = fopen(path, "r")))
+            continue;
+        ok = fscanf(fp, "%31s", comm) == 1 && strncmp(comm, "CAS-UDP", 7) == 0;
+        fclose(fp);
+        if(!ok)
+            continue;
+
+        epicsSnprintf(path, sizeof(path), "/proc/self/task/%s/schedstat",
+                      ent->d_name);
+        if(!(fp = fopen(path, "r")))
+            continue;
+        if(fscanf(fp, "%llu", &runtime) == 1)
+            ns += runtime;
+        fclose(fp);
+    }
+    if(dir)
+        closedir(dir);
+    return ns * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void putHeader(caHdr *pHdr, unsigned cmmd, unsigned postsize,
+    unsigned dataType, unsigned count, ca_uint32_t cid, ca_uint32_t avail)
+{
+    pHdr->m_cmmd = htons(cmmd);
+    pHdr->m_postsize = htons(postsize);
+    pHdr->m_dataType = htons(dataType);
+    pHdr->m_count = htons(count);
+    pHdr->m_cid = htonl(cid);
+    pHdr->m_available = htonl(avail);
+}
+
+/* a version message and NSEARCHES searches, returns the size */
+static unsigned buildDatagram(char *buf, unsigned first)
+{
+    caHdr *pHdr = (caHdr *) buf;
+    unsigned size = sizeof(caHdr);
+    unsigned i;
+
+    putHeader(pHdr, CA_PROTO_VERSION, 0, 0, CA_MINOR_PROTOCOL_REVISION,
+              first, 0);
+
+    for(i=0; i<NSEARCHES; i++) {
+        unsigned n = first + i;
+        char name[24];
+        unsigned len;
+
+        if(n % 2)
+            epicsSnprintf(name, sizeof(name), "nosuch%u", n % NRECORDS);
+        else
+            epicsSnprintf(name, sizeof(name), "srch%u", n % NRECORDS);
+        len = CA_MESSAGE_ALIGN(strlen(name) + 1);
+
+        pHdr = (caHdr *) &buf[size];
+        putHeader(pHdr, CA_PROTO_SEARCH, len, DONTREPLY,
+                  CA_MINOR_PROTOCOL_REVISION, n, n);
+        memset(pHdr + 1, 0, len);
+        strcpy((char *) (pHdr + 1), name);
+        size += sizeof(caHdr) + len;
+    }
+    return size;
+}
+
+/* count the search replies in a reply datagram */
+static unsigned countReplies(const char *buf, int size)
+{
+    unsigned n = 0;
+    int pos = 0;
+
+    while(pos + (int) sizeof(caHdr) <= size) {
+        const caHdr *pHdr = (const caHdr *) &buf[pos];
+        if(ntohs(pHdr->m_cmmd) == CA_PROTO_SEARCH)
+            n++;
+        pos += sizeof(caHdr) + ntohs(pHdr->m_postsize);
+    }
+    return n;
+}
+
+static void runBench(int nrounds)
+{
+    unsigned expected = nrounds * NSENDERS * NDATAGRAMS * NSEARCHES / 2;
+    unsigned replies = 0, datagrams = 0;
+    size_t rcv0, mat0, drp0, rcv1, mat1, drp1;
+    epicsUInt64 start;
+    double cpu, elapsed;
+    char buf[2048];
+    int r, s, d;
+
+    casSearchStatsFetch(&rcv0, &mat0, &drp0);
+    cpu = serverCPU();
+    start = epicsMonotonicGet();
+
+    for(r=0; r<nrounds; r++) {
+        unsigned want = (r + 1) * NSENDERS * NDATAGRAMS * NSEARCHES / 2;
+        int idle = 0;
+
+        /* senders take turns, as in a storm from many clients */
+        for(d=0; d<NDATAGRAMS; d++) {
+            for(s=0; s<NSENDERS; s++) {
+                unsigned size = buildDatagram(buf,
+                    (r * NDATAGRAMS + d) * NSEARCHES);
+                sendto(senders[s], buf, size, 0, &server.sa,
+                       sizeof(server.ia));
+            }
+        }
+
+        while(replies < want && idle < 200) {
+            int got = 0;
+            for(s=0; s<NSENDERS; s++) {
+                int n = recv(senders[s], buf, sizeof(buf), 0);
+                if(n > 0) {
+                    replies += countReplies(buf, n);
+                    datagrams++;
+                    got = 1;
+                }
+            }
+            if(!got) {
+                epicsThreadSleep(0.01);
+                idle++;
+            }
+        }
+    }
+
+    elapsed = (epicsMonotonicGet() - start) * 1e-9;
+    cpu = serverCPU() - cpu;
+    casSearchStatsFetch(&rcv1, &mat1, &drp1);
+
+    testOk(replies == expected && mat1 - mat0 == expected,
+           "%u of %u search replies received, %lu matched",
+           replies, expected, (unsigned long)(mat1 - mat0));
+    testDiag("%.0f searches/s, %u reply datagrams, %.2f us server CPU"
+             " per search", nrounds * NSENDERS * NDATAGRAMS * NSEARCHES
+             / elapsed, datagrams,
+             cpu * 1e6 / (nrounds * NSENDERS * NDATAGRAMS * NSEARCHES));
+    testDiag("server counters: %lu received, %lu matched, %lu dropped",
+             (unsigned long)(rcv1 - rcv0), (unsigned long)(mat1 - mat0),
+             (unsigned long)(drp1 - drp0));
+}
+
+MAIN(benchrsrvSearch)
+{
+    char macros[16];
+    int i;
+
+    testPlan(1);
+
+    /* Keep traffic local */
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "localhost");
+    epicsEnvSet("EPICS_CA_SERVER_PORT", "55088");
+    epicsEnvSet("EPICS_CAS_BEACON_PORT", "55089");
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "localhost");
+
+    osiSockAttach();
+
+    memset(&server, 0, sizeof(server));
+    server.ia.sin_family = AF_INET;
+    server.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.ia.sin_port = htons(SERVER_PORT);
+
+    for(i=0; i<NSENDERS; i++) {
+        osiSockIoctl_t yes = 1;
+        osiSockAddr addr = server;
+
+        senders[i] = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+        if(senders[i] == INVALID_SOCKET)
+            testAbort("Can't create UDP socket");
+        addr.ia.sin_port = 0;
+        if(bind(senders[i], &addr.sa, sizeof(addr.ia)) ||
+           socket_ioctl(senders[i], FIONBIO, &yes))
+            testAbort("Can't bind UDP socket");
+    }
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    for(i=0; i<NRECORDS; i++) {
+        epicsSnprintf(macros, sizeof(macros), "N=%d", i);
+        testdbReadDatabase("benchrsrvSearch.db", NULL, macros);
+    }
+
+    /* the full IOC, with the CA server */
+    if(iocInit())
+        testAbort("iocInit() fails");
+
+    runBench(500);
+
+    for(i=0; i<NSENDERS; i++)
+        epicsSocketDestroy(senders[i]);
+
+    /* The CA server can't be stopped, so the database is not freed */
+    iocShutdown();
+
+    osiSockRelease();
+
+    return testDone();
+}
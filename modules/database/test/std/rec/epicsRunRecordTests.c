@@ -28,6 +28,8 @@ int boTest(void);
 int biTest(void);
 int printfTest(void);
 int aiTest(void);
+int scanTimingTest(void);
+int rsrvIoThreadsTest(void);
 
 void epicsRunRecordTests(void)
 {
@@ -63,5 +65,10 @@ void epicsRunRecordTests(void)
 
     runTest(aiTest);
 
+    runTest(scanTimingTest);
+
+    /* last, as the CA server it starts can't be stopped completely */
+    runTest(rsrvIoThreadsTest);
+
     epicsExit(0);   /* Trigger test harness */
 }
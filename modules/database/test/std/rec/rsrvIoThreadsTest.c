@@ -0,0 +1,274 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* CA server with its TCP clients served by one epoll I/O thread
+ * (rsrvIoThreads).
+ *
+ * Two client contexts share the I/O thread.  Gets, puts and monitors
+ * must work, and while one client has a second put callback waiting
+ * for the first to complete the other client must still be served.
+ * The waiting client may also disconnect.  Subscriptions are served by
+ * the shared CAS-event threads, and stopping the server at iocShutdown()
+ * joins all of these threads.
+ */
+
+#include <string.h>
+
+#include "cadef.h"
+#include "dbDefs.h"
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "db_access_routines.h"
+#include "dbUnitTest.h"
+#include "iocInit.h"
+#include "iocsh.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+/* of slow in rsrvIoThreadsTest.db */
+#define ODLY 4.0
+
+typedef struct {
+    struct ca_client_context *ctx;
+    chid val, slow;
+} testClient;
+
+static testClient clientA, clientB;
+static epicsEventId putDone, monitorDone;
+static int nputs, putOrder[2], nbadPuts;
+static double monitorValue;
+
+static void putCB(struct event_handler_args args)
+{
+    int n = epicsAtomicIncrIntT(&nputs);
+
+    if(args.status != ECA_NORMAL)
+        epicsAtomicIncrIntT(&nbadPuts);
+    if(n <= 2)
+        putOrder[n - 1] = (int)(size_t)args.usr;
+    epicsEventMustTrigger(putDone);
+}
+
+static void monitorCB(struct event_handler_args args)
+{
+    if(args.status == ECA_NORMAL && args.dbr)
+        monitorValue = *(const dbr_double_t *)args.dbr;
+    epicsEventMustTrigger(monitorDone);
+}
+
+/* the server stopping while client B is connected is expected */
+static void quietException(struct exception_handler_args args)
+{
+    testDiag("CA exception: %s", ca_message(args.stat));
+}
+
+static void connectClient(testClient *client)
+{
+    ca_attach_context(client->ctx);
+    ca_add_exception_event(quietException, NULL);
+    if(ca_create_channel("val", NULL, NULL, 0, &client->val) != ECA_NORMAL ||
+       ca_create_channel("slow.A", NULL, NULL, 0, &client->slow) != ECA_NORMAL ||
+       ca_pend_io(5.0) != ECA_NORMAL)
+        testAbort("Can't connect to val and slow.A");
+    ca_detach_context();
+}
+
+/* get as client B, ok when it doesn't take the whole timeout */
+static int getB(chid chan, double *pValue)
+{
+    int status;
+
+    ca_attach_context(clientB.ctx);
+    status = ca_get(DBR_DOUBLE, chan, pValue);
+    if(status == ECA_NORMAL)
+        status = ca_pend_io(5.0);
+    ca_detach_context();
+    return status == ECA_NORMAL;
+}
+
+/* two put callbacks to slow, the second has to wait for the first */
+static void putTwiceA(void)
+{
+    dbr_double_t one = 1.0, two = 2.0;
+
+    epicsAtomicSetIntT(&nputs, 0);
+    ca_attach_context(clientA.ctx);
+    if(ca_array_put_callback(DBR_DOUBLE, 1, clientA.slow, &one,
+                             putCB, (void*)1) != ECA_NORMAL ||
+       ca_array_put_callback(DBR_DOUBLE, 1, clientA.slow, &two,
+                             putCB, (void*)2) != ECA_NORMAL)
+        testAbort("ca_array_put_callback() fails");
+    ca_flush_io();
+    ca_detach_context();
+
+    /* the server starts the first and parks the second */
+    epicsThreadSleep(0.5);
+}
+
+static void testBasic(void)
+{
+    dbr_double_t value = 42.0;
+    double got = 0.0;
+    evid sub;
+    int ok;
+
+    testDiag("get, put and monitor through the I/O thread");
+
+    ca_attach_context(clientB.ctx);
+    if(ca_create_subscription(DBR_DOUBLE, 1, clientB.val, DBE_VALUE,
+                              monitorCB, NULL, &sub) != ECA_NORMAL)
+        testAbort("ca_create_subscription() fails");
+    ca_flush_io();
+    ca_detach_context();
+    epicsEventWaitWithTimeout(monitorDone, 5.0);
+
+    ca_attach_context(clientA.ctx);
+    testOk1(ca_put(DBR_DOUBLE, clientA.val, &value) == ECA_NORMAL &&
+            ca_pend_io(5.0) == ECA_NORMAL);
+    ca_detach_context();
+
+    testOk(epicsEventWaitWithTimeout(monitorDone, 5.0) == epicsEventOK &&
+           monitorValue == 42.0, "monitor update %g", monitorValue);
+
+    ok = getB(clientB.val, &got);
+    testOk(ok && got == 42.0, "get %g", got);
+
+    ca_attach_context(clientB.ctx);
+    ca_clear_subscription(sub);
+    ca_flush_io();
+    ca_detach_context();
+}
+
+static void testParkedPut(void)
+{
+    double got = 0.0;
+    int i, ok;
+
+    testDiag("second put callback to a busy channel");
+
+    putTwiceA();
+
+    /* a blocked I/O thread would only answer after the first put */
+    ok = getB(clientB.val, &got);
+    testOk(ok && epicsAtomicGetIntT(&nputs) == 0,
+           "other client served while a put callback waits, %d completed",
+           epicsAtomicGetIntT(&nputs));
+
+    for(i=0; i<2; i++)
+        epicsEventWaitWithTimeout(putDone, 3*ODLY);
+    testOk(epicsAtomicGetIntT(&nputs) == 2 && !epicsAtomicGetIntT(&nbadPuts),
+           "both put callbacks completed, %d bad", nbadPuts);
+    testOk(putOrder[0] == 1 && putOrder[1] == 2,
+           "put callbacks completed in order %d %d",
+           putOrder[0], putOrder[1]);
+    ok = getB(clientB.slow, &got);
+    testOk(ok && got == 2.0, "slow %g", got);
+}
+
+static void testParkedDisconnect(void)
+{
+    epicsUInt64 start;
+    double got = 0.0, elapsed;
+    int ok;
+
+    testDiag("client disconnects while a put callback waits");
+
+    putTwiceA();
+
+    /* the context waits for the server to close the circuit */
+    start = epicsMonotonicGet();
+    ca_attach_context(clientA.ctx);
+    ca_context_destroy();
+    clientA.ctx = NULL;
+    ok = getB(clientB.val, &got);
+    elapsed = (epicsMonotonicGet() - start) * 1e-9;
+    testOk(ok && elapsed < ODLY - 1.0,
+           "disconnect noticed and other client served in %.3f sec", elapsed);
+
+    /* the first put still completes in the server */
+    epicsThreadSleep(ODLY);
+    testOk(getB(clientB.val, &got), "other client served after the disconnect");
+}
+
+/* the threads of rsrvIoThreads, running or not */
+static void testThreads(int running)
+{
+#if defined(__linux__)
+    testOk(!epicsThreadGetId("CAS-io0") == !running,
+           "CAS-io0 %s", running ? "running" : "joined");
+    testOk(!epicsThreadGetId("CAS-event0") == !running,
+           "CAS-event0 %s", running ? "running" : "joined");
+    testOk(!epicsThreadGetId("CAS-reaper") == !running,
+           "CAS-reaper %s", running ? "running" : "joined");
+    if(running)
+        testOk(!epicsThreadGetId("CAS-event") && !epicsThreadGetId("CAS-client"),
+               "no thread for each client");
+#else
+    testSkip(running ? 4 : 3, "no epoll I/O threads on this target");
+#endif
+}
+
+MAIN(rsrvIoThreadsTest)
+{
+    testPlan(16);
+
+    /* Keep traffic local */
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "localhost");
+    epicsEnvSet("EPICS_CA_SERVER_PORT", "55090");
+    epicsEnvSet("EPICS_CAS_BEACON_PORT", "55091");
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "localhost");
+
+    putDone = epicsEventMustCreate(epicsEventEmpty);
+    monitorDone = epicsEventMustCreate(epicsEventEmpty);
+
+    /* Client contexts created after iocInit() would access the
+     * database directly rather than through the CA server.
+     */
+    if(ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+        testAbort("ca_context_create() fails");
+    clientA.ctx = ca_current_context();
+    ca_detach_context();
+    if(ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+        testAbort("ca_context_create() fails");
+    clientB.ctx = ca_current_context();
+    ca_detach_context();
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    /* one I/O thread for both clients */
+    iocshCmd("var rsrvIoThreads 1");
+    testdbReadDatabase("rsrvIoThreadsTest.db", NULL, NULL);
+
+    /* the full IOC, with the CA server */
+    if(iocInit())
+        testAbort("iocInit() fails");
+
+    connectClient(&clientA);
+    connectClient(&clientB);
+    testThreads(TRUE);
+
+    testBasic();
+    testParkedPut();
+    testParkedDisconnect();
+
+    /* Client B is still connected when the server stops. The rest of
+     * the CA server can't be stopped, so the database is not freed.
+     */
+    iocShutdown();
+    testThreads(FALSE);
+
+    ca_attach_context(clientB.ctx);
+    ca_context_destroy();
+
+    return testDone();
+}
@@ -0,0 +1,145 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "callback.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "dbUnitTest.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "testMain.h"
+
+/*
+ * Scan timing statistics of a periodic scan list and of scanOnce, read
+ * through scanTimingGet() and the "Scan Timing" device support.  Scans
+ * are only timed while scanRecordTiming is set.
+ */
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static epicsEventId blocked, release;
+
+static void blockCallback(epicsCallback *pcb)
+{
+    epicsEventMustTrigger(blocked);
+    epicsEventMustWait(release);
+}
+
+/* An event posted again before its scan has run */
+static void testRepeatedEvent(void)
+{
+    epicsCallback blocker;
+    scanTimingStats stats;
+    EVENTPVT pel = eventNameToHandle("timing");
+
+    testDiag("a repeated event is late from its first request");
+    blocked = epicsEventMustCreate(epicsEventEmpty);
+    release = epicsEventMustCreate(epicsEventEmpty);
+    callbackSetCallback(blockCallback, &blocker);
+    callbackSetPriority(priorityLow, &blocker);
+
+    callbackRequest(&blocker);
+    epicsEventMustWait(blocked);
+    scanTimingGet("Event Low", 1, &stats);
+    postEvent(pel);
+    epicsThreadSleep(0.2);
+    postEvent(pel);
+    epicsEventMustTrigger(release);
+    testSyncCallback();
+
+    scanTimingGet("Event Low", 0, &stats);
+    testOk(stats.count == 2 && stats.lateMax >= 0.15,
+           "%lu event scans, late by up to %g s", stats.count, stats.lateMax);
+
+    epicsEventDestroy(blocked);
+    epicsEventDestroy(release);
+}
+
+MAIN(scanTimingTest)
+{
+    scanTimingStats stats;
+    dbCommon *ponce;
+    int i;
+
+    testPlan(20);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("scanTimingTest.db", NULL, NULL);
+
+    testOk(scanTimingGet(".1 second", 0, &stats) == -1,
+           "no statistics before iocInit");
+
+    scanRecordTiming = 1;
+    testIocInitOk();
+
+    for (i = 0; i < 50; i++) {
+        if (scanTimingGet(".1 second", 0, &stats) == 0 && stats.count >= 3)
+            break;
+        epicsThreadSleep(0.1);
+    }
+    testOk(stats.count >= 3, ".1 second list scanned %lu times",
+           stats.count);
+    testOk(stats.execMax > 0.0 && stats.execP50 <= stats.execMax &&
+           stats.execP99 <= stats.execMax,
+           "exec P50 %g <= P99 %g <= max %g s",
+           stats.execP50, stats.execP99, stats.execMax);
+    testOk(stats.lateP50 <= stats.lateMax && stats.lateP99 <= stats.lateMax,
+           "late P50 %g, P99 %g <= max %g s",
+           stats.lateP50, stats.lateP99, stats.lateMax);
+    testOk(stats.recordMax > 0.0 && stats.recordMax <= stats.execMax,
+           "slowest record %g s", stats.recordMax);
+    testOk(strcmp(stats.recordMaxName, "timing:work") == 0,
+           "slowest record is '%s'", stats.recordMaxName);
+
+    testOk1(scanTimingGet("No such list", 0, &stats) == -1);
+
+    ponce = testdbRecordPtr("timing:once");
+    testOk1(scanTimingGet("Once", 1, &stats) == 0);
+    for (i = 0; i < 10; i++)
+        scanOnce(ponce);
+    testSyncCallback();
+    for (i = 0; i < 50; i++) {
+        if (scanTimingGet("Once", 0, &stats) == 0 && stats.count >= 10)
+            break;
+        epicsThreadSleep(0.01);
+    }
+    testOk(stats.count == 10, "scanOnce counted %lu times", stats.count);
+    testOk(strcmp(stats.recordMaxName, "timing:once") == 0,
+           "slowest once record is '%s'", stats.recordMaxName);
+
+    testdbPutFieldOk("timing:count.PROC", DBF_LONG, 1);
+    testdbPutFieldOk("timing:slowest.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("timing:slowest", DBF_STRING, "timing:work");
+    testdbPutFieldOk("timing:late.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("timing:late.SEVR", DBF_LONG, 0);
+
+    testdbPutFieldOk("timing:nolist.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("timing:nolist.SEVR", DBF_LONG, 3);
+
+    testOk1(scanTimingShow(".1 second", 0) == 0);
+
+    testRepeatedEvent();
+
+    testDiag("scans aren't timed with scanRecordTiming zero");
+    scanRecordTiming = 0;
+    scanTimingGet("Once", 1, &stats);
+    scanOnce(ponce);
+    testSyncCallback();
+    epicsThreadSleep(0.1);
+    scanTimingGet("Once", 0, &stats);
+    testOk(stats.count == 0 && !*stats.recordMaxName,
+           "scanOnce counted %lu times, slowest record '%s'",
+           stats.count, stats.recordMaxName);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}